@@ -1,6 +1,7 @@
 // Observability Adapter Stub Implementation for C++ CAF Ingress
 
 #include "ingress_observability_stub.hpp"
+#include "beamline/worker/pii_matcher.hpp"
 #include <sstream>
 #include <iomanip>
 #include <ctime>
@@ -121,13 +122,8 @@ std::string LoggerStub::sanitize_context(const std::map<std::string, std::string
 }
 
 bool LoggerStub::is_pii_field(const std::string& field) {
-    static const std::vector<std::string> pii_fields = {
-        "password", "api_key", "secret", "token", "access_token",
-        "refresh_token", "authorization", "credit_card", "ssn", "email", "phone"
-    };
-    std::string lower_field = field;
-    std::transform(lower_field.begin(), lower_field.end(), lower_field.begin(), ::tolower);
-    return std::find(pii_fields.begin(), pii_fields.end(), lower_field) != pii_fields.end();
+    // Same precompiled, case-insensitive substring matcher as the worker's logs
+    return beamline::worker::PiiMatcher::instance().matches(field);
 }
 
 } // namespace observability
@@ -1,13 +1,20 @@
 #pragma once
 
 #include "beamline/worker/core.hpp"
+#include "beamline/worker/resource_meter.hpp"
+#include "beamline/worker/tenant_fair_queue.hpp"
 #include "beamline/worker/observability.hpp"
+#include "beamline/worker/retry_policy.hpp"
+#include "beamline/worker/tracer.hpp"
 #include <caf/actor.hpp>
 #include <caf/actor_system.hpp>
 #include <caf/event_based_actor.hpp>
 #include <caf/typed_actor.hpp>
 #include <caf/typed_event_based_actor.hpp>
-#include <queue>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace beamline {
 namespace worker {
@@ -70,16 +77,34 @@ using WorkerActor = WorkerActorImpl;
 using pool_actor = caf::typed_actor<
     caf::reacts_to<caf::atom_value, StepRequest>, // execute step
     caf::reacts_to<caf::atom_value, std::string>, // cancel step
-    caf::reacts_to<caf::atom_value> // get pool metrics
+    caf::reacts_to<caf::atom_value>, // get pool metrics / eviction tick / shutdown
+    caf::reacts_to<caf::atom_value, std::string, caf::actor> // executor done (block type, executor)
 >;
 
+// Block types served by pools besides the built-in http.request, fs.blob_put and fs.blob_get.
+// Register before steps of the type arrive; pools spawn executors of it like the built-in ones.
+using BlockExecutorFactory = std::function<std::shared_ptr<BlockExecutor>()>;
+void register_block_executor(const std::string& type, BlockExecutorFactory factory);
+
 struct PoolConfig {
     ResourceClass resource_class;
     int max_concurrency;
+    // Warm executor actors kept per block type (0 = spawn lazily on first use)
+    int executor_pool_min = 0;
+    // Upper bound of live executor actors per block type (0 = max_concurrency)
+    int executor_pool_max = 0;
+    // Idle executors above executor_pool_min are shut down after this period
+    int64_t executor_idle_timeout_ms = 30000;
+    // Pending-queue weights per tenant ("tenant=weight,...", see parse_tenant_weights)
+    std::string tenant_weights;
+    // false: spawn an executor actor per step and retire it afterwards (no warm executors)
+    bool executor_pooling = true;
     
     template <class Inspector>
     friend typename Inspector::result_type inspect(Inspector& f, PoolConfig& config) {
-        return f(config.resource_class, config.max_concurrency);
+        return f(config.resource_class, config.max_concurrency, config.executor_pool_min,
+                 config.executor_pool_max, config.executor_idle_timeout_ms, config.tenant_weights,
+                 config.executor_pooling);
     }
 };
 
@@ -94,16 +119,64 @@ private:
     ResourceClass resource_class_;
     int max_concurrency_;
     int current_load_ = 0;
-    std::queue<std::pair<caf::actor_addr, StepRequest>> pending_requests_;
+    // Queued step; its "step" span stays open while it waits
+    struct PendingRequest {
+        caf::actor_addr requester;
+        StepRequest request;
+        Span step_span;
+    };
+    // Dispatched step: its executor (for cancellation), span and timings for the queue-time metrics
+    struct RunningStep {
+        caf::actor executor;
+        std::string step_id;
+        std::string tenant_id;
+        double estimated_cost_ms = 0; // Charged to the tenant when it left the pending queue
+        Span step_span;
+        std::chrono::steady_clock::time_point enqueued_at;
+        std::chrono::steady_clock::time_point dispatched_at;
+    };
+    // Deficit round robin across tenants; priority class, then earliest deadline first within
+    // a tenant; keyed by step_id
+    TenantFairQueue<PendingRequest> pending_requests_;
+    std::unordered_map<caf::actor_addr, RunningStep> running_steps_; // By executor
+    std::unordered_map<std::string, caf::actor_addr> running_step_ids_; // step_id -> running_steps_ key
     int max_queue_size_ = 1000; // CP2: Bounded queue size (configurable)
+    bool throttle_check_scheduled_ = false; // A "throttle" tick is pending
     std::shared_ptr<Observability> observability_; // CP2: For metrics collection
     
+    // Warm executor actors, reused across steps instead of spawning one per step
+    struct IdleExecutor {
+        caf::actor handle;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+    bool executor_pooling_;
+    int executor_pool_min_;
+    int executor_pool_max_;
+    std::chrono::milliseconds executor_idle_timeout_;
+    std::unordered_map<std::string, std::vector<IdleExecutor>> idle_executors_; // by block type, LIFO
+    std::unordered_map<std::string, int> live_executors_; // idle + busy, by block type
+    
     void process_pending();
     size_t get_queue_depth() const;
     void update_queue_metrics(); // CP2: Update queue depth and active tasks metrics
+    void update_tenant_queue_metrics(const std::string& tenant_id);
+    // Holds the tenant's steps in the pending queue while TenantLedger has it over quota;
+    // returns whether it is throttled
+    bool throttle_if_over_quota(const std::string& tenant_id);
+    void schedule_throttle_check();
     
     std::shared_ptr<BlockExecutor> create_block_executor(const std::string& type);
-    void execute_step(const StepRequest& request, caf::actor_addr requester);
+    Span start_step_span(const StepRequest& request);
+    void execute_step(const StepRequest& request, caf::actor_addr requester, Span step_span,
+                      std::chrono::steady_clock::time_point enqueued_at, double estimated_cost_ms = 0);
+    void expire_request(PendingRequest& pending, std::chrono::steady_clock::time_point enqueued_at);
+    void shed_request(const std::string& tenant_id, PendingRequest& pending);
+    
+    caf::actor acquire_executor(const std::string& type, const SpanContext& trace_parent);
+    void release_executor(const std::string& type, caf::actor executor);
+    void prewarm_executors();
+    void evict_idle_executors();
+    void shutdown_executors();
     
     caf::scheduled_actor* self_ = nullptr;
 };
@@ -111,14 +184,16 @@ private:
 class PoolActorImpl : public caf::typed_event_based_actor<
     caf::reacts_to<caf::atom_value, StepRequest>,
     caf::reacts_to<caf::atom_value, std::string>,
-    caf::reacts_to<caf::atom_value>
+    caf::reacts_to<caf::atom_value>,
+    caf::reacts_to<caf::atom_value, std::string, caf::actor>
 > {
 public:
     PoolActorImpl(caf::actor_config& cfg, PoolConfig config)
         : caf::typed_event_based_actor<
             caf::reacts_to<caf::atom_value, StepRequest>,
             caf::reacts_to<caf::atom_value, std::string>,
-            caf::reacts_to<caf::atom_value>
+            caf::reacts_to<caf::atom_value>,
+            caf::reacts_to<caf::atom_value, std::string, caf::actor>
           >(cfg),
           state_(this, std::move(config)) {}
 
@@ -133,7 +208,9 @@ private:
 using executor_actor = caf::typed_actor<
     caf::reacts_to<caf::atom_value, StepRequest, caf::actor>, // execute step with reply-to pool (generic actor)
     caf::reacts_to<caf::atom_value, std::string>, // cancel step
-    caf::reacts_to<caf::atom_value> // get executor metrics
+    caf::reacts_to<caf::atom_value>, // get executor metrics / shutdown
+    caf::reacts_to<caf::atom_value, uint64_t>, // retry attempt (delayed self-message)
+    caf::reacts_to<caf::atom_value, uint64_t, StepResult> // async attempt completed
 >;
 
 class ExecutorActorState {
@@ -142,13 +219,37 @@ public:
     
     executor_actor::behavior_type make_behavior();
     
+    // Steps started and not yet completed, including those waiting out a backoff
+    size_t steps_in_flight() const { return retries_.size(); }
+    
 private:
+    // In-flight step between attempts. Backoff is a delayed message to self,
+    // so a step waiting for its next attempt holds no scheduler thread.
+    struct RetryState {
+        StepRequest request;
+        caf::actor pool;
+        RetryPolicy policy;
+        std::chrono::steady_clock::time_point started_at;
+        std::chrono::steady_clock::time_point attempt_started_at;
+        int32_t attempt = 0;
+        StepResult last_result;
+        SpanContext trace_parent; // Pool's "step" span, from the request's traceparent
+        Span attempt_span;
+        ResourceMeter::Usage usage; // Summed over attempts; peak is the largest attempt's
+    };
+    
     caf::actor_system& system_;
     std::shared_ptr<BlockExecutor> executor_;
     std::unordered_map<std::string, caf::actor_addr> running_steps_;
+    std::unordered_map<uint64_t, RetryState> retries_;
+    uint64_t next_retry_token_ = 0;
     std::shared_ptr<Observability> observability_; // CP2: For metrics collection
     
-    caf::expected<StepResult> execute_with_retry(const StepRequest& req);
+    void start_step(const StepRequest& req, caf::actor pool);
+    void run_attempt(uint64_t token);
+    void add_attempt_usage(RetryState& state, const ResourceMeter::Usage& usage);
+    void on_attempt_result(uint64_t token, caf::expected<StepResult> result);
+    void complete_step(uint64_t token, const StepResult& result);
     caf::expected<StepResult> execute_single_attempt(const StepRequest& req);
     void record_step_metrics(const StepRequest& req, const StepResult& result, double duration_seconds); // CP2: Record metrics
 
@@ -158,20 +259,26 @@ private:
 class ExecutorActorImpl : public caf::typed_event_based_actor<
     caf::reacts_to<caf::atom_value, StepRequest, caf::actor>,
     caf::reacts_to<caf::atom_value, std::string>,
-    caf::reacts_to<caf::atom_value>
+    caf::reacts_to<caf::atom_value>,
+    caf::reacts_to<caf::atom_value, uint64_t>,
+    caf::reacts_to<caf::atom_value, uint64_t, StepResult>
 > {
 public:
     ExecutorActorImpl(caf::actor_config& cfg, std::shared_ptr<BlockExecutor> executor)
         : caf::typed_event_based_actor<
             caf::reacts_to<caf::atom_value, StepRequest, caf::actor>,
             caf::reacts_to<caf::atom_value, std::string>,
-            caf::reacts_to<caf::atom_value>
+            caf::reacts_to<caf::atom_value>,
+            caf::reacts_to<caf::atom_value, uint64_t>,
+            caf::reacts_to<caf::atom_value, uint64_t, StepResult>
           >(cfg),
           state_(this, std::move(executor)) {}
           
     behavior_type make_behavior() override {
         return state_.make_behavior();
     }
+    
+    const ExecutorActorState& state() const { return state_; }
 private:
     ExecutorActorState state_;
 };
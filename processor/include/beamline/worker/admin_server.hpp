@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Admin HTTP server (/metrics, /health, /ready, debug endpoints)
+ *
+ * One epoll loop on one thread serves every admin route on a single port.
+ * Sockets are non-blocking, so a slow client only holds its own connection,
+ * and HTTP/1.1 keep-alive lets a scraper reuse its connection. A connection is
+ * closed if a request does not arrive in full within the request timeout, or if
+ * it sits idle between requests for longer than the idle timeout. Responses of
+ * at least gzip_min_bytes are gzip-compressed when the client accepts it.
+ *
+ * Handlers run on the server thread, so they must not block.
+ */
+class AdminServer {
+public:
+    struct Config {
+        std::string address = "0.0.0.0";
+        uint16_t port = 9091;               // 0 = any free port (see port())
+        int64_t request_timeout_ms = 5000;  // Time allowed to receive a complete request
+        int64_t idle_timeout_ms = 30000;    // Keep-alive connections idle longer are closed
+        size_t max_connections = 256;       // Further connections are accepted and closed
+        size_t max_request_bytes = 8192;    // Larger request headers get 431
+        size_t gzip_min_bytes = 1024;       // Smaller bodies are sent uncompressed
+    };
+
+    struct Request {
+        std::string_view method;
+        std::string_view path;              // Without the query string
+        std::string_view query;
+        std::string_view accept;            // Accept header, for content negotiation
+    };
+
+    struct Response {
+        int status = 200;
+        std::string content_type = "text/plain; charset=utf-8";
+        std::string body;
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    explicit AdminServer(Config config);
+    ~AdminServer();
+
+    AdminServer(const AdminServer&) = delete;
+    AdminServer& operator=(const AdminServer&) = delete;
+
+    // Serve GET and HEAD requests for `path` (exact match); register before start()
+    void handle(const std::string& path, Handler handler);
+
+    // Bind, listen and start the loop. Throws std::runtime_error if the socket cannot be set up.
+    void start();
+    // Close every connection and join the loop thread; safe to call more than once
+    void stop();
+
+    bool running() const { return running_.load(std::memory_order_acquire); }
+    uint16_t port() const { return bound_port_; }
+
+    // gzip-compress `input` (exposed for tests)
+    static std::string gzip(std::string_view input);
+
+private:
+    struct Connection;
+
+    void run();
+    void accept_connections();
+    void on_readable(Connection& connection);
+    void on_writable(Connection& connection);
+    bool process_requests(Connection& connection);
+    void queue_response(Connection& connection, bool head_only, bool keep_alive, bool accepts_gzip,
+                        Response response);
+    void update_interest(Connection& connection);
+    void close_connection(int fd);
+    void expire_connections();
+
+    Config config_;
+    std::map<std::string, Handler, std::less<>> routes_;
+    std::map<int, std::unique_ptr<Connection>> connections_; // Loop thread only
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;                        // eventfd that stop() signals
+    uint16_t bound_port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+} // namespace worker
+} // namespace beamline
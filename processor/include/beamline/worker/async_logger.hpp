@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Asynchronous line logger
+ *
+ * Each producing thread owns a single-producer/single-consumer byte ring, so
+ * write() is a bounds check and a memcpy with no locks and no syscall. A
+ * background writer drains all rings every flush interval (or earlier when a
+ * ring is half full) and emits the lines with batched writev() calls, either
+ * to stdout/stderr or to a single log file.
+ *
+ * Overflow is bounded: when a thread's ring is full the producer waits at most
+ * max_block_us for the writer to make room, then drops the line and counts it.
+ */
+class AsyncLogger {
+public:
+    enum class Stream { out, err };
+
+    struct Config {
+        std::string path;                 // Log file (appended); empty = stdout/stderr
+        size_t ring_bytes = 256 * 1024;   // Per-thread buffer, rounded up to a power of two
+        int64_t flush_interval_ms = 10;   // Max delay before buffered lines are written
+        int64_t max_block_us = 0;         // Wait for space before dropping (0 = drop immediately)
+    };
+
+    struct Stats {
+        uint64_t submitted = 0;
+        uint64_t written = 0;
+        uint64_t dropped = 0;             // Lines lost to a full ring
+        uint64_t bytes_written = 0;
+        uint64_t write_calls = 0;         // writev()/write() syscalls issued
+        size_t threads = 0;               // Live producer rings
+    };
+
+    explicit AsyncLogger(Config config);
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Process-wide logger used by Observability; configure() only has an effect before first use
+    static void configure(Config config);
+    static AsyncLogger& instance();
+
+    // Queue one line (a newline is appended). Returns false if it was dropped.
+    bool write(Stream stream, std::string_view line);
+
+    // Block until every line queued before the call has been handed to the kernel
+    void flush();
+
+    Stats stats() const;
+
+private:
+    struct Ring;
+
+    Ring& local_ring();
+    bool wait_for_space(Ring& ring, size_t needed);
+    void write_direct(Stream stream, std::string_view line);
+    void writer_loop();
+    void drain();
+    void wake_writer();
+
+    const uint64_t id_;
+    Config config_;
+    int out_fd_ = 1;
+    int err_fd_ = 2;
+    bool owns_fd_ = false;
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    // Counters of rings whose threads exited and were drained
+    uint64_t retired_submitted_ = 0;
+    uint64_t retired_dropped_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable flushed_cv_;
+    bool running_ = true;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
+    std::atomic<bool> wake_requested_{false};
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+    std::atomic<uint64_t> write_calls_{0};
+
+    std::thread writer_;
+};
+
+} // namespace worker
+} // namespace beamline
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "beamline/worker/core.hpp"
+#include "beamline/worker/resource_meter.hpp"
+#include <algorithm>
 #include <chrono>
 
 namespace beamline {
@@ -23,12 +25,12 @@ public:
     // Default implementation uses stored context_
     caf::expected<StepResult> execute(const StepRequest& req, const BlockContext& ctx) override {
         // Use provided context (may override stored context_)
-        return execute_impl(req, ctx);
+        return metered_execute(req, ctx);
     }
     
     // Legacy execute without context - uses stored context_
     caf::expected<StepResult> execute(const StepRequest& req) override {
-        return execute_impl(req, context_);
+        return metered_execute(req, context_);
     }
     
     caf::expected<void> cancel(const std::string& step_id) override {
@@ -41,6 +43,10 @@ public:
         return metrics_;
     }
     
+    void record_async_result(const StepResult& result) override {
+        record_result(result);
+    }
+    
 protected:
     std::string block_type_;
     ResourceClass resource_class_;
@@ -62,6 +68,27 @@ protected:
         metrics_.error_count++;
     }
     
+    void record_result(const StepResult& result) {
+        if (result.status == StepStatus::ok) {
+            record_success(result.latency_ms);
+        } else {
+            record_error(result.latency_ms);
+        }
+    }
+    
+    // Runs execute_impl and fills in the measured CPU time and peak heap of the call;
+    // a block's own mem_bytes (e.g. a payload size) is kept when it is larger
+    caf::expected<StepResult> metered_execute(const StepRequest& req, const BlockContext& ctx) {
+        int64_t successes = metrics_.success_count;
+        ResourceMeter meter;
+        auto result = execute_impl(req, ctx);
+        auto usage = meter.elapsed();
+        int64_t reported_mem = metrics_.success_count != successes ? metrics_.mem_bytes : 0;
+        metrics_.cpu_time_ms = usage.cpu_time_ns / 1000000;
+        metrics_.mem_bytes = std::max(reported_mem, usage.peak_heap_bytes);
+        return result;
+    }
+    
     bool validate_required_inputs(const StepRequest& req, const std::vector<std::string>& required_inputs) {
         for (const auto& input : required_inputs) {
             if (req.inputs.find(input) == req.inputs.end()) {
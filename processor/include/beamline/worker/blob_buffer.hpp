@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Shared, refcounted read-only byte buffer
+ *
+ * Copies are cheap handles onto the same storage; the storage (typically a
+ * read-only file mapping) is released when the last handle goes away. Used
+ * to hand large blobs to downstream consumers without copying them into
+ * StepResult::outputs.
+ */
+class BlobBuffer {
+public:
+    BlobBuffer() = default;
+
+    // Map [offset, offset + length) of a file read-only. length 0 maps to end of file.
+    // Throws std::runtime_error on failure or if offset is past the end of the file.
+    static BlobBuffer map_file(const std::string& path, uint64_t offset = 0, uint64_t length = 0);
+
+    // Wrap an owned string (for producers that already hold the bytes in memory)
+    static BlobBuffer from_string(std::string data);
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::string_view view() const { return {data_, size_}; }
+
+    // Sub-range sharing the same storage; clipped to the buffer bounds
+    BlobBuffer slice(size_t offset, size_t length) const;
+
+    // Size of the underlying file (only meaningful for map_file buffers)
+    uint64_t file_size() const { return file_size_; }
+
+private:
+    std::shared_ptr<const void> storage_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t file_size_ = 0;
+};
+
+} // namespace worker
+} // namespace beamline
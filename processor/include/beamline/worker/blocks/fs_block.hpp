@@ -2,10 +2,16 @@
 
 #include "beamline/worker/base_block_executor.hpp"
 #include <string>
+#include <vector>
 
 namespace beamline {
 namespace worker {
 
+// Directories fs.* blocks may touch. Blobs written by other blocks (e.g. spilled
+// HTTP bodies) must also live here so fs.blob_get can read them back.
+const std::vector<std::string>& fs_allowed_roots();
+bool is_fs_path_allowed(const std::string& path);
+
 class FsBlockExecutor : public BaseBlockExecutor {
 public:
     FsBlockExecutor();
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "beamline/worker/base_block_executor.hpp"
+#include "beamline/worker/http_engine.hpp"
 #include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 namespace beamline {
 namespace worker {
@@ -10,22 +17,40 @@ namespace worker {
 class HttpBlockExecutor : public BaseBlockExecutor {
 public:
     HttpBlockExecutor();
+    ~HttpBlockExecutor() override; // Aborts the transfers still in flight
     
     caf::expected<StepResult> execute_impl(const StepRequest& req, const BlockContext& ctx) override;
+    
+    // Requests are handed to the shared HttpEngine; `done` runs on the engine thread.
+    // Metrics are recorded when the owning actor calls record_async_result().
+    bool supports_async() const override { return true; }
+    void execute_async(const StepRequest& req, const BlockContext& ctx, StepCompletion done) override;
+    
+    // Aborts the engine transfer of an async step (by its "step_id" input)
+    caf::expected<void> cancel(const std::string& step_id) override;
 
 private:
-    struct HttpResponse {
-        int status_code;
-        std::string body;
-        std::string headers;
+    // Async transfers not yet completed. Shared with their completion callbacks, which
+    // remove their entry even if this executor has been destroyed in the meantime.
+    struct InFlightTransfers {
+        struct Entry {
+            std::string step_id;
+            HttpEngine::TransferId transfer_id = 0;
+        };
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> entries;
+        uint64_t next_key = 0;
     };
+    std::shared_ptr<InFlightTransfers> in_flight_ = std::make_shared<InFlightTransfers>();
+    
+    // Validates inputs and builds the engine request. Returns an error result for invalid input.
+    std::optional<StepResult> prepare_request(const StepRequest& req, const ResultMetadata& metadata,
+                                              std::chrono::steady_clock::time_point start_time,
+                                              HttpEngine::Request& http_request);
     
-    HttpResponse perform_http_request(const std::string& url, const std::string& method, 
-                                     const std::string& body, const nlohmann::json& headers, 
-                                     int64_t timeout_ms);
-                                     
-    static size_t write_callback(void* contents, size_t size, size_t nmemb, std::string* userp);
-    static size_t header_callback(char* buffer, size_t size, size_t nitems, std::string* userdata);
+    // Builds the step result; safe to call on the engine thread (touches no executor state)
+    static StepResult complete_request(HttpEngine::Response response, const ResultMetadata& metadata,
+                                       std::chrono::steady_clock::time_point start_time);
 };
 
 } // namespace worker
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "beamline/worker/base_block_executor.hpp"
+#include "beamline/worker/sqlite_pool.hpp"
+#include "beamline/worker/sql_result_encoder.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Open result sets of paged sql.query steps
+ *
+ * A page that stops at max_rows parks its statement here under an opaque token;
+ * the step that passes the token back as "cursor" (with the same connection,
+ * query and params) continues stepping it instead of running the query again.
+ * Only read-only statements are paged. A parked cursor keeps its pooled handle
+ * leased and its read snapshot open, so the table is bounded and cursors that
+ * are not continued within the idle timeout are closed the next time the table
+ * is used.
+ */
+class SqlCursorTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        size_t max_cursors = 64;         // Oldest parked cursor is closed beyond this
+        int64_t idle_timeout_ms = 60000; // Closed if not continued within this
+    };
+
+    struct Cursor {
+        Cursor() = default;
+        ~Cursor();
+        Cursor(const Cursor&) = delete;
+        Cursor& operator=(const Cursor&) = delete;
+
+        std::optional<SqliteConnectionPool::Lease> lease; // Empty on an executor-private handle
+        sqlite3_stmt* stmt = nullptr; // Finalized with the cursor; positioned on the next page's first row
+        std::string key;              // Connection, query and params it was opened with
+        size_t position = 0;          // Rows returned so far
+        Clock::time_point expires_at;
+    };
+
+    explicit SqlCursorTable(Config config);
+    ~SqlCursorTable();
+
+    SqlCursorTable(const SqlCursorTable&) = delete;
+    SqlCursorTable& operator=(const SqlCursorTable&) = delete;
+
+    // Process-wide table for cursors on pooled handles
+    static SqlCursorTable& instance();
+
+    // Stores the cursor and returns its token
+    std::string park(std::unique_ptr<Cursor> cursor, Clock::time_point now = Clock::now());
+
+    // Removes and returns the cursor; nullptr if the token is unknown, expired or was
+    // issued for a different key
+    std::unique_ptr<Cursor> take(const std::string& token, const std::string& key,
+                                 Clock::time_point now = Clock::now());
+
+    size_t size() const;
+
+private:
+    Config config_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Cursor>> cursors_;
+    std::mt19937_64 token_rng_;
+};
+
+class SqlBlockExecutor : public BaseBlockExecutor {
+public:
+    SqlBlockExecutor();
+    caf::expected<void> init(const BlockContext& ctx) override;
+    caf::expected<StepResult> execute_impl(const StepRequest& req, const BlockContext& ctx) override;
+
+private:
+    // Sandbox database, private to this executor
+    std::unique_ptr<SqliteConnection> sandbox_db_;
+    // Paged queries on the sandbox database; closed before it
+    SqlCursorTable sandbox_cursors_{SqlCursorTable::Config{}};
+    // Reused across steps so steady-state queries do not reallocate the output buffer
+    SqlResultEncoder encoder_;
+};
+
+// Bind the JSON `params` input to a prepared statement: an array binds positionally
+// (?1, ?2, ...), an object binds by name (:name, @name or $name). Throws
+// std::invalid_argument on malformed JSON or a parameter the statement does not declare.
+void bind_sql_params(sqlite3_stmt* stmt, const std::string& params_json);
+
+} // namespace worker
+} // namespace beamline
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "beamline/worker/blob_buffer.hpp"
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <chrono>
+#include <functional>
 #include <caf/actor_system.hpp>
 #include <caf/actor.hpp>
 #include <caf/behavior.hpp>
@@ -117,6 +119,8 @@ struct StepResult {
     ResultMetadata metadata;     // Trace, flow, step, tenant IDs
     int64_t latency_ms = 0;
     int32_t retries_used = 0;
+    // Zero-copy payloads for in-process consumers (e.g. mapped blobs); not serialized
+    std::unordered_map<std::string, BlobBuffer> blobs;
     
     // Helper methods for status checks
     bool is_success() const { return status == StepStatus::ok; }
@@ -220,6 +224,22 @@ public:
         return execute(req, empty_ctx);
     }
     
+    // Asynchronous execution for I/O-bound blocks. `done` may run on another thread
+    // (e.g. an I/O engine thread) and must only hand the result off; it must not touch
+    // the executor, which may be gone by then.
+    // Default implementation runs execute() inline.
+    using StepCompletion = std::function<void(caf::expected<StepResult>)>;
+    virtual bool supports_async() const { return false; }
+    virtual void execute_async(const StepRequest& req, const BlockContext& ctx, StepCompletion done) {
+        done(execute(req, ctx));
+    }
+    
+    // Called by the owning actor once an execute_async() result has been handed back to it,
+    // so executor state (metrics) is only ever updated on the actor
+    virtual void record_async_result(const StepResult& result) {
+        (void)result;
+    }
+    
     virtual caf::expected<void> cancel(const std::string& step_id) = 0;
     virtual BlockMetrics metrics() const = 0;
     virtual ResourceClass resource_class() const = 0;
@@ -242,15 +262,40 @@ struct WorkerConfig {
     int cpu_pool_size = 4;
     int gpu_pool_size = 1;
     int io_pool_size = 8;
-    int64_t max_memory_per_tenant_mb = 1024;
-    int64_t max_cpu_time_per_tenant_ms = 3600000; // 1 hour
+    int executor_pool_min = 1;           // Warm executor actors per block type and pool
+    int executor_pool_max = 0;           // Max executor actors per block type and pool (0 = pool size)
+    int64_t executor_idle_timeout_ms = 30000;
+    int http_max_host_connections = 64;  // Pooled HTTP connections per scheme+host+port
+    int http_max_idle_connections = 32;  // Keep-alive HTTP connections cached for reuse
+    int64_t http_max_body_bytes = 8 * 1024 * 1024; // In-memory HTTP body cap; larger bodies spill to disk
+    std::string fs_sync_policy = "none"; // fs.blob_put durability: none | per_write | group_commit
+    int64_t fs_group_commit_ms = 5;      // Max delay before a group commit syncs pending writes
+    int blocking_io_threads = 8;         // Threads of the shared blocking-I/O executor (fs blocks, timeouts)
+    int64_t blocking_io_max_queue = 1024; // Queued blocking operations before new ones are rejected
+    int sql_max_idle_connections = 8;    // Pooled SQLite handles kept per connection string
+    int sql_statement_cache_size = 64;   // Prepared statements cached per SQLite handle
+    std::string feature_flags_file;      // Optional NAME=value flags file; reloaded on change or SIGHUP
+    std::string log_file;                // JSON log destination; empty = stdout (ERROR to stderr)
+    int64_t log_buffer_kb = 256;         // Per-thread async log buffer
+    int64_t log_max_block_us = 0;        // Wait for log buffer space before dropping a line (0 = drop)
+    std::string pii_fields;              // Comma-separated key patterns redacted from logs; empty = defaults
+    std::string log_level = "info";      // debug | info | warn | error
+    std::string log_sampling;            // Per-message sampling, e.g. "Step execution started=1/100;Processing queued request=50/s"
+    int64_t max_memory_per_tenant_mb = 0;        // Peak heap of one step (0 = unlimited)
+    int64_t max_cpu_time_per_tenant_ms = 0;      // CPU time per quota window (0 = unlimited)
+    int64_t tenant_quota_window_ms = 3600000;    // Sliding window the per-tenant quotas apply to
+    std::string tenant_weights;          // Fair-queuing weights per tenant, e.g. "gold=4,silver=2,*=1" (default 1)
     bool sandbox_mode = false;
     std::string nats_url = "nats://localhost:4222";
     std::string prometheus_endpoint = "0.0.0.0:9090";
+    int64_t metrics_cache_ms = 0;        // Scrapes within this window share one /metrics render (0 = off)
+    std::string trace_file;              // OTLP/JSON lines file for exported spans (empty = tracing off)
+    double trace_sample_ratio = 0.01;    // Head sampling: fraction of new traces always exported
+    int64_t trace_slow_ms = 1000;        // Tail sampling: also export traces whose step took this long
     
     template <class Inspector>
     friend typename Inspector::result_type inspect(Inspector& f, WorkerConfig& config) {
-        return f(config.cpu_pool_size, config.gpu_pool_size, config.io_pool_size, config.max_memory_per_tenant_mb, config.max_cpu_time_per_tenant_ms, config.sandbox_mode, config.nats_url, config.prometheus_endpoint);
+        return f(config.cpu_pool_size, config.gpu_pool_size, config.io_pool_size, config.executor_pool_min, config.executor_pool_max, config.executor_idle_timeout_ms, config.http_max_host_connections, config.http_max_idle_connections, config.http_max_body_bytes, config.fs_sync_policy, config.fs_group_commit_ms, config.blocking_io_threads, config.blocking_io_max_queue, config.sql_max_idle_connections, config.sql_statement_cache_size, config.feature_flags_file, config.log_file, config.log_buffer_kb, config.log_max_block_us, config.pii_fields, config.log_level, config.log_sampling, config.max_memory_per_tenant_mb, config.max_cpu_time_per_tenant_ms, config.tenant_quota_window_ms, config.tenant_weights, config.sandbox_mode, config.nats_url, config.prometheus_endpoint, config.metrics_cache_ms, config.trace_file, config.trace_sample_ratio, config.trace_slow_ms);
     }
 };
 
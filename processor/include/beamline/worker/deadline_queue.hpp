@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+// Priority class of a queued step (the optional "priority" step input)
+enum class StepPriority : uint8_t { high = 0, normal = 1, low = 2 };
+
+// "high", "normal" or "low"; an empty string is normal, anything else nullopt
+inline std::optional<StepPriority> parse_step_priority(std::string_view text) {
+    if (text.empty() || text == "normal") {
+        return StepPriority::normal;
+    } else if (text == "high") {
+        return StepPriority::high;
+    } else if (text == "low") {
+        return StepPriority::low;
+    }
+    return std::nullopt;
+}
+
+/**
+ * Queue of pending steps, ordered by priority class, then earliest deadline
+ * first within a class, then arrival order among equal deadlines
+ *
+ * A binary heap of small slots pointing into a node slab: push and pop are
+ * O(log n). Entries pushed with a key (the step_id) are indexed, so erase(key)
+ * is O(1) per entry: the node is emptied and its heap slot is left behind as a
+ * tombstone that pop() skips. Tombstones are compacted once they outnumber
+ * live entries.
+ *
+ * A higher class always goes first, so a steady stream of high-priority steps
+ * can starve lower classes.
+ */
+template <class T>
+class DeadlineQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        T value;
+        StepPriority priority;
+        Clock::time_point deadline;
+        Clock::time_point enqueued_at;
+        uint64_t sequence;
+        std::string key;
+    };
+
+    // An empty key leaves the entry out of the index
+    void push(T value, StepPriority priority, Clock::time_point deadline,
+              Clock::time_point enqueued_at = Clock::now(), std::string key = {}) {
+        uint32_t node = allocate_node();
+        uint64_t sequence = next_sequence_++;
+        if (!key.empty()) {
+            index_.emplace(key, node);
+        }
+        nodes_[node].entry.emplace(Entry{std::move(value), priority, deadline, enqueued_at, sequence, std::move(key)});
+        heap_.push_back(Slot{priority, deadline, sequence, node});
+        std::push_heap(heap_.begin(), heap_.end(), &DeadlineQueue::after);
+        live_++;
+    }
+
+    // The entry pop() would return; the queue must not be empty
+    const Entry& top() const { return *nodes_[heap_.front().node].entry; }
+
+    // Remove and return the first entry; the queue must not be empty
+    Entry pop() {
+        uint32_t node = heap_.front().node;
+        std::pop_heap(heap_.begin(), heap_.end(), &DeadlineQueue::after);
+        heap_.pop_back();
+        unindex(node);
+        Entry entry = std::move(*nodes_[node].entry);
+        release_node(node);
+        live_--;
+        discard_tombstones();
+        return entry;
+    }
+
+    // Remove and return the entry pop() would return last; O(n), for shedding load
+    Entry pop_last() {
+        auto last = std::max_element(heap_.begin(), heap_.end(), [this](const Slot& a, const Slot& b) {
+            bool a_live = nodes_[a.node].entry.has_value();
+            bool b_live = nodes_[b.node].entry.has_value();
+            if (a_live != b_live) {
+                return !a_live;
+            }
+            return after(b, a);
+        });
+        uint32_t node = last->node;
+        unindex(node);
+        Entry entry = std::move(*nodes_[node].entry);
+        nodes_[node].entry.reset(); // Tombstone, like erase()
+        live_--;
+        tombstones_++;
+        discard_tombstones();
+        if (tombstones_ > kCompactThreshold && tombstones_ > live_) {
+            compact();
+        }
+        return entry;
+    }
+
+    // Remove every entry pushed under `key`, handing each to `visit` first.
+    // Returns the number removed.
+    template <class Visitor>
+    size_t erase(const std::string& key, Visitor&& visit) {
+        auto [first, last] = index_.equal_range(key);
+        size_t erased = 0;
+        for (auto it = first; it != last; ++it) {
+            auto& node = nodes_[it->second];
+            visit(*node.entry);
+            node.entry.reset(); // Tombstone until its heap slot is discarded
+            erased++;
+        }
+        if (erased == 0) {
+            return 0;
+        }
+        index_.erase(first, last);
+        live_ -= erased;
+        tombstones_ += erased;
+        discard_tombstones();
+        if (tombstones_ > kCompactThreshold && tombstones_ > live_) {
+            compact();
+        }
+        return erased;
+    }
+
+    size_t erase(const std::string& key) {
+        return erase(key, [](Entry&) {});
+    }
+
+    bool contains(const std::string& key) const { return index_.count(key) > 0; }
+    bool empty() const { return live_ == 0; }
+    size_t size() const { return live_; }
+
+private:
+    static constexpr size_t kCompactThreshold = 64;
+
+    // Heap element: the ordering fields are copied here so sifting never touches the nodes
+    struct Slot {
+        StepPriority priority;
+        Clock::time_point deadline;
+        uint64_t sequence;
+        uint32_t node;
+    };
+
+    struct Node {
+        std::optional<Entry> entry; // Empty: free, or erased and awaiting its heap slot
+    };
+
+    // Heap order: true when `a` should be dequeued after `b`
+    static bool after(const Slot& a, const Slot& b) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        if (a.deadline != b.deadline) {
+            return a.deadline > b.deadline;
+        }
+        return a.sequence > b.sequence;
+    }
+
+    uint32_t allocate_node() {
+        if (!free_nodes_.empty()) {
+            uint32_t node = free_nodes_.back();
+            free_nodes_.pop_back();
+            return node;
+        }
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void release_node(uint32_t node) {
+        nodes_[node].entry.reset();
+        free_nodes_.push_back(node);
+    }
+
+    // Drops the index record of a live node
+    void unindex(uint32_t node) {
+        const auto& key = nodes_[node].entry->key;
+        if (key.empty()) {
+            return;
+        }
+        auto [first, last] = index_.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == node) {
+                index_.erase(it);
+                return;
+            }
+        }
+    }
+
+    // Keeps the front of the heap a live entry, so top() and pop() need no checks
+    void discard_tombstones() {
+        while (!heap_.empty() && !nodes_[heap_.front().node].entry) {
+            uint32_t node = heap_.front().node;
+            std::pop_heap(heap_.begin(), heap_.end(), &DeadlineQueue::after);
+            heap_.pop_back();
+            release_node(node);
+            tombstones_--;
+        }
+    }
+
+    void compact() {
+        auto end = std::remove_if(heap_.begin(), heap_.end(), [this](const Slot& slot) {
+            if (nodes_[slot.node].entry) {
+                return false;
+            }
+            release_node(slot.node);
+            return true;
+        });
+        heap_.erase(end, heap_.end());
+        std::make_heap(heap_.begin(), heap_.end(), &DeadlineQueue::after);
+        tombstones_ = 0;
+    }
+
+    std::vector<Slot> heap_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_nodes_;
+    std::unordered_multimap<std::string, uint32_t> index_; // Key -> node
+    size_t live_ = 0;
+    size_t tombstones_ = 0;
+    uint64_t next_sequence_ = 0;
+};
+
+} // namespace worker
+} // namespace beamline
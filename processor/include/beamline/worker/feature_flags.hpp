@@ -2,8 +2,15 @@
 
 #include <string>
 #include <cstdlib>
+#include <cstdint>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace beamline {
 namespace worker {
@@ -19,9 +26,109 @@ namespace worker {
  * - CP2_COMPLETE_TIMEOUT_ENABLED
  * - CP2_QUEUE_MANAGEMENT_ENABLED
  * - CP2_OBSERVABILITY_METRICS_ENABLED
+ * 
+ * or in a flags file (one `NAME=value` per line, `#` comments) that overrides
+ * the environment. Flags are parsed once into an immutable snapshot published
+ * through an atomic pointer, so each check is a single load. reload() (or
+ * SIGHUP / a flags file change, see start_reload_watcher) swaps in a new snapshot.
  */
 class FeatureFlags {
 public:
+    struct Snapshot {
+        bool advanced_retry = false;
+        bool complete_timeout = false;
+        bool queue_management = false;
+        bool observability_metrics = false;
+        uint64_t version = 0;
+    };
+    
+    /**
+     * Current flags; the reference stays valid for the lifetime of the process
+     */
+    static const Snapshot& snapshot() {
+        const Snapshot* current = state().current.load(std::memory_order_acquire);
+        if (current == nullptr) {
+            reload();
+            current = state().current.load(std::memory_order_acquire);
+        }
+        return *current;
+    }
+    
+    /**
+     * Re-read the environment and flags file and publish a new snapshot
+     */
+    static void reload() {
+        auto& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        
+        std::unordered_map<std::string, std::string> file_values;
+        if (!st.flags_file.empty()) {
+            std::ifstream file(st.flags_file);
+            std::string line;
+            while (std::getline(file, line)) {
+                auto eq = line.find('=');
+                if (line.empty() || line[0] == '#' || eq == std::string::npos) {
+                    continue;
+                }
+                file_values[trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+            }
+        }
+        auto flag = [&](const char* name) {
+            auto it = file_values.find(name);
+            if (it != file_values.end()) {
+                return parse_bool(it->second.c_str(), false);
+            }
+            return get_env_bool(name, false);
+        };
+        
+        auto next = std::make_unique<Snapshot>();
+        next->advanced_retry = flag("CP2_ADVANCED_RETRY_ENABLED");
+        next->complete_timeout = flag("CP2_COMPLETE_TIMEOUT_ENABLED");
+        next->queue_management = flag("CP2_QUEUE_MANAGEMENT_ENABLED");
+        next->observability_metrics = flag("CP2_OBSERVABILITY_METRICS_ENABLED");
+        next->version = st.snapshots.size() + 1;
+        
+        // Old snapshots are kept: readers may still hold references, and reloads are rare
+        st.current.store(next.get(), std::memory_order_release);
+        st.snapshots.push_back(std::move(next));
+    }
+    
+    /**
+     * Set the flags file consulted by reload(); takes effect on the next reload
+     */
+    static void set_flags_file(const std::string& path) {
+        auto& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.flags_file = path;
+    }
+    
+    static std::string flags_file() {
+        auto& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        return st.flags_file;
+    }
+    
+    /**
+     * Reload on SIGHUP and whenever the flags file's modification time changes
+     * (polled every poll_interval_ms). Defined in feature_flags.cpp.
+     */
+    static void start_reload_watcher(int64_t poll_interval_ms = 1000);
+    static void stop_reload_watcher();
+    
+    /**
+     * Parse a flag value: "true"/"yes" (case-insensitive) and "1" are true
+     */
+    static bool parse_bool(const char* value, bool default_value) {
+        if (value == nullptr) {
+            return default_value;
+        }
+        
+        std::string str_value(value);
+        std::transform(str_value.begin(), str_value.end(), str_value.begin(), ::tolower);
+        
+        return (str_value == "true" || str_value == "1" || str_value == "yes");
+    }
+
     /**
      * Check if CP2 Advanced Retry features are enabled
      * 
@@ -31,7 +138,7 @@ public:
      * - Retry budget management (W3-1.4)
      */
     static bool is_advanced_retry_enabled() {
-        return get_env_bool("CP2_ADVANCED_RETRY_ENABLED", false);
+        return snapshot().advanced_retry;
     }
     
     /**
@@ -43,7 +150,7 @@ public:
      * - Total timeout across retries (W3-2.3)
      */
     static bool is_complete_timeout_enabled() {
-        return get_env_bool("CP2_COMPLETE_TIMEOUT_ENABLED", false);
+        return snapshot().complete_timeout;
     }
     
     /**
@@ -55,7 +162,7 @@ public:
      * - Queue rejection handling (W3-4.3)
      */
     static bool is_queue_management_enabled() {
-        return get_env_bool("CP2_QUEUE_MANAGEMENT_ENABLED", false);
+        return snapshot().queue_management;
     }
     
     /**
@@ -67,7 +174,7 @@ public:
      * - All Worker metrics
      */
     static bool is_observability_metrics_enabled() {
-        return get_env_bool("CP2_OBSERVABILITY_METRICS_ENABLED", false);
+        return snapshot().observability_metrics;
     }
     
 private:
@@ -82,15 +189,28 @@ private:
      * Returns `default_value` if environment variable is not set or has other value.
      */
     static bool get_env_bool(const char* env_var, bool default_value) {
-        const char* value = std::getenv(env_var);
-        if (value == nullptr) {
-            return default_value;
+        return parse_bool(std::getenv(env_var), default_value);
+    }
+    
+    struct State {
+        std::mutex mutex;
+        std::string flags_file;
+        std::atomic<const Snapshot*> current{nullptr};
+        std::vector<std::unique_ptr<Snapshot>> snapshots;
+    };
+    
+    static State& state() {
+        static State instance;
+        return instance;
+    }
+    
+    static std::string trim(const std::string& value) {
+        auto begin = value.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return "";
         }
-        
-        std::string str_value(value);
-        std::transform(str_value.begin(), str_value.end(), str_value.begin(), ::tolower);
-        
-        return (str_value == "true" || str_value == "1" || str_value == "yes");
+        auto end = value.find_last_not_of(" \t\r");
+        return value.substr(begin, end - begin + 1);
     }
 };
 
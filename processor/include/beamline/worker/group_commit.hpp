@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Durability policy for fs.blob_put
+ *
+ * - none:         rely on the page cache (no fsync)
+ * - per_write:    fdatasync() every file and fsync() its directory
+ * - group_commit: writers wait for a shared syncfs() that runs at most every
+ *                 interval_ms per filesystem, so thousands of small writes per
+ *                 second share a handful of journal commits
+ */
+enum class SyncPolicy {
+    none,
+    per_write,
+    group_commit
+};
+
+std::optional<SyncPolicy> parse_sync_policy(const std::string& name);
+std::string sync_policy_to_string(SyncPolicy policy);
+
+class GroupCommitter {
+public:
+    struct Config {
+        SyncPolicy policy = SyncPolicy::none;
+        int64_t interval_ms = 5;
+    };
+
+    explicit GroupCommitter(Config config);
+    ~GroupCommitter();
+
+    GroupCommitter(const GroupCommitter&) = delete;
+    GroupCommitter& operator=(const GroupCommitter&) = delete;
+
+    // Process-wide committer used by fs blocks; configure() only has an effect before first use
+    static void configure(Config config);
+    static GroupCommitter& instance();
+
+    SyncPolicy policy() const { return config_.policy; }
+
+    // Make the data of an open file durable. Blocks until durable under `policy`.
+    // Returns false with `error` set if the sync failed.
+    bool sync_file(int fd, SyncPolicy policy, std::string& error);
+
+    // Persist a directory entry change (e.g. rename). per_write syncs the directory
+    // immediately; group_commit folds it into the next batch without waiting.
+    bool sync_directory(const std::string& dir, SyncPolicy policy, std::string& error);
+
+    int64_t commits() const;
+
+private:
+    // Pending batch for one filesystem
+    struct Batch {
+        int fd = -1;                  // Any fd on the filesystem, used for syncfs()
+        uint64_t requested_epoch = 0; // Highest epoch a writer is waiting for
+        uint64_t committed_epoch = 0;
+        int last_error = 0;
+    };
+
+    Config config_;
+    mutable std::mutex mutex_;
+    std::condition_variable committed_cv_;
+    std::condition_variable work_cv_;
+    std::unordered_map<dev_t, Batch> batches_;
+    uint64_t epoch_ = 1;
+    int64_t commits_ = 0;
+    bool running_ = true;
+    std::thread committer_thread_;
+
+    void committer_loop();
+    bool wait_for_group_commit(int fd, std::string& error);
+};
+
+} // namespace worker
+} // namespace beamline
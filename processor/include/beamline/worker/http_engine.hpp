@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Event-driven HTTP engine on curl_multi
+ *
+ * A single I/O thread owns the multi handle and drives it from epoll, so
+ * thousands of http.request steps can be in flight without blocking
+ * scheduler threads. Because every transfer goes through the same multi
+ * handle, connections, HTTP/2 streams and resolved DNS entries are reused
+ * across steps. Keep-alive connections are pooled per scheme+host+port with
+ * per-host and idle limits; DNS and TLS session caches are additionally
+ * shared process-wide through a CURLSH handle.
+ *
+ * Completions are delivered through a callback that runs on the engine
+ * thread; callers must only hand the response off (e.g. send an actor
+ * message) and never block inside it.
+ */
+class HttpEngine {
+public:
+    struct Config {
+        long max_host_connections = 64;     // Per scheme+host+port, 0 = unlimited
+        long max_total_connections = 0;     // 0 = unlimited
+        long max_idle_connections = 32;     // Keep-alive connections cached for reuse
+        long dns_cache_timeout_s = 60;
+        bool http2 = true;                  // Negotiate HTTP/2 over TLS and multiplex streams
+        size_t max_body_in_memory = 8 * 1024 * 1024; // Per response; larger bodies spill to disk
+        std::string spill_dir = "/tmp/beamline/http/"; // Empty = fail bodies over the cap
+    };
+
+    // Connection pool statistics for one origin (scheme://host:port)
+    struct HostPoolStats {
+        int64_t requests = 0;               // Completed transfers
+        int64_t reused_connections = 0;     // Transfers served on a cached connection
+        int64_t new_connections = 0;        // Connections opened (TCP + TLS handshakes)
+        int64_t active = 0;                 // Transfers currently in flight
+        int64_t peak_active = 0;
+
+        double reuse_ratio() const {
+            return requests > 0 ? static_cast<double>(reused_connections) / static_cast<double>(requests) : 0.0;
+        }
+    };
+
+    struct PoolStats {
+        std::unordered_map<std::string, HostPoolStats> hosts;
+        int64_t requests = 0;
+        int64_t reused_connections = 0;
+        int64_t active = 0;
+        int64_t idle_handles = 0;           // Cached easy handles ready for the next transfer
+        long max_host_connections = 0;
+
+        double reuse_ratio() const {
+            return requests > 0 ? static_cast<double>(reused_connections) / static_cast<double>(requests) : 0.0;
+        }
+        // Busiest origin's in-flight transfers relative to the per-host connection limit
+        double occupancy() const;
+    };
+
+    struct Request {
+        std::string url;
+        std::string method = "GET";
+        std::string body;
+        std::vector<std::string> headers;   // "Name: value"
+        int64_t connect_timeout_ms = 0;     // 0 = curl default
+        int64_t timeout_ms = 0;             // 0 = no total timeout
+
+        // Response body streaming: at most `max_body_in_memory` bytes are buffered.
+        // Larger bodies stream into a file under `spill_dir`. Unset values use the engine config.
+        size_t max_body_in_memory = 0;      // 0 = engine default; can only lower the engine's cap
+        std::string spill_dir;              // Empty = engine default
+    };
+
+    struct Response {
+        int curl_code = 0;                  // CURLcode, 0 on success
+        std::string error;                  // curl_easy_strerror() when curl_code != 0
+        int status_code = 0;
+        std::string body;                   // Empty when the body was spilled to body_path
+        std::string body_path;              // File holding the body, set only when spilled
+        uint64_t body_size = 0;
+        std::string headers;
+
+        bool ok() const { return curl_code == 0; }
+        bool spilled() const { return !body_path.empty(); }
+        bool timed_out() const;
+    };
+
+    using Callback = std::function<void(Response)>;
+    using TransferId = uint64_t;
+
+    explicit HttpEngine(Config config);
+    ~HttpEngine();
+
+    HttpEngine(const HttpEngine&) = delete;
+    HttpEngine& operator=(const HttpEngine&) = delete;
+
+    // Process-wide engine shared by all HttpBlockExecutor instances.
+    // configure() only has an effect before the first instance() call.
+    static void configure(Config config);
+    static HttpEngine& instance();
+
+    // Queue a transfer; `on_complete` is invoked exactly once on the engine thread
+    TransferId submit(Request request, Callback on_complete);
+
+    // Abort a queued or running transfer: it is removed from the multi handle and completes
+    // with CURLE_ABORTED_BY_CALLBACK. Ids of transfers that already completed are ignored.
+    void cancel(TransferId id);
+
+    // Convenience for synchronous callers: submit and wait for the response
+    Response perform(Request request);
+
+    int64_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+
+    const Config& config() const { return config_; }
+    PoolStats pool_stats() const;
+
+    // Pool key for a URL: lowercase "scheme://host:port" with the scheme's default port filled in
+    static std::string origin_key(const std::string& url);
+
+private:
+    struct Impl;
+
+    Config config_;
+    std::unique_ptr<Impl> impl_;
+    mutable std::mutex stats_mutex_;
+    std::unordered_map<std::string, HostPoolStats> host_stats_;
+    std::thread io_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int64_t> in_flight_{0};
+
+    void io_loop();
+};
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+class IoExecutor;
+
+enum class IoTaskStatus {
+    completed,
+    timed_out,  // Deadline passed while queued or running; the caller stopped waiting
+    cancelled,
+    rejected    // Queue was full or the executor is shutting down
+};
+
+// Handle to one submitted operation, shared by the submitter and the executor
+class IoTask {
+public:
+    enum class State { queued, running, finished, cancelled };
+
+    // Polled by long-running operations; true once the task was cancelled or timed out
+    bool cancelled() const { return cancel_requested_.load(std::memory_order_acquire); }
+
+    // Request cancellation. Returns true if the task had not started and will never run.
+    bool cancel();
+
+    // Wait for the task to finish or be dropped. Returns false if the deadline passed first.
+    bool wait_until(std::chrono::steady_clock::time_point deadline);
+
+    State state() const;
+    std::chrono::steady_clock::time_point deadline() const { return deadline_; }
+
+private:
+    friend class IoExecutor;
+
+    IoExecutor* owner_ = nullptr;
+    std::function<void(const IoTask&)> operation_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::chrono::steady_clock::time_point enqueued_at_;
+    std::atomic<bool> cancel_requested_{false};
+    mutable std::mutex mutex_;
+    std::condition_variable done_cv_;
+    State state_ = State::queued;
+    bool abandoned_ = false; // Cancelled while running; counted in Stats::abandoned until it finishes
+};
+
+/**
+ * Shared, bounded executor for blocking I/O (file system, blocking syscalls)
+ *
+ * A fixed set of threads drains a bounded FIFO queue, so blocking operations
+ * never create a thread per call. Tasks carry a deadline: a task still queued
+ * at its deadline is dropped without running, and a caller waiting on a task
+ * returns at the deadline instead of blocking until the operation finishes.
+ * Running tasks are cancelled cooperatively via IoTask::cancelled().
+ */
+class IoExecutor {
+public:
+    struct Config {
+        int threads = 8;
+        size_t max_queue_depth = 1024;
+    };
+
+    struct Stats {
+        size_t queue_depth = 0;
+        size_t peak_queue_depth = 0;
+        int threads = 0;
+        int active = 0;
+        int abandoned = 0;      // Of active: cancelled or timed out, still holding their thread
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t cancelled = 0;
+        uint64_t expired = 0;   // Dropped from the queue after their deadline
+        uint64_t rejected = 0;
+        int64_t max_queue_wait_ms = 0;
+    };
+
+    explicit IoExecutor(Config config);
+    ~IoExecutor();
+
+    IoExecutor(const IoExecutor&) = delete;
+    IoExecutor& operator=(const IoExecutor&) = delete;
+
+    // Process-wide executor used by blocks; configure() only has an effect before first use
+    static void configure(Config config);
+    static IoExecutor& instance();
+
+    // Enqueue an operation. Returns nullptr if the queue is full or the executor is stopping.
+    std::shared_ptr<IoTask> submit(std::function<void(const IoTask&)> operation,
+                                   std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Run `operation` on the executor and wait until it finishes or `deadline` passes
+     *
+     * On completion the operation's value is stored in `result` and exceptions it
+     * threw are rethrown here. On timeout the task is cancelled and the caller
+     * returns immediately; a still-running operation finishes in the background
+     * and its result is discarded.
+     */
+    template<typename Result>
+    IoTaskStatus run_until(std::function<Result(const IoTask&)> operation,
+                           std::chrono::steady_clock::time_point deadline,
+                           Result& result) {
+        // Shared with the task so a late completion never touches the caller's stack
+        struct Outcome {
+            std::optional<Result> value;
+            std::exception_ptr error;
+        };
+        auto outcome = std::make_shared<Outcome>();
+
+        auto task = submit([operation = std::move(operation), outcome](const IoTask& self) {
+            try {
+                outcome->value.emplace(operation(self));
+            } catch (...) {
+                outcome->error = std::current_exception();
+            }
+        }, deadline);
+        if (!task) {
+            return IoTaskStatus::rejected;
+        }
+
+        if (!task->wait_until(deadline)) {
+            task->cancel();
+            return IoTaskStatus::timed_out;
+        }
+        if (task->state() == IoTask::State::cancelled) {
+            return std::chrono::steady_clock::now() >= deadline ? IoTaskStatus::timed_out
+                                                               : IoTaskStatus::cancelled;
+        }
+        if (outcome->error) {
+            std::rethrow_exception(outcome->error);
+        }
+        result = std::move(*outcome->value);
+        return IoTaskStatus::completed;
+    }
+
+    Stats stats() const;
+
+private:
+    friend class IoTask;
+
+    Config config_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::deque<std::shared_ptr<IoTask>> queue_;
+    std::vector<std::thread> threads_;
+    bool running_ = true;
+    Stats stats_;
+
+    void worker_loop();
+    void on_cancelled_while_queued();
+    void on_cancelled_while_running(IoTask& task);
+};
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace beamline {
+namespace worker {
+
+// Fields of one structured log line; empty CP1 fields are omitted from the output
+struct JsonLogRecord {
+    std::string_view timestamp;
+    std::string_view level;
+    std::string_view component;
+    std::string_view message;
+    std::string_view tenant_id;
+    std::string_view run_id;
+    std::string_view flow_id;
+    std::string_view step_id;
+    std::string_view trace_id;
+    std::string_view worker_id; // Always present in "context"; a context entry of the same name wins
+    const std::unordered_map<std::string, std::string>* context = nullptr;
+    uint64_t suppressed = 0;    // Lines dropped by sampling before this one; written only when non-zero
+};
+
+/**
+ * Streaming JSON encoding for log lines
+ *
+ * Writes straight into a caller-owned buffer instead of building a json DOM, so
+ * formatting a line into a reused buffer does not allocate. The output is
+ * byte-identical to nlohmann::json::dump() of the equivalent object (sorted keys,
+ * no whitespace, the same escapes) for valid UTF-8. Invalid UTF-8 bytes, on which
+ * dump() throws, are replaced with U+FFFD.
+ */
+void append_json_log_string(std::string& out, std::string_view text);
+
+// Append `record` as one JSON object (no trailing newline). Context values whose
+// key matches `is_redacted` are written as "[REDACTED]".
+void append_json_log(std::string& out, const JsonLogRecord& record, bool (*is_redacted)(std::string_view key));
+
+} // namespace worker
+} // namespace beamline
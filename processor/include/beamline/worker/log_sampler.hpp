@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Per-message-template log sampling
+ *
+ * Rules are keyed by the log message (the template; variable data lives in the
+ * CP1 fields and context). A rule keeps one line in `one_in` and/or at most
+ * `per_second` lines per second (token bucket with `burst` capacity). Lines of
+ * a template without a rule are always kept. When a line is kept after others
+ * of its template were dropped, admit() reports how many so the line can carry
+ * the count.
+ */
+class LogSampler {
+public:
+    struct Rule {
+        uint64_t one_in = 1;      // Keep every Nth line (1 = all)
+        double per_second = 0;    // Token bucket refill rate (0 = unlimited)
+        double burst = 0;         // Bucket capacity (0 = max(1, per_second))
+    };
+
+    struct Config {
+        std::unordered_map<std::string, Rule> rules;
+    };
+
+    struct Decision {
+        bool keep = true;
+        uint64_t suppressed = 0;  // Lines of this template dropped since the last kept one
+    };
+
+    explicit LogSampler(const Config& config);
+
+    LogSampler(const LogSampler&) = delete;
+    LogSampler& operator=(const LogSampler&) = delete;
+
+    // Process-wide sampler used by Observability; configure() only has an effect before first use
+    static void configure(Config config);
+    static LogSampler& instance();
+
+    /**
+     * Parse rules of the form `template=spec;template=spec` where spec is `1/N`,
+     * `R/s` or both separated by a comma (`1/10,50/s`). Throws std::invalid_argument.
+     */
+    static Config parse_rules(const std::string& rules);
+
+    Decision admit(const std::string& message);
+
+private:
+    struct State {
+        Rule rule;
+        std::atomic<uint64_t> seen{0};
+        std::atomic<uint64_t> suppressed{0};
+        std::mutex bucket_mutex;
+        double tokens = 0;
+        int64_t refilled_at_ns = 0;
+    };
+
+    bool take_token(State& state);
+
+    // Built once; lookups never modify the map
+    std::unordered_map<std::string, std::unique_ptr<State>> states_;
+};
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sched.h>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Lock-free metrics registry
+ *
+ * Counters, gauges and fixed-bucket histograms exported in the Prometheus text
+ * or OpenMetrics format. A series (one label-value combination of a family) is
+ * interned when first used: its label values and the `{...}` label blocks of its
+ * sample lines (one per histogram bucket, `le` included) are rendered once, and
+ * the returned handle points straight at its cells. Counters and histograms keep one
+ * cache-line-aligned shard per CPU, so recording is a relaxed atomic add that
+ * concurrent writers do not contend on; the shards are summed when rendering.
+ *
+ * Resolving a handle from label values hashes them and probes a lock-free table,
+ * without allocating. Only the first use of a new combination takes the family's
+ * mutex. Hot call sites with fixed labels keep the handle instead.
+ *
+ * Cardinality is bounded: label names that identify a single run or request are
+ * rejected at registration (record them as exemplars instead), and a family that
+ * reaches its series limit records new combinations into one overflow series.
+ * Each handle resolved to it counts a sample in metrics_dropped_samples_total,
+ * so a combination written again is counted again.
+ */
+class MetricsRegistry {
+    struct Series;
+
+public:
+    enum class MetricType { counter, gauge, histogram };
+
+    // Exposition format; OpenMetrics adds exemplars and the `# EOF` terminator
+    enum class Format { prometheus, openmetrics };
+
+    struct Options {
+        size_t shards = 0;                   // Per-CPU shards per series (0 = one per CPU, max 64)
+        size_t max_series_per_family = 4096; // Further label combinations go to the overflow series
+        // Label names add_family() rejects because their values are unbounded
+        std::vector<std::string> unbounded_labels = {"run_id", "flow_id", "step_id", "trace_id",
+                                                     "span_id", "request_id"};
+    };
+
+    using LabelValues = std::initializer_list<std::string_view>;
+    using LabelPairs = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+    // Label values of the series that absorbs combinations beyond a family's limit
+    static constexpr std::string_view OVERFLOW_LABEL_VALUE = "__overflow__";
+
+    // The most recent exemplar of a counter or histogram bucket (OpenMetrics)
+    struct Exemplar {
+        std::string labels;      // Escaped `name="value"` pairs, at most 128 bytes
+        double value = 0;
+        double timestamp = 0;    // Unix time in seconds
+    };
+
+    class Counter {
+    public:
+        Counter() = default;
+        void inc(uint64_t amount = 1) const {
+            if (series_) {
+                series_->cell(series_->shard(), 0).fetch_add(amount, std::memory_order_relaxed);
+            }
+        }
+        // Also keep `exemplar` (pairs with empty values are skipped) as the series' exemplar
+        void inc(uint64_t amount, LabelPairs exemplar) const;
+        uint64_t value() const;
+        std::optional<Exemplar> exemplar() const;
+        explicit operator bool() const { return series_ != nullptr; }
+
+    private:
+        friend class MetricsRegistry;
+        explicit Counter(Series* series) : series_(series) {}
+        Series* series_ = nullptr;
+    };
+
+    class Gauge {
+    public:
+        Gauge() = default;
+        void set(double value) const {
+            if (series_) {
+                series_->cell(0, 0).store(std::bit_cast<uint64_t>(value), std::memory_order_relaxed);
+            }
+        }
+        void add(double delta) const {
+            if (series_) {
+                add_double(series_->cell(0, 0), delta);
+            }
+        }
+        double value() const;
+        explicit operator bool() const { return series_ != nullptr; }
+
+    private:
+        friend class MetricsRegistry;
+        explicit Gauge(Series* series) : series_(series) {}
+        Series* series_ = nullptr;
+    };
+
+    class Histogram {
+    public:
+        Histogram() = default;
+        void observe(double value) const;
+        // Also keep `exemplar` as the exemplar of the bucket `value` falls into
+        void observe(double value, LabelPairs exemplar) const;
+        uint64_t count() const;
+        double sum() const;
+        // `bucket` indexes the family's buckets; the last one is +Inf
+        std::optional<Exemplar> exemplar(size_t bucket) const;
+        explicit operator bool() const { return series_ != nullptr; }
+
+    private:
+        friend class MetricsRegistry;
+        explicit Histogram(Series* series) : series_(series) {}
+        Series* series_ = nullptr;
+    };
+
+    class Family {
+    public:
+        Family(const Family&) = delete;
+        Family& operator=(const Family&) = delete;
+
+        // Handles for one label-value combination, in label_names order. Throw
+        // std::logic_error if the family has another type or the count is wrong.
+        // When the family is full, new combinations get the overflow series.
+        Counter counter(LabelValues values) { return Counter(resolve(MetricType::counter, values)); }
+        Gauge gauge(LabelValues values) { return Gauge(resolve(MetricType::gauge, values)); }
+        Histogram histogram(LabelValues values) { return Histogram(resolve(MetricType::histogram, values)); }
+
+        const std::string& name() const { return name_; }
+        MetricType type() const { return type_; }
+        size_t series_count() const;
+
+    private:
+        friend class MetricsRegistry;
+        Family() = default;
+
+        Series* resolve(MetricType type, LabelValues values);
+        Series* find(uint64_t hash, LabelValues values) const;
+        Series* overflow();
+        std::unique_ptr<Series> make_series(uint64_t hash, std::vector<std::string> values) const;
+        void render(std::string& out, Format format, Exemplar& exemplar) const;
+
+        MetricsRegistry* registry_ = nullptr;
+        std::string name_;
+        std::string help_;
+        MetricType type_ = MetricType::counter;
+        std::vector<std::string> label_names_;
+        std::string const_label_text_;   // Escaped `name="value"` pairs shared by every series
+        std::vector<double> buckets_;    // Histogram upper bounds, ascending, without +Inf
+        size_t max_series_ = 0;
+        std::string headers_[2];         // `# HELP` / `# TYPE` lines per Format
+        std::string counter_sample_[2];  // Counter sample name per Format (OpenMetrics needs `_total`)
+
+        // Open-addressing table of interned series; slots are published once and never change
+        std::unique_ptr<std::atomic<Series*>[]> slots_;
+        size_t slot_mask_ = 0;
+        std::atomic<size_t> series_count_{0};
+        std::atomic<Series*> overflow_{nullptr}; // Created on first overflow
+
+        mutable std::mutex mutex_;       // Guards series_ and overflow_ creation, and rendering
+        std::vector<std::unique_ptr<Series>> series_;
+        std::unique_ptr<Series> overflow_owner_;
+    };
+
+    MetricsRegistry() : MetricsRegistry(Options()) {}
+    explicit MetricsRegistry(Options options);
+    ~MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /**
+     * Register a family. Throws std::invalid_argument for a duplicate or invalid
+     * name, an unbounded label name, or a histogram whose buckets are empty or not
+     * strictly ascending. `max_series` overrides the registry's per-family limit
+     * (0 = default). Families live as long as the registry.
+     */
+    Family& add_family(MetricType type,
+                       const std::string& name,
+                       const std::string& help,
+                       std::vector<std::string> label_names = {},
+                       std::vector<double> buckets = {},
+                       const std::vector<std::pair<std::string, std::string>>& const_labels = {},
+                       size_t max_series = 0);
+
+    // Append every family that has series, sorted by name. Nothing is cleared, so a
+    // caller that reuses `out` across scrapes keeps its capacity.
+    void render(std::string& out, Format format = Format::prometheus) const;
+
+    size_t shard_count() const { return shard_mask_ + 1; }
+
+private:
+    // One cache line of cells; a shard is a whole number of lines so shards never share one
+    struct alignas(64) CacheLine {
+        std::atomic<uint64_t> cells[8];
+    };
+
+    // Seqlock-protected copy of the latest exemplar; writers that find it busy skip the update
+    struct ExemplarSlot {
+        static constexpr size_t MAX_LABEL_BYTES = 128;
+        std::atomic<uint64_t> sequence{0};   // Odd while being written
+        std::atomic<uint64_t> value_bits{0};
+        std::atomic<int64_t> timestamp_us{0};
+        std::atomic<uint64_t> length{0};
+        std::atomic<uint64_t> words[MAX_LABEL_BYTES / 8] = {};
+    };
+
+    struct Series {
+        ~Series() { delete[] exemplars.load(std::memory_order_relaxed); }
+
+        const Family* family = nullptr;
+        uint64_t hash = 0;
+        std::vector<std::string> label_values;
+        std::string label_text;          // Escaped label pairs; empty values are omitted
+        // `{labels} ` (or a single space) of each sample line, concatenated: the plain
+        // block first, then one per histogram bucket with its `le` label
+        std::string label_blocks;
+        std::vector<uint32_t> block_ends;
+
+        std::string_view label_block(size_t index) const {
+            size_t begin = index == 0 ? 0 : block_ends[index - 1];
+            return std::string_view(label_blocks).substr(begin, block_ends[index] - begin);
+        }
+        size_t shard_mask = 0;           // Gauges have a single shard
+        size_t lines_per_shard = 1;
+        std::unique_ptr<CacheLine[]> lines;
+        size_t exemplar_count = 1;       // One per counter, one per histogram bucket
+        std::atomic<ExemplarSlot*> exemplars{nullptr}; // Allocated on the first exemplar
+
+        std::atomic<uint64_t>& cell(size_t shard, size_t index) const {
+            return lines[shard * lines_per_shard + index / 8].cells[index % 8];
+        }
+
+        size_t shard() const {
+#ifdef __linux__
+            int cpu = sched_getcpu();
+            if (cpu >= 0) {
+                return static_cast<size_t>(cpu) & shard_mask;
+            }
+#endif
+            return thread_slot() & shard_mask;
+        }
+    };
+
+    static size_t thread_slot();
+    static void write_exemplar(Series& series, size_t index, double value, LabelPairs labels);
+    static std::optional<Exemplar> read_exemplar(const Series& series, size_t index);
+    // Reads into `out`, reusing its label buffer; false if there is no exemplar
+    static bool read_exemplar(const Series& series, size_t index, Exemplar& out);
+
+    // Doubles are stored as their bit pattern so the cells can be plain integer atomics
+    static void add_double(std::atomic<uint64_t>& cell, double delta) {
+        uint64_t current = cell.load(std::memory_order_relaxed);
+        while (!cell.compare_exchange_weak(current, std::bit_cast<uint64_t>(std::bit_cast<double>(current) + delta),
+                                           std::memory_order_relaxed)) {
+        }
+    }
+
+    Options options_;
+    size_t shard_mask_ = 0;
+    mutable std::mutex mutex_;           // Guards families_
+    std::map<std::string, std::unique_ptr<Family>> families_;
+    Family* dropped_samples_family_ = nullptr;
+};
+
+} // namespace worker
+} // namespace beamline
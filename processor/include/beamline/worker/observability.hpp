@@ -1,25 +1,125 @@
 #pragma once
 
 #include "beamline/worker/core.hpp"
-// #include <prometheus/counter.h>
-// #include <prometheus/gauge.h>
-// #include <prometheus/histogram.h>
-// #include <prometheus/registry.h>
+#include "beamline/worker/metrics_registry.hpp"
+#include "beamline/worker/admin_server.hpp"
 // #include <opentelemetry/trace/tracer.h>
+#include <array>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <atomic>
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 namespace beamline {
 namespace worker {
 
+enum class LogLevel { debug = 0, info = 1, warn = 2, error = 3 };
+
+// "debug", "info", "warn"/"warning", "error" (case-insensitive)
+std::optional<LogLevel> parse_log_level(const std::string& name);
+const char* log_level_name(LogLevel level);
+
+class Observability;
+
+// Samples another component's state into metrics; see Observability::add_metrics_collector
+using MetricsCollector = std::function<void(Observability&)>;
+
 class Observability {
 public:
-    Observability(const std::string& worker_id);
+    /**
+     * Metric families recorded into by Observability instances
+     *
+     * The worker keeps one set per process (shared_metrics()): the worker actor, pools
+     * and executors each hold an Observability, and what they record is served by the
+     * admin endpoint's /metrics whichever instance runs it. Families are registered
+     * once, when the set is created. A set given a `worker_id` carries it as a constant
+     * label on the CP1 families; the shared set has none, since the instances recording
+     * into it have different ids.
+     */
+    struct Metrics {
+        explicit Metrics(const std::string& worker_id = "");
+        
+        MetricsRegistry registry;
+        
+        // Metrics (CP1 - legacy)
+        MetricsRegistry::Family* task_total_family = nullptr;
+        MetricsRegistry::Family* task_latency_family = nullptr;
+        MetricsRegistry::Family* resource_usage_family = nullptr;
+        MetricsRegistry::Family* pool_queue_depth_family = nullptr;
+        std::array<MetricsRegistry::Gauge, 3> pool_queue_depth_gauges; // Pre-resolved, indexed by ResourceClass
+        
+        // CP2 Wave 1 Metrics
+        MetricsRegistry::Family* step_executions_total_family = nullptr;
+        MetricsRegistry::Family* step_execution_duration_seconds_family = nullptr;
+        MetricsRegistry::Family* step_errors_total_family = nullptr;
+        MetricsRegistry::Family* flow_execution_duration_seconds_family = nullptr;
+        MetricsRegistry::Family* queue_depth_family = nullptr;
+        MetricsRegistry::Family* queue_wait_seconds_family = nullptr;
+        MetricsRegistry::Family* queue_time_ratio_family = nullptr;
+        MetricsRegistry::Family* active_tasks_family = nullptr;
+        MetricsRegistry::Family* executors_family = nullptr;
+        MetricsRegistry::Family* idle_executors_family = nullptr;
+        MetricsRegistry::Family* tenant_queue_depth_family = nullptr;
+        MetricsRegistry::Family* tenant_queue_wait_seconds_family = nullptr;
+        MetricsRegistry::Family* tenant_usage_ms_total_family = nullptr;
+        MetricsRegistry::Family* tenant_cpu_time_us_total_family = nullptr;
+        MetricsRegistry::Family* tenant_allocated_bytes_total_family = nullptr;
+        MetricsRegistry::Family* tenant_throttled_family = nullptr;
+        MetricsRegistry::Family* health_status_family = nullptr;
+        
+        // Shared HTTP connection pool, sampled at scrape time
+        MetricsRegistry::Counter http_requests_total;
+        MetricsRegistry::Counter http_reused_connections_total;
+        MetricsRegistry::Gauge http_connection_reuse_ratio;
+        MetricsRegistry::Gauge http_active_transfers;
+        MetricsRegistry::Gauge http_idle_handles;
+        MetricsRegistry::Gauge http_pool_occupancy;
+        
+        // Shared blocking-I/O executor, sampled at scrape time (queue depth and active
+        // threads are the "blocking_io" series of worker_queue_depth and worker_active_tasks)
+        MetricsRegistry::Counter blocking_io_expired_total;
+        MetricsRegistry::Counter blocking_io_rejected_total;
+        MetricsRegistry::Gauge blocking_io_max_queue_wait_ms;
+        MetricsRegistry::Gauge blocking_io_abandoned;
+        
+        // Async logger, sampled at scrape time
+        MetricsRegistry::Counter log_lines_written_total;
+        MetricsRegistry::Counter log_lines_dropped_total;
+        MetricsRegistry::Counter log_write_calls_total;
+        
+        // Totals last copied into the counters above (see set_http_pool_stats)
+        std::atomic<uint64_t> http_requests_sampled{0};
+        std::atomic<uint64_t> http_reused_connections_sampled{0};
+        std::atomic<uint64_t> blocking_io_expired_sampled{0};
+        std::atomic<uint64_t> blocking_io_rejected_sampled{0};
+        std::atomic<uint64_t> log_lines_written_sampled{0};
+        std::atomic<uint64_t> log_lines_dropped_sampled{0};
+        std::atomic<uint64_t> log_write_calls_sampled{0};
+        
+        std::mutex collectors_mutex;
+        std::vector<MetricsCollector> collectors;
+    };
+    
+    // The process-wide set, created by the first call
+    static std::shared_ptr<Metrics> shared_metrics();
+    
+    // Records into shared_metrics()
+    explicit Observability(const std::string& worker_id);
+    // Records into `metrics`, e.g. a private set in tests
+    Observability(const std::string& worker_id, std::shared_ptr<Metrics> metrics);
     ~Observability();
     
+    // Log level threshold (process-wide, default info). Lines below it return before any
+    // formatting; hot call sites check is_log_enabled() before building their context.
+    static void set_log_level(LogLevel level) { min_log_level_.store(level, std::memory_order_relaxed); }
+    static bool is_log_enabled(LogLevel level) { return level >= min_log_level_.load(std::memory_order_relaxed); }
+    
     // Metrics (CP1 - legacy)
     void increment_task_total(const std::string& block_type, const std::string& status);
     void record_task_latency(const std::string& block_type, int64_t latency_ms);
@@ -56,15 +156,56 @@ public:
     
     void set_queue_depth(const std::string& resource_pool, int64_t depth);
     
+    // Time a step waited in its pool's pending queue, and that wait as a share (0..1) of its latency
+    void record_queue_time(const std::string& resource_pool, double wait_seconds, double latency_share);
+    
     void set_active_tasks(const std::string& resource_pool, int64_t count);
     
+    // Executor actors a pool has spawned, and those of them parked warm for reuse
+    void set_executor_counts(const std::string& resource_pool, int64_t live, int64_t idle);
+    
+    // Per-tenant pending-queue depth and wait, and executor time used (fair-queuing inputs)
+    void set_tenant_queue_depth(const std::string& resource_pool, const std::string& tenant_id, int64_t depth);
+    void record_tenant_queue_wait(const std::string& resource_pool, const std::string& tenant_id, double wait_seconds);
+    void add_tenant_usage(const std::string& resource_pool, const std::string& tenant_id, double usage_ms);
+    
+    // Per-tenant measured CPU time and heap allocations of completed steps, and quota throttling
+    void add_tenant_resource_usage(const std::string& tenant_id, int64_t cpu_time_ns, int64_t allocated_bytes);
+    void set_tenant_throttled(const std::string& resource_pool, const std::string& tenant_id, bool throttled);
+    
     void set_health_status(const std::string& check, int64_t status); // 1 = healthy, 0 = unhealthy
     
-    // CP2 Wave 1 Metrics Endpoint (gated behind CP2_OBSERVABILITY_METRICS_ENABLED)
-    void start_metrics_endpoint(const std::string& address, uint16_t port);
-    void stop_metrics_endpoint();
-    std::string get_metrics_response(); // Prometheus text format
+    // Run `collector` before every /metrics render that is not served from the cache, to
+    // sample components that keep their own statistics. Collectors are kept with the metric
+    // families, so they apply to every instance recording into them.
+    void add_metrics_collector(MetricsCollector collector);
+    
+    // Shared HTTP connection pool: completed transfers and those served on a cached connection
+    // (totals since start), transfers in flight, cached easy handles, and the busiest origin's
+    // in-flight transfers relative to the per-host connection limit
+    void set_http_pool_stats(int64_t requests, int64_t reused_connections, int64_t active_transfers,
+                             int64_t idle_handles, double occupancy);
+    
+    // Shared blocking-I/O executor: queued and running operations, operations dropped at their
+    // deadline or refused by a full queue (totals since start), and the longest queue wait seen
+    void set_blocking_io_stats(int64_t queue_depth, int64_t active, uint64_t expired, uint64_t rejected,
+                               int64_t max_queue_wait_ms, int64_t abandoned = 0);
+    
+    // Async logger: lines written, lines dropped because a thread's ring was full, and
+    // write syscalls issued (totals since start)
+    void set_logger_stats(uint64_t written, uint64_t dropped, uint64_t write_calls);
+    
+    // CP2 Wave 1 Metrics (gated behind CP2_OBSERVABILITY_METRICS_ENABLED), served at /metrics.
+    // Rendered into a buffer kept per format; scrapes within the cache window of the last
+    // render (set_metrics_cache_ms, 0 = off) share its output instead of rendering again.
+    std::string get_metrics_response(MetricsRegistry::Format format = MetricsRegistry::Format::prometheus);
+    void set_metrics_cache_ms(int64_t cache_ms) { metrics_cache_ms_.store(cache_ms, std::memory_order_relaxed); }
     std::string get_health_response(); // JSON health status
+    std::string get_readiness_response(); // JSON readiness status
+    
+    // Readiness reported by /ready (503 until set_ready(true), e.g. once the worker actor is up)
+    void set_ready(bool ready) { ready_.store(ready, std::memory_order_release); }
+    bool is_ready() const { return ready_.load(std::memory_order_acquire); }
     
     // Tracing
     /*
@@ -128,60 +269,61 @@ public:
                                 const BlockContext& ctx,
                                 const std::unordered_map<std::string, std::string>& context = {});
     
-    // Prometheus registry access
-    // std::shared_ptr<prometheus::Registry> registry() { return registry_; }
+    // Metrics registry access
+    MetricsRegistry& registry() { return metrics_->registry; }
+    
+    // Admin HTTP endpoint: /health (and CP1 /_health), /ready and /metrics on one port
+    void start_admin_endpoint(const std::string& address, uint16_t port,
+                              AdminServer::Config config = AdminServer::Config());
+    void stop_admin_endpoint();
+    uint16_t admin_port() const; // Bound port, 0 when not running
     
-    // Health endpoint
-    void start_health_endpoint(const std::string& address, uint16_t port);
-    void stop_health_endpoint();
+    // Health endpoint (CP1 name for the admin endpoint)
+    void start_health_endpoint(const std::string& address, uint16_t port) { start_admin_endpoint(address, port); }
+    void stop_health_endpoint() { stop_admin_endpoint(); }
     
 private:
     std::string worker_id_;
-/*
-    std::shared_ptr<prometheus::Registry> registry_;
-    
-    // Metrics (CP1 - legacy)
-    prometheus::Family<prometheus::Counter>* task_total_family_;
-    prometheus::Family<prometheus::Histogram>* task_latency_family_;
-    prometheus::Family<prometheus::Gauge>* resource_usage_family_;
-    prometheus::Family<prometheus::Gauge>* pool_queue_depth_family_;
-    
-    // CP2 Wave 1 Metrics
-    prometheus::Family<prometheus::Counter>* step_executions_total_family_;
-    prometheus::Family<prometheus::Histogram>* step_execution_duration_seconds_family_;
-    prometheus::Family<prometheus::Counter>* step_errors_total_family_;
-    prometheus::Family<prometheus::Histogram>* flow_execution_duration_seconds_family_;
-    prometheus::Family<prometheus::Gauge>* queue_depth_family_;
-    prometheus::Family<prometheus::Gauge>* active_tasks_family_;
-    prometheus::Family<prometheus::Gauge>* health_status_family_;
-*/
+    std::shared_ptr<Metrics> metrics_;
     
     // Tracer
     // std::shared_ptr<opentelemetry::trace::Tracer> tracer_;
     
-    // Health endpoint
-    std::thread health_server_thread_;
-    std::atomic<bool> health_server_running_{false};
-    int health_server_socket_{-1};
+    // Last /metrics render per MetricsRegistry::Format; the body doubles as the reused buffer
+    struct MetricsCache {
+        std::mutex mutex;
+        std::string body;
+        std::chrono::steady_clock::time_point rendered_at;
+        bool valid = false;
+    };
+    std::array<MetricsCache, 2> metrics_cache_;
+    std::atomic<int64_t> metrics_cache_ms_{0};
     
-    // CP2 Wave 1 Metrics endpoint (port 9092)
-    std::thread metrics_server_thread_;
-    std::atomic<bool> metrics_server_running_{false};
-    int metrics_server_socket_{-1};
+    // Admin endpoint (health, readiness, metrics)
+    std::unique_ptr<AdminServer> admin_server_;
+    std::atomic<bool> ready_{false};
     
-    void initialize_metrics();
-    void initialize_cp2_metrics(); // CP2 Wave 1 metrics initialization
     void initialize_tracing();
-    void health_server_loop(int socket_fd);
-    void metrics_server_loop(int socket_fd); // CP2 Wave 1 metrics endpoint
-    std::string format_json_log(const std::string& level,
-                                 const std::string& message,
-                                 const std::string& tenant_id,
-                                 const std::string& run_id,
-                                 const std::string& flow_id,
-                                 const std::string& step_id,
-                                 const std::string& trace_id,
-                                 const std::unordered_map<std::string, std::string>& context);
+    static inline std::atomic<LogLevel> min_log_level_{LogLevel::info};
+    
+    void write_log(LogLevel level,
+                   const std::string& message,
+                   const std::string& tenant_id,
+                   const std::string& run_id,
+                   const std::string& flow_id,
+                   const std::string& step_id,
+                   const std::string& trace_id,
+                   const std::unordered_map<std::string, std::string>& context);
+    // Formats into a thread-local buffer; the reference is valid until the thread's next call
+    const std::string& format_json_log(const std::string& level,
+                                       const std::string& message,
+                                       const std::string& tenant_id,
+                                       const std::string& run_id,
+                                       const std::string& flow_id,
+                                       const std::string& step_id,
+                                       const std::string& trace_id,
+                                       const std::unordered_map<std::string, std::string>& context,
+                                       uint64_t suppressed = 0);
 };
 
 } // namespace worker
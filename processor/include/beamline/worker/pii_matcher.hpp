@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Case-insensitive PII key matcher
+ *
+ * A key is PII if it contains any of the configured patterns (so "user_email"
+ * and "X-Api_Key" match "email" and "api_key"). The patterns are compiled once
+ * into an Aho-Corasick automaton over a compressed byte alphabet with ASCII case
+ * folded in, so matches() is one table lookup per key byte with no copies and no
+ * allocation, regardless of how many patterns there are.
+ *
+ * The process-wide matcher is shared by the worker's Observability and the ingress
+ * logger; configure() sets its pattern list at startup, before the first log line.
+ */
+class PiiMatcher {
+public:
+    static const std::vector<std::string>& default_patterns() {
+        static const std::vector<std::string> patterns = {
+            "password", "api_key", "secret", "token", "access_token",
+            "refresh_token", "authorization", "credit_card", "ssn",
+            "email", "phone"
+        };
+        return patterns;
+    }
+
+    explicit PiiMatcher(const std::vector<std::string>& patterns = default_patterns()) {
+        // Alphabet: one class per distinct (lowercased) pattern byte, 0 for everything else
+        classes_.fill(0);
+        class_count_ = 1;
+        for (const auto& pattern : patterns) {
+            for (char ch : pattern) {
+                auto c = fold(static_cast<unsigned char>(ch));
+                if (classes_[c] == 0) {
+                    classes_[c] = static_cast<uint16_t>(class_count_);
+                    if (c >= 'a' && c <= 'z') {
+                        classes_[c - 'a' + 'A'] = static_cast<uint16_t>(class_count_);
+                    }
+                    class_count_++;
+                }
+            }
+        }
+
+        // Trie of the patterns; -1 marks a missing edge until the automaton is completed
+        std::vector<int32_t> next(class_count_, -1);
+        std::vector<bool> accepting(1, false);
+        for (const auto& pattern : patterns) {
+            if (pattern.empty()) {
+                continue;
+            }
+            size_t state = 0;
+            for (char ch : pattern) {
+                size_t edge = state * class_count_ + classes_[static_cast<unsigned char>(ch)];
+                if (next[edge] < 0) {
+                    next[edge] = static_cast<int32_t>(accepting.size());
+                    next.resize(next.size() + class_count_, -1);
+                    accepting.push_back(false);
+                }
+                state = static_cast<size_t>(next[edge]);
+            }
+            accepting[state] = true;
+            patterns_.push_back(pattern);
+        }
+        if (accepting.size() > STATE_MASK) {
+            throw std::invalid_argument("PII pattern list is too large");
+        }
+
+        // Breadth-first: missing edges follow the failure link, so every state has a
+        // transition for every class; a state is accepting if any suffix of it is
+        std::vector<int32_t> fail(accepting.size(), 0);
+        std::vector<size_t> queue;
+        for (size_t c = 0; c < class_count_; c++) {
+            if (next[c] < 0) {
+                next[c] = 0;
+            } else {
+                queue.push_back(static_cast<size_t>(next[c]));
+            }
+        }
+        for (size_t i = 0; i < queue.size(); i++) {
+            size_t state = queue[i];
+            auto failure = static_cast<size_t>(fail[state]);
+            accepting[state] = accepting[state] || accepting[failure];
+            for (size_t c = 0; c < class_count_; c++) {
+                int32_t& target = next[state * class_count_ + c];
+                int32_t fallback = next[failure * class_count_ + c];
+                if (target < 0) {
+                    target = fallback;
+                } else {
+                    fail[static_cast<size_t>(target)] = fallback;
+                    queue.push_back(static_cast<size_t>(target));
+                }
+            }
+        }
+
+        // Transitions into an accepting state carry a flag bit, so matching needs one load per byte
+        transitions_.reserve(next.size());
+        for (int32_t target : next) {
+            auto entry = static_cast<uint16_t>(target);
+            transitions_.push_back(accepting[static_cast<size_t>(target)] ? static_cast<uint16_t>(entry | ACCEPT_FLAG)
+                                                                         : entry);
+        }
+    }
+
+    bool matches(std::string_view key) const {
+        size_t state = 0;
+        for (char ch : key) {
+            uint16_t entry = transitions_[state * class_count_ + classes_[static_cast<unsigned char>(ch)]];
+            if (entry & ACCEPT_FLAG) {
+                return true;
+            }
+            state = entry;
+        }
+        return false;
+    }
+
+    const std::vector<std::string>& patterns() const { return patterns_; }
+
+    /**
+     * Set the pattern list of the process-wide matcher; only has an effect before
+     * instance() is first called. An empty list keeps the defaults.
+     */
+    static void configure(std::vector<std::string> patterns) {
+        auto& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.patterns = std::move(patterns);
+    }
+
+    static const PiiMatcher& instance() {
+        static const PiiMatcher matcher{[] {
+            auto& st = state();
+            std::lock_guard<std::mutex> lock(st.mutex);
+            return st.patterns.empty() ? default_patterns() : st.patterns;
+        }()};
+        return matcher;
+    }
+
+    /**
+     * Parse a comma-separated pattern list ("password, api_key,ssn"); blanks are skipped
+     */
+    static std::vector<std::string> parse_list(const std::string& list) {
+        std::vector<std::string> patterns;
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            auto begin = list.find_first_not_of(" \t", start);
+            auto last = list.find_last_not_of(" \t", end - 1);
+            if (begin != std::string::npos && begin < end && last != std::string::npos && last >= begin) {
+                patterns.push_back(list.substr(begin, last - begin + 1));
+            }
+            start = end + 1;
+        }
+        return patterns;
+    }
+
+private:
+    static constexpr uint16_t ACCEPT_FLAG = 0x8000;
+    static constexpr size_t STATE_MASK = 0x7FFF;
+
+    static unsigned char fold(unsigned char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+    }
+
+    struct State {
+        std::mutex mutex;
+        std::vector<std::string> patterns;
+    };
+
+    static State& state() {
+        static State instance;
+        return instance;
+    }
+
+    std::array<uint16_t, 256> classes_{};
+    size_t class_count_ = 1;
+    std::vector<uint16_t> transitions_;
+    std::vector<std::string> patterns_;
+};
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * CPU time and heap use of the calling thread over a scope, for per-step accounting
+ *
+ * CPU time is CLOCK_THREAD_CPUTIME_ID. Heap use comes from per-thread counters
+ * kept by the global operator new/delete replacements in resource_meter.cpp:
+ * bytes allocated, and the peak of bytes allocated minus bytes freed on this
+ * thread. Memory freed here that another thread allocated lowers that balance,
+ * so the peak is a lower bound of what the scope held. malloc/free calls that
+ * bypass operator new (C libraries) are not counted.
+ *
+ * Meters nest: an inner meter restores the outer one's peak when destroyed.
+ * A meter must be read and destroyed on the thread that created it.
+ */
+class ResourceMeter {
+public:
+    struct Usage {
+        int64_t cpu_time_ns = 0;
+        int64_t allocated_bytes = 0;
+        int64_t peak_heap_bytes = 0; // Highest heap balance above the start, 0 if it never rose
+    };
+
+    ResourceMeter();
+    ~ResourceMeter();
+
+    ResourceMeter(const ResourceMeter&) = delete;
+    ResourceMeter& operator=(const ResourceMeter&) = delete;
+
+    // Usage since construction
+    Usage elapsed() const;
+
+    static int64_t thread_cpu_time_ns();
+
+    // Heap bytes allocated and currently held (allocated minus freed) by this thread
+    static int64_t thread_allocated_bytes();
+    static int64_t thread_heap_balance();
+
+private:
+    int64_t start_cpu_ns_;
+    int64_t start_allocated_;
+    int64_t start_balance_;
+    int64_t saved_peak_; // The enclosing scope's peak, restored on destruction
+};
+
+} // namespace worker
+} // namespace beamline
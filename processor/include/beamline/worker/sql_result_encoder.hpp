@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Encodes sql.query result rows straight from sqlite3_column_* into one buffer
+ *
+ * Formats:
+ * - rows:     [{"col":"value",...},...] - the original sql.query shape (text
+ *             values, NULL columns omitted), now properly escaped
+ * - columnar: {"columns":["a","b"],"rows":[[1,"x"],[2,null]]} - names written
+ *             once, typed values (numbers, strings, null, base64 blobs)
+ * - binary:   compact length-prefixed encoding, see below
+ *
+ * Binary layout (integers are unsigned LEB128 varints unless noted):
+ *   "BLSQ" u8 version=1, column_count, {name_len, name bytes} * column_count,
+ *   then per row: u8 1, then per cell u8 type + payload:
+ *     0 null | 1 integer (zigzag varint) | 2 float (8 bytes, little endian)
+ *     | 3 text (len, bytes) | 4 blob (len, bytes)
+ *   terminated by u8 0.
+ *
+ * A binary result is returned base64-encoded (see append_buffer_base64),
+ * since step outputs are strings.
+ *
+ * The buffer keeps its capacity across reset(), so an encoder owned by an
+ * executor does not reallocate once it has seen its largest result.
+ */
+class SqlResultEncoder {
+public:
+    enum class Format {
+        rows,
+        columnar,
+        binary
+    };
+
+    static std::optional<Format> parse_format(const std::string& name);
+
+    // Start a new result for `stmt`; column names are taken from the statement
+    void begin(Format format, sqlite3_stmt* stmt);
+
+    // Append the statement's current row (after sqlite3_step returned SQLITE_ROW)
+    void add_row(sqlite3_stmt* stmt);
+
+    // Close the result; the encoded bytes are in buffer() until the next begin()
+    void finish();
+
+    const std::string& buffer() const { return buffer_; }
+    size_t row_count() const { return row_count_; }
+    size_t capacity() const { return buffer_.capacity(); }
+
+    // Append buffer() as base64, so a binary result can travel in a text output
+    void append_buffer_base64(std::string& out) const;
+
+private:
+    Format format_ = Format::rows;
+    int column_count_ = 0;
+    size_t row_count_ = 0;
+    std::string buffer_;
+    std::vector<std::string> json_keys_; // Escaped "name": prefixes for the rows format
+
+    void append_json_cell(sqlite3_stmt* stmt, int column);
+    void append_binary_cell(sqlite3_stmt* stmt, int column);
+    void append_varint(uint64_t value);
+};
+
+} // namespace worker
+} // namespace beamline
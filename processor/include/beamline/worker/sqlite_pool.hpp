@@ -0,0 +1,130 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * One pooled SQLite handle with an LRU cache of prepared statements
+ *
+ * Statements are keyed by SQL text and reused across steps: prepare() hands
+ * out a cached statement (reset, bindings cleared) or prepares and caches a
+ * new one, finalizing the least recently used statement when the cache is full.
+ * A connection is used by one step at a time.
+ */
+class SqliteConnection {
+public:
+    SqliteConnection(sqlite3* db, size_t statement_cache_size);
+    ~SqliteConnection();
+
+    SqliteConnection(const SqliteConnection&) = delete;
+    SqliteConnection& operator=(const SqliteConnection&) = delete;
+
+    sqlite3* db() const { return db_; }
+
+    // Returns a ready-to-bind statement owned by the cache. Throws std::runtime_error
+    // if the SQL does not compile.
+    sqlite3_stmt* prepare(const std::string& sql);
+
+    // Reset a statement handed out by prepare() so the next step can reuse it
+    static void release(sqlite3_stmt* stmt);
+
+    size_t cached_statements() const { return lru_.size(); }
+    uint64_t cache_hits() const { return cache_hits_; }
+    uint64_t cache_misses() const { return cache_misses_; }
+
+private:
+    struct CachedStatement {
+        std::string sql;
+        sqlite3_stmt* stmt;
+    };
+
+    sqlite3* db_;
+    size_t statement_cache_size_;
+    std::list<CachedStatement> lru_; // Most recently used first
+    std::unordered_map<std::string, std::list<CachedStatement>::iterator> statements_;
+    uint64_t cache_hits_ = 0;
+    uint64_t cache_misses_ = 0;
+};
+
+/**
+ * Per-connection-string pool of SQLite handles for sql.query
+ *
+ * File databases are opened once in WAL mode (readers do not block the
+ * writer) and handed back to the pool after each step. In-memory and
+ * temporary databases are private to a handle, so they are never pooled:
+ * every lease on them gets a fresh, empty database as before.
+ */
+class SqliteConnectionPool {
+public:
+    struct Config {
+        size_t max_idle_per_database = 8; // Idle handles kept per connection string
+        size_t statement_cache_size = 64; // Prepared statements cached per handle
+        int busy_timeout_ms = 5000;       // How long a writer waits on a locked database
+    };
+
+    struct Stats {
+        uint64_t opened = 0;     // sqlite3_open calls
+        uint64_t reused = 0;     // Leases served from an idle handle
+        uint64_t statement_hits = 0;
+        uint64_t statement_misses = 0;
+        size_t idle = 0;
+    };
+
+    // RAII handle; returns the connection to the pool when destroyed
+    class Lease {
+    public:
+        Lease(SqliteConnectionPool* pool, std::string key, std::unique_ptr<SqliteConnection> connection);
+        ~Lease();
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&&) = delete;
+
+        SqliteConnection& operator*() const { return *connection_; }
+        SqliteConnection* operator->() const { return connection_.get(); }
+
+        // Close instead of pooling (e.g. after an error left the handle in a bad state)
+        void discard() { discard_ = true; }
+
+    private:
+        SqliteConnectionPool* pool_;
+        std::string key_;
+        std::unique_ptr<SqliteConnection> connection_;
+        bool discard_ = false;
+        uint64_t hits_at_acquire_ = 0;
+        uint64_t misses_at_acquire_ = 0;
+    };
+
+    explicit SqliteConnectionPool(Config config);
+
+    // Process-wide pool used by sql.query; configure() only has an effect before first use
+    static void configure(Config config);
+    static SqliteConnectionPool& instance();
+
+    // Throws std::runtime_error if the database cannot be opened
+    Lease acquire(const std::string& connection_string);
+
+    Stats stats() const;
+
+    static bool is_poolable(const std::string& connection_string);
+
+private:
+    Config config_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<std::unique_ptr<SqliteConnection>>> idle_;
+    Stats stats_;
+
+    std::unique_ptr<SqliteConnection> open(const std::string& connection_string);
+    void release(const std::string& key, std::unique_ptr<SqliteConnection> connection, bool discard,
+                 uint64_t new_hits, uint64_t new_misses);
+};
+
+} // namespace worker
+} // namespace beamline
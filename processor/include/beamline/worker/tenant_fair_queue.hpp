@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "beamline/worker/deadline_queue.hpp"
+
+namespace beamline {
+namespace worker {
+
+// "tenant=weight,..." with positive weights; "*" sets the weight of unlisted tenants
+inline std::unordered_map<std::string, double> parse_tenant_weights(const std::string& spec) {
+    std::unordered_map<std::string, double> weights;
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string entry = spec.substr(start, end - start);
+        start = end + 1;
+        entry.erase(0, entry.find_first_not_of(" \t"));
+        entry.erase(entry.find_last_not_of(" \t") + 1);
+        if (entry.empty()) {
+            continue;
+        }
+
+        auto eq = entry.rfind('=');
+        if (eq == std::string::npos || eq == 0) {
+            throw std::invalid_argument("Invalid tenant weight: " + entry);
+        }
+        double weight = 0;
+        try {
+            size_t used = 0;
+            weight = std::stod(entry.substr(eq + 1), &used);
+            if (used != entry.size() - eq - 1) {
+                weight = 0;
+            }
+        } catch (const std::exception&) {
+            weight = 0;
+        }
+        if (!(weight > 0)) {
+            throw std::invalid_argument("Invalid tenant weight: " + entry);
+        }
+        weights[entry.substr(0, eq)] = weight;
+    }
+    return weights;
+}
+
+/**
+ * Pending steps split into one DeadlineQueue per tenant, served by deficit
+ * round robin so one tenant's backlog cannot starve the others
+ *
+ * Each visit of a backlogged tenant credits quantum * weight to its deficit;
+ * the tenant is served while its deficit covers the estimated cost of a step
+ * (an average of its measured costs). charge() settles the measured cost of a
+ * dispatched step against the estimate, so over time tenants receive executor
+ * time in proportion to their weights. Within a tenant, steps keep priority
+ * class and deadline order.
+ *
+ * A throttled tenant keeps its backlog but is left out of the round until it
+ * is unthrottled.
+ */
+template <class T>
+class TenantFairQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Entry = typename DeadlineQueue<T>::Entry;
+
+    // Step cost the first steps of a tenant are charged before any measurement (ms)
+    static constexpr double kInitialCostMs = 10.0;
+    // Share of the quantum kept per settled step once the cost that raised it is gone
+    static constexpr double kQuantumDecay = 0.99;
+
+    // `quantum_ms` is the smallest quantum; it rises to the largest tenant cost estimate
+    explicit TenantFairQueue(std::unordered_map<std::string, double> weights = {}, double quantum_ms = kInitialCostMs)
+        : weights_(std::move(weights)), min_quantum_ms_(quantum_ms), quantum_ms_(quantum_ms) {
+        auto fallback = weights_.find("*");
+        if (fallback != weights_.end()) {
+            default_weight_ = fallback->second;
+            weights_.erase(fallback);
+        }
+    }
+
+    double weight(const std::string& tenant) const {
+        auto it = weights_.find(tenant);
+        return it != weights_.end() ? it->second : default_weight_;
+    }
+
+    void push(const std::string& tenant, T value, StepPriority priority, Clock::time_point deadline,
+              Clock::time_point enqueued_at = Clock::now(), std::string key = {}) {
+        auto& state = tenant_state(tenant);
+        if (state.queue.empty() && !state.throttled) {
+            join_round(tenant, state);
+        }
+        if (!key.empty()) {
+            key_tenants_.emplace(key, tenant);
+        }
+        state.queue.push(std::move(value), priority, deadline, enqueued_at, std::move(key));
+        size_++;
+    }
+
+    // Next step by deficit round robin; has_ready() must be true. `tenant` receives
+    // its tenant and `estimated_cost_ms` what it was charged, to pass to charge().
+    Entry pop(std::string& tenant, double& estimated_cost_ms) {
+        while (true) {
+            auto& state = tenants_.at(active_.front());
+            if (!state.credited) {
+                state.deficit += quantum_ms_ * weight(active_.front());
+                state.credited = true;
+            }
+            if (state.deficit < state.cost_estimate_ms) {
+                // Spent for this round
+                state.credited = false;
+                active_.push_back(std::move(active_.front()));
+                active_.pop_front();
+                continue;
+            }
+
+            tenant = active_.front();
+            estimated_cost_ms = state.cost_estimate_ms;
+            state.deficit -= estimated_cost_ms;
+            Entry entry = state.queue.pop();
+            forget_key(entry.key, tenant);
+            size_--;
+            if (state.queue.empty()) {
+                retire_front();
+            }
+            return entry;
+        }
+    }
+
+    // Settle a dispatched step: measured cost against the estimate charged by pop()
+    // (0 for steps that never queued). Updates the tenant's cost estimate and usage.
+    void charge(const std::string& tenant, double estimated_cost_ms, double actual_cost_ms) {
+        auto& state = tenant_state(tenant);
+        state.usage_ms += actual_cost_ms;
+        state.cost_estimate_ms = std::max(1.0, state.cost_estimate_ms * 0.8 + actual_cost_ms * 0.2);
+        // A quantum must cover a step of the most expensive tenant, or rounds are spent crediting;
+        // it decays back once no tenant's estimate holds it up, so one slow burst does not
+        // coarsen the round robin for good
+        quantum_ms_ = std::max({min_quantum_ms_, state.cost_estimate_ms, quantum_ms_ * kQuantumDecay});
+        if (estimated_cost_ms > 0) {
+            // Overruns carry into the next rounds, at most one quantum of debt
+            double tenant_quantum = quantum_ms_ * weight(tenant);
+            state.deficit = std::max(state.deficit - (actual_cost_ms - estimated_cost_ms), -tenant_quantum);
+        }
+    }
+
+    // Return the estimate charged by pop() for a step that never ran
+    void refund(const std::string& tenant, double estimated_cost_ms) {
+        tenant_state(tenant).deficit += estimated_cost_ms;
+    }
+
+    void set_throttled(const std::string& tenant, bool throttled) {
+        auto& state = tenant_state(tenant);
+        if (state.throttled == throttled) {
+            return;
+        }
+        state.throttled = throttled;
+        if (state.queue.empty()) {
+            return;
+        }
+        if (throttled) {
+            remove_active(tenant);
+        } else {
+            join_round(tenant, state);
+        }
+    }
+
+    bool throttled(const std::string& tenant) const {
+        auto it = tenants_.find(tenant);
+        return it != tenants_.end() && it->second.throttled;
+    }
+
+    // Tenants currently throttled
+    std::vector<std::string> throttled_tenants() const {
+        std::vector<std::string> tenants;
+        for (const auto& [name, state] : tenants_) {
+            if (state.throttled) {
+                tenants.push_back(name);
+            }
+        }
+        return tenants;
+    }
+
+    // Make room for `tenant` when the queue is full: removes the least urgent step of the
+    // tenant furthest over its weighted share, unless that is `tenant` itself. Returns
+    // false when nothing was shed.
+    template <class Visitor>
+    bool shed_for(const std::string& tenant, Visitor&& visit) {
+        const std::string* heaviest = nullptr;
+        double heaviest_share = 0;
+        for (const auto& [name, state] : tenants_) {
+            double share = static_cast<double>(state.queue.size()) / weight(name);
+            if (share > heaviest_share) {
+                heaviest = &name;
+                heaviest_share = share;
+            }
+        }
+        auto arriving = tenants_.find(tenant);
+        double arriving_share = static_cast<double>(arriving != tenants_.end() ? arriving->second.queue.size() + 1 : 1) /
+                                weight(tenant);
+        if (!heaviest || *heaviest == tenant || arriving_share >= heaviest_share) {
+            return false;
+        }
+
+        std::string victim = *heaviest;
+        auto& state = tenants_.at(victim);
+        Entry entry = state.queue.pop_last();
+        forget_key(entry.key, victim);
+        size_--;
+        if (state.queue.empty()) {
+            remove_active(victim);
+        }
+        visit(victim, entry);
+        return true;
+    }
+
+    // Remove every step pushed under `key`, handing each to `visit(tenant, entry)` first
+    template <class Visitor>
+    size_t erase(const std::string& key, Visitor&& visit) {
+        auto [first, last] = key_tenants_.equal_range(key);
+        if (first == last) {
+            return 0;
+        }
+        std::vector<std::string> tenants;
+        for (auto it = first; it != last; ++it) {
+            if (std::find(tenants.begin(), tenants.end(), it->second) == tenants.end()) {
+                tenants.push_back(it->second);
+            }
+        }
+        key_tenants_.erase(first, last);
+
+        size_t erased = 0;
+        for (const auto& tenant : tenants) {
+            auto& state = tenants_.at(tenant);
+            erased += state.queue.erase(key, [&visit, &tenant](Entry& entry) { visit(tenant, entry); });
+            if (state.queue.empty()) {
+                remove_active(tenant);
+            }
+        }
+        size_ -= erased;
+        return erased;
+    }
+
+    size_t erase(const std::string& key) {
+        return erase(key, [](const std::string&, Entry&) {});
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    // Some queued step belongs to a tenant that is not throttled
+    bool has_ready() const { return !active_.empty(); }
+
+    size_t size(const std::string& tenant) const {
+        auto it = tenants_.find(tenant);
+        return it != tenants_.end() ? it->second.queue.size() : 0;
+    }
+
+    // Deficit credited per visit at weight 1 (ms)
+    double quantum_ms() const { return quantum_ms_; }
+
+    // Measured executor time charged to the tenant so far (ms)
+    double usage_ms(const std::string& tenant) const {
+        auto it = tenants_.find(tenant);
+        return it != tenants_.end() ? it->second.usage_ms : 0.0;
+    }
+
+private:
+    struct TenantState {
+        DeadlineQueue<T> queue;
+        double deficit = 0;
+        double cost_estimate_ms = kInitialCostMs;
+        double usage_ms = 0;
+        bool credited = false; // Quantum already added during the current visit
+        bool throttled = false;
+    };
+
+    TenantState& tenant_state(const std::string& tenant) {
+        return tenants_[tenant];
+    }
+
+    void join_round(const std::string& tenant, TenantState& state) {
+        // Debt from steps still being settled is kept, credit is not
+        state.deficit = std::min(state.deficit, 0.0);
+        state.credited = false;
+        active_.push_back(tenant);
+    }
+
+    void forget_key(const std::string& key, const std::string& tenant) {
+        if (key.empty()) {
+            return;
+        }
+        auto [first, last] = key_tenants_.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == tenant) {
+                key_tenants_.erase(it);
+                return;
+            }
+        }
+    }
+
+    void retire_front() {
+        auto& state = tenants_.at(active_.front());
+        state.deficit = std::min(state.deficit, 0.0);
+        state.credited = false;
+        active_.pop_front();
+    }
+
+    void remove_active(const std::string& tenant) {
+        auto it = std::find(active_.begin(), active_.end(), tenant);
+        if (it == active_.end()) {
+            return;
+        }
+        if (it == active_.begin()) {
+            retire_front();
+            return;
+        }
+        auto& state = tenants_.at(tenant);
+        state.deficit = std::min(state.deficit, 0.0);
+        state.credited = false;
+        active_.erase(it);
+    }
+
+    std::unordered_map<std::string, double> weights_;
+    double default_weight_ = 1.0;
+    double min_quantum_ms_;
+    double quantum_ms_;
+    std::unordered_map<std::string, TenantState> tenants_;
+    std::deque<std::string> active_; // Backlogged tenants in round-robin order
+    std::unordered_multimap<std::string, std::string> key_tenants_; // Key -> tenant
+    size_t size_ = 0;
+};
+
+} // namespace worker
+} // namespace beamline
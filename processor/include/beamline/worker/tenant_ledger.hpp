@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+/**
+ * Per-tenant resource ledger over a sliding window
+ *
+ * Executors record each step's measured CPU time and heap use under its tenant;
+ * pools and the scheduler read the window's totals to enforce the per-tenant
+ * quotas. The window is a ring of time buckets per tenant: recording adds to the
+ * current bucket with relaxed atomics and a bucket is reset when its slot comes
+ * round again, so usage ages out one bucket at a time. Adds racing with that
+ * reset may be lost.
+ *
+ * Tenants are found through a lock-free open-addressing table; only the first
+ * step of a new tenant takes the mutex. Tenants beyond max_tenants share one
+ * overflow account. Steps without a tenant id are not accounted and are never
+ * over quota.
+ */
+class TenantLedger {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        int64_t window_ms = 3600000;  // Sliding window the quotas apply to
+        size_t buckets = 60;          // Window resolution: usage ages out window_ms / buckets at a time
+        int64_t max_cpu_time_ms = 0;  // CPU time per tenant within the window (0 = unlimited)
+        int64_t max_memory_bytes = 0; // Peak heap of one of the tenant's steps within the window (0 = unlimited)
+        size_t max_tenants = 4096;
+    };
+
+    struct Usage {
+        int64_t cpu_time_ns = 0;
+        int64_t allocated_bytes = 0;
+        int64_t peak_heap_bytes = 0; // Largest peak of a single step
+        uint64_t steps = 0;
+    };
+
+    enum class QuotaState { within, cpu_time_exceeded, memory_exceeded };
+
+    // Tenant name of the shared account for tenants beyond max_tenants
+    static constexpr std::string_view OVERFLOW_TENANT = "__overflow__";
+
+    explicit TenantLedger(Config config);
+    ~TenantLedger();
+
+    TenantLedger(const TenantLedger&) = delete;
+    TenantLedger& operator=(const TenantLedger&) = delete;
+
+    // Settings for the process-wide ledger; call before the first instance()
+    static void configure(Config config);
+    static TenantLedger& instance();
+
+    void record(std::string_view tenant_id, int64_t cpu_time_ns, int64_t allocated_bytes, int64_t peak_heap_bytes,
+                Clock::time_point now = Clock::now());
+
+    // Totals of the window ending at `now`
+    Usage usage(std::string_view tenant_id, Clock::time_point now = Clock::now()) const;
+
+    QuotaState quota_state(std::string_view tenant_id, Clock::time_point now = Clock::now()) const;
+    bool over_quota(std::string_view tenant_id, Clock::time_point now = Clock::now()) const {
+        return quota_state(tenant_id, now) != QuotaState::within;
+    }
+
+    const Config& config() const { return config_; }
+
+    // Window resolution: recorded usage ages out this much at a time
+    std::chrono::milliseconds bucket_width() const { return std::chrono::milliseconds(bucket_ms_); }
+
+private:
+    struct Bucket {
+        std::atomic<int64_t> epoch{-1}; // Bucket index since the clock's epoch
+        std::atomic<int64_t> cpu_time_ns{0};
+        std::atomic<int64_t> allocated_bytes{0};
+        std::atomic<int64_t> peak_heap_bytes{0};
+        std::atomic<uint64_t> steps{0};
+    };
+
+    struct Account {
+        Account(std::string name, size_t buckets) : tenant_id(std::move(name)), ring(buckets) {}
+        std::string tenant_id;
+        std::vector<Bucket> ring;
+    };
+
+    Account* find(std::string_view tenant_id, size_t hash) const;
+    Account* find_or_create(std::string_view tenant_id);
+    int64_t epoch_of(Clock::time_point now) const;
+
+    Config config_;
+    int64_t bucket_ms_;
+    size_t mask_;
+    std::unique_ptr<std::atomic<Account*>[]> table_;
+    std::vector<std::unique_ptr<Account>> accounts_; // Owned; guarded by mutex_
+    std::mutex mutex_;
+    std::atomic<Account*> overflow_{nullptr};
+};
+
+} // namespace worker
+} // namespace beamline
@@ -1,10 +1,9 @@
 #pragma once
 
 #include "beamline/worker/feature_flags.hpp"
+#include "beamline/worker/io_executor.hpp"
 #include <chrono>
 #include <functional>
-#include <future>
-#include <thread>
 
 namespace beamline {
 namespace worker {
@@ -24,37 +23,57 @@ public:
     /**
      * Execute operation with timeout
      * 
-     * Returns true if operation completed within timeout, false if timeout occurred
+     * Returns true if operation completed within timeout, false if timeout occurred.
+     * Never blocks past the timeout, even if the operation itself is still running.
+     * 
+     * The operation is passed its IoTask and should return early once
+     * task.cancelled() is true. One that started before the timeout and does
+     * not check it keeps running past this call and holds an executor thread
+     * until it returns; such threads are reported as abandoned and counted in
+     * the blocking_io queue depth.
      */
     template<typename Result>
     static bool execute_with_timeout(
-        std::function<Result()> operation,
+        std::function<Result(const IoTask&)> operation,
         int64_t timeout_ms,
         Result& result,
         Result timeout_result) {
         
         if (!FeatureFlags::is_complete_timeout_enabled()) {
             // CP1 behavior: no timeout enforcement
-            result = operation();
+            IoTask never_cancelled;
+            result = operation(never_cancelled);
             return true;
         }
         
-        // CP2 behavior: enforce timeout using async execution
-        auto future = std::async(std::launch::async, operation);
-        
-        auto status = future.wait_for(std::chrono::milliseconds(timeout_ms));
+        // CP2 behavior: run on the shared blocking-I/O executor and stop waiting at the deadline.
+        // A timed-out operation is cancelled: dropped if still queued, signalled if running.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        auto status = IoExecutor::instance().run_until<Result>(std::move(operation), deadline, result);
         
-        if (status == std::future_status::timeout) {
-            // Timeout occurred
+        if (status != IoTaskStatus::completed) {
+            // Timed out, or rejected because the executor queue is full
             result = timeout_result;
             return false;
         }
         
         // Operation completed
-        result = future.get();
         return true;
     }
     
+    // For operations that cannot be interrupted; see above for what outlives a timeout
+    template<typename Result>
+    static bool execute_with_timeout(
+        std::function<Result()> operation,
+        int64_t timeout_ms,
+        Result& result,
+        Result timeout_result) {
+        return execute_with_timeout<Result>(
+            std::function<Result(const IoTask&)>(
+                [operation = std::move(operation)](const IoTask&) { return operation(); }),
+            timeout_ms, result, std::move(timeout_result));
+    }
+    
     /**
      * Get FS operation timeout based on operation type
      */
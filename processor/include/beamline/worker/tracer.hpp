@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+// Identifies a span within a trace; propagated in-process and as a W3C traceparent
+struct SpanContext {
+    uint64_t trace_high = 0;
+    uint64_t trace_low = 0;
+    uint64_t span_id = 0;
+    bool sampled = false;  // Head sampling decision, inherited by child spans
+    bool remote = false;   // Parent lives in another process; the child is a local root
+
+    bool valid() const { return span_id != 0 && (trace_high | trace_low) != 0; }
+
+    // "00-<32 hex trace id>-<16 hex span id>-<flags>", empty when invalid
+    std::string traceparent() const;
+    // Invalid context if `header` is not a version-00 traceparent
+    static SpanContext from_traceparent(std::string_view header, bool remote = true);
+};
+
+class Tracer;
+
+// Fixed-size span data, copied into a ring by Span::end()
+struct SpanRecord {
+    static constexpr size_t MAX_ATTRIBUTES = 4;
+    static constexpr size_t MAX_VALUE_BYTES = 46;   // Longer values are truncated
+
+    static constexpr uint8_t SAMPLED = 1;
+    static constexpr uint8_t LOCAL_ROOT = 2;
+    static constexpr uint8_t ERROR = 4;
+    static constexpr uint8_t CLIENT = 8;
+
+    struct Attribute {
+        const char* key;                            // String literal
+        bool integer;
+        uint8_t length;
+        char value[MAX_VALUE_BYTES];
+    };
+
+    uint64_t trace_high = 0;
+    uint64_t trace_low = 0;
+    uint64_t span_id = 0;
+    uint64_t parent_span_id = 0;
+    int64_t start_ns = 0;                           // steady_clock, converted to Unix time on export
+    int64_t end_ns = 0;
+    const char* name = "";                          // String literal
+    uint8_t flags = 0;
+    uint8_t attribute_count = 0;
+    uint8_t status_length = 0;
+    char status_message[MAX_VALUE_BYTES] = {};
+    Attribute attributes[MAX_ATTRIBUTES] = {};
+};
+
+/**
+ * An open span. Ends (and is recorded) when end() is called or it is destroyed.
+ * A default-constructed Span, or one started while tracing is off, records nothing.
+ */
+class Span {
+public:
+    Span() = default;
+    ~Span() { end(); }
+
+    Span(Span&& other) noexcept;
+    Span& operator=(Span&& other) noexcept;
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    explicit operator bool() const { return tracer_ != nullptr; }
+    SpanContext context() const;
+
+    // `key` must be a string literal; at most SpanRecord::MAX_ATTRIBUTES are kept
+    Span& set_attribute(const char* key, std::string_view value);
+    Span& set_attribute(const char* key, int64_t value);
+    // Mark the span failed; error spans keep their whole trace (tail sampling)
+    void set_error(std::string_view message = {});
+    void end();
+
+private:
+    friend class Tracer;
+    Tracer* tracer_ = nullptr;
+    SpanRecord record_;
+};
+
+/**
+ * Span recorder with a batching OTLP/JSON exporter
+ *
+ * Ending a span copies a fixed-size record into the calling thread's
+ * single-producer ring: no locks, no allocation, no syscall. A background
+ * exporter drains the rings every export interval and appends one OTLP/JSON
+ * ExportTraceServiceRequest per line to the trace file, which an OpenTelemetry
+ * Collector can tail with its otlpjsonfile receiver.
+ *
+ * Sampling: a trace started here is head-sampled when its trace id falls under
+ * sample_ratio (a sampled remote parent is always followed); its spans are
+ * exported as they end. Spans of other traces are held by the exporter until
+ * the trace's local root ends, and the whole trace is kept only if a span
+ * failed or the root took at least slow_threshold_ms (tail sampling). Traces
+ * whose root never ends are discarded after tail_timeout_ms.
+ *
+ * With an empty path tracing is off and start_span() returns an inert Span.
+ */
+class Tracer {
+public:
+    enum class SpanKind { internal, client };
+
+    struct Config {
+        std::string path;                   // OTLP/JSON lines file (appended); empty = tracing off
+        std::string service_name = "beamline-worker";
+        double sample_ratio = 0.01;         // Head sampling: fraction of new traces always exported
+        int64_t slow_threshold_ms = 1000;   // Tail sampling: keep traces whose root took this long
+        bool keep_errors = true;            // Tail sampling: keep traces with a failed span
+        size_t ring_spans = 512;            // Per-thread ring, rounded up to a power of two
+        int64_t export_interval_ms = 1000;
+        int64_t tail_timeout_ms = 60000;    // Undecided traces are dropped after this long
+        size_t max_pending_spans = 65536;   // Spans held for tail decisions; further ones are dropped
+        size_t max_batch_spans = 512;       // Spans per exported line
+    };
+
+    struct Stats {
+        uint64_t recorded = 0;              // Spans ended
+        uint64_t dropped = 0;               // Lost to a full ring or the pending limit
+        uint64_t exported = 0;
+        uint64_t discarded = 0;             // Not sampled (head or tail)
+        uint64_t batches = 0;               // Lines written
+        size_t pending = 0;                 // Spans awaiting a tail decision
+        size_t threads = 0;                 // Live producer rings
+    };
+
+    explicit Tracer(Config config);
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Process-wide tracer; configure() only has an effect before the first instance() call
+    static void configure(Config config);
+    static Tracer& instance();
+
+    bool enabled() const { return enabled_; }
+
+    // `name` must be a string literal. Without a valid parent a new trace is started.
+    Span start_span(const char* name, const SpanContext& parent = SpanContext(), SpanKind kind = SpanKind::internal);
+    // Same, for an interval that began earlier (e.g. time spent queued)
+    Span start_span(const char* name, const SpanContext& parent, SpanKind kind,
+                    std::chrono::steady_clock::time_point start);
+
+    // Child of current(); inert outside any Scope, so untraced callers (tests, tools) record nothing
+    Span start_child(const char* name, SpanKind kind = SpanKind::internal);
+
+    // Span context of the innermost Scope on this thread (invalid outside any scope)
+    static SpanContext current();
+
+    // Makes `context` the current span context of this thread until destroyed
+    class Scope {
+    public:
+        explicit Scope(const SpanContext& context);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        SpanContext previous_;
+    };
+
+    // Export everything recorded before the call that has a sampling decision
+    void flush();
+
+    Stats stats() const;
+
+private:
+    friend class Span;
+    struct Ring;
+
+    struct TraceKey {
+        uint64_t high;
+        uint64_t low;
+        bool operator==(const TraceKey& other) const { return high == other.high && low == other.low; }
+    };
+    struct TraceKeyHash {
+        size_t operator()(const TraceKey& key) const {
+            return static_cast<size_t>(key.low ^ (key.high * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+    // Spans of an unsampled trace held until its local root ends
+    struct PendingTrace {
+        enum class Decision : uint8_t { undecided, keep, drop };
+        std::vector<SpanRecord> spans;
+        int64_t updated_ns = 0;
+        Decision decision = Decision::undecided;
+    };
+
+    void submit(const SpanRecord& record);
+    Ring& local_ring();
+    void exporter_loop();
+    void export_pass(bool final);
+    void write_batch(const std::vector<SpanRecord>& spans);
+
+    const uint64_t id_;
+    Config config_;
+    bool enabled_ = false;
+    int fd_ = -1;
+    uint64_t sample_threshold_ = 0;         // trace_low below this is head-sampled
+    int64_t epoch_offset_ns_ = 0;           // system_clock - steady_clock at construction
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    uint64_t retired_recorded_ = 0;
+    uint64_t retired_dropped_ = 0;
+
+    // Exporter thread only
+    std::unordered_map<TraceKey, PendingTrace, TraceKeyHash> pending_;
+    std::vector<SpanRecord> drained_;
+    std::vector<SpanRecord> batch_;
+    std::string output_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable flushed_cv_;
+    bool running_ = true;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
+
+    std::atomic<uint64_t> dropped_{0};      // Pending limit
+    std::atomic<uint64_t> exported_{0};
+    std::atomic<uint64_t> discarded_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<size_t> pending_spans_{0};
+
+    std::thread exporter_;
+};
+
+} // namespace worker
+} // namespace beamline
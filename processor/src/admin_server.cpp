@@ -0,0 +1,524 @@
+#include "beamline/worker/admin_server.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int MAX_EVENTS = 64;
+constexpr int64_t MAX_POLL_MS = 1000;
+
+const char* reason_phrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Whether an Accept-Encoding value allows gzip ("gzip", "*", not with q=0)
+bool accepts_gzip_encoding(std::string_view header) {
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view item = header.substr(0, comma);
+        header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+        size_t semicolon = item.find(';');
+        std::string_view coding = trim(item.substr(0, semicolon));
+        if (!iequals(coding, "gzip") && coding != "*") {
+            continue;
+        }
+        if (semicolon == std::string_view::npos) {
+            return true;
+        }
+        std::string_view param = trim(item.substr(semicolon + 1));
+        if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=') {
+            return true;
+        }
+        param.remove_prefix(2);
+        // q is 0..1 with at most three decimals; any non-zero digit means acceptable
+        return param.find_first_of("123456789") != std::string_view::npos;
+    }
+    return false;
+}
+
+} // namespace
+
+struct AdminServer::Connection {
+    int fd = -1;
+    std::string input;
+    std::string output;
+    size_t output_offset = 0;
+    bool close_after_write = false;
+    bool want_write = false;           // EPOLLOUT registered
+    Clock::time_point deadline;
+};
+
+AdminServer::AdminServer(Config config) : config_(std::move(config)) {}
+
+AdminServer::~AdminServer() {
+    stop();
+}
+
+void AdminServer::handle(const std::string& path, Handler handler) {
+    routes_[path] = std::move(handler);
+}
+
+void AdminServer::start() {
+    if (running()) {
+        return;
+    }
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config_.port);
+    if (config_.address.empty() || config_.address == "0.0.0.0") {
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+    } else if (inet_pton(AF_INET, config_.address.c_str(), &server_addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid admin server address: " + config_.address);
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Admin server socket failed: ") + std::strerror(errno));
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) < 0 || listen(fd, 128) < 0) {
+        std::string error = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("Admin server bind/listen on " + config_.address + ":" +
+                                 std::to_string(config_.port) + " failed: " + error);
+    }
+    socklen_t addr_len = sizeof(server_addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&server_addr), &addr_len);
+    bound_port_ = ntohs(server_addr.sin_port);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::string error = std::strerror(errno);
+        close(fd);
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+        epoll_fd_ = wake_fd_ = -1;
+        throw std::runtime_error("Admin server epoll setup failed: " + error);
+    }
+    listen_fd_ = fd;
+    for (int watched : {listen_fd_, wake_fd_}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = watched;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, watched, &event);
+    }
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread([this]() { run(); });
+}
+
+void AdminServer::stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd_, &one, sizeof(one));
+    (void)written;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    for (int fd : {listen_fd_, epoll_fd_, wake_fd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    listen_fd_ = epoll_fd_ = wake_fd_ = -1;
+}
+
+void AdminServer::run() {
+    epoll_event events[MAX_EVENTS];
+    while (running_.load(std::memory_order_acquire)) {
+        // Sleep until the nearest connection deadline
+        int64_t timeout_ms = MAX_POLL_MS;
+        auto now = Clock::now();
+        for (const auto& [fd, connection] : connections_) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(connection->deadline - now).count();
+            timeout_ms = std::clamp<int64_t>(remaining + 1, 0, timeout_ms);
+        }
+
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, static_cast<int>(timeout_ms));
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                continue; // running_ is checked by the loop condition
+            }
+            if (fd == listen_fd_) {
+                accept_connections();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                on_writable(*it->second);
+            }
+            it = connections_.find(fd);
+            if (it != connections_.end() && (events[i].events & EPOLLIN)) {
+                on_readable(*it->second);
+            }
+        }
+        expire_connections();
+    }
+
+    while (!connections_.empty()) {
+        close_connection(connections_.begin()->first);
+    }
+}
+
+void AdminServer::accept_connections() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN once the backlog is drained; other errors are per-connection
+        }
+        if (connections_.size() >= config_.max_connections) {
+            close(fd);
+            continue;
+        }
+        int opt = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->deadline = Clock::now() + std::chrono::milliseconds(config_.request_timeout_ms);
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        connections_.emplace(fd, std::move(connection));
+    }
+}
+
+void AdminServer::on_readable(Connection& connection) {
+    char buffer[4096];
+    bool was_idle = connection.input.empty();
+    bool peer_closed = false;
+    for (;;) {
+        ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection.input.append(buffer, static_cast<size_t>(received));
+            if (connection.input.size() > config_.max_request_bytes * 4) {
+                break; // Enough to reject; do not buffer an unbounded stream
+            }
+            continue;
+        }
+        if (received == 0) {
+            peer_closed = true; // Half-close: still answer what was received
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            close_connection(connection.fd);
+            return;
+        }
+        break;
+    }
+    if (was_idle && !connection.input.empty()) {
+        // A new request started: it must arrive within the request timeout
+        connection.deadline = Clock::now() + std::chrono::milliseconds(config_.request_timeout_ms);
+    }
+    bool queued = process_requests(connection);
+    if (peer_closed) {
+        if (connection.output_offset >= connection.output.size()) {
+            close_connection(connection.fd);
+            return;
+        }
+        connection.close_after_write = true;
+    }
+    if (queued) {
+        on_writable(connection);
+    }
+}
+
+bool AdminServer::process_requests(Connection& connection) {
+    bool queued = false;
+    while (!connection.close_after_write) {
+        size_t header_end = connection.input.find("\r\n\r\n");
+        if (header_end == std::string::npos) {
+            if (connection.input.size() > config_.max_request_bytes) {
+                Response response;
+                response.status = 431;
+                response.body = "Request headers too large\n";
+                queue_response(connection, false, false, false, std::move(response));
+                queued = true;
+            }
+            break;
+        }
+        if (header_end + 4 > config_.max_request_bytes) {
+            Response response;
+            response.status = 431;
+            response.body = "Request headers too large\n";
+            queue_response(connection, false, false, false, std::move(response));
+            queued = true;
+            break;
+        }
+
+        std::string_view head(connection.input.data(), header_end);
+        size_t line_end = head.find("\r\n");
+        std::string_view request_line = head.substr(0, line_end);
+        std::string_view headers = line_end == std::string_view::npos ? std::string_view() : head.substr(line_end + 2);
+
+        Request request;
+        size_t first_space = request_line.find(' ');
+        size_t second_space = request_line.find(' ', first_space == std::string_view::npos ? 0 : first_space + 1);
+        bool well_formed = first_space != std::string_view::npos && second_space != std::string_view::npos;
+        std::string_view version;
+        if (well_formed) {
+            request.method = request_line.substr(0, first_space);
+            std::string_view target = request_line.substr(first_space + 1, second_space - first_space - 1);
+            version = request_line.substr(second_space + 1);
+            size_t question = target.find('?');
+            request.path = target.substr(0, question);
+            request.query = question == std::string_view::npos ? std::string_view() : target.substr(question + 1);
+            well_formed = !request.path.empty() && request.path[0] == '/' && version.substr(0, 5) == "HTTP/";
+        }
+
+        // HTTP/1.1 keeps the connection open unless asked not to; HTTP/1.0 only when asked
+        bool keep_alive = version == "HTTP/1.1";
+        bool accepts_gzip = false;
+        bool has_body = false;
+        while (!headers.empty()) {
+            size_t end = headers.find("\r\n");
+            std::string_view line = headers.substr(0, end);
+            headers = end == std::string_view::npos ? std::string_view() : headers.substr(end + 2);
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos) {
+                well_formed = false;
+                continue;
+            }
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = trim(line.substr(colon + 1));
+            if (iequals(name, "connection")) {
+                if (iequals(value, "close")) {
+                    keep_alive = false;
+                } else if (iequals(value, "keep-alive")) {
+                    keep_alive = true;
+                }
+            } else if (iequals(name, "accept")) {
+                request.accept = value;
+            } else if (iequals(name, "accept-encoding")) {
+                accepts_gzip = accepts_gzip_encoding(value);
+            } else if (iequals(name, "transfer-encoding") || (iequals(name, "content-length") && value != "0")) {
+                has_body = true;
+            }
+        }
+
+        Response response;
+        if (!well_formed || has_body) {
+            // Admin requests carry no body; rather than skip one, close after answering
+            response.status = 400;
+            response.body = "Bad Request\n";
+            keep_alive = false;
+        } else if (request.method != "GET" && request.method != "HEAD") {
+            response.status = 405;
+            response.body = "Method Not Allowed\n";
+        } else if (auto route = routes_.find(request.path); route == routes_.end()) {
+            response.status = 404;
+            response.body = "404 Not Found";
+        } else {
+            try {
+                response = route->second(request);
+            } catch (const std::exception& e) {
+                response = Response();
+                response.status = 500;
+                response.body = std::string("Internal Server Error: ") + e.what() + "\n";
+            }
+        }
+        queue_response(connection, request.method == "HEAD", keep_alive, accepts_gzip, std::move(response));
+        queued = true;
+        connection.input.erase(0, header_end + 4);
+    }
+    return queued;
+}
+
+void AdminServer::queue_response(Connection& connection, bool head_only, bool keep_alive,
+                                 bool accepts_gzip, Response response) {
+    bool compressed = accepts_gzip && response.body.size() >= config_.gzip_min_bytes;
+    if (compressed) {
+        response.body = gzip(response.body);
+    }
+
+    std::string& out = connection.output;
+    if (connection.output_offset > 0 && connection.output_offset == out.size()) {
+        out.clear();
+        connection.output_offset = 0;
+    }
+    char digits[24];
+    out.append("HTTP/1.1 ");
+    out.append(digits, static_cast<size_t>(std::to_chars(digits, digits + sizeof(digits), response.status).ptr - digits));
+    out.push_back(' ');
+    out.append(reason_phrase(response.status));
+    out.append("\r\nContent-Type: ");
+    out.append(response.content_type);
+    out.append("\r\nContent-Length: ");
+    out.append(digits, static_cast<size_t>(std::to_chars(digits, digits + sizeof(digits), response.body.size()).ptr - digits));
+    if (compressed) {
+        out.append("\r\nContent-Encoding: gzip");
+    }
+    if (response.body.size() >= config_.gzip_min_bytes || compressed) {
+        out.append("\r\nVary: Accept-Encoding");
+    }
+    if (response.status == 405) {
+        out.append("\r\nAllow: GET, HEAD");
+    }
+    out.append(keep_alive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    if (!head_only) {
+        out.append(response.body);
+    }
+    connection.close_after_write = !keep_alive;
+}
+
+void AdminServer::on_writable(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.output_offset,
+                            connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.output_offset += static_cast<size_t>(sent);
+            // A slow reader gets the request timeout for each chunk it accepts
+            connection.deadline = Clock::now() + std::chrono::milliseconds(config_.request_timeout_ms);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            update_interest(connection);
+            return;
+        }
+        close_connection(connection.fd);
+        return;
+    }
+
+    connection.output.clear();
+    connection.output_offset = 0;
+    if (connection.close_after_write) {
+        close_connection(connection.fd);
+        return;
+    }
+    // Pipelined requests already buffered are answered now; otherwise wait idle
+    connection.deadline = Clock::now() + std::chrono::milliseconds(
+        connection.input.empty() ? config_.idle_timeout_ms : config_.request_timeout_ms);
+    update_interest(connection);
+    if (!connection.input.empty() && process_requests(connection)) {
+        on_writable(connection);
+    }
+}
+
+void AdminServer::update_interest(Connection& connection) {
+    bool want_write = connection.output_offset < connection.output.size();
+    if (want_write == connection.want_write) {
+        return;
+    }
+    connection.want_write = want_write;
+    epoll_event event{};
+    // While a response is pending, stop reading so a pipelining client cannot grow the buffers
+    event.events = want_write ? EPOLLOUT : (EPOLLIN | EPOLLRDHUP);
+    event.data.fd = connection.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void AdminServer::close_connection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(it);
+}
+
+void AdminServer::expire_connections() {
+    auto now = Clock::now();
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        int fd = it->first;
+        bool expired = it->second->deadline <= now;
+        ++it;
+        if (expired) {
+            close_connection(fd);
+        }
+    }
+}
+
+std::string AdminServer::gzip(std::string_view input) {
+    z_stream stream{};
+    // windowBits 15 + 16 selects the gzip wrapper; level 1 keeps scrapes cheap
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+    std::string output;
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("deflate failed");
+    }
+    return output;
+}
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,367 @@
+#include "beamline/worker/async_logger.hpp"
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+AsyncLogger::Config& default_config() {
+    static AsyncLogger::Config config;
+    return config;
+}
+
+// Records are a 4-byte header followed by the line and its newline, padded to 4 bytes,
+// so a header never wraps around the end of the ring
+constexpr uint32_t PAD_RECORD = 0x80000000u; // Skip to the start of the ring
+constexpr uint32_t ERR_STREAM = 0x40000000u;
+constexpr uint32_t LENGTH_MASK = 0x3FFFFFFFu;
+constexpr size_t HEADER_BYTES = sizeof(uint32_t);
+constexpr size_t MIN_RING_BYTES = 4096;
+constexpr size_t MAX_BATCH_IOVECS = IOV_MAX;
+
+size_t record_bytes(size_t payload) {
+    return HEADER_BYTES + ((payload + 3) & ~size_t{3});
+}
+
+std::atomic<uint64_t> next_logger_id{1};
+
+} // namespace
+
+struct AsyncLogger::Ring {
+    explicit Ring(size_t capacity)
+        : buffer(capacity), mask(capacity - 1) {}
+
+    std::vector<char> buffer;
+    const size_t mask;
+    alignas(64) std::atomic<uint64_t> head{0};      // Written by the owning thread
+    alignas(64) std::atomic<uint64_t> tail{0};      // Written by the writer thread
+    alignas(64) std::atomic<uint64_t> submitted{0}; // Owner-only counters, read by stats()
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> closed{false};                // Owning thread has exited
+
+    size_t capacity() const { return buffer.size(); }
+};
+
+namespace {
+
+// Rings of the current thread, one per logger it has written to. Each entry keeps
+// its ring alive through the `closed` flag, which is raised when the thread exits.
+struct LocalRing {
+    uint64_t logger_id;
+    void* ring;
+    std::shared_ptr<std::atomic<bool>> closed;
+};
+
+struct LocalRings {
+    std::vector<LocalRing> entries;
+
+    ~LocalRings() {
+        for (auto& entry : entries) {
+            entry.closed->store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local LocalRings local_rings;
+
+} // namespace
+
+AsyncLogger::AsyncLogger(Config config)
+    : id_(next_logger_id.fetch_add(1, std::memory_order_relaxed)),
+      config_(std::move(config)) {
+    size_t capacity = MIN_RING_BYTES;
+    while (capacity < config_.ring_bytes) {
+        capacity <<= 1;
+    }
+    config_.ring_bytes = capacity;
+
+    if (!config_.path.empty()) {
+        int fd = ::open(config_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open log file " + config_.path + ": " + std::strerror(errno));
+        }
+        out_fd_ = fd;
+        err_fd_ = fd;
+        owns_fd_ = true;
+    }
+
+    writer_ = std::thread([this]() { writer_loop(); });
+}
+
+AsyncLogger::~AsyncLogger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    work_cv_.notify_one();
+    writer_.join();
+    if (owns_fd_) {
+        ::close(out_fd_);
+    }
+}
+
+void AsyncLogger::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = std::move(config);
+}
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return logger;
+}
+
+bool AsyncLogger::write(Stream stream, std::string_view line) {
+    size_t payload = line.size() + 1;
+    size_t needed = record_bytes(payload);
+    if (needed > config_.ring_bytes / 2 || payload > LENGTH_MASK) {
+        // Larger than a ring can reasonably batch; these are rare enough to write inline
+        write_direct(stream, line);
+        return true;
+    }
+
+    Ring& ring = local_ring();
+    ring.submitted.store(ring.submitted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    size_t pos = static_cast<size_t>(head) & ring.mask;
+    size_t contiguous = ring.capacity() - pos;
+    size_t total = contiguous < needed ? contiguous + needed : needed;
+    if (ring.capacity() - (head - ring.tail.load(std::memory_order_acquire)) < total &&
+        !wait_for_space(ring, total)) {
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    char* data = ring.buffer.data();
+    if (contiguous < needed) {
+        std::memcpy(data + pos, &PAD_RECORD, HEADER_BYTES);
+        head += contiguous;
+        pos = 0;
+    }
+    uint32_t header = static_cast<uint32_t>(payload) | (stream == Stream::err ? ERR_STREAM : 0u);
+    std::memcpy(data + pos, &header, HEADER_BYTES);
+    std::memcpy(data + pos + HEADER_BYTES, line.data(), line.size());
+    data[pos + HEADER_BYTES + line.size()] = '\n';
+    head += needed;
+    ring.head.store(head, std::memory_order_release);
+
+    if (head - ring.tail.load(std::memory_order_relaxed) > ring.capacity() / 2) {
+        wake_writer();
+    }
+    return true;
+}
+
+void AsyncLogger::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        return;
+    }
+    uint64_t ticket = ++flush_requested_;
+    work_cv_.notify_one();
+    flushed_cv_.wait(lock, [this, ticket]() { return flush_completed_ >= ticket; });
+}
+
+AsyncLogger::Stats AsyncLogger::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        stats.submitted = retired_submitted_;
+        stats.dropped = retired_dropped_;
+        for (const auto& ring : rings_) {
+            stats.submitted += ring->submitted.load(std::memory_order_relaxed);
+            stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+        stats.threads = rings_.size();
+    }
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+    stats.write_calls = write_calls_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+AsyncLogger::Ring& AsyncLogger::local_ring() {
+    for (auto& entry : local_rings.entries) {
+        if (entry.logger_id == id_) {
+            return *static_cast<Ring*>(entry.ring);
+        }
+    }
+
+    auto ring = std::make_shared<Ring>(config_.ring_bytes);
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+    local_rings.entries.push_back({id_, ring.get(), std::shared_ptr<std::atomic<bool>>(ring, &ring->closed)});
+    return *ring;
+}
+
+bool AsyncLogger::wait_for_space(Ring& ring, size_t needed) {
+    if (config_.max_block_us <= 0) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(config_.max_block_us);
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    do {
+        wake_writer();
+        std::this_thread::yield();
+        if (ring.capacity() - (head - ring.tail.load(std::memory_order_acquire)) >= needed) {
+            return true;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+}
+
+void AsyncLogger::write_direct(Stream stream, std::string_view line) {
+    char newline = '\n';
+    iovec iov[2] = {
+        {const_cast<char*>(line.data()), line.size()},
+        {&newline, 1}
+    };
+    ssize_t written = ::writev(stream == Stream::err ? err_fd_ : out_fd_, iov, 2);
+    write_calls_.fetch_add(1, std::memory_order_relaxed);
+    if (written > 0) {
+        written_.fetch_add(1, std::memory_order_relaxed);
+        bytes_written_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::wake_writer() {
+    if (!wake_requested_.load(std::memory_order_relaxed) &&
+        !wake_requested_.exchange(true, std::memory_order_relaxed)) {
+        work_cv_.notify_one();
+    }
+}
+
+void AsyncLogger::writer_loop() {
+    auto interval = std::chrono::milliseconds(std::max<int64_t>(config_.flush_interval_ms, 1));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait_for(lock, interval, [this]() {
+            return !running_ || flush_requested_ > flush_completed_ ||
+                   wake_requested_.load(std::memory_order_relaxed);
+        });
+        bool stopping = !running_;
+        uint64_t target = flush_requested_;
+        wake_requested_.store(false, std::memory_order_relaxed);
+
+        lock.unlock();
+        drain();
+        lock.lock();
+
+        flush_completed_ = target;
+        flushed_cv_.notify_all();
+        if (stopping) {
+            break;
+        }
+    }
+}
+
+void AsyncLogger::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    // With a log file both streams share one descriptor and one batch
+    std::vector<iovec> batches[2];
+    std::vector<std::pair<Ring*, uint64_t>> consumed;
+
+    auto write_batches = [&]() {
+        int fds[2] = {out_fd_, err_fd_};
+        for (size_t stream = 0; stream < 2; stream++) {
+            auto& iov = batches[stream];
+            size_t done = 0;
+            while (done < iov.size()) {
+                int count = static_cast<int>(std::min(iov.size() - done, MAX_BATCH_IOVECS));
+                ssize_t written = ::writev(fds[stream], &iov[done], count);
+                write_calls_.fetch_add(1, std::memory_order_relaxed);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    break; // Nowhere to report it; the lines are lost
+                }
+                bytes_written_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+                auto remaining = static_cast<size_t>(written);
+                while (done < iov.size() && remaining >= iov[done].iov_len) {
+                    remaining -= iov[done].iov_len;
+                    done++;
+                }
+                if (remaining > 0) {
+                    iov[done].iov_base = static_cast<char*>(iov[done].iov_base) + remaining;
+                    iov[done].iov_len -= remaining;
+                }
+            }
+            written_.fetch_add(done, std::memory_order_relaxed);
+            iov.clear();
+        }
+        // Only now may producers reuse the space the iovecs pointed into
+        for (auto& [ring, tail] : consumed) {
+            ring->tail.store(tail, std::memory_order_release);
+        }
+        consumed.clear();
+    };
+
+    for (auto& ring_ptr : rings) {
+        Ring& ring = *ring_ptr;
+        const char* data = ring.buffer.data();
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        while (tail < head) {
+            size_t pos = static_cast<size_t>(tail) & ring.mask;
+            uint32_t header;
+            std::memcpy(&header, data + pos, HEADER_BYTES);
+            if (header & PAD_RECORD) {
+                tail += ring.capacity() - pos;
+                continue;
+            }
+            size_t payload = header & LENGTH_MASK;
+            size_t stream = (header & ERR_STREAM) && !owns_fd_ ? 1 : 0;
+            batches[stream].push_back({const_cast<char*>(data + pos + HEADER_BYTES), payload});
+            tail += record_bytes(payload);
+
+            if (batches[stream].size() >= MAX_BATCH_IOVECS) {
+                consumed.emplace_back(&ring, tail);
+                write_batches();
+            }
+        }
+        consumed.emplace_back(&ring, tail);
+    }
+    write_batches();
+
+    // Forget rings of exited threads once everything they queued is written
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (auto it = rings_.begin(); it != rings_.end();) {
+        Ring& ring = **it;
+        if (ring.closed.load(std::memory_order_acquire) &&
+            ring.tail.load(std::memory_order_relaxed) == ring.head.load(std::memory_order_acquire)) {
+            retired_submitted_ += ring.submitted.load(std::memory_order_relaxed);
+            retired_dropped_ += ring.dropped.load(std::memory_order_relaxed);
+            it = rings_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace worker
+} // namespace beamline
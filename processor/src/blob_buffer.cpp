@@ -0,0 +1,102 @@
+#include "beamline/worker/blob_buffer.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+// Owns one mmap() region; unmapped when the last BlobBuffer referencing it is gone
+struct Mapping {
+    void* address = MAP_FAILED;
+    size_t length = 0;
+
+    ~Mapping() {
+        if (address != MAP_FAILED) {
+            munmap(address, length);
+        }
+    }
+};
+
+} // namespace
+
+BlobBuffer BlobBuffer::map_file(const std::string& path, uint64_t offset, uint64_t length) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            throw std::runtime_error("File not found: " + path);
+        }
+        throw std::runtime_error("Failed to open file for reading: " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("Failed to stat file: " + path + ": " + std::strerror(err));
+    }
+    auto file_size = static_cast<uint64_t>(st.st_size);
+    if (offset > file_size) {
+        close(fd);
+        throw std::runtime_error("Offset " + std::to_string(offset) + " is beyond end of file (" +
+                                 std::to_string(file_size) + " bytes): " + path);
+    }
+    uint64_t available = file_size - offset;
+    uint64_t range = length == 0 ? available : std::min(length, available);
+
+    BlobBuffer buffer;
+    buffer.file_size_ = file_size;
+    if (range == 0) {
+        close(fd);
+        return buffer; // mmap() rejects zero-length mappings
+    }
+
+    // mmap offsets must be page aligned; map from the page start and skip the prefix
+    auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t aligned_offset = offset - (offset % page_size);
+    auto prefix = static_cast<size_t>(offset - aligned_offset);
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->length = static_cast<size_t>(range) + prefix;
+    mapping->address = mmap(nullptr, mapping->length, PROT_READ, MAP_PRIVATE, fd,
+                            static_cast<off_t>(aligned_offset));
+    int err = errno;
+    close(fd); // The mapping keeps the file referenced
+    if (mapping->address == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file: " + path + ": " + std::strerror(err));
+    }
+    madvise(mapping->address, mapping->length, MADV_SEQUENTIAL);
+
+    buffer.data_ = static_cast<const char*>(mapping->address) + prefix;
+    buffer.size_ = static_cast<size_t>(range);
+    buffer.storage_ = std::move(mapping);
+    return buffer;
+}
+
+BlobBuffer BlobBuffer::from_string(std::string data) {
+    auto owned = std::make_shared<const std::string>(std::move(data));
+    BlobBuffer buffer;
+    buffer.data_ = owned->data();
+    buffer.size_ = owned->size();
+    buffer.file_size_ = owned->size();
+    buffer.storage_ = std::move(owned);
+    return buffer;
+}
+
+BlobBuffer BlobBuffer::slice(size_t offset, size_t length) const {
+    BlobBuffer sliced = *this;
+    size_t start = std::min(offset, size_);
+    sliced.data_ = data_ ? data_ + start : nullptr;
+    sliced.size_ = std::min(length, size_ - start);
+    return sliced;
+}
+
+} // namespace worker
+} // namespace beamline
@@ -1,15 +1,164 @@
 #include "beamline/worker/blocks/fs_block.hpp"
 #include "beamline/worker/timeout_enforcement.hpp"
 #include "beamline/worker/feature_flags.hpp"
+#include "beamline/worker/blob_buffer.hpp"
+#include "beamline/worker/group_commit.hpp"
+#include "beamline/worker/io_executor.hpp"
+#include "beamline/worker/tracer.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <filesystem>
 #include <chrono>
-#include <future>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_set>
 
 namespace beamline {
 namespace worker {
 
+const std::vector<std::string>& fs_allowed_roots() {
+    static const std::vector<std::string> roots = {
+        "/tmp/beamline/",
+        "/var/lib/beamline/data/",
+        "./data/"
+    };
+    return roots;
+}
+
+bool is_fs_path_allowed(const std::string& path) {
+    // Normalize so "/tmp/beamline/../etc" cannot escape a root
+    std::string normalized = std::filesystem::path(path).lexically_normal().string();
+    
+    for (const auto& root : fs_allowed_roots()) {
+        std::string prefix = std::filesystem::path(root).lexically_normal().string();
+        if (normalized.find(prefix) == 0) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+namespace {
+
+// Directories already known to exist, so hot paths skip create_directories()
+std::mutex& created_dirs_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_set<std::string>& created_dirs() {
+    static std::unordered_set<std::string> dirs;
+    return dirs;
+}
+
+void ensure_directory(const std::filesystem::path& dir) {
+    std::string key = dir.string();
+    {
+        std::lock_guard<std::mutex> lock(created_dirs_mutex());
+        if (created_dirs().count(key)) {
+            return;
+        }
+    }
+    std::filesystem::create_directories(dir);
+    std::lock_guard<std::mutex> lock(created_dirs_mutex());
+    created_dirs().insert(std::move(key));
+}
+
+// Write `content` to a temp file next to `path`, make it durable per `sync_policy`,
+// then atomically publish it. Readers see either the old file or the complete new one.
+// A cancelled `task` (timed-out step) abandons the write before the file is published.
+std::pair<bool, std::string> write_blob_atomically(const std::string& path, const std::string& content,
+                                                   bool overwrite, SyncPolicy sync_policy,
+                                                   const IoTask* task = nullptr) {
+    constexpr size_t write_chunk_size = 1024 * 1024;
+    static std::atomic<uint64_t> temp_counter{0};
+    
+    try {
+        std::filesystem::path filepath(path);
+        auto dir = filepath.parent_path();
+        ensure_directory(dir);
+        
+        std::string temp_path = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(temp_counter++);
+        int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno == ENOENT) {
+            // Directory was removed behind the cache's back
+            {
+                std::lock_guard<std::mutex> lock(created_dirs_mutex());
+                created_dirs().erase(dir.string());
+            }
+            ensure_directory(dir);
+            fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        }
+        if (fd < 0) {
+            return {false, "Failed to open file for writing: " + path + ": " + std::strerror(errno)};
+        }
+        
+        auto fail = [&](const std::string& message) -> std::pair<bool, std::string> {
+            close(fd);
+            unlink(temp_path.c_str());
+            return {false, message};
+        };
+        
+        size_t written = 0;
+        while (written < content.size()) {
+            if (task && task->cancelled()) {
+                return fail("FS write cancelled: " + path);
+            }
+            auto n = write(fd, content.data() + written, std::min(content.size() - written, write_chunk_size));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return fail("Failed to write file: " + path + ": " + std::strerror(errno));
+            }
+            written += static_cast<size_t>(n);
+        }
+        
+        std::string sync_error;
+        if (!GroupCommitter::instance().sync_file(fd, sync_policy, sync_error)) {
+            return fail(sync_error);
+        }
+        if (task && task->cancelled()) {
+            return fail("FS write cancelled: " + path);
+        }
+        close(fd);
+        
+        if (overwrite) {
+            if (rename(temp_path.c_str(), path.c_str()) != 0) {
+                int err = errno;
+                unlink(temp_path.c_str());
+                return {false, "Failed to rename into place: " + path + ": " + std::strerror(err)};
+            }
+        } else {
+            // link() refuses to replace an existing file, closing the exists() check race
+            if (link(temp_path.c_str(), path.c_str()) != 0) {
+                int err = errno;
+                unlink(temp_path.c_str());
+                if (err == EEXIST) {
+                    return {false, "File already exists and overwrite is false: " + path};
+                }
+                return {false, "Failed to link into place: " + path + ": " + std::strerror(err)};
+            }
+            unlink(temp_path.c_str());
+        }
+        
+        if (!GroupCommitter::instance().sync_directory(dir.empty() ? "." : dir.string(), sync_policy, sync_error)) {
+            return {false, sync_error};
+        }
+        return {true, ""};
+    } catch (const std::exception& e) {
+        return {false, e.what()};
+    }
+}
+
+} // namespace
+
 // FsBlockExecutor (fs.blob_put)
 FsBlockExecutor::FsBlockExecutor() : BaseBlockExecutor("fs.blob_put", ResourceClass::io) {}
 
@@ -48,60 +197,56 @@ caf::expected<StepResult> FsBlockExecutor::execute_impl(const StepRequest& req,
             throw std::runtime_error("Path not allowed: " + path);
         }
         
+        // Durability policy: per-step "sync" input overrides the worker default
+        SyncPolicy sync_policy = GroupCommitter::instance().policy();
+        std::string sync_input = get_input_or_default(req, "sync");
+        if (!sync_input.empty()) {
+            auto parsed = parse_sync_policy(sync_input);
+            if (!parsed) {
+                throw std::invalid_argument("Invalid sync policy: " + sync_input);
+            }
+            sync_policy = *parsed;
+        }
+        
         // Check if file exists and overwrite is false
         if (!overwrite && std::filesystem::exists(path)) {
             throw std::runtime_error("File already exists and overwrite is false: " + path);
         }
         
+        // Ends with the I/O; a failure is reported on the enclosing step.attempt span
+        auto io_span = Tracer::instance().start_child("fs.write");
+        io_span.set_attribute("fs.bytes", static_cast<int64_t>(content.size()));
+        
         // CP2: Execute FS operations with timeout
         if (FeatureFlags::is_complete_timeout_enabled() && fs_timeout_ms > 0) {
-            // Execute file write in async with timeout
+            // Execute file write on the shared blocking-I/O executor; the deadline counts from step start
             // Capture by value to avoid race conditions
-            auto write_future = std::async(std::launch::async, [path, content]() -> std::pair<bool, std::string> {
-                try {
-                    // Create directory if it doesn't exist
-                    std::filesystem::path filepath(path);
-                    std::filesystem::create_directories(filepath.parent_path());
-                    
-                    // Write file
-                    std::ofstream file(path, std::ios::binary);
-                    if (!file.is_open()) {
-                        return {false, "Failed to open file for writing: " + path};
-                    }
-                    
-                    file.write(content.data(), static_cast<std::streamsize>(content.size()));
-                    file.close();
-                    return {true, ""};
-                } catch (const std::exception& e) {
-                    return {false, e.what()};
-                }
-            });
+            auto deadline = start_time + std::chrono::milliseconds(fs_timeout_ms);
+            std::pair<bool, std::string> outcome;
+            auto status = IoExecutor::instance().run_until<std::pair<bool, std::string>>(
+                [path, content, overwrite, sync_policy](const IoTask& task) {
+                    return write_blob_atomically(path, content, overwrite, sync_policy, &task);
+                }, deadline, outcome);
             
-            auto status = write_future.wait_for(std::chrono::milliseconds(fs_timeout_ms));
-            if (status == std::future_status::timeout) {
+            if (status == IoTaskStatus::rejected) {
+                throw std::runtime_error("FS write operation rejected: I/O executor queue is full");
+            } else if (status != IoTaskStatus::completed) {
                 throw std::runtime_error("FS write operation timeout: exceeded " + 
                                         std::to_string(fs_timeout_ms) + "ms");
             }
             
-            auto [operation_success, operation_error] = write_future.get();
+            auto [operation_success, operation_error] = outcome;
             if (!operation_success) {
                 throw std::runtime_error(operation_error);
             }
         } else {
             // CP1 behavior: no timeout enforcement
-            // Create directory if it doesn't exist
-            std::filesystem::path filepath(path);
-            std::filesystem::create_directories(filepath.parent_path());
-            
-            // Write file
-            std::ofstream file(path, std::ios::binary);
-            if (!file.is_open()) {
-                throw std::runtime_error("Failed to open file for writing: " + path);
+            auto [operation_success, operation_error] = write_blob_atomically(path, content, overwrite, sync_policy);
+            if (!operation_success) {
+                throw std::runtime_error(operation_error);
             }
-            
-            file.write(content.data(), static_cast<std::streamsize>(content.size()));
-            file.close();
         }
+        io_span.end();
         
         auto end_time = std::chrono::steady_clock::now();
         auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
@@ -109,6 +254,7 @@ caf::expected<StepResult> FsBlockExecutor::execute_impl(const StepRequest& req,
         std::unordered_map<std::string, std::string> outputs;
         outputs["path"] = path;
         outputs["size"] = std::to_string(content.size());
+        outputs["sync"] = sync_policy_to_string(sync_policy);
         outputs["created"] = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
         
         record_success(latency_ms, 0, static_cast<int64_t>(content.size()));
@@ -126,6 +272,8 @@ caf::expected<StepResult> FsBlockExecutor::execute_impl(const StepRequest& req,
         if (error_msg.find("permission") != std::string::npos || 
             error_msg.find("Permission") != std::string::npos) {
             error_code = ErrorCode::permission_denied;
+        } else if (dynamic_cast<const std::invalid_argument*>(&e) != nullptr) {
+            error_code = ErrorCode::invalid_input;
         }
         
         return StepResult::error_result(error_code, error_msg, metadata, latency_ms);
@@ -133,19 +281,7 @@ caf::expected<StepResult> FsBlockExecutor::execute_impl(const StepRequest& req,
 }
 
 bool FsBlockExecutor::is_path_allowed(const std::string& path) {
-    std::vector<std::string> allowed_prefixes = {
-        "/tmp/beamline/",
-        "/var/lib/beamline/data/",
-        "./data/"
-    };
-    
-    for (const auto& prefix : allowed_prefixes) {
-        if (path.find(prefix) == 0) {
-            return true;
-        }
-    }
-    
-    return false;
+    return is_fs_path_allowed(path);
 }
 
 // FsGetBlockExecutor (fs.blob_get)
@@ -184,81 +320,64 @@ caf::expected<StepResult> FsGetBlockExecutor::execute_impl(const StepRequest& re
             throw std::runtime_error("Path not allowed: " + path);
         }
         
-        std::string content;
-        std::streamsize file_size = 0;
+        // Optional byte range; length 0 reads to end of file
+        uint64_t offset = 0;
+        uint64_t length = 0;
+        try {
+            offset = std::stoull(get_input_or_default(req, "offset", "0"));
+            length = std::stoull(get_input_or_default(req, "length", "0"));
+        } catch (const std::exception&) {
+            auto end_time = std::chrono::steady_clock::now();
+            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            record_error(latency_ms);
+            return StepResult::error_result(ErrorCode::invalid_format, "Invalid offset/length", metadata, latency_ms);
+        }
+        
+        // "buffer" hands the mapping to in-process consumers via StepResult::blobs without copying;
+        // "inline" (default) also copies the bytes into outputs["content"]
+        bool inline_content = get_input_or_default(req, "content_mode", "inline") != "buffer";
+        
+        BlobBuffer buffer;
+        auto io_span = Tracer::instance().start_child("fs.read");
         
         if (FeatureFlags::is_complete_timeout_enabled() && fs_timeout_ms > 0) {
-            // Execute file read in async with timeout
-            auto read_future = std::async(std::launch::async, [path]() -> std::tuple<bool, std::string, std::streamsize> {
-                try {
-                    // Check if file exists
-                    if (!std::filesystem::exists(path)) {
-                        return {false, "File not found: " + path, 0};
-                    }
-                    
-                    // Read file
-                    std::ifstream file(path, std::ios::binary | std::ios::ate);
-                    if (!file.is_open()) {
-                        return {false, "Failed to open file for reading: " + path, 0};
-                    }
-                    
-                    std::streamsize size = file.tellg();
-                    file.seekg(0, std::ios::beg);
-                    
-                    std::string file_content;
-                    file_content.resize(static_cast<size_t>(size));
-                    file.read(file_content.data(), size);
-                    file.close();
-                    return {true, std::move(file_content), size};
-                } catch (const std::exception& e) {
-                    return {false, e.what(), 0};
-                }
-            });
+            // Map file on the shared blocking-I/O executor; the deadline counts from step start
+            auto deadline = start_time + std::chrono::milliseconds(fs_timeout_ms);
+            auto status = IoExecutor::instance().run_until<BlobBuffer>(
+                [path, offset, length](const IoTask&) {
+                    return BlobBuffer::map_file(path, offset, length);
+                }, deadline, buffer);
             
-            auto status = read_future.wait_for(std::chrono::milliseconds(fs_timeout_ms));
-            if (status == std::future_status::timeout) {
+            if (status == IoTaskStatus::rejected) {
+                throw std::runtime_error("FS read operation rejected: I/O executor queue is full");
+            } else if (status != IoTaskStatus::completed) {
                 throw std::runtime_error("FS read operation timeout: exceeded " + 
                                         std::to_string(fs_timeout_ms) + "ms");
             }
-            
-            auto [operation_success, read_content, read_file_size] = read_future.get();
-            if (!operation_success) {
-                throw std::runtime_error(read_content);
-            }
-            content = std::move(read_content);
-            file_size = read_file_size;
         } else {
             // CP1 behavior: no timeout enforcement
-            // Check if file exists
-            if (!std::filesystem::exists(path)) {
-                throw std::runtime_error("File not found: " + path);
-            }
-            
-            // Read file
-            std::ifstream file(path, std::ios::binary | std::ios::ate);
-            if (!file.is_open()) {
-                throw std::runtime_error("Failed to open file for reading: " + path);
-            }
-            
-            file_size = file.tellg();
-            file.seekg(0, std::ios::beg);
-            
-            content.resize(static_cast<size_t>(file_size));
-            file.read(content.data(), file_size);
-            file.close();
+            buffer = BlobBuffer::map_file(path, offset, length);
         }
+        io_span.set_attribute("fs.bytes", static_cast<int64_t>(buffer.size()));
+        io_span.end();
         
         auto end_time = std::chrono::steady_clock::now();
         auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
         
         std::unordered_map<std::string, std::string> outputs;
         outputs["path"] = path;
-        outputs["content"] = content;
-        outputs["size"] = std::to_string(static_cast<int64_t>(file_size));
+        if (inline_content) {
+            outputs["content"] = std::string(buffer.view());
+        }
+        outputs["size"] = std::to_string(buffer.size());
+        outputs["offset"] = std::to_string(offset);
+        outputs["file_size"] = std::to_string(buffer.file_size());
         outputs["modified"] = std::to_string(std::filesystem::last_write_time(path).time_since_epoch().count());
         
-        record_success(latency_ms, 0, static_cast<int64_t>(file_size));
-        return StepResult::success(metadata, outputs, latency_ms);
+        record_success(latency_ms, 0, static_cast<int64_t>(buffer.size()));
+        auto result = StepResult::success(metadata, outputs, latency_ms);
+        result.blobs["content"] = std::move(buffer);
+        return result;
         
     } catch (const std::exception& e) {
         auto end_time = std::chrono::steady_clock::now();
@@ -272,6 +391,8 @@ caf::expected<StepResult> FsGetBlockExecutor::execute_impl(const StepRequest& re
         if (error_msg.find("not found") != std::string::npos || 
             error_msg.find("Not found") != std::string::npos) {
             error_code = ErrorCode::resource_unavailable;
+        } else if (error_msg.find("beyond end of file") != std::string::npos) {
+            error_code = ErrorCode::invalid_input;
         }
         
         return StepResult::error_result(error_code, error_msg, metadata, latency_ms);
@@ -279,19 +400,7 @@ caf::expected<StepResult> FsGetBlockExecutor::execute_impl(const StepRequest& re
 }
 
 bool FsGetBlockExecutor::is_path_allowed(const std::string& path) {
-    std::vector<std::string> allowed_prefixes = {
-        "/tmp/beamline/",
-        "/var/lib/beamline/data/",
-        "./data/"
-    };
-    
-    for (const auto& prefix : allowed_prefixes) {
-        if (path.find(prefix) == 0) {
-            return true;
-        }
-    }
-    
-    return false;
+    return is_fs_path_allowed(path);
 }
 
 } // namespace worker
@@ -1,28 +1,138 @@
 #include "beamline/worker/blocks/http_block.hpp"
+#include "beamline/worker/blocks/fs_block.hpp"
 #include "beamline/worker/timeout_enforcement.hpp"
 #include "beamline/worker/feature_flags.hpp"
-#include <curl/curl.h>
+#include "beamline/worker/tracer.hpp"
 #include <chrono>
-#include <stdexcept>
+#include <filesystem>
+#include <memory>
+#include <vector>
 
 namespace beamline {
 namespace worker {
 
 using json = nlohmann::json;
 
+namespace {
+
+// Client span for one request; its context goes downstream as the traceparent header
+Span start_request_span(HttpEngine::Request& http_request) {
+    auto span = Tracer::instance().start_child("http.request", Tracer::SpanKind::client);
+    if (span) {
+        span.set_attribute("http.method", http_request.method);
+        http_request.headers.push_back("traceparent: " + span.context().traceparent());
+    }
+    return span;
+}
+
+void end_request_span(Span& span, const HttpEngine::Response& response) {
+    if (!span) {
+        return;
+    }
+    span.set_attribute("http.status_code", int64_t{response.status_code});
+    if (!response.ok()) {
+        span.set_error(response.error);
+    } else if (response.status_code >= 500) {
+        span.set_error("HTTP " + std::to_string(response.status_code));
+    }
+    span.end();
+}
+
+} // namespace
+
 HttpBlockExecutor::HttpBlockExecutor() : BaseBlockExecutor("http.request", ResourceClass::io) {}
 
+HttpBlockExecutor::~HttpBlockExecutor() {
+    std::vector<HttpEngine::TransferId> transfers;
+    {
+        std::lock_guard<std::mutex> lock(in_flight_->mutex);
+        for (const auto& [key, entry] : in_flight_->entries) {
+            transfers.push_back(entry.transfer_id);
+        }
+    }
+    for (auto id : transfers) {
+        HttpEngine::instance().cancel(id);
+    }
+}
+
 caf::expected<StepResult> HttpBlockExecutor::execute_impl(const StepRequest& req, const BlockContext& ctx) {
     auto start_time = std::chrono::steady_clock::now();
     auto metadata = BlockExecutor::metadata_from_context(ctx);
     
+    HttpEngine::Request http_request;
+    if (auto invalid = prepare_request(req, metadata, start_time, http_request)) {
+        record_result(*invalid);
+        return *invalid;
+    }
+    
+    // Synchronous callers still go through the shared engine so connections are reused
+    auto request_span = start_request_span(http_request);
+    auto response = HttpEngine::instance().perform(std::move(http_request));
+    end_request_span(request_span, response);
+    auto result = complete_request(std::move(response), metadata, start_time);
+    record_result(result);
+    return result;
+}
+
+void HttpBlockExecutor::execute_async(const StepRequest& req, const BlockContext& ctx, StepCompletion done) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto metadata = BlockExecutor::metadata_from_context(ctx);
+    
+    HttpEngine::Request http_request;
+    if (auto invalid = prepare_request(req, metadata, start_time, http_request)) {
+        done(*invalid);
+        return;
+    }
+    
+    // The engine's callbacks must be copyable, so an active span is shared with the completion
+    std::shared_ptr<Span> request_span;
+    if (auto span = start_request_span(http_request)) {
+        request_span = std::make_shared<Span>(std::move(span));
+    }
+    
+    // Held across submit() so the completion cannot remove the entry before it is added
+    std::lock_guard<std::mutex> lock(in_flight_->mutex);
+    auto key = in_flight_->next_key++;
+    auto transfer_id = HttpEngine::instance().submit(std::move(http_request),
+        [in_flight = in_flight_, key, metadata, start_time, request_span, done = std::move(done)](
+            HttpEngine::Response response) {
+            {
+                std::lock_guard<std::mutex> entries_lock(in_flight->mutex);
+                in_flight->entries.erase(key);
+            }
+            if (request_span) {
+                end_request_span(*request_span, response);
+            }
+            done(complete_request(std::move(response), metadata, start_time));
+        });
+    in_flight_->entries.emplace(key, InFlightTransfers::Entry{get_input_or_default(req, "step_id"), transfer_id});
+}
+
+caf::expected<void> HttpBlockExecutor::cancel(const std::string& step_id) {
+    std::vector<HttpEngine::TransferId> transfers;
+    {
+        std::lock_guard<std::mutex> lock(in_flight_->mutex);
+        for (const auto& [key, entry] : in_flight_->entries) {
+            if (entry.step_id == step_id) {
+                transfers.push_back(entry.transfer_id);
+            }
+        }
+    }
+    // The completions still run (with an aborted transfer) and remove the entries
+    for (auto id : transfers) {
+        HttpEngine::instance().cancel(id);
+    }
+    return caf::unit;
+}
+
+std::optional<StepResult> HttpBlockExecutor::prepare_request(const StepRequest& req, const ResultMetadata& metadata,
+                                                             std::chrono::steady_clock::time_point start_time,
+                                                             HttpEngine::Request& http_request) {
     // Validate required inputs
     std::vector<std::string> required_inputs = {"url", "method"};
     if (!validate_required_inputs(req, required_inputs)) {
         auto end_time = std::chrono::steady_clock::now();
         auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        record_error(latency_ms);
-        
         return StepResult::error_result(
             ErrorCode::missing_required_field,
             "Missing required inputs: url, method",
@@ -31,175 +141,111 @@ caf::expected<StepResult> HttpBlockExecutor::execute_impl(const StepRequest& req
         );
     }
     
-    std::string url = req.inputs.at("url");
-    std::string method = req.inputs.at("method");
-    std::string body = get_input_or_default(req, "body");
+    http_request.url = req.inputs.at("url");
+    http_request.method = req.inputs.at("method");
+    http_request.body = get_input_or_default(req, "body");
     std::string headers_json = get_input_or_default(req, "headers", "{}");
     
+    // Parse headers
+    json headers;
     try {
-        // Parse headers
-        json headers;
-        try {
-            headers = json::parse(headers_json);
-        } catch (const json::parse_error& e) {
-            auto end_time = std::chrono::steady_clock::now();
-            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            record_error(latency_ms);
-            
-            return StepResult::error_result(
-                ErrorCode::invalid_format,
-                "Invalid headers JSON: " + std::string(e.what()),
-                metadata,
-                latency_ms
-            );
-        }
-        
-        // Execute HTTP request
-        auto http_result = perform_http_request(url, method, body, headers, req.timeout_ms);
-        
+        headers = json::parse(headers_json);
+    } catch (const json::parse_error& e) {
         auto end_time = std::chrono::steady_clock::now();
         auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        
-        // Prepare outputs
-        std::unordered_map<std::string, std::string> outputs;
-        outputs["status_code"] = std::to_string(http_result.status_code);
-        outputs["body"] = http_result.body;
-        outputs["headers"] = http_result.headers;
-        
-        if (http_result.status_code >= 200 && http_result.status_code < 300) {
-            record_success(latency_ms);
-            return StepResult::success(metadata, outputs, latency_ms);
+        return StepResult::error_result(
+            ErrorCode::invalid_format,
+            "Invalid headers JSON: " + std::string(e.what()),
+            metadata,
+            latency_ms
+        );
+    }
+    
+    for (auto& [key, value] : headers.items()) {
+        std::string value_str;
+        if (value.is_string()) {
+            value_str = value.get<std::string>();
         } else {
-            record_error(latency_ms);
-            return StepResult::error_result(
-                ErrorCode::http_error,
-                "HTTP request failed with status: " + std::to_string(http_result.status_code),
-                metadata,
-                latency_ms
-            );
+            value_str = value.dump();
         }
-        
-    } catch (const std::exception& e) {
-        auto end_time = std::chrono::steady_clock::now();
-        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        record_error(latency_ms);
-        
-        // Determine error code based on exception type
-        ErrorCode error_code = ErrorCode::network_error;
-        std::string error_msg = "HTTP request exception: " + std::string(e.what());
-        
-        // Check for timeout-related errors
-        if (error_msg.find("timeout") != std::string::npos || 
-            error_msg.find("TIMEOUT") != std::string::npos) {
-            error_code = ErrorCode::connection_timeout;
+        http_request.headers.push_back(key + ": " + value_str);
+    }
+    
+    // Response streaming: cap the in-memory body, spill larger bodies to a blob under the fs roots.
+    // The engine bounds max_body_bytes by --http-max-body-bytes.
+    std::string max_body_bytes = get_input_or_default(req, "max_body_bytes");
+    if (!max_body_bytes.empty()) {
+        try {
+            http_request.max_body_in_memory = static_cast<size_t>(std::stoull(max_body_bytes));
+        } catch (const std::exception&) {
+            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+            return StepResult::error_result(ErrorCode::invalid_format,
+                                            "Invalid max_body_bytes: " + max_body_bytes, metadata, latency_ms);
         }
-        
-        return StepResult::error_result(error_code, error_msg, metadata, latency_ms);
     }
-}
-
-HttpBlockExecutor::HttpResponse HttpBlockExecutor::perform_http_request(const std::string& url, const std::string& method, 
-                                 const std::string& body, const json& headers, 
-                                 int64_t timeout_ms) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error("Failed to initialize CURL");
+    http_request.spill_dir = get_input_or_default(req, "spill_dir");
+    if (!http_request.spill_dir.empty() && !is_fs_path_allowed(http_request.spill_dir + "/")) {
+        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+        return StepResult::error_result(ErrorCode::permission_denied,
+                                        "Spill directory not allowed: " + http_request.spill_dir, metadata, latency_ms);
     }
     
-    std::string response_body;
-    std::string response_headers;
-    long response_code = 0;
-    
-    // Set basic options
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
-    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
-    
     // CP2: Separate connection timeout and total timeout
     if (FeatureFlags::is_complete_timeout_enabled()) {
         int64_t connection_timeout = TimeoutEnforcement::get_http_connection_timeout_ms();
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connection_timeout);
+        http_request.connect_timeout_ms = connection_timeout;
         
         // Total timeout = connection timeout + request timeout
-        int64_t request_timeout = timeout_ms - connection_timeout;
-        if (request_timeout > 0) {
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, request_timeout);
-        } else {
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
-        }
+        int64_t request_timeout = req.timeout_ms - connection_timeout;
+        http_request.timeout_ms = request_timeout > 0 ? request_timeout : req.timeout_ms;
     } else {
         // CP1 behavior: single timeout
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+        http_request.timeout_ms = req.timeout_ms;
     }
     
-    // Set method
-    if (method == "GET") {
-        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-    } else if (method == "POST") {
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
-    } else if (method == "PUT") {
-        // Use CUSTOMREQUEST PUT with POSTFIELDS to avoid dealing with READFUNCTION/FILE*
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
-    } else if (method == "DELETE") {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-    }
+    return std::nullopt;
+}
+
+StepResult HttpBlockExecutor::complete_request(HttpEngine::Response response, const ResultMetadata& metadata,
+                                               std::chrono::steady_clock::time_point start_time) {
+    auto end_time = std::chrono::steady_clock::now();
+    auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
     
-    // Set headers
-    struct curl_slist* header_list = nullptr;
-    for (auto& [key, value] : headers.items()) {
-        std::string value_str;
-        if (value.is_string()) {
-            value_str = value.get<std::string>();
-        } else {
-            value_str = value.dump();
-        }
-        std::string header = key + ": " + value_str;
-        header_list = curl_slist_append(header_list, header.c_str());
-    }
-    if (header_list) {
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+    if (!response.ok()) {
+        // Determine error code based on transfer failure
+        ErrorCode error_code = response.timed_out() ? ErrorCode::connection_timeout : ErrorCode::network_error;
+        std::string error_msg = "HTTP request exception: CURL request failed: " + response.error;
+        return StepResult::error_result(error_code, error_msg, metadata, latency_ms);
     }
     
-    // Perform request
-    CURLcode res = curl_easy_perform(curl);
-    
-    if (res != CURLE_OK) {
-        curl_slist_free_all(header_list);
-        curl_easy_cleanup(curl);
-        throw std::runtime_error("CURL request failed: " + std::string(curl_easy_strerror(res)));
+    // Prepare outputs; spilled bodies are returned as a blob reference, not bytes
+    std::unordered_map<std::string, std::string> outputs;
+    outputs["status_code"] = std::to_string(response.status_code);
+    outputs["body_size"] = std::to_string(response.body_size);
+    if (response.spilled()) {
+        outputs["body_path"] = response.body_path;
+        outputs["body_spilled"] = "true";
+    } else {
+        outputs["body"] = std::move(response.body);
     }
+    outputs["headers"] = std::move(response.headers);
     
-    // Get response code
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    
-    // Cleanup
-    curl_slist_free_all(header_list);
-    curl_easy_cleanup(curl);
-    
-    return {static_cast<int>(response_code), response_body, response_headers};
-}
-
-size_t HttpBlockExecutor::write_callback(void* contents, size_t size, size_t nmemb, std::string* userp) {
-    if (userp == nullptr || contents == nullptr) {
-        return 0;
+    if (response.status_code >= 200 && response.status_code < 300) {
+        return StepResult::success(metadata, outputs, latency_ms);
     }
-    const char* data = static_cast<const char*>(contents);
-    userp->append(data, size * nmemb);
-    return size * nmemb;
-}
-
-size_t HttpBlockExecutor::header_callback(char* buffer, size_t size, size_t nitems, std::string* userdata) {
-    if (userdata == nullptr || buffer == nullptr) {
-        return 0;
+    
+    if (response.spilled()) {
+        std::error_code ec;
+        std::filesystem::remove(response.body_path, ec); // Error results carry no body
     }
-    userdata->append(buffer, size * nitems);
-    return size * nitems;
+    return StepResult::error_result(
+        ErrorCode::http_error,
+        "HTTP request failed with status: " + std::to_string(response.status_code),
+        metadata,
+        latency_ms
+    );
 }
 
 } // namespace worker
@@ -1,193 +1,364 @@
-#include "beamline/worker/core.hpp"
-#include "beamline/worker/base_block_executor.hpp"
-#include <sqlite3.h>
+#include "beamline/worker/blocks/sql_block.hpp"
+#include "beamline/worker/tracer.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
 #include <chrono>
-#include <sstream>
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+#include <vector>
 
 namespace beamline {
 namespace worker {
 
-class SqlBlockExecutor : public BaseBlockExecutor {
-public:
-    SqlBlockExecutor() : BaseBlockExecutor("sql.query", ResourceClass::cpu) {}
-    
-    ~SqlBlockExecutor() {
-        if (db_) {
-            sqlite3_close(db_);
-        }
+namespace {
+
+void bind_value(sqlite3_stmt* stmt, int index, const nlohmann::json& value) {
+    int rc = SQLITE_OK;
+    if (value.is_null()) {
+        rc = sqlite3_bind_null(stmt, index);
+    } else if (value.is_boolean()) {
+        rc = sqlite3_bind_int(stmt, index, value.get<bool>() ? 1 : 0);
+    } else if (value.is_number_integer()) {
+        rc = sqlite3_bind_int64(stmt, index, value.get<sqlite3_int64>());
+    } else if (value.is_number_float()) {
+        rc = sqlite3_bind_double(stmt, index, value.get<double>());
+    } else if (value.is_string()) {
+        const auto& text = value.get_ref<const std::string&>();
+        rc = sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+    } else {
+        // Arrays and objects are stored as their JSON text
+        std::string text = value.dump();
+        rc = sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+    }
+    if (rc != SQLITE_OK) {
+        throw std::runtime_error("Failed to bind parameter " + std::to_string(index) + ": " + sqlite3_errstr(rc));
     }
-    
-    caf::expected<void> init(const BlockContext& ctx) override {
-        context_ = ctx;
-        
-        // Initialize SQLite for sandbox mode or specific database connections
-        if (context_.sandbox) {
-            // Use in-memory database for sandbox mode
-            int rc = sqlite3_open(":memory:", &db_);
-            if (rc != SQLITE_OK) {
-                return caf::make_error(caf::sec::runtime_error, "Failed to open SQLite database");
+}
+
+} // namespace
+
+void bind_sql_params(sqlite3_stmt* stmt, const std::string& params_json) {
+    nlohmann::json params;
+    try {
+        params = nlohmann::json::parse(params_json);
+    } catch (const nlohmann::json::parse_error& e) {
+        throw std::invalid_argument("Invalid params JSON: " + std::string(e.what()));
+    }
+
+    int declared = sqlite3_bind_parameter_count(stmt);
+    if (params.is_array()) {
+        if (static_cast<int>(params.size()) != declared) {
+            throw std::invalid_argument("Expected " + std::to_string(declared) + " parameters, got " +
+                                        std::to_string(params.size()));
+        }
+        for (size_t i = 0; i < params.size(); i++) {
+            bind_value(stmt, static_cast<int>(i) + 1, params[i]);
+        }
+    } else if (params.is_object()) {
+        for (const auto& [name, value] : params.items()) {
+            int index = 0;
+            if (!name.empty() && (name[0] == ':' || name[0] == '@' || name[0] == '$')) {
+                index = sqlite3_bind_parameter_index(stmt, name.c_str());
+            } else {
+                for (const char* prefix : {":", "@", "$"}) {
+                    index = sqlite3_bind_parameter_index(stmt, (prefix + name).c_str());
+                    if (index != 0) {
+                        break;
+                    }
+                }
             }
+            if (index == 0) {
+                throw std::invalid_argument("Unknown query parameter: " + name);
+            }
+            bind_value(stmt, index, value);
         }
-        
-        return caf::unit;
+    } else if (!params.is_null()) {
+        throw std::invalid_argument("params must be a JSON array or object");
     }
-    
-    caf::expected<StepResult> execute_impl(const StepRequest& req, const BlockContext& ctx) override {
-        auto start_time = std::chrono::steady_clock::now();
-        auto metadata = BlockExecutor::metadata_from_context(ctx);
-        
-        // Validate required inputs
-        std::vector<std::string> required_inputs = {"query"};
-        if (!validate_required_inputs(req, required_inputs)) {
-            auto end_time = std::chrono::steady_clock::now();
-            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            record_error(latency_ms);
-            
-            return StepResult::error_result(
-                ErrorCode::missing_required_field,
-                "Missing required input: query",
-                metadata,
-                latency_ms
-            );
+}
+
+SqlCursorTable::Cursor::~Cursor() {
+    // Before the lease hands the handle back
+    sqlite3_finalize(stmt);
+}
+
+SqlCursorTable::SqlCursorTable(Config config)
+    : config_(config), token_rng_(std::random_device{}()) {}
+
+SqlCursorTable::~SqlCursorTable() = default;
+
+SqlCursorTable& SqlCursorTable::instance() {
+    // Parked cursors hold pool leases, so the pool is constructed first and outlives the table
+    SqliteConnectionPool::instance();
+    static SqlCursorTable table{Config{}};
+    return table;
+}
+
+std::string SqlCursorTable::park(std::unique_ptr<Cursor> cursor, Clock::time_point now) {
+    cursor->expires_at = now + std::chrono::milliseconds(config_.idle_timeout_ms);
+
+    // Closed outside the lock: closing returns a handle to the connection pool
+    std::vector<std::unique_ptr<Cursor>> closed;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = cursors_.begin(); it != cursors_.end();) {
+        if (it->second->expires_at <= now) {
+            closed.push_back(std::move(it->second));
+            it = cursors_.erase(it);
+        } else {
+            ++it;
         }
-        
-        std::string query = req.inputs.at("query");
-        std::string connection_string = get_input_or_default(req, "connection", ":memory:");
-        
-        // Parse parameters if provided
-        // Note: Parameter parsing from JSON is not implemented in CP1
-        // For CP1, queries are executed as-is without parameter substitution
-        // Full parameter binding would require JSON parsing and proper SQLite binding (planned for CP2)
-        if (req.inputs.count("params")) {
-            // Parameters are provided but not used in CP1
-            // In CP2, this would parse JSON and bind parameters to SQLite placeholders
+    }
+    if (cursors_.size() >= config_.max_cursors && !cursors_.empty()) {
+        auto oldest = std::min_element(cursors_.begin(), cursors_.end(), [](const auto& a, const auto& b) {
+            return a.second->expires_at < b.second->expires_at;
+        });
+        closed.push_back(std::move(oldest->second));
+        cursors_.erase(oldest);
+    }
+
+    std::string token;
+    do {
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", static_cast<unsigned long long>(token_rng_()),
+                      static_cast<unsigned long long>(token_rng_()));
+        token = buffer;
+    } while (cursors_.count(token));
+    cursors_.emplace(token, std::move(cursor));
+    return token;
+}
+
+std::unique_ptr<SqlCursorTable::Cursor> SqlCursorTable::take(const std::string& token, const std::string& key,
+                                                             Clock::time_point now) {
+    std::unique_ptr<Cursor> cursor;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cursors_.find(token);
+    if (it == cursors_.end() || it->second->key != key) {
+        return nullptr;
+    }
+    cursor = std::move(it->second);
+    cursors_.erase(it);
+    if (cursor->expires_at <= now) {
+        return nullptr; // Closed on return
+    }
+    return cursor;
+}
+
+size_t SqlCursorTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cursors_.size();
+}
+
+SqlBlockExecutor::SqlBlockExecutor() : BaseBlockExecutor("sql.query", ResourceClass::cpu) {}
+
+caf::expected<void> SqlBlockExecutor::init(const BlockContext& ctx) {
+    context_ = ctx;
+
+    // Initialize SQLite for sandbox mode or specific database connections
+    if (context_.sandbox) {
+        // Use in-memory database for sandbox mode
+        sqlite3* db = nullptr;
+        int rc = sqlite3_open(":memory:", &db);
+        if (rc != SQLITE_OK) {
+            sqlite3_close(db);
+            return caf::make_error(caf::sec::runtime_error, "Failed to open SQLite database");
         }
-        
-        try {
-            sqlite3* db = db_;
-            bool local_db = false;
-            
-            // Connect to database if not in sandbox mode or different connection
-            if (!ctx.sandbox || connection_string != ":memory:") {
-                int rc = sqlite3_open(connection_string.c_str(), &db);
-                if (rc != SQLITE_OK) {
-                    throw std::runtime_error("Failed to open database: " + connection_string);
-                }
-                local_db = true;
+        sandbox_db_ = std::make_unique<SqliteConnection>(db, 64);
+    }
+
+    return caf::unit;
+}
+
+caf::expected<StepResult> SqlBlockExecutor::execute_impl(const StepRequest& req, const BlockContext& ctx) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto metadata = BlockExecutor::metadata_from_context(ctx);
+
+    // Validate required inputs
+    std::vector<std::string> required_inputs = {"query"};
+    if (!validate_required_inputs(req, required_inputs)) {
+        auto end_time = std::chrono::steady_clock::now();
+        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        record_error(latency_ms);
+
+        return StepResult::error_result(
+            ErrorCode::missing_required_field,
+            "Missing required input: query",
+            metadata,
+            latency_ms
+        );
+    }
+
+    std::string query = req.inputs.at("query");
+    std::string connection_string = get_input_or_default(req, "connection", ":memory:");
+
+    // Result encoding: format, page size and the cursor of the page to continue
+    std::string format_name = get_input_or_default(req, "format", "rows");
+    auto parsed_format = SqlResultEncoder::parse_format(format_name);
+    size_t max_rows = 0;
+    std::string cursor_token = get_input_or_default(req, "cursor");
+    bool paging_valid = true;
+    try {
+        max_rows = std::stoull(get_input_or_default(req, "max_rows", "0"));
+    } catch (const std::exception&) {
+        paging_valid = false;
+    }
+    if (!parsed_format || !paging_valid) {
+        auto end_time = std::chrono::steady_clock::now();
+        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        record_error(latency_ms);
+
+        return StepResult::error_result(
+            ErrorCode::invalid_input,
+            parsed_format ? "Invalid max_rows" : "Invalid result format: " + format_name,
+            metadata,
+            latency_ms
+        );
+    }
+    auto format = *parsed_format;
+
+    try {
+        auto query_span = Tracer::instance().start_child("sql.query", Tracer::SpanKind::client);
+
+        // Sandbox steps on the default database use the executor's private handle;
+        // everything else borrows a pooled handle (opened once, WAL mode)
+        bool private_db = ctx.sandbox && connection_string == ":memory:" && sandbox_db_;
+        SqlCursorTable& cursors = private_db ? sandbox_cursors_ : SqlCursorTable::instance();
+        std::string params_json = get_input_or_default(req, "params");
+        std::string cursor_key = connection_string + '\0' + query + '\0' + params_json;
+
+        // A paged query steps a statement of its own, parked between pages; a one-shot
+        // query uses the handle's cached statement
+        bool paging = max_rows > 0 || !cursor_token.empty();
+        std::unique_ptr<SqlCursorTable::Cursor> open_cursor;
+        std::optional<SqliteConnectionPool::Lease> lease;
+        sqlite3_stmt* stmt = nullptr;
+        bool continued = !cursor_token.empty();
+        if (continued) {
+            open_cursor = cursors.take(cursor_token, cursor_key);
+            if (!open_cursor) {
+                throw std::invalid_argument("Unknown or expired cursor");
             }
-            
-            // Prepare statement
-            sqlite3_stmt* stmt = nullptr;
-            int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
-            if (rc != SQLITE_OK) {
-                if (local_db) sqlite3_close(db);
-                throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+            stmt = open_cursor->stmt;
+        } else {
+            SqliteConnection* connection = sandbox_db_.get();
+            if (!private_db) {
+                lease.emplace(SqliteConnectionPool::instance().acquire(connection_string));
+                connection = &**lease;
             }
-            
-            // RAII wrapper to ensure statement is finalized
-            struct StatementGuard {
-                sqlite3_stmt* stmt_;
-                bool local_db_;
-                sqlite3* db_;
-                StatementGuard(sqlite3_stmt* stmt, bool local_db, sqlite3* db) 
-                    : stmt_(stmt), local_db_(local_db), db_(db) {}
-                ~StatementGuard() {
-                    if (stmt_) {
-                        sqlite3_finalize(stmt_);
-                    }
-                    if (local_db_ && db_) {
-                        sqlite3_close(db_);
-                    }
+            if (paging) {
+                open_cursor = std::make_unique<SqlCursorTable::Cursor>();
+                open_cursor->key = cursor_key;
+                if (lease) {
+                    open_cursor->lease.emplace(std::move(*lease));
                 }
-                // Non-copyable
-                StatementGuard(const StatementGuard&) = delete;
-                StatementGuard& operator=(const StatementGuard&) = delete;
-            };
-            
-            StatementGuard guard(stmt, local_db, db);
-            local_db = false; // Guard will handle cleanup
-            
-            // Bind parameters (simplified - CP1 does not support parameter binding)
-            // For CP1, queries are executed as-is without parameter substitution
-            // Full parameter binding would require:
-            // 1. Parse JSON parameters
-            // 2. Map parameter names to SQLite placeholders (? or :name)
-            // 3. Use sqlite3_bind_* functions to bind values
-            // This is planned for CP2
-            
-            // Execute query
-            std::vector<std::unordered_map<std::string, std::string>> rows;
-            
-            while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-                std::unordered_map<std::string, std::string> row;
-                int col_count = sqlite3_column_count(stmt);
-                
-                for (int i = 0; i < col_count; i++) {
-                    const char* col_name = sqlite3_column_name(stmt, i);
-                    const char* col_value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, i));
-                    
-                    if (col_name && col_value) {
-                        row[col_name] = col_value;
-                    }
+                if (sqlite3_prepare_v2(connection->db(), query.c_str(), static_cast<int>(query.size()),
+                                       &open_cursor->stmt, nullptr) != SQLITE_OK) {
+                    throw std::runtime_error("Failed to prepare statement: " +
+                                             std::string(sqlite3_errmsg(connection->db())));
                 }
-                
-                rows.push_back(row);
-            }
-            
-            if (rc != SQLITE_DONE) {
-                throw std::runtime_error("Query execution failed: " + std::string(sqlite3_errmsg(db)));
+                if (!open_cursor->stmt) {
+                    throw std::invalid_argument("Empty query");
+                }
+                // Pages are served from one open statement, which must not write
+                if (!sqlite3_stmt_readonly(open_cursor->stmt)) {
+                    throw std::invalid_argument("max_rows requires a read-only query");
+                }
+                stmt = open_cursor->stmt;
+            } else {
+                // Prepared statements are cached per handle and keyed by SQL text
+                stmt = connection->prepare(query);
             }
-            
-            // Get number of affected rows for non-SELECT queries
-            int affected_rows = sqlite3_changes(db);
-            
-            auto end_time = std::chrono::steady_clock::now();
-            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            
-            // Format results
-            std::unordered_map<std::string, std::string> outputs;
-            if (!rows.empty()) {
-                // Convert rows to JSON string (simplified)
-                std::stringstream json_result;
-                json_result << "[";
-                for (size_t i = 0; i < rows.size(); i++) {
-                    if (i > 0) json_result << ",";
-                    json_result << "{";
-                    bool first = true;
-                    for (const auto& [key, value] : rows[i]) {
-                        if (!first) json_result << ",";
-                        json_result << "\"" << key << "\":\"" << value << "\"";
-                        first = false;
-                    }
-                    json_result << "}";
+        }
+        sqlite3* db = sqlite3_db_handle(stmt);
+
+        // RAII wrapper to ensure the cached statement is reset for the next step
+        struct StatementGuard {
+            sqlite3_stmt* stmt_;
+            explicit StatementGuard(sqlite3_stmt* stmt) : stmt_(stmt) {}
+            ~StatementGuard() {
+                if (stmt_) {
+                    SqliteConnection::release(stmt_);
                 }
-                json_result << "]";
-                outputs["rows"] = json_result.str();
-                outputs["row_count"] = std::to_string(rows.size());
+            }
+            // Non-copyable
+            StatementGuard(const StatementGuard&) = delete;
+            StatementGuard& operator=(const StatementGuard&) = delete;
+        };
+
+        StatementGuard guard(paging ? nullptr : stmt);
+
+        if (!continued && !params_json.empty()) {
+            bind_sql_params(stmt, params_json);
+        }
+
+        // Execute query, encoding each row straight from the statement into the reusable buffer.
+        // A continued cursor is already positioned on its next row.
+        encoder_.begin(format, stmt);
+
+        int rc = continued ? SQLITE_ROW : sqlite3_step(stmt);
+        while (rc == SQLITE_ROW) {
+            if (max_rows > 0 && encoder_.row_count() >= max_rows) {
+                break; // At least one more row remains
+            }
+            encoder_.add_row(stmt);
+            rc = sqlite3_step(stmt);
+        }
+        bool has_more = rc == SQLITE_ROW;
+
+        if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+            throw std::runtime_error("Query execution failed: " + std::string(sqlite3_errmsg(db)));
+        }
+        encoder_.finish();
+        query_span.set_attribute("db.rows", static_cast<int64_t>(encoder_.row_count()));
+        query_span.end();
+
+        // Get number of affected rows for non-SELECT queries
+        int affected_rows = sqlite3_changes(db);
+
+        auto end_time = std::chrono::steady_clock::now();
+        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+        // Format results
+        std::unordered_map<std::string, std::string> outputs;
+        if (sqlite3_column_count(stmt) > 0) {
+            if (format == SqlResultEncoder::Format::binary) {
+                // Outputs are what gets serialized back to the caller; blobs stay in-process
+                encoder_.append_buffer_base64(outputs["rows"]);
+                outputs["rows_size"] = std::to_string(encoder_.buffer().size());
             } else {
-                outputs["affected_rows"] = std::to_string(affected_rows);
+                outputs["rows"] = encoder_.buffer();
             }
-            
-            record_success(latency_ms);
-            return StepResult::success(metadata, outputs, latency_ms);
-            
-        } catch (const std::exception& e) {
-            auto end_time = std::chrono::steady_clock::now();
-            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            record_error(latency_ms);
-            
-            return StepResult::error_result(
-                ErrorCode::execution_failed,
-                "SQL query execution failed: " + std::string(e.what()),
-                metadata,
-                latency_ms
-            );
+            outputs["row_count"] = std::to_string(encoder_.row_count());
+            outputs["format"] = format_name;
+            if (paging) {
+                // Pass "cursor" back in to fetch the next page; a finished cursor is closed here
+                outputs["has_more"] = has_more ? "true" : "false";
+                if (has_more) {
+                    open_cursor->position += encoder_.row_count();
+                    outputs["cursor"] = cursors.park(std::move(open_cursor));
+                }
+            }
+        } else {
+            outputs["affected_rows"] = std::to_string(affected_rows);
         }
+
+        record_success(latency_ms, 0, static_cast<int64_t>(encoder_.buffer().size()));
+        return StepResult::success(metadata, outputs, latency_ms);
+
+    } catch (const std::exception& e) {
+        auto end_time = std::chrono::steady_clock::now();
+        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        record_error(latency_ms);
+
+        bool bad_params = dynamic_cast<const std::invalid_argument*>(&e) != nullptr;
+        return StepResult::error_result(
+            bad_params ? ErrorCode::invalid_input : ErrorCode::execution_failed,
+            "SQL query execution failed: " + std::string(e.what()),
+            metadata,
+            latency_ms
+        );
     }
-    
-private:
-    sqlite3* db_ = nullptr;
-};
+}
 
 } // namespace worker
-} // namespace beamline
\ No newline at end of file
+} // namespace beamline
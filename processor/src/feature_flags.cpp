@@ -0,0 +1,98 @@
+#include "beamline/worker/feature_flags.hpp"
+#include <sys/stat.h>
+#include <csignal>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+// Set from the signal handler; only lock-free atomics are safe to touch there
+std::atomic<bool> reload_requested{false};
+
+void handle_sighup(int) {
+    reload_requested.store(true, std::memory_order_relaxed);
+}
+
+struct Watcher {
+    std::mutex mutex;
+    std::condition_variable stop_cv;
+    bool running = false;
+    std::thread thread;
+};
+
+Watcher& watcher() {
+    static Watcher instance;
+    return instance;
+}
+
+// Modification time of the flags file, or 0 if there is none
+int64_t flags_file_mtime_ns() {
+    auto path = FeatureFlags::flags_file();
+    struct stat st{};
+    if (path.empty() || stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+} // namespace
+
+void FeatureFlags::start_reload_watcher(int64_t poll_interval_ms) {
+    auto& w = watcher();
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.running) {
+        return;
+    }
+    w.running = true;
+
+    struct sigaction action{};
+    action.sa_handler = handle_sighup;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &action, nullptr);
+
+    auto interval = std::chrono::milliseconds(std::max<int64_t>(poll_interval_ms, 10));
+    w.thread = std::thread([interval]() {
+        auto& self = watcher();
+        int64_t last_mtime = flags_file_mtime_ns();
+        std::unique_lock<std::mutex> wait_lock(self.mutex);
+        while (self.running) {
+            self.stop_cv.wait_for(wait_lock, interval, [&self]() { return !self.running; });
+            if (!self.running) {
+                break;
+            }
+            wait_lock.unlock();
+
+            int64_t mtime = flags_file_mtime_ns();
+            if (reload_requested.exchange(false, std::memory_order_relaxed) || mtime != last_mtime) {
+                last_mtime = mtime;
+                FeatureFlags::reload();
+            }
+
+            wait_lock.lock();
+        }
+    });
+}
+
+void FeatureFlags::stop_reload_watcher() {
+    auto& w = watcher();
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.running) {
+            return;
+        }
+        w.running = false;
+        thread = std::move(w.thread);
+    }
+    w.stop_cv.notify_all();
+    thread.join();
+    signal(SIGHUP, SIG_DFL);
+}
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,227 @@
+#include "beamline/worker/group_commit.hpp"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+GroupCommitter::Config& default_config() {
+    static GroupCommitter::Config config;
+    return config;
+}
+
+} // namespace
+
+std::optional<SyncPolicy> parse_sync_policy(const std::string& name) {
+    if (name == "none") {
+        return SyncPolicy::none;
+    } else if (name == "per_write") {
+        return SyncPolicy::per_write;
+    } else if (name == "group_commit") {
+        return SyncPolicy::group_commit;
+    }
+    return std::nullopt;
+}
+
+std::string sync_policy_to_string(SyncPolicy policy) {
+    switch (policy) {
+        case SyncPolicy::none:
+            return "none";
+        case SyncPolicy::per_write:
+            return "per_write";
+        case SyncPolicy::group_commit:
+            return "group_commit";
+    }
+    return "none";
+}
+
+GroupCommitter::GroupCommitter(Config config)
+    : config_(config),
+      committer_thread_([this]() { committer_loop(); }) {}
+
+GroupCommitter::~GroupCommitter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    work_cv_.notify_all();
+    committed_cv_.notify_all();
+    committer_thread_.join();
+    for (auto& [dev, batch] : batches_) {
+        if (batch.fd >= 0) {
+            close(batch.fd);
+        }
+    }
+}
+
+void GroupCommitter::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = config;
+}
+
+GroupCommitter& GroupCommitter::instance() {
+    static GroupCommitter committer{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return committer;
+}
+
+int64_t GroupCommitter::commits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commits_;
+}
+
+bool GroupCommitter::sync_file(int fd, SyncPolicy policy, std::string& error) {
+    switch (policy) {
+        case SyncPolicy::none:
+            return true;
+        case SyncPolicy::per_write:
+            if (fdatasync(fd) != 0) {
+                error = std::string("fdatasync failed: ") + std::strerror(errno);
+                return false;
+            }
+            return true;
+        case SyncPolicy::group_commit:
+            return wait_for_group_commit(fd, error);
+    }
+    return true;
+}
+
+bool GroupCommitter::sync_directory(const std::string& dir, SyncPolicy policy, std::string& error) {
+    if (policy == SyncPolicy::none) {
+        return true;
+    }
+
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        error = "Failed to open directory " + dir + ": " + std::strerror(errno);
+        return false;
+    }
+
+    bool ok = true;
+    if (policy == SyncPolicy::per_write) {
+        if (fsync(dir_fd) != 0) {
+            error = "fsync of directory " + dir + " failed: " + std::strerror(errno);
+            ok = false;
+        }
+    } else {
+        // Picked up by the next syncfs() of this filesystem; nobody waits for it
+        struct stat st{};
+        if (fstat(dir_fd, &st) == 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& batch = batches_[st.st_dev];
+            if (batch.fd < 0) {
+                batch.fd = dup(dir_fd);
+            }
+            batch.requested_epoch = epoch_;
+            work_cv_.notify_one();
+        }
+    }
+    close(dir_fd);
+    return ok;
+}
+
+bool GroupCommitter::wait_for_group_commit(int fd, std::string& error) {
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        error = std::string("fstat failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        lock.unlock();
+        return sync_file(fd, SyncPolicy::per_write, error);
+    }
+
+    auto& batch = batches_[st.st_dev];
+    if (batch.fd < 0) {
+        batch.fd = dup(fd);
+    }
+    uint64_t target = epoch_;
+    batch.requested_epoch = target;
+    work_cv_.notify_one();
+    committed_cv_.wait(lock, [&]() { return batch.committed_epoch >= target || !running_; });
+
+    if (batch.committed_epoch < target) {
+        // Shutting down before our batch was committed
+        lock.unlock();
+        return sync_file(fd, SyncPolicy::per_write, error);
+    }
+    if (batch.last_error != 0) {
+        error = std::string("syncfs failed: ") + std::strerror(batch.last_error);
+        return false;
+    }
+    return true;
+}
+
+void GroupCommitter::committer_loop() {
+    auto interval = std::chrono::milliseconds(config_.interval_ms);
+    auto last_commit = std::chrono::steady_clock::now() - interval;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [&]() {
+            if (!running_) {
+                return true;
+            }
+            for (const auto& [dev, batch] : batches_) {
+                if (batch.requested_epoch > batch.committed_epoch) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (!running_) {
+            break;
+        }
+
+        // Let more writers join the batch until the commit interval has passed
+        work_cv_.wait_until(lock, last_commit + interval, [&]() { return !running_; });
+        if (!running_) {
+            break;
+        }
+
+        // Writers arriving from now on wait for the next epoch
+        uint64_t sealed = epoch_++;
+        std::vector<std::pair<dev_t, int>> to_sync;
+        for (const auto& [dev, batch] : batches_) {
+            if (batch.requested_epoch > batch.committed_epoch) {
+                to_sync.emplace_back(dev, batch.fd);
+            }
+        }
+
+        lock.unlock();
+        std::vector<int> errors;
+        errors.reserve(to_sync.size());
+        for (const auto& [dev, sync_fd] : to_sync) {
+            errors.push_back(syncfs(sync_fd) == 0 ? 0 : errno);
+        }
+        last_commit = std::chrono::steady_clock::now();
+        lock.lock();
+
+        for (size_t i = 0; i < to_sync.size(); i++) {
+            auto& batch = batches_[to_sync[i].first];
+            batch.committed_epoch = sealed;
+            batch.last_error = errors[i];
+            commits_++;
+        }
+        committed_cv_.notify_all();
+    }
+}
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,650 @@
+#include "beamline/worker/http_engine.hpp"
+#include <curl/curl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+constexpr size_t MAX_IDLE_EASY_HANDLES = 256;
+constexpr int MAX_EPOLL_EVENTS = 64;
+
+// Receives the response body: buffers up to the in-memory cap, then streams to a spill file
+struct BodySink {
+    HttpEngine::Response* response = nullptr;
+    size_t max_in_memory = 0;
+    std::string spill_dir;
+    std::FILE* spill_file = nullptr;
+    std::string error;
+
+    bool start_spill() {
+        if (spill_dir.empty()) {
+            error = "Response body exceeds in-memory limit of " + std::to_string(max_in_memory) + " bytes";
+            return false;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(spill_dir, ec);
+        std::string path_template = (std::filesystem::path(spill_dir) / "http-body-XXXXXX").string();
+        int fd = mkstemp(path_template.data());
+        if (fd < 0) {
+            error = "Failed to create spill file in " + spill_dir;
+            return false;
+        }
+        spill_file = fdopen(fd, "wb");
+        if (!spill_file) {
+            close(fd);
+            unlink(path_template.c_str());
+            error = "Failed to open spill file " + path_template;
+            return false;
+        }
+        response->body_path = path_template;
+
+        // Move what was buffered so far to disk and release the memory
+        auto& body = response->body;
+        if (!body.empty() && std::fwrite(body.data(), 1, body.size(), spill_file) != body.size()) {
+            error = "Failed to write spill file " + path_template;
+            return false;
+        }
+        std::string().swap(body);
+        return true;
+    }
+
+    size_t write(const char* data, size_t length) {
+        auto& body = response->body;
+        if (!spill_file && max_in_memory > 0 && body.size() + length > max_in_memory) {
+            if (!start_spill()) {
+                return 0; // Aborts the transfer with CURLE_WRITE_ERROR
+            }
+        }
+        if (spill_file) {
+            if (std::fwrite(data, 1, length, spill_file) != length) {
+                error = "Failed to write spill file " + response->body_path;
+                return 0;
+            }
+        } else {
+            body.append(data, length);
+        }
+        response->body_size += length;
+        return length;
+    }
+
+    // Flush the spill file; on failure remove it so no partial blob is left behind
+    void finish(bool success) {
+        if (spill_file) {
+            if (std::fclose(spill_file) != 0) {
+                success = false;
+            }
+            spill_file = nullptr;
+        }
+        if (!success && response->spilled()) {
+            unlink(response->body_path.c_str());
+            response->body_path.clear();
+        }
+    }
+};
+
+struct Transfer {
+    HttpEngine::TransferId id = 0;
+    std::string origin;
+    CURL* easy = nullptr;
+    curl_slist* header_list = nullptr;
+    HttpEngine::Request request;
+    HttpEngine::Response response;
+    BodySink body_sink;
+    HttpEngine::Callback on_complete;
+};
+
+size_t write_callback(void* contents, size_t size, size_t nmemb, BodySink* sink) {
+    if (sink == nullptr || contents == nullptr) {
+        return 0;
+    }
+    return sink->write(static_cast<const char*>(contents), size * nmemb);
+}
+
+size_t header_callback(char* buffer, size_t size, size_t nitems, std::string* userdata) {
+    if (userdata == nullptr || buffer == nullptr) {
+        return 0;
+    }
+    userdata->append(buffer, size * nitems);
+    return size * nitems;
+}
+
+// DNS and TLS session caches shared by every engine in the process
+class SharedCaches {
+public:
+    SharedCaches() : share_(curl_share_init()) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &SharedCaches::lock);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &SharedCaches::unlock);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    ~SharedCaches() {
+        curl_share_cleanup(share_);
+    }
+
+    CURLSH* handle() const { return share_; }
+
+private:
+    CURLSH* share_;
+    std::mutex mutexes_[CURL_LOCK_DATA_LAST];
+
+    static void lock(CURL* /*easy*/, curl_lock_data data, curl_lock_access /*access*/, void* userp) {
+        static_cast<SharedCaches*>(userp)->mutexes_[data].lock();
+    }
+
+    static void unlock(CURL* /*easy*/, curl_lock_data data, void* userp) {
+        static_cast<SharedCaches*>(userp)->mutexes_[data].unlock();
+    }
+};
+
+SharedCaches& shared_caches() {
+    static SharedCaches caches;
+    return caches;
+}
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+HttpEngine::Config& default_config() {
+    static HttpEngine::Config config;
+    return config;
+}
+
+} // namespace
+
+struct HttpEngine::Impl {
+    CURLM* multi = nullptr;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+
+    // Deadline requested by curl's timer callback (engine thread only)
+    std::optional<std::chrono::steady_clock::time_point> timer_deadline;
+
+    std::atomic<HttpEngine::TransferId> next_transfer_id{1};
+    std::mutex submit_mutex;
+    std::vector<std::unique_ptr<Transfer>> submitted;
+    std::vector<HttpEngine::TransferId> cancelled;
+
+    // Engine thread only
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> active;
+    std::unordered_map<HttpEngine::TransferId, CURL*> active_ids;
+    std::vector<CURL*> idle_handles;
+    std::atomic<int64_t> idle_handle_count{0}; // idle_handles.size(), for pool_stats()
+
+    static int socket_callback(CURL* /*easy*/, curl_socket_t s, int what, void* userp, void* /*socketp*/) {
+        auto* impl = static_cast<Impl*>(userp);
+        if (what == CURL_POLL_REMOVE) {
+            epoll_ctl(impl->epoll_fd, EPOLL_CTL_DEL, s, nullptr);
+            return 0;
+        }
+
+        epoll_event ev{};
+        ev.events = 0;
+        if (what & CURL_POLL_IN) {
+            ev.events |= EPOLLIN;
+        }
+        if (what & CURL_POLL_OUT) {
+            ev.events |= EPOLLOUT;
+        }
+        ev.data.fd = s;
+        if (epoll_ctl(impl->epoll_fd, EPOLL_CTL_MOD, s, &ev) != 0 && errno == ENOENT) {
+            epoll_ctl(impl->epoll_fd, EPOLL_CTL_ADD, s, &ev);
+        }
+        return 0;
+    }
+
+    static int timer_callback(CURLM* /*multi*/, long timeout_ms, void* userp) {
+        auto* impl = static_cast<Impl*>(userp);
+        if (timeout_ms < 0) {
+            impl->timer_deadline.reset();
+        } else {
+            impl->timer_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        }
+        return 0;
+    }
+
+    CURL* acquire_handle() {
+        if (!idle_handles.empty()) {
+            CURL* easy = idle_handles.back();
+            idle_handles.pop_back();
+            idle_handle_count.store(static_cast<int64_t>(idle_handles.size()), std::memory_order_relaxed);
+            curl_easy_reset(easy);
+            return easy;
+        }
+        return curl_easy_init();
+    }
+
+    void release_handle(CURL* easy) {
+        if (idle_handles.size() < MAX_IDLE_EASY_HANDLES) {
+            idle_handles.push_back(easy);
+            idle_handle_count.store(static_cast<int64_t>(idle_handles.size()), std::memory_order_relaxed);
+        } else {
+            curl_easy_cleanup(easy);
+        }
+    }
+};
+
+bool HttpEngine::Response::timed_out() const {
+    return curl_code == CURLE_OPERATION_TIMEDOUT;
+}
+
+double HttpEngine::PoolStats::occupancy() const {
+    if (max_host_connections <= 0) {
+        return 0.0;
+    }
+    int64_t busiest = 0;
+    for (const auto& [origin, host] : hosts) {
+        busiest = std::max(busiest, host.active);
+    }
+    return static_cast<double>(busiest) / static_cast<double>(max_host_connections);
+}
+
+HttpEngine::HttpEngine(Config config)
+    : config_(config),
+      impl_(std::make_unique<Impl>()) {
+    static std::once_flag curl_init_once;
+    std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    shared_caches();
+
+    impl_->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    impl_->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    impl_->multi = curl_multi_init();
+    if (impl_->epoll_fd < 0 || impl_->wake_fd < 0 || !impl_->multi) {
+        throw std::runtime_error("Failed to initialize HTTP engine");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = impl_->wake_fd;
+    epoll_ctl(impl_->epoll_fd, EPOLL_CTL_ADD, impl_->wake_fd, &ev);
+
+    curl_multi_setopt(impl_->multi, CURLMOPT_SOCKETFUNCTION, &Impl::socket_callback);
+    curl_multi_setopt(impl_->multi, CURLMOPT_SOCKETDATA, impl_.get());
+    curl_multi_setopt(impl_->multi, CURLMOPT_TIMERFUNCTION, &Impl::timer_callback);
+    curl_multi_setopt(impl_->multi, CURLMOPT_TIMERDATA, impl_.get());
+    curl_multi_setopt(impl_->multi, CURLMOPT_MAX_HOST_CONNECTIONS, config_.max_host_connections);
+    curl_multi_setopt(impl_->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, config_.max_total_connections);
+    if (config_.max_idle_connections > 0) {
+        curl_multi_setopt(impl_->multi, CURLMOPT_MAXCONNECTS, config_.max_idle_connections);
+    }
+    if (config_.http2) {
+        curl_multi_setopt(impl_->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+
+    running_ = true;
+    io_thread_ = std::thread([this]() { io_loop(); });
+}
+
+HttpEngine::~HttpEngine() {
+    running_ = false;
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(impl_->wake_fd, &one, sizeof(one));
+    if (io_thread_.joinable()) {
+        io_thread_.join();
+    }
+
+    // Fail whatever is still queued or in flight
+    std::vector<std::unique_ptr<Transfer>> pending;
+    {
+        std::lock_guard<std::mutex> lock(impl_->submit_mutex);
+        pending.swap(impl_->submitted);
+    }
+    for (auto& [easy, transfer] : impl_->active) {
+        curl_multi_remove_handle(impl_->multi, easy);
+        pending.push_back(std::move(transfer));
+    }
+    impl_->active.clear();
+    for (auto& transfer : pending) {
+        if (transfer->easy) {
+            curl_easy_cleanup(transfer->easy);
+        }
+        if (transfer->body_sink.response) {
+            transfer->body_sink.finish(false);
+        }
+        curl_slist_free_all(transfer->header_list);
+        transfer->response.curl_code = CURLE_ABORTED_BY_CALLBACK;
+        transfer->response.error = "HTTP engine shutting down";
+        transfer->on_complete(std::move(transfer->response));
+    }
+    for (CURL* easy : impl_->idle_handles) {
+        curl_easy_cleanup(easy);
+    }
+
+    curl_multi_cleanup(impl_->multi);
+    close(impl_->wake_fd);
+    close(impl_->epoll_fd);
+}
+
+void HttpEngine::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = config;
+}
+
+HttpEngine& HttpEngine::instance() {
+    static HttpEngine engine{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return engine;
+}
+
+std::string HttpEngine::origin_key(const std::string& url) {
+    std::string key;
+    CURLU* parsed = curl_url();
+    if (parsed && curl_url_set(parsed, CURLUPART_URL, url.c_str(), 0) == CURLUE_OK) {
+        char* scheme = nullptr;
+        char* host = nullptr;
+        char* port = nullptr;
+        if (curl_url_get(parsed, CURLUPART_SCHEME, &scheme, 0) == CURLUE_OK &&
+            curl_url_get(parsed, CURLUPART_HOST, &host, 0) == CURLUE_OK &&
+            curl_url_get(parsed, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+            key = std::string(scheme) + "://" + host + ":" + port;
+        }
+        curl_free(scheme);
+        curl_free(host);
+        curl_free(port);
+    }
+    curl_url_cleanup(parsed);
+    if (key.empty()) {
+        key = url; // Unparseable URL: the transfer will fail anyway, keep it in its own bucket
+    }
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+
+HttpEngine::PoolStats HttpEngine::pool_stats() const {
+    PoolStats stats;
+    stats.max_host_connections = config_.max_host_connections;
+    stats.idle_handles = impl_->idle_handle_count.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats.hosts = host_stats_;
+    for (const auto& [origin, host] : host_stats_) {
+        stats.requests += host.requests;
+        stats.reused_connections += host.reused_connections;
+        stats.active += host.active;
+    }
+    return stats;
+}
+
+HttpEngine::TransferId HttpEngine::submit(Request request, Callback on_complete) {
+    auto transfer = std::make_unique<Transfer>();
+    auto id = impl_->next_transfer_id.fetch_add(1, std::memory_order_relaxed);
+    transfer->id = id;
+    transfer->origin = origin_key(request.url);
+    transfer->request = std::move(request);
+    transfer->on_complete = std::move(on_complete);
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        auto& host = host_stats_[transfer->origin];
+        host.active++;
+        host.peak_active = std::max(host.peak_active, host.active);
+    }
+    in_flight_++;
+    {
+        std::lock_guard<std::mutex> lock(impl_->submit_mutex);
+        impl_->submitted.push_back(std::move(transfer));
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(impl_->wake_fd, &one, sizeof(one));
+    return id;
+}
+
+void HttpEngine::cancel(TransferId id) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->submit_mutex);
+        impl_->cancelled.push_back(id);
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(impl_->wake_fd, &one, sizeof(one));
+}
+
+HttpEngine::Response HttpEngine::perform(Request request) {
+    auto promise = std::make_shared<std::promise<Response>>();
+    auto future = promise->get_future();
+    submit(std::move(request), [promise](Response response) {
+        promise->set_value(std::move(response));
+    });
+    return future.get();
+}
+
+void HttpEngine::io_loop() {
+    auto& impl = *impl_;
+    epoll_event events[MAX_EPOLL_EVENTS];
+
+    auto start_submitted = [&]() {
+        std::vector<std::unique_ptr<Transfer>> batch;
+        {
+            std::lock_guard<std::mutex> lock(impl.submit_mutex);
+            batch.swap(impl.submitted);
+        }
+        for (auto& transfer : batch) {
+            CURL* easy = impl.acquire_handle();
+            if (!easy) {
+                transfer->response.curl_code = CURLE_FAILED_INIT;
+                transfer->response.error = "Failed to initialize CURL";
+                {
+                    std::lock_guard<std::mutex> lock(stats_mutex_);
+                    host_stats_[transfer->origin].active--;
+                }
+                in_flight_--;
+                transfer->on_complete(std::move(transfer->response));
+                continue;
+            }
+            transfer->easy = easy;
+            const auto& req = transfer->request;
+
+            curl_easy_setopt(easy, CURLOPT_URL, req.url.c_str());
+            curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_callback);
+            transfer->body_sink.response = &transfer->response;
+            // A request may lower the in-memory cap but never raise it
+            size_t max_in_memory = config_.max_body_in_memory;
+            if (req.max_body_in_memory > 0 && (max_in_memory == 0 || req.max_body_in_memory < max_in_memory)) {
+                max_in_memory = req.max_body_in_memory;
+            }
+            transfer->body_sink.max_in_memory = max_in_memory;
+            transfer->body_sink.spill_dir = !req.spill_dir.empty() ? req.spill_dir : config_.spill_dir;
+            curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer->body_sink);
+            curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, header_callback);
+            curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer->response.headers);
+            curl_easy_setopt(easy, CURLOPT_DNS_CACHE_TIMEOUT, config_.dns_cache_timeout_s);
+            curl_easy_setopt(easy, CURLOPT_SHARE, shared_caches().handle());
+            if (config_.http2) {
+                curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+                // Wait for an existing connection to confirm multiplexing instead of opening a new one
+                curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+            }
+            if (req.connect_timeout_ms > 0) {
+                curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(req.connect_timeout_ms));
+            }
+            if (req.timeout_ms > 0) {
+                curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(req.timeout_ms));
+            }
+
+            if (req.method == "GET") {
+                curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+            } else if (req.method == "POST") {
+                curl_easy_setopt(easy, CURLOPT_POST, 1L);
+                curl_easy_setopt(easy, CURLOPT_POSTFIELDS, req.body.c_str());
+                curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req.body.size()));
+            } else if (req.method == "PUT") {
+                curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "PUT");
+                curl_easy_setopt(easy, CURLOPT_POSTFIELDS, req.body.c_str());
+                curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req.body.size()));
+            } else if (req.method == "DELETE") {
+                curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "DELETE");
+            }
+
+            for (const auto& header : req.headers) {
+                transfer->header_list = curl_slist_append(transfer->header_list, header.c_str());
+            }
+            if (transfer->header_list) {
+                curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer->header_list);
+            }
+
+            curl_multi_add_handle(impl.multi, easy);
+            impl.active_ids.emplace(transfer->id, easy);
+            impl.active.emplace(easy, std::move(transfer));
+        }
+    };
+
+    auto take_cancelled = [&]() {
+        std::vector<TransferId> ids;
+        std::lock_guard<std::mutex> lock(impl.submit_mutex);
+        ids.swap(impl.cancelled);
+        return ids;
+    };
+
+    auto abort_transfers = [&](const std::vector<TransferId>& ids) {
+        for (auto id : ids) {
+            auto id_it = impl.active_ids.find(id);
+            if (id_it == impl.active_ids.end()) {
+                continue; // Already completed
+            }
+            CURL* easy = id_it->second;
+            impl.active_ids.erase(id_it);
+            auto it = impl.active.find(easy);
+            auto transfer = std::move(it->second);
+            impl.active.erase(it);
+
+            // Closes the transfer's connection if it was mid-response; the handle is reusable
+            curl_multi_remove_handle(impl.multi, easy);
+            transfer->body_sink.finish(false);
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                host_stats_[transfer->origin].active--;
+            }
+            curl_slist_free_all(transfer->header_list);
+            transfer->header_list = nullptr;
+            impl.release_handle(easy);
+            in_flight_--;
+            transfer->response.curl_code = CURLE_ABORTED_BY_CALLBACK;
+            transfer->response.error = "Transfer cancelled";
+            transfer->on_complete(std::move(transfer->response));
+        }
+    };
+
+    auto finish_completed = [&]() {
+        int pending_msgs = 0;
+        while (CURLMsg* msg = curl_multi_info_read(impl.multi, &pending_msgs)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL* easy = msg->easy_handle;
+            CURLcode code = msg->data.result;
+            auto it = impl.active.find(easy);
+            curl_multi_remove_handle(impl.multi, easy);
+            if (it == impl.active.end()) {
+                curl_easy_cleanup(easy);
+                continue;
+            }
+            auto transfer = std::move(it->second);
+            impl.active.erase(it);
+            impl.active_ids.erase(transfer->id);
+
+            auto& response = transfer->response;
+            transfer->body_sink.finish(code == CURLE_OK);
+            response.curl_code = static_cast<int>(code);
+            if (code == CURLE_OK) {
+                long response_code = 0;
+                curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response_code);
+                response.status_code = static_cast<int>(response_code);
+            } else if (code == CURLE_WRITE_ERROR && !transfer->body_sink.error.empty()) {
+                response.error = transfer->body_sink.error;
+            } else {
+                response.error = curl_easy_strerror(code);
+            }
+
+            // Zero new connections means the transfer ran on a pooled one
+            long num_connects = 0;
+            curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &num_connects);
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                auto& host = host_stats_[transfer->origin];
+                host.active--;
+                host.requests++;
+                host.new_connections += num_connects;
+                if (num_connects == 0 && code == CURLE_OK) {
+                    host.reused_connections++;
+                }
+            }
+
+            curl_slist_free_all(transfer->header_list);
+            transfer->header_list = nullptr;
+            impl.release_handle(easy);
+            in_flight_--;
+            transfer->on_complete(std::move(response));
+        }
+    };
+
+    while (running_) {
+        int wait_ms = -1;
+        if (impl.timer_deadline) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                *impl.timer_deadline - std::chrono::steady_clock::now()).count();
+            wait_ms = static_cast<int>(std::clamp<int64_t>(remaining, 0, 1000));
+        }
+
+        int n = epoll_wait(impl.epoll_fd, events, MAX_EPOLL_EVENTS, wait_ms);
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+
+        int running_handles = 0;
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == impl.wake_fd) {
+                uint64_t value = 0;
+                [[maybe_unused]] auto drained = read(impl.wake_fd, &value, sizeof(value));
+                // Taken first: a transfer is queued before it can be cancelled, so once the
+                // queue is started every cancelled id is either active or already finished
+                auto cancelled = take_cancelled();
+                start_submitted();
+                abort_transfers(cancelled);
+                continue;
+            }
+            int mask = 0;
+            if (events[i].events & EPOLLIN) {
+                mask |= CURL_CSELECT_IN;
+            }
+            if (events[i].events & EPOLLOUT) {
+                mask |= CURL_CSELECT_OUT;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                mask |= CURL_CSELECT_ERR;
+            }
+            curl_multi_socket_action(impl.multi, fd, mask, &running_handles);
+        }
+
+        if (impl.timer_deadline && std::chrono::steady_clock::now() >= *impl.timer_deadline) {
+            impl.timer_deadline.reset();
+            curl_multi_socket_action(impl.multi, CURL_SOCKET_TIMEOUT, 0, &running_handles);
+        }
+
+        finish_completed();
+    }
+}
+
+} // namespace worker
+} // namespace beamline
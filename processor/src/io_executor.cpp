@@ -0,0 +1,219 @@
+#include "beamline/worker/io_executor.hpp"
+#include <algorithm>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+IoExecutor::Config& default_config() {
+    static IoExecutor::Config config;
+    return config;
+}
+
+} // namespace
+
+bool IoTask::cancel() {
+    cancel_requested_.store(true, std::memory_order_release);
+    State previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = state_;
+        if (state_ == State::queued) {
+            state_ = State::cancelled;
+        }
+    }
+    if (previous == State::running && owner_) {
+        // Running tasks observe cancelled(); until they return they still hold a thread
+        owner_->on_cancelled_while_running(*this);
+    }
+    if (previous != State::queued) {
+        return false; // Finished and already cancelled tasks are unaffected
+    }
+    done_cv_.notify_all();
+    if (owner_) {
+        owner_->on_cancelled_while_queued();
+    }
+    return true;
+}
+
+bool IoTask::wait_until(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return done_cv_.wait_until(lock, deadline, [this]() {
+        return state_ == State::finished || state_ == State::cancelled;
+    });
+}
+
+IoTask::State IoTask::state() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+IoExecutor::IoExecutor(Config config)
+    : config_(config) {
+    int thread_count = std::max(config_.threads, 1);
+    stats_.threads = thread_count;
+    threads_.reserve(static_cast<size_t>(thread_count));
+    for (int i = 0; i < thread_count; i++) {
+        threads_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+IoExecutor::~IoExecutor() {
+    std::deque<std::shared_ptr<IoTask>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        abandoned.swap(queue_);
+    }
+    work_cv_.notify_all();
+
+    // Release anyone still waiting on a task that will never run
+    for (auto& task : abandoned) {
+        {
+            std::lock_guard<std::mutex> task_lock(task->mutex_);
+            task->cancel_requested_.store(true, std::memory_order_release);
+            task->state_ = IoTask::State::cancelled;
+        }
+        task->done_cv_.notify_all();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void IoExecutor::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = config;
+}
+
+IoExecutor& IoExecutor::instance() {
+    static IoExecutor executor{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return executor;
+}
+
+std::shared_ptr<IoTask> IoExecutor::submit(std::function<void(const IoTask&)> operation,
+                                           std::chrono::steady_clock::time_point deadline) {
+    auto task = std::make_shared<IoTask>();
+    task->owner_ = this;
+    task->operation_ = std::move(operation);
+    task->deadline_ = deadline;
+    task->enqueued_at_ = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || stats_.queue_depth >= config_.max_queue_depth) {
+            stats_.rejected++;
+            return nullptr;
+        }
+        if (queue_.size() >= 2 * config_.max_queue_depth) {
+            // Cancelled tasks stay in queue_ until popped; purge them when they pile up
+            queue_.erase(std::remove_if(queue_.begin(), queue_.end(), [](const std::shared_ptr<IoTask>& queued) {
+                std::lock_guard<std::mutex> task_lock(queued->mutex_);
+                return queued->state_ != IoTask::State::queued;
+            }), queue_.end());
+        }
+        queue_.push_back(task);
+        stats_.submitted++;
+        stats_.queue_depth++;
+        stats_.peak_queue_depth = std::max(stats_.peak_queue_depth, stats_.queue_depth);
+    }
+    work_cv_.notify_one();
+    return task;
+}
+
+IoExecutor::Stats IoExecutor::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void IoExecutor::on_cancelled_while_queued() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.queue_depth > 0) {
+        stats_.queue_depth--;
+    }
+    stats_.cancelled++;
+}
+
+void IoExecutor::on_cancelled_while_running(IoTask& task) {
+    // Same lock order as worker_loop, so the count is never decremented before it is taken
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> task_lock(task.mutex_);
+    if (task.state_ == IoTask::State::running && !task.abandoned_) {
+        task.abandoned_ = true;
+        stats_.abandoned++;
+    }
+}
+
+void IoExecutor::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+        if (!running_) {
+            break;
+        }
+
+        auto task = std::move(queue_.front());
+        queue_.pop_front();
+
+        // Claim the task; cancelled tasks were already taken out of queue_depth
+        bool expired = false;
+        {
+            std::lock_guard<std::mutex> task_lock(task->mutex_);
+            if (task->state_ != IoTask::State::queued) {
+                continue;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (now >= task->deadline_) {
+                task->state_ = IoTask::State::cancelled;
+                task->cancel_requested_.store(true, std::memory_order_release);
+                expired = true;
+            } else {
+                task->state_ = IoTask::State::running;
+            }
+            auto waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - task->enqueued_at_).count();
+            stats_.max_queue_wait_ms = std::max(stats_.max_queue_wait_ms, static_cast<int64_t>(waited_ms));
+        }
+        stats_.queue_depth--;
+        if (expired) {
+            stats_.expired++;
+            task->done_cv_.notify_all();
+            continue;
+        }
+        stats_.active++;
+        lock.unlock();
+
+        try {
+            task->operation_(*task);
+        } catch (...) {
+            // Operations report failures through their own captured state
+        }
+        task->operation_ = nullptr; // Drop captured state as soon as possible
+
+        // Stats are settled before the waiter wakes, so it never sees the task still active
+        lock.lock();
+        bool abandoned;
+        {
+            std::lock_guard<std::mutex> task_lock(task->mutex_);
+            task->state_ = IoTask::State::finished;
+            abandoned = task->abandoned_;
+        }
+        stats_.active--;
+        stats_.completed++;
+        if (abandoned) {
+            stats_.abandoned--;
+        }
+        task->done_cv_.notify_all();
+    }
+}
+
+} // namespace worker
+} // namespace beamline
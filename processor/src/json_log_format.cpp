@@ -0,0 +1,178 @@
+#include "beamline/worker/json_log_format.hpp"
+#include <algorithm>
+#include <charconv>
+#include <vector>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+constexpr char hex_digits[] = "0123456789abcdef";
+constexpr std::string_view REPLACEMENT_CHARACTER = "\xEF\xBF\xBD";
+constexpr std::string_view REDACTED = "[REDACTED]";
+
+bool is_continuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+// Length of the well-formed UTF-8 sequence starting at text[i], or 0 if it is not one
+size_t utf8_sequence_length(std::string_view text, size_t i) {
+    auto byte = [&](size_t offset) -> unsigned char {
+        return i + offset < text.size() ? static_cast<unsigned char>(text[i + offset]) : 0x00;
+    };
+    unsigned char lead = byte(0);
+    unsigned char second = byte(1);
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        return is_continuation(second) ? 2 : 0;
+    }
+    if (lead >= 0xE0 && lead <= 0xEF) {
+        // Reject overlong forms (E0 80..9F) and UTF-16 surrogates (ED A0..BF)
+        bool valid_second = lead == 0xE0 ? (second >= 0xA0 && second <= 0xBF)
+                          : lead == 0xED ? (second >= 0x80 && second <= 0x9F)
+                          : is_continuation(second);
+        return valid_second && is_continuation(byte(2)) ? 3 : 0;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        // Reject overlong forms (F0 80..8F) and code points above U+10FFFF (F4 90..)
+        bool valid_second = lead == 0xF0 ? (second >= 0x90 && second <= 0xBF)
+                          : lead == 0xF4 ? (second >= 0x80 && second <= 0x8F)
+                          : is_continuation(second);
+        return valid_second && is_continuation(byte(2)) && is_continuation(byte(3)) ? 4 : 0;
+    }
+    return 0;
+}
+
+void append_key(std::string& out, std::string_view key) {
+    append_json_log_string(out, key);
+    out.push_back(':');
+}
+
+void append_field(std::string& out, std::string_view key, std::string_view value) {
+    out.push_back(',');
+    append_key(out, key);
+    append_json_log_string(out, value);
+}
+
+void append_optional_field(std::string& out, std::string_view key, std::string_view value) {
+    if (!value.empty()) {
+        append_field(out, key, value);
+    }
+}
+
+using ContextEntry = std::unordered_map<std::string, std::string>::value_type;
+
+void append_context(std::string& out, const JsonLogRecord& record, bool (*is_redacted)(std::string_view key)) {
+    // Context keys in std::map order, as nlohmann::json objects are sorted
+    thread_local std::vector<const ContextEntry*> sorted;
+    sorted.clear();
+    if (record.context) {
+        for (const auto& entry : *record.context) {
+            sorted.push_back(&entry);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const ContextEntry* a, const ContextEntry* b) {
+            return a->first < b->first;
+        });
+    }
+
+    constexpr std::string_view worker_id_key = "worker_id";
+    bool worker_id_pending = true;
+    bool first = true;
+    auto emit = [&](std::string_view key, std::string_view value) {
+        if (!first) {
+            out.push_back(',');
+        }
+        first = false;
+        append_key(out, key);
+        append_json_log_string(out, is_redacted && is_redacted(key) ? REDACTED : value);
+    };
+
+    out.push_back('{');
+    for (const ContextEntry* entry : sorted) {
+        std::string_view key = entry->first;
+        if (worker_id_pending && key >= worker_id_key) {
+            worker_id_pending = false;
+            if (key != worker_id_key) {
+                emit(worker_id_key, record.worker_id);
+            }
+        }
+        emit(key, entry->second);
+    }
+    if (worker_id_pending) {
+        emit(worker_id_key, record.worker_id);
+    }
+    out.push_back('}');
+}
+
+} // namespace
+
+void append_json_log_string(std::string& out, std::string_view text) {
+    out.push_back('"');
+    size_t run_start = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+            i++;
+            continue;
+        }
+        if (c >= 0x80) {
+            size_t length = utf8_sequence_length(text, i);
+            if (length > 0) {
+                i += length;
+                continue;
+            }
+        }
+
+        // Copy the clean run in one go, then the escape
+        out.append(text.data() + run_start, i - run_start);
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            default:
+                if (c >= 0x80) {
+                    out.append(REPLACEMENT_CHARACTER);
+                } else {
+                    out.append("\\u00");
+                    out.push_back(hex_digits[c >> 4]);
+                    out.push_back(hex_digits[c & 0xF]);
+                }
+                break;
+        }
+        run_start = ++i;
+    }
+    out.append(text.data() + run_start, text.size() - run_start);
+    out.push_back('"');
+}
+
+void append_json_log(std::string& out, const JsonLogRecord& record, bool (*is_redacted)(std::string_view key)) {
+    // Fields are written in sorted key order
+    out.push_back('{');
+    append_key(out, "component");
+    append_json_log_string(out, record.component);
+    out.append(",\"context\":");
+    append_context(out, record, is_redacted);
+    append_optional_field(out, "flow_id", record.flow_id);
+    append_field(out, "level", record.level);
+    append_field(out, "message", record.message);
+    append_optional_field(out, "run_id", record.run_id);
+    append_optional_field(out, "step_id", record.step_id);
+    if (record.suppressed > 0) {
+        char digits[24];
+        auto end = std::to_chars(digits, digits + sizeof(digits), record.suppressed).ptr;
+        out.append(",\"suppressed\":");
+        out.append(digits, static_cast<size_t>(end - digits));
+    }
+    append_optional_field(out, "tenant_id", record.tenant_id);
+    append_field(out, "timestamp", record.timestamp);
+    append_optional_field(out, "trace_id", record.trace_id);
+    out.push_back('}');
+}
+
+} // namespace worker
+} // namespace beamline
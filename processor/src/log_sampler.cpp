@@ -0,0 +1,146 @@
+#include "beamline/worker/log_sampler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+LogSampler::Config& default_config() {
+    static LogSampler::Config config;
+    return config;
+}
+
+std::string trim(const std::string& value) {
+    auto begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    auto end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+LogSampler::LogSampler(const Config& config) {
+    for (const auto& [message, rule] : config.rules) {
+        auto state = std::make_unique<State>();
+        state->rule = rule;
+        state->rule.one_in = std::max<uint64_t>(rule.one_in, 1);
+        if (state->rule.per_second > 0 && state->rule.burst <= 0) {
+            state->rule.burst = std::max(1.0, state->rule.per_second);
+        }
+        state->tokens = state->rule.burst;
+        state->refilled_at_ns = steady_now_ns();
+        states_.emplace(message, std::move(state));
+    }
+}
+
+void LogSampler::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = std::move(config);
+}
+
+LogSampler& LogSampler::instance() {
+    static LogSampler sampler{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return sampler;
+}
+
+LogSampler::Config LogSampler::parse_rules(const std::string& rules) {
+    Config config;
+    size_t start = 0;
+    while (start < rules.size()) {
+        size_t end = rules.find(';', start);
+        if (end == std::string::npos) {
+            end = rules.size();
+        }
+        std::string entry = trim(rules.substr(start, end - start));
+        start = end + 1;
+        if (entry.empty()) {
+            continue;
+        }
+
+        auto eq = entry.rfind('=');
+        if (eq == std::string::npos || trim(entry.substr(0, eq)).empty()) {
+            throw std::invalid_argument("Invalid log sampling rule: " + entry);
+        }
+        Rule rule;
+        std::string specs = entry.substr(eq + 1) + ",";
+        size_t spec_start = 0;
+        size_t comma;
+        while ((comma = specs.find(',', spec_start)) != std::string::npos) {
+            std::string spec = trim(specs.substr(spec_start, comma - spec_start));
+            spec_start = comma + 1;
+            try {
+                size_t used = 0;
+                // The rate suffix is checked first so "1/s" is one line per second
+                if (spec.size() > 2 && spec.compare(spec.size() - 2, 2, "/s") == 0) {
+                    rule.per_second = std::stod(spec.substr(0, spec.size() - 2), &used);
+                    used += 2;
+                } else if (spec.rfind("1/", 0) == 0) {
+                    rule.one_in = std::stoull(spec.substr(2), &used);
+                    used += 2;
+                }
+                if (used != spec.size() || rule.one_in == 0 || rule.per_second < 0) {
+                    throw std::invalid_argument(spec);
+                }
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid log sampling rule: " + entry);
+            }
+        }
+        config.rules[trim(entry.substr(0, eq))] = rule;
+    }
+    return config;
+}
+
+LogSampler::Decision LogSampler::admit(const std::string& message) {
+    Decision decision;
+    if (states_.empty()) {
+        return decision;
+    }
+    auto it = states_.find(message);
+    if (it == states_.end()) {
+        return decision;
+    }
+
+    State& state = *it->second;
+    uint64_t seen = state.seen.fetch_add(1, std::memory_order_relaxed);
+    decision.keep = seen % state.rule.one_in == 0 && (state.rule.per_second <= 0 || take_token(state));
+    if (!decision.keep) {
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+    } else if (state.suppressed.load(std::memory_order_relaxed) > 0) {
+        decision.suppressed = state.suppressed.exchange(0, std::memory_order_relaxed);
+    }
+    return decision;
+}
+
+bool LogSampler::take_token(State& state) {
+    std::lock_guard<std::mutex> lock(state.bucket_mutex);
+    int64_t now = steady_now_ns();
+    double elapsed_s = static_cast<double>(now - state.refilled_at_ns) / 1e9;
+    state.refilled_at_ns = now;
+    state.tokens = std::min(state.rule.burst, state.tokens + elapsed_s * state.rule.per_second);
+    if (state.tokens < 1.0) {
+        return false;
+    }
+    state.tokens -= 1.0;
+    return true;
+}
+
+} // namespace worker
+} // namespace beamline
@@ -7,6 +7,21 @@
 #include "beamline/worker/actors.hpp"
 #include "beamline/worker/ingress_actor.hpp"
 #include "beamline/worker/observability.hpp"
+#ifdef BEAMLINE_WITH_CURL
+#include "beamline/worker/http_engine.hpp"
+#endif
+#include "beamline/worker/group_commit.hpp"
+#include "beamline/worker/io_executor.hpp"
+#ifdef BEAMLINE_WITH_SQLITE
+#include "beamline/worker/sqlite_pool.hpp"
+#endif
+#include "beamline/worker/feature_flags.hpp"
+#include "beamline/worker/async_logger.hpp"
+#include "beamline/worker/pii_matcher.hpp"
+#include "beamline/worker/log_sampler.hpp"
+#include "beamline/worker/tracer.hpp"
+#include "beamline/worker/tenant_fair_queue.hpp"
+#include "beamline/worker/tenant_ledger.hpp"
 #include <unistd.h>
 
 class WorkerConfig : public caf::actor_system_config {
@@ -16,11 +31,36 @@ public:
             .add(worker_config.cpu_pool_size, "cpu-pool-size", "CPU pool size")
             .add(worker_config.gpu_pool_size, "gpu-pool-size", "GPU pool size")
             .add(worker_config.io_pool_size, "io-pool-size", "I/O pool size")
-            .add(worker_config.max_memory_per_tenant_mb, "max-memory-mb", "Max memory per tenant (MB)")
-            .add(worker_config.max_cpu_time_per_tenant_ms, "max-cpu-time-ms", "Max CPU time per tenant (ms)")
+            .add(worker_config.executor_pool_min, "executor-pool-min", "Warm executor actors per block type")
+            .add(worker_config.executor_pool_max, "executor-pool-max", "Max executor actors per block type (0 = pool size)")
+            .add(worker_config.executor_idle_timeout_ms, "executor-idle-timeout-ms", "Idle executor eviction timeout (ms)")
+            .add(worker_config.http_max_host_connections, "http-max-host-connections", "Max HTTP connections per host")
+            .add(worker_config.http_max_idle_connections, "http-max-idle-connections", "Max idle keep-alive HTTP connections")
+            .add(worker_config.http_max_body_bytes, "http-max-body-bytes", "In-memory HTTP response body cap (bytes)")
+            .add(worker_config.fs_sync_policy, "fs-sync-policy", "fs.blob_put durability: none, per_write or group_commit")
+            .add(worker_config.fs_group_commit_ms, "fs-group-commit-ms", "Group commit interval for fs.blob_put (ms)")
+            .add(worker_config.blocking_io_threads, "blocking-io-threads", "Threads for blocking file system I/O")
+            .add(worker_config.blocking_io_max_queue, "blocking-io-max-queue", "Max queued blocking I/O operations")
+            .add(worker_config.sql_max_idle_connections, "sql-max-idle-connections", "Pooled SQLite handles per database")
+            .add(worker_config.sql_statement_cache_size, "sql-statement-cache-size", "Prepared statements cached per SQLite handle")
+            .add(worker_config.feature_flags_file, "feature-flags-file", "Feature flags file (NAME=value), reloaded on change or SIGHUP")
+            .add(worker_config.log_file, "log-file", "Write JSON logs to this file instead of stdout/stderr")
+            .add(worker_config.log_buffer_kb, "log-buffer-kb", "Per-thread async log buffer (KiB)")
+            .add(worker_config.log_max_block_us, "log-max-block-us", "Max wait for log buffer space before dropping (us)")
+            .add(worker_config.pii_fields, "pii-fields", "Comma-separated log context key patterns to redact")
+            .add(worker_config.log_level, "log-level", "Minimum log level: debug, info, warn or error")
+            .add(worker_config.log_sampling, "log-sampling", "Per-message log sampling: message=1/N,R/s;...")
+            .add(worker_config.max_memory_per_tenant_mb, "max-memory-mb", "Max heap a tenant's step may peak at (MB, 0 = unlimited)")
+            .add(worker_config.max_cpu_time_per_tenant_ms, "max-cpu-time-ms", "Max CPU time per tenant within the quota window (ms, 0 = unlimited)")
+            .add(worker_config.tenant_quota_window_ms, "tenant-quota-window-ms", "Sliding window the per-tenant quotas apply to (ms)")
+            .add(worker_config.tenant_weights, "tenant-weights", "Pending-queue weights per tenant: tenant=weight,... (* = unlisted tenants)")
             .add(worker_config.sandbox_mode, "sandbox", "Enable sandbox mode")
             .add(worker_config.nats_url, "nats-url", "NATS server URL")
-            .add(worker_config.prometheus_endpoint, "prometheus-endpoint", "Prometheus metrics endpoint");
+            .add(worker_config.prometheus_endpoint, "prometheus-endpoint", "Prometheus metrics endpoint")
+            .add(worker_config.metrics_cache_ms, "metrics-cache-ms", "Share one /metrics render across scrapes for this long (ms, 0 = off)")
+            .add(worker_config.trace_file, "trace-file", "Append sampled spans to this file as OTLP/JSON (empty = tracing off)")
+            .add(worker_config.trace_sample_ratio, "trace-sample-ratio", "Fraction of traces always exported (head sampling)")
+            .add(worker_config.trace_slow_ms, "trace-slow-ms", "Also export traces of steps slower than this (ms) or with errors");
         
         // Load CAF modules
         load<caf::io::middleman>();
@@ -34,6 +74,47 @@ void caf_main(caf::actor_system& system, const WorkerConfig& config) {
     std::unique_ptr<beamline::worker::Observability> observability;
     
     try {
+        // Load feature flags once; hot paths read the snapshot instead of the environment
+        beamline::worker::FeatureFlags::set_flags_file(config.worker_config.feature_flags_file);
+        beamline::worker::FeatureFlags::reload();
+        beamline::worker::FeatureFlags::start_reload_watcher();
+        
+        // Log lines are buffered per thread and written in batches by a background thread
+        beamline::worker::AsyncLogger::Config log_config;
+        log_config.path = config.worker_config.log_file;
+        log_config.ring_bytes = static_cast<size_t>(config.worker_config.log_buffer_kb) * 1024;
+        log_config.max_block_us = config.worker_config.log_max_block_us;
+        beamline::worker::AsyncLogger::configure(log_config);
+        beamline::worker::PiiMatcher::configure(beamline::worker::PiiMatcher::parse_list(config.worker_config.pii_fields));
+        auto log_level = beamline::worker::parse_log_level(config.worker_config.log_level);
+        if (!log_level) {
+            throw std::invalid_argument("Invalid log-level: " + config.worker_config.log_level);
+        }
+        beamline::worker::Observability::set_log_level(*log_level);
+        beamline::worker::LogSampler::configure(beamline::worker::LogSampler::parse_rules(config.worker_config.log_sampling));
+        
+        // Spans are recorded per thread and exported in batches; errors and slow steps are always kept
+        beamline::worker::Tracer::Config trace_config;
+        trace_config.path = config.worker_config.trace_file;
+        trace_config.sample_ratio = config.worker_config.trace_sample_ratio;
+        trace_config.slow_threshold_ms = config.worker_config.trace_slow_ms;
+        beamline::worker::Tracer::configure(trace_config);
+        beamline::worker::Tracer::instance(); // Open the trace file now so a bad path fails at startup
+        
+        // Pools share their pending queues between tenants by these weights; reject a bad spec here
+        beamline::worker::parse_tenant_weights(config.worker_config.tenant_weights);
+        
+        // Measured per-step CPU time and heap use per tenant; pools throttle tenants over quota
+        if (config.worker_config.tenant_quota_window_ms <= 0) {
+            throw std::invalid_argument("Invalid tenant-quota-window-ms: " +
+                                        std::to_string(config.worker_config.tenant_quota_window_ms));
+        }
+        beamline::worker::TenantLedger::Config ledger_config;
+        ledger_config.window_ms = config.worker_config.tenant_quota_window_ms;
+        ledger_config.max_cpu_time_ms = config.worker_config.max_cpu_time_per_tenant_ms;
+        ledger_config.max_memory_bytes = config.worker_config.max_memory_per_tenant_mb * 1024 * 1024;
+        beamline::worker::TenantLedger::configure(ledger_config);
+        
         // Initialize observability first
         observability = std::make_unique<beamline::worker::Observability>("worker_" + std::to_string(getpid()));
         observability->log_info("Worker starting", "", "", "", "", "", {
@@ -43,49 +124,94 @@ void caf_main(caf::actor_system& system, const WorkerConfig& config) {
             {"sandbox_mode", config.worker_config.sandbox_mode ? "true" : "false"}
         });
         
-        // Start health endpoint
+        // Start the admin endpoint (/health, /_health, /ready, /metrics on one port)
         // Parse prometheus_endpoint (format: "address:port")
-        std::string health_address = "0.0.0.0";
-        uint16_t health_port = 9091; // Default health port (9090 is for Prometheus metrics)
+        std::string admin_address = "0.0.0.0";
+        uint16_t admin_port = 9091; // Default admin port (prometheus_endpoint port + 1)
         
         size_t colon_pos = config.worker_config.prometheus_endpoint.find(':');
         if (colon_pos != std::string::npos) {
-            health_address = config.worker_config.prometheus_endpoint.substr(0, colon_pos);
+            admin_address = config.worker_config.prometheus_endpoint.substr(0, colon_pos);
             std::string port_str = config.worker_config.prometheus_endpoint.substr(colon_pos + 1);
-            health_port = static_cast<uint16_t>(std::stoi(port_str) + 1); // Health on next port
+            admin_port = static_cast<uint16_t>(std::stoi(port_str) + 1); // Admin on next port
         }
         
-        observability->start_health_endpoint(health_address, health_port);
-        
-        // CP2: Start metrics endpoint on port 9092 (if feature flag enabled)
-        // Parse prometheus_endpoint to get base port
-        uint16_t metrics_port = 9092; // Default CP2 metrics port
-        if (colon_pos != std::string::npos) {
-            std::string port_str = config.worker_config.prometheus_endpoint.substr(colon_pos + 1);
-            int base_port = std::stoi(port_str);
-            metrics_port = static_cast<uint16_t>(base_port + 2); // Metrics on base_port + 2
-        }
-        observability->start_metrics_endpoint(health_address, metrics_port);
+        observability->set_metrics_cache_ms(config.worker_config.metrics_cache_ms);
+        observability->start_admin_endpoint(admin_address, admin_port);
         
         // Set initial health status metric
         observability->set_health_status("worker", 1); // 1 = healthy
         
+#ifdef BEAMLINE_WITH_CURL
+        // Size the shared HTTP connection pool before the first http.request step
+        beamline::worker::HttpEngine::Config http_config;
+        http_config.max_host_connections = config.worker_config.http_max_host_connections;
+        http_config.max_idle_connections = config.worker_config.http_max_idle_connections;
+        http_config.max_body_in_memory = static_cast<size_t>(config.worker_config.http_max_body_bytes);
+        beamline::worker::HttpEngine::configure(http_config);
+#endif
+        
+        // Durability policy for fs.blob_put; steps may override it with the "sync" input
+        auto sync_policy = beamline::worker::parse_sync_policy(config.worker_config.fs_sync_policy);
+        if (!sync_policy) {
+            throw std::invalid_argument("Invalid fs-sync-policy: " + config.worker_config.fs_sync_policy);
+        }
+        beamline::worker::GroupCommitter::Config commit_config;
+        commit_config.policy = *sync_policy;
+        commit_config.interval_ms = config.worker_config.fs_group_commit_ms;
+        beamline::worker::GroupCommitter::configure(commit_config);
+        
+        // Bounded thread pool shared by all blocking file system operations
+        beamline::worker::IoExecutor::Config io_config;
+        io_config.threads = config.worker_config.blocking_io_threads;
+        io_config.max_queue_depth = static_cast<size_t>(config.worker_config.blocking_io_max_queue);
+        beamline::worker::IoExecutor::configure(io_config);
+        
+#ifdef BEAMLINE_WITH_SQLITE
+        // SQLite handles and prepared statements are reused across sql.query steps
+        beamline::worker::SqliteConnectionPool::Config sql_config;
+        sql_config.max_idle_per_database = static_cast<size_t>(config.worker_config.sql_max_idle_connections);
+        sql_config.statement_cache_size = static_cast<size_t>(config.worker_config.sql_statement_cache_size);
+        beamline::worker::SqliteConnectionPool::configure(sql_config);
+#endif
+        
+        // Shared components keep their own statistics; /metrics samples them when scraped
+        observability->add_metrics_collector([](beamline::worker::Observability& metrics) {
+#ifdef BEAMLINE_WITH_CURL
+            auto http_pool = beamline::worker::HttpEngine::instance().pool_stats();
+            metrics.set_http_pool_stats(http_pool.requests, http_pool.reused_connections, http_pool.active,
+                                        http_pool.idle_handles, http_pool.occupancy());
+#endif
+            auto blocking_io = beamline::worker::IoExecutor::instance().stats();
+            metrics.set_blocking_io_stats(static_cast<int64_t>(blocking_io.queue_depth), blocking_io.active,
+                                          blocking_io.expired, blocking_io.rejected, blocking_io.max_queue_wait_ms,
+                                          blocking_io.abandoned);
+            auto logger = beamline::worker::AsyncLogger::instance().stats();
+            metrics.set_logger_stats(logger.written, logger.dropped, logger.write_calls);
+        });
+        
         // Create worker actor
         // Actor is kept alive by the actor system, no need to store reference
         auto worker_actor = system.spawn<beamline::worker::WorkerActor>(config.worker_config);
         
         // Create ingress actor
         system.spawn<beamline::worker::ingress_actor>(config.worker_config.nats_url, caf::actor_cast<caf::actor>(worker_actor));
+        observability->set_ready(true);
         
         // Keep the system running
         observability->log_info("Worker CAF runtime is running. Press Enter to exit...", "", "", "", "", "", {});
         std::cin.get();
         
         observability->log_info("Worker shutting down", "", "", "", "", "", {});
+        observability->set_ready(false);
+        beamline::worker::FeatureFlags::stop_reload_watcher();
+        beamline::worker::Tracer::instance().flush();
+        beamline::worker::AsyncLogger::instance().flush();
         
     } catch (const std::exception& e) {
         if (observability) {
             observability->log_error("Worker fatal error", "", "", "", "", "", {{"error", e.what()}});
+            beamline::worker::AsyncLogger::instance().flush();
         } else {
             // Fallback to stderr if observability is not initialized
             std::cerr << "Worker fatal error (observability not initialized): " << e.what() << std::endl;
@@ -0,0 +1,571 @@
+#include "beamline/worker/metrics_registry.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+constexpr size_t MAX_SHARDS = 64;
+
+size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+uint64_t hash_label_values(MetricsRegistry::LabelValues values) {
+    // FNV-1a with a separator byte, so ("ab", "") and ("a", "b") differ
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::string_view value : values) {
+        for (char ch : value) {
+            hash = (hash ^ static_cast<unsigned char>(ch)) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xFF) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool is_valid_name(const std::string& name) {
+    if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char ch) {
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_' || ch == ':';
+    });
+}
+
+void append_escaped(std::string& out, std::string_view text, bool escape_quotes) {
+    for (char ch : text) {
+        if (ch == '\\') {
+            out.append("\\\\");
+        } else if (ch == '\n') {
+            out.append("\\n");
+        } else if (ch == '"' && escape_quotes) {
+            out.append("\\\"");
+        } else {
+            out.push_back(ch);
+        }
+    }
+}
+
+void append_label(std::string& out, std::string_view name, std::string_view value) {
+    if (!out.empty()) {
+        out.push_back(',');
+    }
+    out.append(name);
+    out.append("=\"");
+    append_escaped(out, value, true);
+    out.push_back('"');
+}
+
+void append_number(std::string& out, uint64_t value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, static_cast<size_t>(end - digits));
+}
+
+void append_number(std::string& out, double value) {
+    if (std::isnan(value)) {
+        out.append("NaN");
+    } else if (std::isinf(value)) {
+        out.append(value > 0 ? "+Inf" : "-Inf");
+    } else {
+        char digits[32];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        out.append(digits, static_cast<size_t>(end - digits));
+    }
+}
+
+// `{labels} ` with the braces omitted when there are no labels
+void append_label_block(std::string& out, std::string_view labels, std::string_view extra_label = {}) {
+    if (!labels.empty() || !extra_label.empty()) {
+        out.push_back('{');
+        out.append(labels);
+        if (!labels.empty() && !extra_label.empty()) {
+            out.push_back(',');
+        }
+        out.append(extra_label);
+        out.push_back('}');
+    }
+    out.push_back(' ');
+}
+
+// One sample line: name, pre-rendered label block and value
+template <typename Value>
+void append_sample(std::string& out, std::string_view name, std::string_view suffix,
+                   std::string_view label_block, Value value) {
+    out.append(name);
+    out.append(suffix);
+    out.append(label_block);
+    append_number(out, value);
+}
+
+// OpenMetrics exemplar suffix: ` # {labels} value timestamp`
+void append_exemplar(std::string& out, const MetricsRegistry::Exemplar& exemplar) {
+    out.append(" # {");
+    out.append(exemplar.labels);
+    out.append("} ");
+    append_number(out, exemplar.value);
+    out.push_back(' ');
+    append_number(out, exemplar.timestamp);
+}
+
+// Append `name="value"` (comma-separated) to the fixed buffer if the whole pair fits;
+// returns the new length
+size_t append_exemplar_label(char* buffer, size_t capacity, size_t length,
+                             std::string_view name, std::string_view value) {
+    size_t end = length;
+    auto put = [&](char ch) {
+        if (end < capacity) {
+            buffer[end] = ch;
+        }
+        end++;
+    };
+    if (length > 0) {
+        put(',');
+    }
+    for (char ch : name) {
+        put(ch);
+    }
+    put('=');
+    put('"');
+    for (char ch : value) {
+        if (ch == '\\' || ch == '"' || ch == '\n') {
+            put('\\');
+            put(ch == '\n' ? 'n' : ch);
+        } else {
+            put(ch);
+        }
+    }
+    put('"');
+    return end <= capacity ? end : length;
+}
+
+} // namespace
+
+size_t MetricsRegistry::thread_slot() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+MetricsRegistry::MetricsRegistry(Options options) : options_(std::move(options)) {
+    size_t shards = options_.shards > 0 ? options_.shards : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    shard_mask_ = round_up_pow2(std::min(shards, MAX_SHARDS)) - 1;
+    options_.max_series_per_family = std::max<size_t>(options_.max_series_per_family, 1);
+    dropped_samples_family_ = &add_family(
+        MetricType::counter, "metrics_dropped_samples_total",
+        "Samples for label combinations past the family's series limit, recorded into the overflow series",
+        {"family"});
+}
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+MetricsRegistry::Family& MetricsRegistry::add_family(MetricType type,
+                                                     const std::string& name,
+                                                     const std::string& help,
+                                                     std::vector<std::string> label_names,
+                                                     std::vector<double> buckets,
+                                                     const std::vector<std::pair<std::string, std::string>>& const_labels,
+                                                     size_t max_series) {
+    if (!is_valid_name(name)) {
+        throw std::invalid_argument("Invalid metric name: " + name);
+    }
+    for (const auto& label : label_names) {
+        if (!is_valid_name(label) || label == "le") {
+            throw std::invalid_argument("Invalid label name for " + name + ": " + label);
+        }
+        if (std::find(options_.unbounded_labels.begin(), options_.unbounded_labels.end(), label) !=
+            options_.unbounded_labels.end()) {
+            throw std::invalid_argument("Label " + label + " of " + name + " is unbounded; record it as an exemplar");
+        }
+    }
+    if (type == MetricType::histogram) {
+        if (buckets.empty() || std::adjacent_find(buckets.begin(), buckets.end(), std::greater_equal<double>()) != buckets.end()) {
+            throw std::invalid_argument("Histogram buckets must be non-empty and ascending: " + name);
+        }
+        if (std::isinf(buckets.back())) {
+            buckets.pop_back(); // +Inf is always implied
+        }
+    }
+
+    std::unique_ptr<Family> family(new Family());
+    family->registry_ = this;
+    family->name_ = name;
+    family->help_ = help;
+    family->type_ = type;
+    family->label_names_ = std::move(label_names);
+    family->buckets_ = std::move(buckets);
+    for (const auto& [label, value] : const_labels) {
+        append_label(family->const_label_text_, label, value);
+    }
+    family->max_series_ = max_series > 0 ? max_series : options_.max_series_per_family;
+
+    // OpenMetrics names a counter family without `_total` and escapes quotes in HELP
+    static constexpr const char* type_names[] = {"counter", "gauge", "histogram"};
+    std::string openmetrics_name = name;
+    if (type == MetricType::counter && name.size() > 6 && name.compare(name.size() - 6, 6, "_total") == 0) {
+        openmetrics_name.resize(name.size() - 6);
+    }
+    const std::string* header_names[] = {&name, &openmetrics_name};
+    for (size_t format = 0; format < 2; format++) {
+        std::string& header = family->headers_[format];
+        if (!help.empty()) {
+            header.append("# HELP ");
+            header.append(*header_names[format]);
+            header.push_back(' ');
+            append_escaped(header, help, format == static_cast<size_t>(Format::openmetrics));
+            header.push_back('\n');
+        }
+        header.append("# TYPE ");
+        header.append(*header_names[format]);
+        header.push_back(' ');
+        header.append(type_names[static_cast<size_t>(type)]);
+        header.push_back('\n');
+    }
+    family->counter_sample_[static_cast<size_t>(Format::prometheus)] = name;
+    family->counter_sample_[static_cast<size_t>(Format::openmetrics)] = openmetrics_name + "_total";
+    size_t slot_count = round_up_pow2(family->max_series_ * 2);
+    family->slots_ = std::make_unique<std::atomic<Series*>[]>(slot_count);
+    family->slot_mask_ = slot_count - 1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = families_.emplace(name, std::move(family));
+    if (!inserted) {
+        throw std::invalid_argument("Duplicate metric family: " + name);
+    }
+    return *it->second;
+}
+
+MetricsRegistry::Series* MetricsRegistry::Family::find(uint64_t hash, LabelValues values) const {
+    for (size_t i = hash & slot_mask_;; i = (i + 1) & slot_mask_) {
+        Series* series = slots_[i].load(std::memory_order_acquire);
+        if (!series) {
+            return nullptr;
+        }
+        if (series->hash == hash && std::equal(values.begin(), values.end(),
+                                               series->label_values.begin(), series->label_values.end())) {
+            return series;
+        }
+    }
+}
+
+MetricsRegistry::Series* MetricsRegistry::Family::resolve(MetricType type, LabelValues values) {
+    if (type != type_ || values.size() != label_names_.size()) {
+        throw std::logic_error("Metric " + name_ + " used with the wrong type or label count");
+    }
+    uint64_t hash = hash_label_values(values);
+    if (Series* series = find(hash, values)) {
+        return series;
+    }
+    if (series_count_.load(std::memory_order_relaxed) >= max_series_) {
+        return overflow();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (Series* series = find(hash, values)) {
+        return series; // Created by another thread meanwhile
+    }
+    if (series_.size() >= max_series_) {
+        lock.unlock();
+        return overflow();
+    }
+
+    series_.push_back(make_series(hash, std::vector<std::string>(values.begin(), values.end())));
+    Series* created = series_.back().get();
+    size_t i = hash & slot_mask_;
+    while (slots_[i].load(std::memory_order_relaxed)) {
+        i = (i + 1) & slot_mask_;
+    }
+    slots_[i].store(created, std::memory_order_release);
+    series_count_.store(series_.size(), std::memory_order_relaxed);
+    return created;
+}
+
+MetricsRegistry::Series* MetricsRegistry::Family::overflow() {
+    if (registry_->dropped_samples_family_ && this != registry_->dropped_samples_family_) {
+        registry_->dropped_samples_family_->counter({name_}).inc();
+    }
+    if (Series* series = overflow_.load(std::memory_order_acquire)) {
+        return series;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!overflow_owner_) {
+        overflow_owner_ = make_series(0, std::vector<std::string>(label_names_.size(), std::string(OVERFLOW_LABEL_VALUE)));
+        overflow_.store(overflow_owner_.get(), std::memory_order_release);
+    }
+    return overflow_owner_.get();
+}
+
+std::unique_ptr<MetricsRegistry::Series> MetricsRegistry::Family::make_series(uint64_t hash,
+                                                                              std::vector<std::string> values) const {
+    auto series = std::make_unique<Series>();
+    series->family = this;
+    series->hash = hash;
+    series->label_text = const_label_text_;
+    for (size_t label = 0; label < values.size(); label++) {
+        if (!values[label].empty()) {
+            append_label(series->label_text, label_names_[label], values[label]);
+        }
+    }
+    series->label_values = std::move(values);
+    append_label_block(series->label_blocks, series->label_text);
+    series->block_ends.push_back(static_cast<uint32_t>(series->label_blocks.size()));
+    if (type_ == MetricType::histogram) {
+        std::string le_label;
+        for (size_t bucket = 0; bucket <= buckets_.size(); bucket++) {
+            le_label.assign("le=\"");
+            if (bucket < buckets_.size()) {
+                append_number(le_label, buckets_[bucket]);
+            } else {
+                le_label.append("+Inf");
+            }
+            le_label.push_back('"');
+            append_label_block(series->label_blocks, series->label_text, le_label);
+            series->block_ends.push_back(static_cast<uint32_t>(series->label_blocks.size()));
+        }
+    }
+    // Counters: one cell per shard. Histograms: a count per bucket, +Inf, then the sum.
+    size_t cells = type_ == MetricType::histogram ? buckets_.size() + 2 : 1;
+    series->shard_mask = type_ == MetricType::gauge ? 0 : registry_->shard_mask_;
+    series->lines_per_shard = (cells + 7) / 8;
+    series->lines = std::make_unique<CacheLine[]>((series->shard_mask + 1) * series->lines_per_shard);
+    series->exemplar_count = type_ == MetricType::histogram ? buckets_.size() + 1 : 1;
+    return series;
+}
+
+size_t MetricsRegistry::Family::series_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return series_.size();
+}
+
+uint64_t MetricsRegistry::Counter::value() const {
+    uint64_t total = 0;
+    if (series_) {
+        for (size_t shard = 0; shard <= series_->shard_mask; shard++) {
+            total += series_->cell(shard, 0).load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void MetricsRegistry::Counter::inc(uint64_t amount, LabelPairs exemplar) const {
+    if (series_) {
+        series_->cell(series_->shard(), 0).fetch_add(amount, std::memory_order_relaxed);
+        write_exemplar(*series_, 0, static_cast<double>(amount), exemplar);
+    }
+}
+
+std::optional<MetricsRegistry::Exemplar> MetricsRegistry::Counter::exemplar() const {
+    return series_ ? read_exemplar(*series_, 0) : std::nullopt;
+}
+
+double MetricsRegistry::Gauge::value() const {
+    return series_ ? std::bit_cast<double>(series_->cell(0, 0).load(std::memory_order_relaxed)) : 0.0;
+}
+
+void MetricsRegistry::Histogram::observe(double value) const {
+    observe(value, {});
+}
+
+void MetricsRegistry::Histogram::observe(double value, LabelPairs exemplar) const {
+    if (!series_) {
+        return;
+    }
+    const auto& buckets = series_->family->buckets_;
+    size_t bucket = 0;
+    while (bucket < buckets.size() && value > buckets[bucket]) {
+        bucket++;
+    }
+    size_t shard = series_->shard();
+    series_->cell(shard, bucket).fetch_add(1, std::memory_order_relaxed);
+    add_double(series_->cell(shard, buckets.size() + 1), value);
+    if (exemplar.size() > 0) {
+        write_exemplar(*series_, bucket, value, exemplar);
+    }
+}
+
+std::optional<MetricsRegistry::Exemplar> MetricsRegistry::Histogram::exemplar(size_t bucket) const {
+    return series_ ? read_exemplar(*series_, bucket) : std::nullopt;
+}
+
+void MetricsRegistry::write_exemplar(Series& series, size_t index, double value, LabelPairs labels) {
+    // Encode the pairs that fit; OpenMetrics limits an exemplar's labels to 128 characters
+    char text[ExemplarSlot::MAX_LABEL_BYTES] = {};
+    size_t length = 0;
+    for (const auto& [name, label_value] : labels) {
+        if (!label_value.empty()) {
+            length = append_exemplar_label(text, sizeof(text), length, name, label_value);
+        }
+    }
+    if (length == 0 || index >= series.exemplar_count) {
+        return;
+    }
+
+    ExemplarSlot* slots = series.exemplars.load(std::memory_order_acquire);
+    if (!slots) {
+        auto* created = new ExemplarSlot[series.exemplar_count];
+        if (series.exemplars.compare_exchange_strong(slots, created, std::memory_order_acq_rel)) {
+            slots = created;
+        } else {
+            delete[] created; // Another writer installed them first
+        }
+    }
+    ExemplarSlot& slot = slots[index];
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) || !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t words[ExemplarSlot::MAX_LABEL_BYTES / 8];
+    std::memcpy(words, text, sizeof(words));
+    for (size_t i = 0; i < (length + 7) / 8; i++) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.length.store(length, std::memory_order_relaxed);
+    slot.value_bits.store(std::bit_cast<uint64_t>(value), std::memory_order_relaxed);
+    slot.timestamp_us.store(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::optional<MetricsRegistry::Exemplar> MetricsRegistry::read_exemplar(const Series& series, size_t index) {
+    Exemplar exemplar;
+    if (!read_exemplar(series, index, exemplar)) {
+        return std::nullopt;
+    }
+    return exemplar;
+}
+
+bool MetricsRegistry::read_exemplar(const Series& series, size_t index, Exemplar& out) {
+    const ExemplarSlot* slots = series.exemplars.load(std::memory_order_acquire);
+    if (!slots || index >= series.exemplar_count) {
+        return false;
+    }
+    const ExemplarSlot& slot = slots[index];
+    uint64_t words[ExemplarSlot::MAX_LABEL_BYTES / 8];
+    for (;;) {
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false; // Never written
+        }
+        if (before & 1) {
+            continue;
+        }
+        size_t length = std::min<size_t>(slot.length.load(std::memory_order_relaxed), sizeof(words));
+        for (size_t i = 0; i < (length + 7) / 8; i++) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        double value = std::bit_cast<double>(slot.value_bits.load(std::memory_order_relaxed));
+        int64_t timestamp_us = slot.timestamp_us.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            out.labels.assign(reinterpret_cast<const char*>(words), length);
+            out.value = value;
+            out.timestamp = static_cast<double>(timestamp_us) / 1e6;
+            return true;
+        }
+    }
+}
+
+uint64_t MetricsRegistry::Histogram::count() const {
+    uint64_t total = 0;
+    if (series_) {
+        size_t buckets = series_->family->buckets_.size();
+        for (size_t shard = 0; shard <= series_->shard_mask; shard++) {
+            for (size_t bucket = 0; bucket <= buckets; bucket++) {
+                total += series_->cell(shard, bucket).load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return total;
+}
+
+double MetricsRegistry::Histogram::sum() const {
+    double total = 0;
+    if (series_) {
+        size_t sum_cell = series_->family->buckets_.size() + 1;
+        for (size_t shard = 0; shard <= series_->shard_mask; shard++) {
+            total += std::bit_cast<double>(series_->cell(shard, sum_cell).load(std::memory_order_relaxed));
+        }
+    }
+    return total;
+}
+
+void MetricsRegistry::Family::render(std::string& out, Format format, Exemplar& exemplar) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (series_.empty() && !overflow_owner_) {
+        return;
+    }
+    bool exemplars = format == Format::openmetrics;
+    out.append(headers_[static_cast<size_t>(format)]);
+
+    auto render_series = [&](Series* series) {
+        switch (type_) {
+            case MetricType::counter:
+                append_sample(out, counter_sample_[static_cast<size_t>(format)], "", series->label_block(0),
+                              Counter(series).value());
+                if (exemplars && read_exemplar(*series, 0, exemplar)) {
+                    append_exemplar(out, exemplar);
+                }
+                out.push_back('\n');
+                break;
+            case MetricType::gauge:
+                append_sample(out, name_, "", series->label_block(0), Gauge(series).value());
+                out.push_back('\n');
+                break;
+            case MetricType::histogram: {
+                uint64_t cumulative = 0;
+                double sum = 0;
+                size_t sum_cell = buckets_.size() + 1;
+                for (size_t bucket = 0; bucket <= buckets_.size(); bucket++) {
+                    for (size_t shard = 0; shard <= series->shard_mask; shard++) {
+                        cumulative += series->cell(shard, bucket).load(std::memory_order_relaxed);
+                    }
+                    append_sample(out, name_, "_bucket", series->label_block(bucket + 1), cumulative);
+                    if (exemplars && read_exemplar(*series, bucket, exemplar)) {
+                        append_exemplar(out, exemplar);
+                    }
+                    out.push_back('\n');
+                }
+                for (size_t shard = 0; shard <= series->shard_mask; shard++) {
+                    sum += std::bit_cast<double>(series->cell(shard, sum_cell).load(std::memory_order_relaxed));
+                }
+                append_sample(out, name_, "_sum", series->label_block(0), sum);
+                out.push_back('\n');
+                append_sample(out, name_, "_count", series->label_block(0), cumulative);
+                out.push_back('\n');
+                break;
+            }
+        }
+    };
+    for (const auto& series : series_) {
+        render_series(series.get());
+    }
+    if (overflow_owner_) {
+        render_series(overflow_owner_.get());
+    }
+}
+
+void MetricsRegistry::render(std::string& out, Format format) const {
+    Exemplar exemplar; // Scratch buffer shared by every exemplar read
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, family] : families_) {
+        family->render(out, format, exemplar);
+    }
+    if (format == Format::openmetrics) {
+        out.append("# EOF\n");
+    }
+}
+
+} // namespace worker
+} // namespace beamline
@@ -1,6 +1,10 @@
 #include "beamline/worker/observability.hpp"
 #include "beamline/worker/core.hpp"
 #include "beamline/worker/feature_flags.hpp"
+#include "beamline/worker/async_logger.hpp"
+#include "beamline/worker/json_log_format.hpp"
+#include "beamline/worker/pii_matcher.hpp"
+#include "beamline/worker/log_sampler.hpp"
 // #include <prometheus/exposer.h>
 // #include <opentelemetry/trace/provider.h>
 // #include <opentelemetry/exporters/ostream/span_exporter.h>
@@ -14,62 +18,62 @@
 #include <ctime>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <thread>
 #include <atomic>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <cstring>
-#include <map>
 
 namespace beamline {
 namespace worker {
 
 using json = nlohmann::json;
 
-// PII/Secret fields to filter
-static const std::vector<std::string> PII_FIELDS = {
-    "password", "api_key", "secret", "token", "access_token", 
-    "refresh_token", "authorization", "credit_card", "ssn", 
-    "email", "phone"
-};
-
 // Helper function to check if a field name should be filtered (case-insensitive)
-static bool is_pii_field(const std::string& field_name) {
-    std::string lower_field = field_name;
-    std::transform(lower_field.begin(), lower_field.end(), lower_field.begin(), ::tolower);
-    
-    for (const auto& pii_field : PII_FIELDS) {
-        if (lower_field == pii_field || lower_field.find(pii_field) != std::string::npos) {
-            return true;
+static bool is_pii_field(std::string_view field_name) {
+    return PiiMatcher::instance().matches(field_name);
+}
+
+// True if the Accept header prefers OpenMetrics over the Prometheus text format
+static bool prefers_openmetrics(std::string_view accept) {
+    double openmetrics_q = 0;
+    double text_q = 0;
+    while (!accept.empty()) {
+        size_t comma = accept.find(',');
+        std::string_view entry = accept.substr(0, comma);
+        accept = comma == std::string_view::npos ? std::string_view() : accept.substr(comma + 1);
+        
+        size_t semicolon = entry.find(';');
+        std::string_view media_type = entry.substr(0, semicolon);
+        while (!media_type.empty() && media_type.front() == ' ') {
+            media_type.remove_prefix(1);
+        }
+        while (!media_type.empty() && media_type.back() == ' ') {
+            media_type.remove_suffix(1);
+        }
+        double q = 1.0;
+        size_t q_pos = entry.find("q=", semicolon == std::string_view::npos ? entry.size() : semicolon);
+        if (q_pos != std::string_view::npos) {
+            std::from_chars(entry.data() + q_pos + 2, entry.data() + entry.size(), q);
+        }
+        if (media_type == "application/openmetrics-text") {
+            openmetrics_q = std::max(openmetrics_q, q);
+        } else if (media_type == "text/plain") {
+            text_q = std::max(text_q, q);
         }
     }
-    return false;
+    return openmetrics_q > 0 && openmetrics_q >= text_q;
 }
 
-// Recursively filter PII from JSON object
-static void filter_pii_recursive(json& obj) {
-    if (obj.is_object()) {
-        for (auto it = obj.begin(); it != obj.end(); ++it) {
-            std::string key = it.key();
-            if (is_pii_field(key)) {
-                obj[key] = "[REDACTED]";
-            } else if (it.value().is_object() || it.value().is_array()) {
-                filter_pii_recursive(it.value());
-            }
-        }
-    } else if (obj.is_array()) {
-        for (auto& item : obj) {
-            if (item.is_object() || item.is_array()) {
-                filter_pii_recursive(item);
-            }
-        }
+// A counter mirroring a total kept elsewhere advances by what the total grew since the last sample
+static void advance_counter(const MetricsRegistry::Counter& counter, std::atomic<uint64_t>& sampled, int64_t total) {
+    uint64_t current = static_cast<uint64_t>(std::max<int64_t>(0, total));
+    uint64_t previous = sampled.exchange(current, std::memory_order_relaxed);
+    if (current > previous) {
+        counter.inc(current - previous);
     }
 }
 
-// Generate ISO 8601 timestamp with microseconds
-static std::string get_iso8601_timestamp() {
+// Write an ISO 8601 timestamp with microseconds (27 characters) into `buf`
+static size_t format_iso8601_timestamp(char* buf, size_t size) {
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
     auto duration = now.time_since_epoch();
@@ -82,114 +86,210 @@ static std::string get_iso8601_timestamp() {
     gmtime_r(&time_t, &tm_buf);
 #endif
     
+    int length = snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
+                          tm_buf.tm_year + 1900, tm_buf.tm_mon + 1, tm_buf.tm_mday,
+                          tm_buf.tm_hour, tm_buf.tm_min, tm_buf.tm_sec,
+                          microseconds.count());
+    return length > 0 ? std::min(static_cast<size_t>(length), size - 1) : 0;
+}
+
+// Generate ISO 8601 timestamp with microseconds
+static std::string get_iso8601_timestamp() {
     char buf[32];
-    snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
-             tm_buf.tm_year + 1900, tm_buf.tm_mon + 1, tm_buf.tm_mday,
-             tm_buf.tm_hour, tm_buf.tm_min, tm_buf.tm_sec,
-             microseconds.count());
-    
-    return std::string(buf);
+    size_t length = format_iso8601_timestamp(buf, sizeof(buf));
+    return std::string(buf, length);
 }
 
-Observability::Observability(const std::string& worker_id) : worker_id_(worker_id) {
-    initialize_metrics();
+std::optional<LogLevel> parse_log_level(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "debug") {
+        return LogLevel::debug;
+    } else if (lower == "info") {
+        return LogLevel::info;
+    } else if (lower == "warn" || lower == "warning") {
+        return LogLevel::warn;
+    } else if (lower == "error") {
+        return LogLevel::error;
+    }
+    return std::nullopt;
+}
+
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::debug: return "DEBUG";
+        case LogLevel::info: return "INFO";
+        case LogLevel::warn: return "WARN";
+        case LogLevel::error: return "ERROR";
+    }
+    return "INFO";
+}
+
+Observability::Observability(const std::string& worker_id)
+    : Observability(worker_id, shared_metrics()) {}
+
+Observability::Observability(const std::string& worker_id, std::shared_ptr<Metrics> metrics)
+    : worker_id_(worker_id), metrics_(std::move(metrics)) {
     initialize_tracing();
 }
 
 Observability::~Observability() {
-    stop_health_endpoint();
-    stop_metrics_endpoint();
+    stop_admin_endpoint();
 }
 
-void Observability::initialize_metrics() {
-    /*
-    registry_ = std::make_shared<prometheus::Registry>();
+std::shared_ptr<Observability::Metrics> Observability::shared_metrics() {
+    static const std::shared_ptr<Metrics> metrics = std::make_shared<Metrics>();
+    return metrics;
+}
+
+Observability::Metrics::Metrics(const std::string& worker_id) {
+    std::vector<std::pair<std::string, std::string>> worker_label;
+    if (!worker_id.empty()) {
+        worker_label.emplace_back("worker_id", worker_id);
+    }
     
     // Task total counter family
-    task_total_family_ = &prometheus::BuildCounter()
-        .Name("worker_tasks_total")
-        .Help("Total number of tasks executed")
-        .Labels({{"worker_id", worker_id_}})
-        .Register(*registry_);
+    task_total_family = &registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_tasks_total", "Total number of tasks executed",
+        {"block_type", "status"}, {}, worker_label);
     
     // Task latency histogram family
-    task_latency_family_ = &prometheus::BuildHistogram()
-        .Name("worker_task_latency_ms")
-        .Help("Task execution latency in milliseconds")
-        .Labels({{"worker_id", worker_id_}})
-        .Buckets({50, 100, 200, 500, 1000, 2000, 5000})
-        .Register(*registry_);
+    task_latency_family = &registry.add_family(
+        MetricsRegistry::MetricType::histogram, "worker_task_latency_ms", "Task execution latency in milliseconds",
+        {"block_type"}, {50, 100, 200, 500, 1000, 2000, 5000}, worker_label);
     
     // Resource usage gauge family
-    resource_usage_family_ = &prometheus::BuildGauge()
-        .Name("worker_resource_usage")
-        .Help("Resource usage metrics")
-        .Labels({{"worker_id", worker_id_}})
-        .Register(*registry_);
-    
-    // Pool queue depth gauge family
-    pool_queue_depth_family_ = &prometheus::BuildGauge()
-        .Name("worker_pool_queue_depth")
-        .Help("Queue depth for worker pools")
-        .Labels({{"worker_id", worker_id_}})
-        .Register(*registry_);
-    
-    // CP2 Wave 1 Metrics - initialize if feature flag is enabled
-    if (FeatureFlags::is_observability_metrics_enabled()) {
-        initialize_cp2_metrics();
-    }
-    */
-}
-
-void Observability::initialize_cp2_metrics() {
-    /*
-    // CP2 Wave 1 Metrics - only initialize if feature flag is enabled
-    // This method is called from initialize_metrics() if CP2_OBSERVABILITY_METRICS_ENABLED=true
-    
+    resource_usage_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_resource_usage", "Resource usage metrics",
+        {"block_type", "resource"}, {}, worker_label);
+    
+    // Pool queue depth gauge family; the three series are resolved up front
+    pool_queue_depth_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_pool_queue_depth", "Queue depth for worker pools",
+        {"resource_class"}, {}, worker_label);
+    pool_queue_depth_gauges[static_cast<size_t>(ResourceClass::cpu)] = pool_queue_depth_family->gauge({"cpu"});
+    pool_queue_depth_gauges[static_cast<size_t>(ResourceClass::gpu)] = pool_queue_depth_family->gauge({"gpu"});
+    pool_queue_depth_gauges[static_cast<size_t>(ResourceClass::io)] = pool_queue_depth_family->gauge({"io"});
+    
+    // CP2 Wave 1 Metrics are registered regardless of CP2_OBSERVABILITY_METRICS_ENABLED so the
+    // flag can be turned on at runtime; the recorders and the endpoint check it
     // Step executions counter
-    step_executions_total_family_ = &prometheus::BuildCounter()
-        .Name("worker_step_executions_total")
-        .Help("Total number of step executions")
-        .Register(*registry_);
+    step_executions_total_family = &registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_step_executions_total", "Total number of step executions",
+        {"step_type", "execution_status", "tenant_id"});
     
     // Step execution duration histogram
-    step_execution_duration_seconds_family_ = &prometheus::BuildHistogram()
-        .Name("worker_step_execution_duration_seconds")
-        .Help("Step execution duration in seconds")
-        .Buckets({0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 2.0, 5.0})
-        .Register(*registry_);
+    step_execution_duration_seconds_family = &registry.add_family(
+        MetricsRegistry::MetricType::histogram, "worker_step_execution_duration_seconds", "Step execution duration in seconds",
+        {"step_type", "execution_status", "tenant_id"},
+        {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 2.0, 5.0});
     
     // Step errors counter
-    step_errors_total_family_ = &prometheus::BuildCounter()
-        .Name("worker_step_errors_total")
-        .Help("Total number of step errors")
-        .Register(*registry_);
+    step_errors_total_family = &registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_step_errors_total", "Total number of step errors",
+        {"step_type", "error_code", "tenant_id"});
     
     // Flow execution duration histogram
-    flow_execution_duration_seconds_family_ = &prometheus::BuildHistogram()
-        .Name("worker_flow_execution_duration_seconds")
-        .Help("Flow execution duration in seconds")
-        .Buckets({0.01, 0.1, 0.5, 1.0, 5.0, 10.0, 30.0, 60.0})
-        .Register(*registry_);
+    flow_execution_duration_seconds_family = &registry.add_family(
+        MetricsRegistry::MetricType::histogram, "worker_flow_execution_duration_seconds", "Flow execution duration in seconds",
+        {"tenant_id"},
+        {0.01, 0.1, 0.5, 1.0, 5.0, 10.0, 30.0, 60.0});
     
     // Queue depth gauge
-    queue_depth_family_ = &prometheus::BuildGauge()
-        .Name("worker_queue_depth")
-        .Help("Current queue depth")
-        .Register(*registry_);
+    queue_depth_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_queue_depth", "Current queue depth", {"resource_pool"});
+    
+    // Pending-queue wait, absolute and as a share of step latency
+    queue_wait_seconds_family = &registry.add_family(
+        MetricsRegistry::MetricType::histogram, "worker_step_queue_wait_seconds",
+        "Time steps spent in the pool's pending queue in seconds", {"resource_pool"},
+        {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 30.0});
+    queue_time_ratio_family = &registry.add_family(
+        MetricsRegistry::MetricType::histogram, "worker_step_queue_time_ratio",
+        "Share of step latency spent in the pool's pending queue", {"resource_pool"},
+        {0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99});
     
     // Active tasks gauge
-    active_tasks_family_ = &prometheus::BuildGauge()
-        .Name("worker_active_tasks")
-        .Help("Current number of active tasks")
-        .Register(*registry_);
+    active_tasks_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_active_tasks", "Current number of active tasks", {"resource_pool"});
+    
+    // Pooled executor actors
+    executors_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_executors", "Executor actors alive in the pool", {"resource_pool"});
+    idle_executors_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_idle_executors", "Executor actors parked warm for reuse",
+        {"resource_pool"});
+    
+    // Per-tenant fair queuing: backlog, wait and executor time charged
+    tenant_queue_depth_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_tenant_queue_depth", "Pending steps per tenant",
+        {"resource_pool", "tenant_id"});
+    tenant_queue_wait_seconds_family = &registry.add_family(
+        MetricsRegistry::MetricType::histogram, "worker_tenant_queue_wait_seconds",
+        "Time a tenant's steps spent in the pool's pending queue in seconds", {"resource_pool", "tenant_id"},
+        {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 30.0});
+    tenant_usage_ms_total_family = &registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_tenant_usage_ms_total",
+        "Executor time charged to a tenant in milliseconds", {"resource_pool", "tenant_id"});
+    
+    // Per-tenant resource accounting: measured CPU time and heap allocations, quota throttling
+    tenant_cpu_time_us_total_family = &registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_tenant_cpu_time_us_total",
+        "Thread CPU time of a tenant's steps in microseconds", {"tenant_id"});
+    tenant_allocated_bytes_total_family = &registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_tenant_allocated_bytes_total",
+        "Heap bytes allocated by a tenant's steps", {"tenant_id"});
+    tenant_throttled_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_tenant_throttled",
+        "Tenant held back in the pool's pending queue for exceeding its quota (1 = throttled)",
+        {"resource_pool", "tenant_id"});
     
     // Health status gauge
-    health_status_family_ = &prometheus::BuildGauge()
-        .Name("worker_health_status")
-        .Help("Health status (1 = healthy, 0 = unhealthy)")
-        .Register(*registry_);
-    */
+    health_status_family = &registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_health_status", "Health status (1 = healthy, 0 = unhealthy)", {"check"});
+    
+    // Shared HTTP connection pool
+    http_requests_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_http_requests_total",
+        "HTTP transfers completed by the shared connection pool").counter({});
+    http_reused_connections_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_http_reused_connections_total",
+        "HTTP transfers served on a cached connection").counter({});
+    http_connection_reuse_ratio = registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_http_connection_reuse_ratio",
+        "Share of HTTP transfers served on a cached connection").gauge({});
+    http_active_transfers = registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_http_active_transfers", "HTTP transfers in flight").gauge({});
+    http_idle_handles = registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_http_idle_handles",
+        "Cached curl easy handles ready for the next transfer").gauge({});
+    http_pool_occupancy = registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_http_pool_occupancy",
+        "Busiest origin's in-flight transfers relative to the per-host connection limit").gauge({});
+    
+    // Shared blocking-I/O executor
+    blocking_io_expired_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_blocking_io_expired_total",
+        "Blocking I/O operations dropped from the queue after their deadline").counter({});
+    blocking_io_rejected_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_blocking_io_rejected_total",
+        "Blocking I/O operations refused because the queue was full").counter({});
+    blocking_io_max_queue_wait_ms = registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_blocking_io_max_queue_wait_ms",
+        "Longest time a blocking I/O operation waited for a thread in milliseconds").gauge({});
+    blocking_io_abandoned = registry.add_family(
+        MetricsRegistry::MetricType::gauge, "worker_blocking_io_abandoned",
+        "Blocking I/O operations still holding a thread after their caller timed out or cancelled").gauge({});
+    
+    // Async logger
+    log_lines_written_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_log_lines_written_total", "Log lines written").counter({});
+    log_lines_dropped_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_log_lines_dropped_total",
+        "Log lines dropped because the writing thread's buffer was full").counter({});
+    log_write_calls_total = registry.add_family(
+        MetricsRegistry::MetricType::counter, "worker_log_write_calls_total",
+        "writev()/write() calls issued by the log writer").counter({});
 }
 
 void Observability::initialize_tracing() {
@@ -211,66 +311,28 @@ void Observability::initialize_tracing() {
     */
 }
 
-void Observability::increment_task_total(const std::string& /*block_type*/, const std::string& /*status*/) {
-    /*
-    auto& counter = task_total_family_->Add({
-        {"block_type", block_type},
-        {"status", status}
-    });
-    counter.Increment();
-    */
+void Observability::increment_task_total(const std::string& block_type, const std::string& status) {
+    metrics_->task_total_family->counter({block_type, status}).inc();
 }
 
-void Observability::record_task_latency(const std::string& /*block_type*/, int64_t /*latency_ms*/) {
-    /*
-    auto& histogram = task_latency_family_->Add({
-        {"block_type", block_type}
-    });
-    histogram.Observe(latency_ms);
-    */
+void Observability::record_task_latency(const std::string& block_type, int64_t latency_ms) {
+    metrics_->task_latency_family->histogram({block_type}).observe(static_cast<double>(latency_ms));
 }
 
-void Observability::record_resource_usage(const std::string& /*block_type*/, int64_t /*cpu_time_ms*/, int64_t /*mem_bytes*/) {
-    /*
-    // Record CPU time
-    auto& cpu_gauge = resource_usage_family_->Add({
-        {"block_type", block_type},
-        {"resource", "cpu_time_ms"}
-    });
-    cpu_gauge.Set(cpu_time_ms);
-    
-    // Record memory usage
-    auto& mem_gauge = resource_usage_family_->Add({
-        {"block_type", block_type},
-        {"resource", "memory_bytes"}
-    });
-    mem_gauge.Set(mem_bytes);
-    */
+void Observability::record_resource_usage(const std::string& block_type, int64_t cpu_time_ms, int64_t mem_bytes) {
+    metrics_->resource_usage_family->gauge({block_type, "cpu_time_ms"}).set(static_cast<double>(cpu_time_ms));
+    metrics_->resource_usage_family->gauge({block_type, "memory_bytes"}).set(static_cast<double>(mem_bytes));
 }
 
-void Observability::set_pool_queue_depth(ResourceClass resource_class, int64_t /*depth*/) {
-    std::string resource_name;
-    switch (resource_class) {
-        case ResourceClass::cpu:
-            resource_name = "cpu";
-            break;
-        case ResourceClass::gpu:
-            resource_name = "gpu";
-            break;
-        case ResourceClass::io:
-            resource_name = "io";
-            break;
-    }
-    
-    /*
-    auto& gauge = pool_queue_depth_family_->Add({
-        {"resource_class", resource_name}
-    });
-    gauge.Set(depth);
-    */
+void Observability::set_pool_queue_depth(ResourceClass resource_class, int64_t depth) {
+    metrics_->pool_queue_depth_gauges[static_cast<size_t>(resource_class)].set(static_cast<double>(depth));
 }
 
 // CP2 Wave 1 Metrics Implementation
+//
+// Only bounded CP1 fields are labels: tenant_id, when provided (empty values are not
+// exported). run_id, flow_id and step_id identify a single execution, so they are kept
+// as the series' exemplar instead of creating a series per run.
 
 void Observability::record_step_execution(const std::string& step_type,
                                           const std::string& execution_status,
@@ -282,26 +344,13 @@ void Observability::record_step_execution(const std::string& step_type,
         return;
     }
     
-    std::map<std::string, std::string> labels = {
-        {"step_type", step_type},
-        {"execution_status", execution_status}
-    };
-    
-    // Add CP1 correlation fields only if provided (to control cardinality)
-    if (!tenant_id.empty()) labels["tenant_id"] = tenant_id;
-    if (!run_id.empty()) labels["run_id"] = run_id;
-    if (!flow_id.empty()) labels["flow_id"] = flow_id;
-    if (!step_id.empty()) labels["step_id"] = step_id;
-    
-    /*
-    auto& counter = step_executions_total_family_->Add(labels);
-    counter.Increment();
-    */
+    metrics_->step_executions_total_family->counter({step_type, execution_status, tenant_id})
+        .inc(1, {{"run_id", run_id}, {"flow_id", flow_id}, {"step_id", step_id}});
 }
 
 void Observability::record_step_execution_duration(const std::string& step_type,
                                                    const std::string& execution_status,
-                                                   double /*duration_seconds*/,
+                                                   double duration_seconds,
                                                    const std::string& tenant_id,
                                                    const std::string& run_id,
                                                    const std::string& flow_id,
@@ -310,21 +359,9 @@ void Observability::record_step_execution_duration(const std::string& step_type,
         return;
     }
     
-    std::map<std::string, std::string> labels = {
-        {"step_type", step_type},
-        {"execution_status", execution_status}
-    };
-    
-    // Add CP1 correlation fields only if provided
-    if (!tenant_id.empty()) labels["tenant_id"] = tenant_id;
-    if (!run_id.empty()) labels["run_id"] = run_id;
-    if (!flow_id.empty()) labels["flow_id"] = flow_id;
-    if (!step_id.empty()) labels["step_id"] = step_id;
-    
-    /*
-    auto& histogram = step_execution_duration_seconds_family_->Add(labels);
-    histogram.Observe(duration_seconds);
-    */
+    metrics_->step_execution_duration_seconds_family
+        ->histogram({step_type, execution_status, tenant_id})
+        .observe(duration_seconds, {{"run_id", run_id}, {"flow_id", flow_id}, {"step_id", step_id}});
 }
 
 void Observability::record_step_error(const std::string& step_type,
@@ -337,24 +374,11 @@ void Observability::record_step_error(const std::string& step_type,
         return;
     }
     
-    std::map<std::string, std::string> labels = {
-        {"step_type", step_type},
-        {"error_code", error_code}
-    };
-    
-    // Add CP1 correlation fields only if provided
-    if (!tenant_id.empty()) labels["tenant_id"] = tenant_id;
-    if (!run_id.empty()) labels["run_id"] = run_id;
-    if (!flow_id.empty()) labels["flow_id"] = flow_id;
-    if (!step_id.empty()) labels["step_id"] = step_id;
-    
-    /*
-    auto& counter = step_errors_total_family_->Add(labels);
-    counter.Increment();
-    */
+    metrics_->step_errors_total_family->counter({step_type, error_code, tenant_id})
+        .inc(1, {{"run_id", run_id}, {"flow_id", flow_id}, {"step_id", step_id}});
 }
 
-void Observability::record_flow_execution_duration(double /*duration_seconds*/,
+void Observability::record_flow_execution_duration(double duration_seconds,
                                                    const std::string& tenant_id,
                                                    const std::string& run_id,
                                                    const std::string& flow_id) {
@@ -362,59 +386,150 @@ void Observability::record_flow_execution_duration(double /*duration_seconds*/,
         return;
     }
     
-    std::map<std::string, std::string> labels;
+    metrics_->flow_execution_duration_seconds_family->histogram({tenant_id})
+        .observe(duration_seconds, {{"run_id", run_id}, {"flow_id", flow_id}});
+}
+
+void Observability::set_queue_depth(const std::string& resource_pool, int64_t depth) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
     
-    // Add CP1 correlation fields only if provided
-    if (!tenant_id.empty()) labels["tenant_id"] = tenant_id;
-    if (!run_id.empty()) labels["run_id"] = run_id;
-    if (!flow_id.empty()) labels["flow_id"] = flow_id;
+    metrics_->queue_depth_family->gauge({resource_pool}).set(static_cast<double>(depth));
+}
+
+void Observability::record_queue_time(const std::string& resource_pool, double wait_seconds, double latency_share) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
     
-    /*
-    auto& histogram = flow_execution_duration_seconds_family_->Add(labels);
-    histogram.Observe(duration_seconds);
-    */
+    metrics_->queue_wait_seconds_family->histogram({resource_pool}).observe(wait_seconds);
+    metrics_->queue_time_ratio_family->histogram({resource_pool}).observe(latency_share);
+}
+
+void Observability::set_active_tasks(const std::string& resource_pool, int64_t count) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
+    
+    metrics_->active_tasks_family->gauge({resource_pool}).set(static_cast<double>(count));
 }
 
-void Observability::set_queue_depth(const std::string& resource_pool, int64_t /*depth*/) {
+void Observability::set_executor_counts(const std::string& resource_pool, int64_t live, int64_t idle) {
     if (!FeatureFlags::is_observability_metrics_enabled()) {
         return;
     }
     
-    // Silence unused variable warning for resource_pool if metrics disabled
-    (void)resource_pool;
+    metrics_->executors_family->gauge({resource_pool}).set(static_cast<double>(live));
+    metrics_->idle_executors_family->gauge({resource_pool}).set(static_cast<double>(idle));
+}
+
+void Observability::set_tenant_queue_depth(const std::string& resource_pool, const std::string& tenant_id,
+                                           int64_t depth) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
     
-    /*
-    auto& gauge = queue_depth_family_->Add({{"resource_pool", resource_pool}});
-    gauge.Set(depth);
-    */
+    metrics_->tenant_queue_depth_family->gauge({resource_pool, tenant_id}).set(static_cast<double>(depth));
 }
 
-void Observability::set_active_tasks(const std::string& resource_pool, int64_t /*count*/) {
+void Observability::record_tenant_queue_wait(const std::string& resource_pool, const std::string& tenant_id,
+                                             double wait_seconds) {
     if (!FeatureFlags::is_observability_metrics_enabled()) {
         return;
     }
     
-    // Silence unused variable warning for resource_pool if metrics disabled
-    (void)resource_pool;
+    metrics_->tenant_queue_wait_seconds_family->histogram({resource_pool, tenant_id}).observe(wait_seconds);
+}
+
+void Observability::add_tenant_usage(const std::string& resource_pool, const std::string& tenant_id, double usage_ms) {
+    if (!FeatureFlags::is_observability_metrics_enabled() || usage_ms < 0.5) {
+        return;
+    }
     
-    /*
-    auto& gauge = active_tasks_family_->Add({{"resource_pool", resource_pool}});
-    gauge.Set(count);
-    */
+    metrics_->tenant_usage_ms_total_family->counter({resource_pool, tenant_id}).inc(static_cast<uint64_t>(usage_ms + 0.5));
 }
 
-void Observability::set_health_status(const std::string& check, int64_t /*status*/) {
+void Observability::add_tenant_resource_usage(const std::string& tenant_id, int64_t cpu_time_ns,
+                                              int64_t allocated_bytes) {
     if (!FeatureFlags::is_observability_metrics_enabled()) {
         return;
     }
     
-    // Silence unused variable warning for check if metrics disabled
-    (void)check;
+    if (cpu_time_ns >= 1000) {
+        metrics_->tenant_cpu_time_us_total_family->counter({tenant_id}).inc(static_cast<uint64_t>(cpu_time_ns / 1000));
+    }
+    if (allocated_bytes > 0) {
+        metrics_->tenant_allocated_bytes_total_family->counter({tenant_id}).inc(static_cast<uint64_t>(allocated_bytes));
+    }
+}
+
+void Observability::set_tenant_throttled(const std::string& resource_pool, const std::string& tenant_id,
+                                         bool throttled) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
     
-    /*
-    auto& gauge = health_status_family_->Add({{"check", check}});
-    gauge.Set(status);
-    */
+    metrics_->tenant_throttled_family->gauge({resource_pool, tenant_id}).set(throttled ? 1.0 : 0.0);
+}
+
+void Observability::add_metrics_collector(MetricsCollector collector) {
+    std::lock_guard<std::mutex> lock(metrics_->collectors_mutex);
+    metrics_->collectors.push_back(std::move(collector));
+}
+
+void Observability::set_http_pool_stats(int64_t requests, int64_t reused_connections, int64_t active_transfers,
+                                        int64_t idle_handles, double occupancy) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
+    
+    advance_counter(metrics_->http_requests_total, metrics_->http_requests_sampled, requests);
+    advance_counter(metrics_->http_reused_connections_total, metrics_->http_reused_connections_sampled,
+                    reused_connections);
+    metrics_->http_connection_reuse_ratio.set(
+        requests > 0 ? static_cast<double>(reused_connections) / static_cast<double>(requests) : 0.0);
+    metrics_->http_active_transfers.set(static_cast<double>(active_transfers));
+    metrics_->http_idle_handles.set(static_cast<double>(idle_handles));
+    metrics_->http_pool_occupancy.set(occupancy);
+}
+
+void Observability::set_blocking_io_stats(int64_t queue_depth, int64_t active, uint64_t expired, uint64_t rejected,
+                                          int64_t max_queue_wait_ms, int64_t abandoned) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
+    
+    // Threads held by abandoned operations delay queued work like steps ahead in the queue
+    metrics_->queue_depth_family->gauge({"blocking_io"}).set(static_cast<double>(queue_depth + abandoned));
+    metrics_->blocking_io_abandoned.set(static_cast<double>(abandoned));
+    metrics_->active_tasks_family->gauge({"blocking_io"}).set(static_cast<double>(active));
+    advance_counter(metrics_->blocking_io_expired_total, metrics_->blocking_io_expired_sampled,
+                    static_cast<int64_t>(expired));
+    advance_counter(metrics_->blocking_io_rejected_total, metrics_->blocking_io_rejected_sampled,
+                    static_cast<int64_t>(rejected));
+    metrics_->blocking_io_max_queue_wait_ms.set(static_cast<double>(max_queue_wait_ms));
+}
+
+void Observability::set_logger_stats(uint64_t written, uint64_t dropped, uint64_t write_calls) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
+    
+    advance_counter(metrics_->log_lines_written_total, metrics_->log_lines_written_sampled,
+                    static_cast<int64_t>(written));
+    advance_counter(metrics_->log_lines_dropped_total, metrics_->log_lines_dropped_sampled,
+                    static_cast<int64_t>(dropped));
+    advance_counter(metrics_->log_write_calls_total, metrics_->log_write_calls_sampled,
+                    static_cast<int64_t>(write_calls));
+}
+
+void Observability::set_health_status(const std::string& check, int64_t status) {
+    if (!FeatureFlags::is_observability_metrics_enabled()) {
+        return;
+    }
+    
+    metrics_->health_status_family->gauge({check}).set(static_cast<double>(status));
 }
 
 /*
@@ -454,7 +569,10 @@ void Observability::log_info(const std::string& message,
                              const std::string& step_id,
                              const std::string& trace_id,
                              const std::unordered_map<std::string, std::string>& context) {
-    std::cout << format_json_log("INFO", message, tenant_id, run_id, flow_id, step_id, trace_id, context) << std::endl;
+    if (!is_log_enabled(LogLevel::info)) {
+        return;
+    }
+    write_log(LogLevel::info, message, tenant_id, run_id, flow_id, step_id, trace_id, context);
 }
 
 void Observability::log_warn(const std::string& message,
@@ -464,7 +582,10 @@ void Observability::log_warn(const std::string& message,
                               const std::string& step_id,
                               const std::string& trace_id,
                               const std::unordered_map<std::string, std::string>& context) {
-    std::cout << format_json_log("WARN", message, tenant_id, run_id, flow_id, step_id, trace_id, context) << std::endl;
+    if (!is_log_enabled(LogLevel::warn)) {
+        return;
+    }
+    write_log(LogLevel::warn, message, tenant_id, run_id, flow_id, step_id, trace_id, context);
 }
 
 void Observability::log_error(const std::string& message,
@@ -474,7 +595,10 @@ void Observability::log_error(const std::string& message,
                                const std::string& step_id,
                                const std::string& trace_id,
                                const std::unordered_map<std::string, std::string>& context) {
-    std::cerr << format_json_log("ERROR", message, tenant_id, run_id, flow_id, step_id, trace_id, context) << std::endl;
+    if (!is_log_enabled(LogLevel::error)) {
+        return;
+    }
+    write_log(LogLevel::error, message, tenant_id, run_id, flow_id, step_id, trace_id, context);
 }
 
 void Observability::log_debug(const std::string& message,
@@ -484,7 +608,28 @@ void Observability::log_debug(const std::string& message,
                                const std::string& step_id,
                                const std::string& trace_id,
                                const std::unordered_map<std::string, std::string>& context) {
-    std::cout << format_json_log("DEBUG", message, tenant_id, run_id, flow_id, step_id, trace_id, context) << std::endl;
+    if (!is_log_enabled(LogLevel::debug)) {
+        return;
+    }
+    write_log(LogLevel::debug, message, tenant_id, run_id, flow_id, step_id, trace_id, context);
+}
+
+void Observability::write_log(LogLevel level,
+                              const std::string& message,
+                              const std::string& tenant_id,
+                              const std::string& run_id,
+                              const std::string& flow_id,
+                              const std::string& step_id,
+                              const std::string& trace_id,
+                              const std::unordered_map<std::string, std::string>& context) {
+    // Sampled-out lines are dropped before formatting; the next kept one carries the count
+    auto sampled = LogSampler::instance().admit(message);
+    if (!sampled.keep) {
+        return;
+    }
+    AsyncLogger::instance().write(level == LogLevel::error ? AsyncLogger::Stream::err : AsyncLogger::Stream::out,
+                                  format_json_log(log_level_name(level), message, tenant_id, run_id, flow_id,
+                                                  step_id, trace_id, context, sampled.suppressed));
 }
 
 void Observability::log_info_with_context(const std::string& message,
@@ -511,57 +656,45 @@ void Observability::log_debug_with_context(const std::string& message,
     log_debug(message, ctx.tenant_id, ctx.run_id, ctx.flow_id, ctx.step_id, ctx.trace_id, context);
 }
 
-std::string Observability::format_json_log(const std::string& level,
-                                           const std::string& message,
-                                           const std::string& tenant_id,
-                                           const std::string& run_id,
-                                           const std::string& flow_id,
-                                           const std::string& step_id,
-                                           const std::string& trace_id,
-                                           const std::unordered_map<std::string, std::string>& context) {
-    json log_entry;
-    
-    // Required fields (always present)
-    log_entry["timestamp"] = get_iso8601_timestamp();
-    log_entry["level"] = level;
-    log_entry["component"] = "worker";
-    log_entry["message"] = message;
-    
-    // CP1 fields (at top level, when provided)
-    if (!tenant_id.empty()) {
-        log_entry["tenant_id"] = tenant_id;
-    }
-    if (!run_id.empty()) {
-        log_entry["run_id"] = run_id;
-    }
-    if (!flow_id.empty()) {
-        log_entry["flow_id"] = flow_id;
-    }
-    if (!step_id.empty()) {
-        log_entry["step_id"] = step_id;
-    }
-    if (!trace_id.empty()) {
-        log_entry["trace_id"] = trace_id;
-    }
-    
-    // Context object (technical details)
-    json context_obj;
-    context_obj["worker_id"] = worker_id_;
-    
-    // Add context fields
-    for (const auto& [key, value] : context) {
-        context_obj[key] = value;
-    }
-    
-    // Filter PII from context
-    filter_pii_recursive(context_obj);
-    
-    // Add context if not empty
-    if (!context_obj.empty()) {
-        log_entry["context"] = context_obj;
-    }
-    
-    return log_entry.dump();
+const std::string& Observability::format_json_log(const std::string& level,
+                                                  const std::string& message,
+                                                  const std::string& tenant_id,
+                                                  const std::string& run_id,
+                                                  const std::string& flow_id,
+                                                  const std::string& step_id,
+                                                  const std::string& trace_id,
+                                                  const std::unordered_map<std::string, std::string>& context,
+                                                  uint64_t suppressed) {
+    // Reused per thread so steady-state logging does not allocate; an occasional
+    // huge line does not pin its memory forever
+    constexpr size_t max_retained_capacity = 64 * 1024;
+    thread_local std::string buffer;
+    if (buffer.capacity() > max_retained_capacity) {
+        std::string().swap(buffer);
+    }
+    buffer.clear();
+    
+    char timestamp[32];
+    size_t timestamp_length = format_iso8601_timestamp(timestamp, sizeof(timestamp));
+    
+    // Required fields (timestamp, level, component, message) are always present, CP1 fields
+    // at top level when provided, technical details in "context" with PII values redacted
+    JsonLogRecord record;
+    record.timestamp = std::string_view(timestamp, timestamp_length);
+    record.level = level;
+    record.component = "worker";
+    record.message = message;
+    record.tenant_id = tenant_id;
+    record.run_id = run_id;
+    record.flow_id = flow_id;
+    record.step_id = step_id;
+    record.trace_id = trace_id;
+    record.worker_id = worker_id_;
+    record.context = &context;
+    record.suppressed = suppressed;
+    append_json_log(buffer, record, is_pii_field);
+    
+    return buffer;
 }
 
 std::string Observability::get_health_response() {
@@ -571,418 +704,113 @@ std::string Observability::get_health_response() {
     return health_response.dump();
 }
 
-void Observability::health_server_loop(int socket_fd) {
-    char buffer[4096];
-    
-    while (health_server_running_) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_fd = accept(socket_fd, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            if (health_server_running_) {
-                // Error accepting connection, but server still running
-                continue;
-            }
-            break;
-        }
-        
-        // Read request
-        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes_read > 0) {
-            buffer[bytes_read] = '\0';
-            
-            // Simple HTTP request parsing - check if it's GET /_health
-            std::string request(buffer);
-            if (request.find("GET /_health") != std::string::npos || 
-                request.find("GET /_health HTTP") != std::string::npos) {
-                
-                // Generate health response
-                std::string response_body = get_health_response();
-                std::string response = 
-                    "HTTP/1.1 200 OK\r\n"
-                    "Content-Type: application/json\r\n"
-                    "Content-Length: " + std::to_string(response_body.length()) + "\r\n"
-                    "\r\n" + response_body;
-                
-                send(client_fd, response.c_str(), response.length(), 0);
-            } else {
-                // 404 for other paths
-                std::string response = 
-                    "HTTP/1.1 404 Not Found\r\n"
-                    "Content-Type: text/plain\r\n"
-                    "Content-Length: 13\r\n"
-                    "\r\n"
-                    "404 Not Found";
-                send(client_fd, response.c_str(), response.length(), 0);
-            }
-        }
-        
-        close(client_fd);
-    }
+std::string Observability::get_readiness_response() {
+    json readiness_response;
+    readiness_response["status"] = is_ready() ? "ready" : "not_ready";
+    readiness_response["timestamp"] = get_iso8601_timestamp();
+    return readiness_response.dump();
 }
 
-void Observability::start_health_endpoint(const std::string& address, uint16_t port) {
-    if (health_server_running_) {
+void Observability::start_admin_endpoint(const std::string& address, uint16_t port, AdminServer::Config config) {
+    if (admin_server_ && admin_server_->running()) {
         return; // Already running
     }
     
-    // Parse address
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    
-    if (address == "0.0.0.0" || address.empty()) {
-        server_addr.sin_addr.s_addr = INADDR_ANY;
-    } else {
-        inet_pton(AF_INET, address.c_str(), &server_addr.sin_addr);
-    }
-    
-    // Create socket
-    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_fd < 0) {
-        log_error("Failed to create health endpoint socket", "", "", "", "", "", {
-            {"error", "socket creation failed"}
-        });
-        return;
-    }
+    config.address = address;
+    config.port = port;
+    auto server = std::make_unique<AdminServer>(config);
     
-    // Set socket options
-    int opt = 1;
-    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    auto health = [this](const AdminServer::Request&) {
+        AdminServer::Response response;
+        response.content_type = "application/json";
+        response.body = get_health_response();
+        return response;
+    };
+    server->handle("/health", health);
+    server->handle("/_health", health); // CP1 path
+    server->handle("/ready", [this](const AdminServer::Request&) {
+        AdminServer::Response response;
+        response.status = is_ready() ? 200 : 503;
+        response.content_type = "application/json";
+        response.body = get_readiness_response();
+        return response;
+    });
+    server->handle("/metrics", [this](const AdminServer::Request& request) {
+        AdminServer::Response response;
+        if (!FeatureFlags::is_observability_metrics_enabled()) {
+            response.status = 404;
+            response.body = "Metrics disabled (CP2_OBSERVABILITY_METRICS_ENABLED is not set)\n";
+            return response;
+        }
+        if (prefers_openmetrics(request.accept)) {
+            response.content_type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+            response.body = get_metrics_response(MetricsRegistry::Format::openmetrics);
+        } else {
+            response.content_type = "text/plain; version=0.0.4; charset=utf-8";
+            response.body = get_metrics_response(MetricsRegistry::Format::prometheus);
+        }
+        return response;
+    });
     
-    // Bind socket
-    if (bind(socket_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        log_error("Failed to bind health endpoint socket", "", "", "", "", "", {
-            {"error", "bind failed"},
+    try {
+        server->start();
+    } catch (const std::exception& e) {
+        log_error("Failed to start admin endpoint", "", "", "", "", "", {
+            {"error", e.what()},
             {"address", address},
             {"port", std::to_string(port)}
         });
-        close(socket_fd);
-        return;
-    }
-    
-    // Listen
-    if (listen(socket_fd, 5) < 0) {
-        log_error("Failed to listen on health endpoint socket", "", "", "", "", "", {
-            {"error", "listen failed"}
-        });
-        close(socket_fd);
         return;
     }
+    admin_server_ = std::move(server);
     
-    health_server_socket_ = socket_fd;
-    health_server_running_ = true;
-    
-    // Start server thread
-    health_server_thread_ = std::thread(&Observability::health_server_loop, this, socket_fd);
-    
-    log_info("Health endpoint started", "", "", "", "", "", {
+    log_info("Admin endpoint started", "", "", "", "", "", {
         {"address", address},
-        {"port", std::to_string(port)}
+        {"port", std::to_string(admin_server_->port())},
+        {"paths", "/health,/_health,/ready,/metrics"}
     });
 }
 
-void Observability::stop_health_endpoint() {
-    if (!health_server_running_) {
+void Observability::stop_admin_endpoint() {
+    if (!admin_server_) {
         return;
     }
     
-    health_server_running_ = false;
-    
-    // Close socket to wake up accept()
-    if (health_server_socket_ >= 0) {
-        close(health_server_socket_);
-        health_server_socket_ = -1;
-    }
-    
-    // Wait for thread to finish
-    if (health_server_thread_.joinable()) {
-        health_server_thread_.join();
-    }
+    admin_server_->stop();
+    admin_server_.reset();
     
-    log_info("Health endpoint stopped");
+    log_info("Admin endpoint stopped");
+}
+
+uint16_t Observability::admin_port() const {
+    return admin_server_ && admin_server_->running() ? admin_server_->port() : 0;
 }
 
-// CP2 Wave 1 Metrics Endpoint Implementation
+// CP2 Wave 1 Metrics export (served at /metrics by the admin endpoint)
 
-std::string Observability::get_metrics_response() {
+std::string Observability::get_metrics_response(MetricsRegistry::Format format) {
     if (!FeatureFlags::is_observability_metrics_enabled()) {
         return ""; // Return empty if feature flag disabled
     }
-    return "# Worker Metrics (CP2 Wave 1)\n# Registry not initialized\n";
-    /*
-    if (!registry_) {
-        return "# Worker Metrics (CP2 Wave 1)\n# Registry not initialized\n";
-    }
-    
-    std::ostringstream oss;
     
-    // Collect metrics from registry and format as Prometheus text format
-    // prometheus-cpp uses Collect() method to get metrics
-    auto collected = registry_->Collect();
-    
-    // Group metrics by name for HELP/TYPE headers
-    std::map<std::string, std::vector<prometheus::MetricFamily>> grouped;
-    for (const auto& family : collected) {
-        grouped[family.name].push_back(family);
-    }
-    
-    // Format each metric family
-    for (const auto& [name, families] : grouped) {
-        if (families.empty()) continue;
-        
-        const auto& family = families[0];
-        
-        // HELP line
-        if (!family.help.empty()) {
-            oss << "# HELP " << name << " " << family.help << "\n";
-        }
-        
-        // TYPE line
-        std::string type_str;
-        switch (family.type) {
-            case prometheus::MetricType::Counter:
-                type_str = "counter";
-                break;
-            case prometheus::MetricType::Gauge:
-                type_str = "gauge";
-                break;
-            case prometheus::MetricType::Histogram:
-                type_str = "histogram";
-                break;
-            case prometheus::MetricType::Summary:
-                type_str = "summary";
-                break;
-            default:
-                type_str = "untyped";
-                break;
-        }
-        oss << "# TYPE " << name << " " << type_str << "\n";
-        
-        // Metric lines
-        for (const auto& metric : family.metric) {
-            oss << name;
-            
-            // Labels
-            if (!metric.label.empty()) {
-                oss << "{";
-                bool first = true;
-                for (const auto& label : metric.label) {
-                    if (!first) oss << ",";
-                    first = false;
-                    oss << label.name << "=\"" << label.value << "\"";
-                }
-                oss << "}";
-            }
-            
-            oss << " ";
-            
-            // Value based on type
-            switch (family.type) {
-                case prometheus::MetricType::Counter:
-                    if (metric.counter.has_value()) {
-                        oss << metric.counter->value;
-                    }
-                    break;
-                case prometheus::MetricType::Gauge:
-                    if (metric.gauge.has_value()) {
-                        oss << metric.gauge->value;
-                    }
-                    break;
-                case prometheus::MetricType::Histogram:
-                    if (metric.histogram.has_value()) {
-                        // Histogram: export buckets, sum, count
-                        const auto& hist = metric.histogram.value();
-                        
-                        // Export buckets
-                        for (const auto& bucket : hist.bucket) {
-                            oss << name << "_bucket{";
-                            if (!metric.label.empty()) {
-                                bool first = true;
-                                for (const auto& label : metric.label) {
-                                    if (!first) oss << ",";
-                                    first = false;
-                                    oss << label.name << "=\"" << label.value << "\"";
-                                }
-                            }
-                            oss << ",le=\"" << bucket.upper_bound << "\"} " << bucket.cumulative_count << "\n";
-                        }
-                        
-                        // Export sum
-                        oss << name << "_sum{";
-                        if (!metric.label.empty()) {
-                            bool first = true;
-                            for (const auto& label : metric.label) {
-                                if (!first) oss << ",";
-                                first = false;
-                                oss << label.name << "=\"" << label.value << "\"";
-                            }
-                        }
-                        oss << "} " << hist.sample_sum << "\n";
-                        
-                        // Export count
-                        oss << name << "_count{";
-                        if (!metric.label.empty()) {
-                            bool first = true;
-                            for (const auto& label : metric.label) {
-                                if (!first) oss << ",";
-                                first = false;
-                                oss << label.name << "=\"" << label.value << "\"";
-                            }
-                        }
-                        oss << "} " << hist.sample_count;
-                    }
-                    break;
-                default:
-                    oss << "0";
-                    break;
+    // Concurrent scrapers wait for one render and share it while it is fresh
+    MetricsCache& cache = metrics_cache_[static_cast<size_t>(format)];
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto now = std::chrono::steady_clock::now();
+    int64_t cache_ms = metrics_cache_ms_.load(std::memory_order_relaxed);
+    if (!cache.valid || cache_ms <= 0 || now - cache.rendered_at >= std::chrono::milliseconds(cache_ms)) {
+        {
+            std::lock_guard<std::mutex> collectors_lock(metrics_->collectors_mutex);
+            for (const auto& collector : metrics_->collectors) {
+                collector(*this);
             }
-            
-            oss << "\n";
         }
+        cache.body.clear(); // Keeps the capacity of earlier renders
+        metrics_->registry.render(cache.body, format);
+        cache.rendered_at = now;
+        cache.valid = true;
     }
-    
-    return oss.str();
-    */
-}
-
-void Observability::metrics_server_loop(int socket_fd) {
-    char buffer[4096];
-    
-    while (metrics_server_running_) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_fd = accept(socket_fd, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            if (metrics_server_running_) {
-                continue;
-            }
-            break;
-        }
-        
-        // Read request
-        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes_read > 0) {
-            buffer[bytes_read] = '\0';
-            
-            // Simple HTTP request parsing - check if it's GET /metrics
-            std::string request(buffer);
-            if (request.find("GET /metrics") != std::string::npos || 
-                request.find("GET /metrics HTTP") != std::string::npos) {
-                
-                // Generate metrics response
-                std::string response_body = get_metrics_response();
-                std::string response = 
-                    "HTTP/1.1 200 OK\r\n"
-                    "Content-Type: text/plain; version=0.0.4\r\n"
-                    "Content-Length: " + std::to_string(response_body.length()) + "\r\n"
-                    "\r\n" + response_body;
-                
-                send(client_fd, response.c_str(), response.length(), 0);
-            } else {
-                // 404 for other paths
-                std::string response = 
-                    "HTTP/1.1 404 Not Found\r\n"
-                    "Content-Type: text/plain\r\n"
-                    "Content-Length: 13\r\n"
-                    "\r\n"
-                    "404 Not Found";
-                send(client_fd, response.c_str(), response.length(), 0);
-            }
-        }
-        
-        close(client_fd);
-    }
-}
-
-void Observability::start_metrics_endpoint(const std::string& address, uint16_t port) {
-    if (!FeatureFlags::is_observability_metrics_enabled()) {
-        return; // Don't start if feature flag disabled
-    }
-    
-    if (metrics_server_running_) {
-        return; // Already running
-    }
-    
-    // Parse address
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    
-    if (address == "0.0.0.0" || address.empty()) {
-        server_addr.sin_addr.s_addr = INADDR_ANY;
-    } else {
-        inet_pton(AF_INET, address.c_str(), &server_addr.sin_addr);
-    }
-    
-    // Create socket
-    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_fd < 0) {
-        log_error("Failed to create metrics endpoint socket", "", "", "", "", "", {
-            {"error", "socket creation failed"}
-        });
-        return;
-    }
-    
-    // Set socket options
-    int opt = 1;
-    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    // Bind socket
-    if (bind(socket_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        log_error("Failed to bind metrics endpoint socket", "", "", "", "", "", {
-            {"error", "bind failed"},
-            {"address", address},
-            {"port", std::to_string(port)}
-        });
-        close(socket_fd);
-        return;
-    }
-    
-    // Listen
-    if (listen(socket_fd, 5) < 0) {
-        log_error("Failed to listen on metrics endpoint socket", "", "", "", "", "", {
-            {"error", "listen failed"}
-        });
-        close(socket_fd);
-        return;
-    }
-    
-    metrics_server_socket_ = socket_fd;
-    metrics_server_running_ = true;
-    
-    // Start server thread
-    metrics_server_thread_ = std::thread(&Observability::metrics_server_loop, this, socket_fd);
-    
-    log_info("Metrics endpoint started", "", "", "", "", "", {
-        {"address", address},
-        {"port", std::to_string(port)}
-    });
-}
-
-void Observability::stop_metrics_endpoint() {
-    if (!metrics_server_running_) {
-        return;
-    }
-    
-    metrics_server_running_ = false;
-    
-    // Close socket to wake up accept()
-    if (metrics_server_socket_ >= 0) {
-        close(metrics_server_socket_);
-        metrics_server_socket_ = -1;
-    }
-    
-    // Wait for thread to finish
-    if (metrics_server_thread_.joinable()) {
-        metrics_server_thread_.join();
-    }
-    
-    log_info("Metrics endpoint stopped");
+    return cache.body;
 }
 
 } // namespace worker
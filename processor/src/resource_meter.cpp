@@ -0,0 +1,186 @@
+#include "beamline/worker/resource_meter.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <malloc.h>
+#include <new>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+// Plain thread_local (no constructor): safe to touch from operator new on any thread
+struct HeapCounters {
+    int64_t allocated;
+    int64_t freed;
+    int64_t peak_balance;
+};
+
+thread_local HeapCounters heap_counters;
+
+inline void count_allocation(void* ptr) {
+    if (ptr) {
+        auto& counters = heap_counters;
+        counters.allocated += static_cast<int64_t>(malloc_usable_size(ptr));
+        counters.peak_balance = std::max(counters.peak_balance, counters.allocated - counters.freed);
+    }
+}
+
+inline void count_free(void* ptr) {
+    if (ptr) {
+        heap_counters.freed += static_cast<int64_t>(malloc_usable_size(ptr));
+    }
+}
+
+void* allocate(std::size_t size) {
+    void* ptr = std::malloc(size ? size : 1);
+    count_allocation(ptr);
+    return ptr;
+}
+
+void* allocate_aligned(std::size_t size, std::align_val_t alignment) {
+    void* ptr = nullptr;
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if (posix_memalign(&ptr, align, size ? size : 1) != 0) {
+        return nullptr;
+    }
+    count_allocation(ptr);
+    return ptr;
+}
+
+void release(void* ptr) noexcept {
+    count_free(ptr);
+    std::free(ptr);
+}
+
+} // namespace
+
+ResourceMeter::ResourceMeter()
+    : start_cpu_ns_(thread_cpu_time_ns()),
+      start_allocated_(heap_counters.allocated),
+      start_balance_(heap_counters.allocated - heap_counters.freed),
+      saved_peak_(heap_counters.peak_balance) {
+    heap_counters.peak_balance = start_balance_;
+}
+
+ResourceMeter::~ResourceMeter() {
+    heap_counters.peak_balance = std::max(saved_peak_, heap_counters.peak_balance);
+}
+
+ResourceMeter::Usage ResourceMeter::elapsed() const {
+    Usage usage;
+    usage.cpu_time_ns = thread_cpu_time_ns() - start_cpu_ns_;
+    usage.allocated_bytes = heap_counters.allocated - start_allocated_;
+    usage.peak_heap_bytes = std::max<int64_t>(0, heap_counters.peak_balance - start_balance_);
+    return usage;
+}
+
+int64_t ResourceMeter::thread_cpu_time_ns() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int64_t ResourceMeter::thread_allocated_bytes() {
+    return heap_counters.allocated;
+}
+
+int64_t ResourceMeter::thread_heap_balance() {
+    return heap_counters.allocated - heap_counters.freed;
+}
+
+} // namespace worker
+} // namespace beamline
+
+// Global allocation functions: count per-thread heap use for ResourceMeter
+
+void* operator new(std::size_t size) {
+    void* ptr = beamline::worker::allocate(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return beamline::worker::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return beamline::worker::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* ptr = beamline::worker::allocate_aligned(size, alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return beamline::worker::allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return beamline::worker::allocate_aligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    beamline::worker::release(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    beamline::worker::release(ptr);
+}
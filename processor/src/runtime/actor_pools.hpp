@@ -1,70 +1,427 @@
 #pragma once
 #include "worker/block_executor.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
+#include <new>
 #include <thread>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace worker {
 
+// Move-only callable with inline storage; callables up to kInlineSize bytes
+// (the usual lambda capturing a few pointers) are stored without allocating.
+class Task {
+ public:
+  static constexpr size_t kInlineSize = 48;
+
+  Task() noexcept = default;
+
+  template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+  Task(F&& f) {  // Implicit, like std::function
+    using Fn = std::decay_t<F>;
+    if constexpr (sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                  std::is_nothrow_move_constructible_v<Fn>) {
+      new (storage_) Fn(std::forward<F>(f));
+      ops_ = &kInlineOps<Fn>;
+    } else {
+      *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+      ops_ = &kHeapOps<Fn>;
+    }
+  }
+
+  Task(Task&& other) noexcept { take(other); }
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() { reset(); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+  void operator()() { ops_->invoke(storage_); }
+
+ private:
+  struct Ops {
+    void (*invoke)(void*);
+    void (*move)(void* from, void* to) noexcept;
+    void (*destroy)(void*) noexcept;
+  };
+
+  template <class Fn>
+  static constexpr Ops kInlineOps{
+      [](void* p) { (*static_cast<Fn*>(p))(); },
+      [](void* from, void* to) noexcept {
+        new (to) Fn(std::move(*static_cast<Fn*>(from)));
+        static_cast<Fn*>(from)->~Fn();
+      },
+      [](void* p) noexcept { static_cast<Fn*>(p)->~Fn(); }};
+
+  template <class Fn>
+  static constexpr Ops kHeapOps{
+      [](void* p) { (**static_cast<Fn**>(p))(); },
+      [](void* from, void* to) noexcept { *static_cast<Fn**>(to) = *static_cast<Fn**>(from); },
+      [](void* p) noexcept { delete *static_cast<Fn**>(p); }};
+
+  void take(Task& other) noexcept {
+    if (other.ops_) {
+      other.ops_->move(other.storage_, storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+  void reset() noexcept {
+    if (ops_) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+// Chase-Lev work-stealing deque (Lê et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models"). The owner pushes and takes at the bottom; other
+// workers steal from the top. Grows on demand; old arrays live until destruction.
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(size_t capacity = 256) {
+    buffers_.push_back(std::make_unique<Buffer>(capacity));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+  ~WorkStealingDeque() {
+    while (Task* task = take()) delete task;
+  }
+
+  // Owner only
+  void push(Task* task) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* a = buffer_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(a->mask)) a = grow(a, t, b);
+    a->put(b, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only; nullptr when empty
+  Task* take() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* a = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Task* task = a->get(b);
+    if (t == b) {
+      // Last element: race thieves for it
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        task = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // Any thread; nullptr when empty or when another thief won the race
+  Task* steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    Task* task = buffer_.load(std::memory_order_acquire)->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+  size_t size() const {
+    int64_t n = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(size_t min_capacity) {
+      size_t capacity = 2;
+      while (capacity < min_capacity) capacity <<= 1;
+      mask = capacity - 1;
+      slots = std::make_unique<std::atomic<Task*>[]>(capacity);
+    }
+    Task* get(int64_t i) const { return slots[static_cast<size_t>(i) & mask].load(std::memory_order_acquire); }
+    void put(int64_t i, Task* task) { slots[static_cast<size_t>(i) & mask].store(task, std::memory_order_release); }
+
+    size_t mask;
+    std::unique_ptr<std::atomic<Task*>[]> slots;
+  };
+
+  Buffer* grow(Buffer* a, int64_t t, int64_t b) {
+    buffers_.push_back(std::make_unique<Buffer>((a->mask + 1) * 2));
+    Buffer* bigger = buffers_.back().get();
+    for (int64_t i = t; i < b; ++i) bigger->put(i, a->get(i));
+    buffer_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  std::atomic<Buffer*> buffer_{nullptr};
+  std::vector<std::unique_ptr<Buffer>> buffers_;  // Owner only
+};
+
+// Bounded MPMC queue (Vyukov): each cell's sequence number hands it between
+// producers and consumers, so tasks are stored by value without locks.
+class InjectionQueue {
+ public:
+  explicit InjectionQueue(size_t min_capacity) {
+    size_t capacity = 2;
+    while (capacity < min_capacity) capacity <<= 1;
+    mask_ = capacity - 1;
+    cells_ = std::make_unique<Cell[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // Leaves `task` untouched and returns false when full
+  bool try_push(Task& task) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->task = std::move(task);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(Task& task) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    task = std::move(cell->task);
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence{0};
+    Task task;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_ = 0;
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+// Fixed set of worker threads. Tasks submitted from outside the pool go
+// through a lock-free injection queue; tasks a worker submits go onto its own
+// deque, where idle workers steal them. An idle worker spins briefly, then
+// parks until new work is submitted.
 class ActorPool {
  public:
-  explicit ActorPool(int concurrency) : concurrency_(concurrency), stop_(false) {
-    for (int i = 0; i < concurrency_; ++i) {
-      threads_.emplace_back([this]() { this->run(); });
+  explicit ActorPool(int concurrency, size_t injection_capacity = 4096)
+      : injection_(injection_capacity) {
+    size_t workers = concurrency > 0 ? static_cast<size_t>(concurrency) : 1;
+    for (size_t i = 0; i < workers; ++i) workers_.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < workers; ++i) {
+      workers_[i]->thread = std::thread([this, i]() { this->run(i); });
     }
   }
   ~ActorPool() {
+    stop_.store(true, std::memory_order_seq_cst);
     {
-      std::unique_lock<std::mutex> lk(mu_);
-      stop_ = true;
+      std::unique_lock<std::mutex> lk(park_mu_);
+      ++wake_epoch_;
     }
-    cv_.notify_all();
-    for (auto &t : threads_) t.join();
+    park_cv_.notify_all();
+    for (auto& w : workers_) w->thread.join();
   }
 
-  using Task = std::function<void()>;
+  ActorPool(const ActorPool&) = delete;
+  ActorPool& operator=(const ActorPool&) = delete;
+
   void submit(Task t) {
-    {
-      std::unique_lock<std::mutex> lk(mu_);
-      q_.push(std::move(t));
+    if (current_pool_ == this) {
+      workers_[current_index_]->deque.push(new Task(std::move(t)));
+    } else if (!injection_.try_push(t)) {
+      // Injection queue full: rare, so a locked spill list is fine here
+      std::unique_lock<std::mutex> lk(overflow_mu_);
+      overflow_.push_back(std::move(t));
+      overflow_size_.fetch_add(1, std::memory_order_relaxed);
     }
-    cv_.notify_one();
+    wake_one();
   }
 
+  // Approximate; never takes a lock
   size_t queue_depth() const {
-    std::unique_lock<std::mutex> lk(mu_);
-    return q_.size();
+    size_t depth = injection_.size() + overflow_size_.load(std::memory_order_relaxed);
+    for (const auto& w : workers_) depth += w->deque.size();
+    return depth;
   }
 
  private:
-  void run() {
+  struct Worker {
+    WorkStealingDeque deque;
+    std::thread thread;
+  };
+
+  static constexpr int kSpinRounds = 64;    // Look for work this many times before parking
+  static constexpr int kPauseRounds = 16;   // Of which the first ones only pause the CPU
+
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  void run(size_t index) {
+    current_pool_ = this;
+    current_index_ = index;
+    int idle_rounds = 0;
     while (true) {
       Task task;
-      {
-        std::unique_lock<std::mutex> lk(mu_);
-        cv_.wait(lk, [this]{ return stop_ || !q_.empty(); });
-        if (stop_ && q_.empty()) return;
-        task = std::move(q_.front());
-        q_.pop();
+      if (find_task(index, task)) {
+        idle_rounds = 0;
+        try {
+          task();
+        } catch (...) {
+          // Swallow exceptions in worker threads to prevent thread termination
+          // In production, exceptions should be logged and handled appropriately
+        }
+        continue;
+      }
+      if (stop_.load(std::memory_order_acquire)) {
+        if (!has_work()) return;  // Drained
+        continue;
+      }
+      if (++idle_rounds < kSpinRounds) {
+        if (idle_rounds < kPauseRounds) {
+          cpu_relax();
+        } else {
+          std::this_thread::yield();
+        }
+        continue;
+      }
+      park();
+      idle_rounds = 0;
+    }
+  }
+
+  bool find_task(size_t index, Task& task) {
+    if (Task* local = workers_[index]->deque.take()) {
+      task = std::move(*local);
+      delete local;
+      return true;
+    }
+    if (injection_.try_pop(task)) return true;
+    if (overflow_size_.load(std::memory_order_relaxed) > 0) {
+      std::unique_lock<std::mutex> lk(overflow_mu_);
+      if (!overflow_.empty()) {
+        task = std::move(overflow_.front());
+        overflow_.pop_front();
+        overflow_size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
       }
-      try {
-        task();
-      } catch (...) {
-        // Swallow exceptions in worker threads to prevent thread termination
-        // In production, exceptions should be logged and handled appropriately
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+      if (Task* stolen = workers_[(index + i) % workers_.size()]->deque.steal()) {
+        task = std::move(*stolen);
+        delete stolen;
+        return true;
       }
     }
+    return false;
   }
 
-  int concurrency_;
-  mutable std::mutex mu_;
-  std::condition_variable cv_;
-  std::queue<Task> q_;
-  bool stop_;
-  std::vector<std::thread> threads_;
+  bool has_work() const {
+    if (injection_.size() > 0 || overflow_size_.load(std::memory_order_relaxed) > 0) return true;
+    for (const auto& w : workers_) {
+      if (w->deque.size() > 0) return true;
+    }
+    return false;
+  }
+
+  // Sleepers announce themselves before a last look for work, and submitters
+  // check for sleepers after publishing, so a wakeup cannot be missed.
+  void park() {
+    std::unique_lock<std::mutex> lk(park_mu_);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work() && !stop_.load(std::memory_order_acquire)) {
+      uint64_t epoch = wake_epoch_;
+      park_cv_.wait(lk, [this, epoch] { return wake_epoch_ != epoch || stop_.load(std::memory_order_acquire); });
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+    {
+      std::unique_lock<std::mutex> lk(park_mu_);
+      ++wake_epoch_;
+    }
+    park_cv_.notify_one();
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  InjectionQueue injection_;
+  std::mutex overflow_mu_;
+  std::deque<Task> overflow_;
+  std::atomic<size_t> overflow_size_{0};
+
+  std::atomic<bool> stop_{false};
+  std::atomic<int> sleepers_{0};
+  std::mutex park_mu_;
+  std::condition_variable park_cv_;
+  uint64_t wake_epoch_ = 0;  // Guarded by park_mu_
+
+  static inline thread_local ActorPool* current_pool_ = nullptr;
+  static inline thread_local size_t current_index_ = 0;
 };
 
 struct Pools {
@@ -73,4 +430,4 @@ struct Pools {
   std::unique_ptr<ActorPool> io_pool;
 };
 
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #include "worker/types.hpp"
 #include "runtime/actor_pools.hpp"
+#include <functional>
 #include <unordered_map>
 
 namespace worker {
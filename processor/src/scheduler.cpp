@@ -14,15 +14,12 @@ public:
         initialize_resource_pools();
     }
     
-    caf::expected<caf::actor> schedule_step(const StepRequest& request, const BlockContext& context) {
+    caf::expected<caf::actor> schedule_step(const StepRequest& request, [[maybe_unused]] const BlockContext& context) {
         // Determine resource class based on block type and requirements
         ResourceClass resource_class = determine_resource_class(request);
         
-        // Check tenant quotas and limits
-        auto quota_check = check_tenant_quotas(context.tenant_id, resource_class);
-        if (!quota_check) {
-            return quota_check.error();
-        }
+        // Tenant quotas are not checked here: the pool admits every step and keeps an
+        // over-quota tenant's steps queued until its usage is back within quota
         
         // Get appropriate pool actor
         auto pool_actor = get_pool_for_resource(resource_class);
@@ -57,19 +54,21 @@ private:
     caf::actor_system& system_;
     WorkerConfig config_;
     std::unordered_map<std::string, caf::actor> resource_pools_;
-    std::unordered_map<std::string, std::unordered_map<ResourceClass, int64_t>> tenant_usage_;
     
     void initialize_resource_pools() {
         // Create CPU pool
-        PoolConfig cpu_config{ResourceClass::cpu, config_.cpu_pool_size};
+        PoolConfig cpu_config{ResourceClass::cpu, config_.cpu_pool_size, config_.executor_pool_min,
+                              config_.executor_pool_max, config_.executor_idle_timeout_ms, config_.tenant_weights};
         resource_pools_["cpu"] = caf::actor_cast<caf::actor>(system_.spawn<PoolActorImpl>(cpu_config));
         
         // Create GPU pool
-        PoolConfig gpu_config{ResourceClass::gpu, config_.gpu_pool_size};
+        PoolConfig gpu_config{ResourceClass::gpu, config_.gpu_pool_size, config_.executor_pool_min,
+                              config_.executor_pool_max, config_.executor_idle_timeout_ms, config_.tenant_weights};
         resource_pools_["gpu"] = caf::actor_cast<caf::actor>(system_.spawn<PoolActorImpl>(gpu_config));
         
         // Create I/O pool
-        PoolConfig io_config{ResourceClass::io, config_.io_pool_size};
+        PoolConfig io_config{ResourceClass::io, config_.io_pool_size, config_.executor_pool_min,
+                             config_.executor_pool_max, config_.executor_idle_timeout_ms, config_.tenant_weights};
         resource_pools_["io"] = caf::actor_cast<caf::actor>(system_.spawn<PoolActorImpl>(io_config));
     }
     
@@ -94,23 +93,6 @@ private:
         return ResourceClass::cpu;
     }
     
-    caf::expected<void> check_tenant_quotas(const std::string& tenant_id, ResourceClass resource_class) {
-        (void)resource_class; // Mark as used to avoid unused parameter warning
-        auto& usage = tenant_usage_[tenant_id];
-        
-        // Check memory quota
-        if (usage[ResourceClass::cpu] > config_.max_memory_per_tenant_mb * 1024 * 1024) {
-            return caf::make_error(caf::sec::runtime_error, "Tenant memory quota exceeded");
-        }
-        
-        // Check CPU time quota
-        if (usage[ResourceClass::cpu] > config_.max_cpu_time_per_tenant_ms) {
-            return caf::make_error(caf::sec::runtime_error, "Tenant CPU time quota exceeded");
-        }
-        
-        return caf::unit;
-    }
-    
     caf::optional<caf::actor> get_pool_for_resource(ResourceClass resource_class) {
         switch (resource_class) {
             case ResourceClass::cpu:
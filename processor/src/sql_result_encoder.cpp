@@ -0,0 +1,286 @@
+#include "beamline/worker/sql_result_encoder.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+constexpr char hex_digits[] = "0123456789abcdef";
+constexpr char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+enum BinaryType : unsigned char {
+    binary_null = 0,
+    binary_integer = 1,
+    binary_float = 2,
+    binary_text = 3,
+    binary_blob = 4
+};
+
+void append_base64(std::string& out, const unsigned char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 2 < size; i += 3) {
+        uint32_t triple = (uint32_t{data[i]} << 16) | (uint32_t{data[i + 1]} << 8) | data[i + 2];
+        out.push_back(base64_alphabet[(triple >> 18) & 0x3F]);
+        out.push_back(base64_alphabet[(triple >> 12) & 0x3F]);
+        out.push_back(base64_alphabet[(triple >> 6) & 0x3F]);
+        out.push_back(base64_alphabet[triple & 0x3F]);
+    }
+    if (i < size) {
+        uint32_t triple = uint32_t{data[i]} << 16;
+        if (i + 1 < size) {
+            triple |= uint32_t{data[i + 1]} << 8;
+        }
+        out.push_back(base64_alphabet[(triple >> 18) & 0x3F]);
+        out.push_back(base64_alphabet[(triple >> 12) & 0x3F]);
+        out.push_back(i + 1 < size ? base64_alphabet[(triple >> 6) & 0x3F] : '=');
+        out.push_back('=');
+    }
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    out.push_back('"');
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Copy the clean run in one go, then the escape
+        out.append(text.data() + run_start, i - run_start);
+        run_start = i + 1;
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(hex_digits[c >> 4]);
+                out.push_back(hex_digits[c & 0xF]);
+                break;
+        }
+    }
+    out.append(text.data() + run_start, text.size() - run_start);
+    out.push_back('"');
+}
+
+} // namespace
+
+std::optional<SqlResultEncoder::Format> SqlResultEncoder::parse_format(const std::string& name) {
+    if (name == "rows") {
+        return Format::rows;
+    } else if (name == "columnar") {
+        return Format::columnar;
+    } else if (name == "binary") {
+        return Format::binary;
+    }
+    return std::nullopt;
+}
+
+void SqlResultEncoder::begin(Format format, sqlite3_stmt* stmt) {
+    format_ = format;
+    column_count_ = sqlite3_column_count(stmt);
+    row_count_ = 0;
+    buffer_.clear();
+
+    switch (format_) {
+        case Format::rows: {
+            json_keys_.resize(static_cast<size_t>(column_count_));
+            for (int i = 0; i < column_count_; i++) {
+                auto& key = json_keys_[static_cast<size_t>(i)];
+                key.clear();
+                const char* name = sqlite3_column_name(stmt, i);
+                append_json_string(key, name ? name : "");
+                key.push_back(':');
+            }
+            buffer_.push_back('[');
+            break;
+        }
+        case Format::columnar:
+            buffer_.append("{\"columns\":[");
+            for (int i = 0; i < column_count_; i++) {
+                if (i > 0) {
+                    buffer_.push_back(',');
+                }
+                const char* name = sqlite3_column_name(stmt, i);
+                append_json_string(buffer_, name ? name : "");
+            }
+            buffer_.append("],\"rows\":[");
+            break;
+        case Format::binary:
+            buffer_.append("BLSQ");
+            buffer_.push_back(1);
+            append_varint(static_cast<uint64_t>(column_count_));
+            for (int i = 0; i < column_count_; i++) {
+                const char* name = sqlite3_column_name(stmt, i);
+                size_t length = name ? std::strlen(name) : 0;
+                append_varint(length);
+                buffer_.append(name ? name : "", length);
+            }
+            break;
+    }
+}
+
+void SqlResultEncoder::add_row(sqlite3_stmt* stmt) {
+    switch (format_) {
+        case Format::rows: {
+            if (row_count_ > 0) {
+                buffer_.push_back(',');
+            }
+            buffer_.push_back('{');
+            bool first = true;
+            for (int i = 0; i < column_count_; i++) {
+                if (sqlite3_column_type(stmt, i) == SQLITE_NULL) {
+                    continue;
+                }
+                if (!first) {
+                    buffer_.push_back(',');
+                }
+                first = false;
+                buffer_.append(json_keys_[static_cast<size_t>(i)]);
+                const auto* text = sqlite3_column_text(stmt, i);
+                int length = sqlite3_column_bytes(stmt, i);
+                append_json_string(buffer_, {reinterpret_cast<const char*>(text), static_cast<size_t>(length)});
+            }
+            buffer_.push_back('}');
+            break;
+        }
+        case Format::columnar:
+            if (row_count_ > 0) {
+                buffer_.push_back(',');
+            }
+            buffer_.push_back('[');
+            for (int i = 0; i < column_count_; i++) {
+                if (i > 0) {
+                    buffer_.push_back(',');
+                }
+                append_json_cell(stmt, i);
+            }
+            buffer_.push_back(']');
+            break;
+        case Format::binary:
+            buffer_.push_back(1);
+            for (int i = 0; i < column_count_; i++) {
+                append_binary_cell(stmt, i);
+            }
+            break;
+    }
+    row_count_++;
+}
+
+void SqlResultEncoder::finish() {
+    switch (format_) {
+        case Format::rows:
+            buffer_.push_back(']');
+            break;
+        case Format::columnar:
+            buffer_.append("]}");
+            break;
+        case Format::binary:
+            buffer_.push_back(0);
+            break;
+    }
+}
+
+void SqlResultEncoder::append_json_cell(sqlite3_stmt* stmt, int column) {
+    char number[32];
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER: {
+            auto result = std::to_chars(number, number + sizeof(number), sqlite3_column_int64(stmt, column));
+            buffer_.append(number, result.ptr);
+            break;
+        }
+        case SQLITE_FLOAT: {
+            double value = sqlite3_column_double(stmt, column);
+            if (!std::isfinite(value)) {
+                buffer_.append("null"); // JSON has no NaN/Infinity
+                break;
+            }
+            auto result = std::to_chars(number, number + sizeof(number), value);
+            buffer_.append(number, result.ptr);
+            break;
+        }
+        case SQLITE_TEXT: {
+            const auto* text = sqlite3_column_text(stmt, column);
+            int length = sqlite3_column_bytes(stmt, column);
+            append_json_string(buffer_, {reinterpret_cast<const char*>(text), static_cast<size_t>(length)});
+            break;
+        }
+        case SQLITE_BLOB: {
+            const auto* data = static_cast<const unsigned char*>(sqlite3_column_blob(stmt, column));
+            int length = sqlite3_column_bytes(stmt, column);
+            buffer_.push_back('"');
+            append_base64(buffer_, data, static_cast<size_t>(length));
+            buffer_.push_back('"');
+            break;
+        }
+        default:
+            buffer_.append("null");
+            break;
+    }
+}
+
+void SqlResultEncoder::append_binary_cell(sqlite3_stmt* stmt, int column) {
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER: {
+            auto value = static_cast<uint64_t>(sqlite3_column_int64(stmt, column));
+            buffer_.push_back(static_cast<char>(binary_integer));
+            // Zigzag so small negative numbers stay short
+            append_varint((value << 1) ^ (static_cast<uint64_t>(static_cast<int64_t>(value) >> 63)));
+            break;
+        }
+        case SQLITE_FLOAT: {
+            double value = sqlite3_column_double(stmt, column);
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            buffer_.push_back(static_cast<char>(binary_float));
+            for (int shift = 0; shift < 64; shift += 8) {
+                buffer_.push_back(static_cast<char>((bits >> shift) & 0xFF));
+            }
+            break;
+        }
+        case SQLITE_TEXT: {
+            const auto* text = sqlite3_column_text(stmt, column);
+            auto length = static_cast<size_t>(sqlite3_column_bytes(stmt, column));
+            buffer_.push_back(static_cast<char>(binary_text));
+            append_varint(length);
+            buffer_.append(reinterpret_cast<const char*>(text), length);
+            break;
+        }
+        case SQLITE_BLOB: {
+            const auto* data = static_cast<const char*>(sqlite3_column_blob(stmt, column));
+            auto length = static_cast<size_t>(sqlite3_column_bytes(stmt, column));
+            buffer_.push_back(static_cast<char>(binary_blob));
+            append_varint(length);
+            if (length > 0) {
+                buffer_.append(data, length);
+            }
+            break;
+        }
+        default:
+            buffer_.push_back(static_cast<char>(binary_null));
+            break;
+    }
+}
+
+void SqlResultEncoder::append_varint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+}
+
+void SqlResultEncoder::append_buffer_base64(std::string& out) const {
+    out.reserve(out.size() + (buffer_.size() + 2) / 3 * 4);
+    append_base64(out, reinterpret_cast<const unsigned char*>(buffer_.data()), buffer_.size());
+}
+
+} // namespace worker
+} // namespace beamline
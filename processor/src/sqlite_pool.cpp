@@ -0,0 +1,168 @@
+#include "beamline/worker/sqlite_pool.hpp"
+#include <stdexcept>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+SqliteConnectionPool::Config& default_config() {
+    static SqliteConnectionPool::Config config;
+    return config;
+}
+
+} // namespace
+
+SqliteConnection::SqliteConnection(sqlite3* db, size_t statement_cache_size)
+    : db_(db), statement_cache_size_(statement_cache_size) {}
+
+SqliteConnection::~SqliteConnection() {
+    for (auto& cached : lru_) {
+        sqlite3_finalize(cached.stmt);
+    }
+    sqlite3_close(db_);
+}
+
+sqlite3_stmt* SqliteConnection::prepare(const std::string& sql) {
+    auto it = statements_.find(sql);
+    if (it != statements_.end()) {
+        cache_hits_++;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->stmt;
+    }
+
+    cache_misses_++;
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v3(db_, sql.c_str(), static_cast<int>(sql.size()),
+                                SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
+    }
+    if (statement_cache_size_ == 0) {
+        statement_cache_size_ = 1; // The statement in use must stay owned by the cache
+    }
+
+    while (lru_.size() >= statement_cache_size_) {
+        auto& evicted = lru_.back();
+        sqlite3_finalize(evicted.stmt);
+        statements_.erase(evicted.sql);
+        lru_.pop_back();
+    }
+    lru_.push_front({sql, stmt});
+    statements_[sql] = lru_.begin();
+    return stmt;
+}
+
+void SqliteConnection::release(sqlite3_stmt* stmt) {
+    if (stmt) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+}
+
+SqliteConnectionPool::Lease::Lease(SqliteConnectionPool* pool, std::string key,
+                                   std::unique_ptr<SqliteConnection> connection)
+    : pool_(pool), key_(std::move(key)), connection_(std::move(connection)),
+      hits_at_acquire_(connection_->cache_hits()), misses_at_acquire_(connection_->cache_misses()) {}
+
+SqliteConnectionPool::Lease::~Lease() {
+    if (connection_) {
+        uint64_t new_hits = connection_->cache_hits() - hits_at_acquire_;
+        uint64_t new_misses = connection_->cache_misses() - misses_at_acquire_;
+        pool_->release(key_, std::move(connection_), discard_, new_hits, new_misses);
+    }
+}
+
+SqliteConnectionPool::SqliteConnectionPool(Config config)
+    : config_(config) {}
+
+void SqliteConnectionPool::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = config;
+}
+
+SqliteConnectionPool& SqliteConnectionPool::instance() {
+    static SqliteConnectionPool pool{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return pool;
+}
+
+bool SqliteConnectionPool::is_poolable(const std::string& connection_string) {
+    // "" is a private temporary database; ":memory:" and mode=memory URIs are per-handle
+    return !connection_string.empty() &&
+           connection_string != ":memory:" &&
+           connection_string.find("mode=memory") == std::string::npos;
+}
+
+SqliteConnectionPool::Lease SqliteConnectionPool::acquire(const std::string& connection_string) {
+    if (is_poolable(connection_string)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = idle_.find(connection_string);
+        if (it != idle_.end() && !it->second.empty()) {
+            auto connection = std::move(it->second.back());
+            it->second.pop_back();
+            stats_.reused++;
+            stats_.idle--;
+            return Lease(this, connection_string, std::move(connection));
+        }
+    }
+    return Lease(this, connection_string, open(connection_string));
+}
+
+std::unique_ptr<SqliteConnection> SqliteConnectionPool::open(const std::string& connection_string) {
+    sqlite3* db = nullptr;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX;
+    int rc = sqlite3_open_v2(connection_string.c_str(), &db, flags, nullptr);
+    if (rc != SQLITE_OK) {
+        std::string message = db ? sqlite3_errmsg(db) : sqlite3_errstr(rc);
+        sqlite3_close(db);
+        throw std::runtime_error("Failed to open database: " + connection_string + ": " + message);
+    }
+    sqlite3_busy_timeout(db, config_.busy_timeout_ms);
+
+    if (is_poolable(connection_string)) {
+        // WAL lets pooled readers proceed while another handle writes; NORMAL sync is durable in WAL mode
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.opened++;
+    }
+    return std::make_unique<SqliteConnection>(db, config_.statement_cache_size);
+}
+
+void SqliteConnectionPool::release(const std::string& key, std::unique_ptr<SqliteConnection> connection,
+                                   bool discard, uint64_t new_hits, uint64_t new_misses) {
+    std::unique_ptr<SqliteConnection> to_close;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.statement_hits += new_hits;
+        stats_.statement_misses += new_misses;
+
+        // An open transaction would leak into the next step; close such handles instead
+        bool clean = sqlite3_get_autocommit(connection->db()) != 0;
+        if (discard || !clean || !is_poolable(key) || idle_[key].size() >= config_.max_idle_per_database) {
+            to_close = std::move(connection);
+        } else {
+            idle_[key].push_back(std::move(connection));
+            stats_.idle++;
+        }
+    }
+    // to_close (if any) runs sqlite3_close here, outside the lock
+}
+
+SqliteConnectionPool::Stats SqliteConnectionPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,165 @@
+#include "beamline/worker/tenant_ledger.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+TenantLedger::Config& default_config() {
+    static TenantLedger::Config config;
+    return config;
+}
+
+void store_max(std::atomic<int64_t>& cell, int64_t value) {
+    int64_t current = cell.load(std::memory_order_relaxed);
+    while (value > current && !cell.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+TenantLedger::TenantLedger(Config config)
+    : config_(config),
+      bucket_ms_(std::max<int64_t>(1, config.window_ms / static_cast<int64_t>(std::max<size_t>(1, config.buckets)))),
+      mask_(std::bit_ceil(std::max<size_t>(16, config.max_tenants * 2)) - 1),
+      table_(new std::atomic<Account*>[mask_ + 1]) {
+    config_.buckets = std::max<size_t>(1, config_.buckets);
+    for (size_t i = 0; i <= mask_; i++) {
+        table_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+TenantLedger::~TenantLedger() = default;
+
+void TenantLedger::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = config;
+}
+
+TenantLedger& TenantLedger::instance() {
+    static TenantLedger ledger{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return ledger;
+}
+
+int64_t TenantLedger::epoch_of(Clock::time_point now) const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / bucket_ms_;
+}
+
+TenantLedger::Account* TenantLedger::find(std::string_view tenant_id, size_t hash) const {
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+        Account* account = table_[i].load(std::memory_order_acquire);
+        if (!account) {
+            return nullptr;
+        }
+        if (account->tenant_id == tenant_id) {
+            return account;
+        }
+    }
+}
+
+TenantLedger::Account* TenantLedger::find_or_create(std::string_view tenant_id) {
+    size_t hash = std::hash<std::string_view>{}(tenant_id);
+    if (Account* account = find(tenant_id, hash)) {
+        return account;
+    }
+
+    // First step of this tenant
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Account* account = find(tenant_id, hash)) {
+        return account;
+    }
+    if (accounts_.size() >= config_.max_tenants) {
+        if (!overflow_.load(std::memory_order_relaxed)) {
+            accounts_.push_back(std::make_unique<Account>(std::string(OVERFLOW_TENANT), config_.buckets));
+            overflow_.store(accounts_.back().get(), std::memory_order_release);
+        }
+        return overflow_.load(std::memory_order_relaxed);
+    }
+    accounts_.push_back(std::make_unique<Account>(std::string(tenant_id), config_.buckets));
+    Account* account = accounts_.back().get();
+    size_t i = hash & mask_;
+    while (table_[i].load(std::memory_order_relaxed)) {
+        i = (i + 1) & mask_;
+    }
+    table_[i].store(account, std::memory_order_release);
+    return account;
+}
+
+void TenantLedger::record(std::string_view tenant_id, int64_t cpu_time_ns, int64_t allocated_bytes,
+                          int64_t peak_heap_bytes, Clock::time_point now) {
+    if (tenant_id.empty()) {
+        return;
+    }
+    Account* account = find_or_create(tenant_id);
+    int64_t epoch = epoch_of(now);
+    auto& bucket = account->ring[static_cast<size_t>(epoch) % config_.buckets];
+
+    int64_t seen = bucket.epoch.load(std::memory_order_acquire);
+    if (seen < epoch && bucket.epoch.compare_exchange_strong(seen, epoch, std::memory_order_acq_rel)) {
+        // This slot last held a bucket that has left the window
+        bucket.cpu_time_ns.store(0, std::memory_order_relaxed);
+        bucket.allocated_bytes.store(0, std::memory_order_relaxed);
+        bucket.peak_heap_bytes.store(0, std::memory_order_relaxed);
+        bucket.steps.store(0, std::memory_order_relaxed);
+    }
+    bucket.cpu_time_ns.fetch_add(cpu_time_ns, std::memory_order_relaxed);
+    bucket.allocated_bytes.fetch_add(allocated_bytes, std::memory_order_relaxed);
+    store_max(bucket.peak_heap_bytes, peak_heap_bytes);
+    bucket.steps.fetch_add(1, std::memory_order_relaxed);
+}
+
+TenantLedger::Usage TenantLedger::usage(std::string_view tenant_id, Clock::time_point now) const {
+    Usage usage;
+    if (tenant_id.empty()) {
+        return usage;
+    }
+    Account* account = find(tenant_id, std::hash<std::string_view>{}(tenant_id));
+    if (!account) {
+        // Unknown tenants record into the overflow account once the table is full
+        account = overflow_.load(std::memory_order_acquire);
+        if (!account) {
+            return usage;
+        }
+    }
+    int64_t epoch = epoch_of(now);
+    int64_t oldest = epoch - static_cast<int64_t>(config_.buckets) + 1;
+    for (const auto& bucket : account->ring) {
+        int64_t bucket_epoch = bucket.epoch.load(std::memory_order_acquire);
+        if (bucket_epoch < oldest || bucket_epoch > epoch) {
+            continue;
+        }
+        usage.cpu_time_ns += bucket.cpu_time_ns.load(std::memory_order_relaxed);
+        usage.allocated_bytes += bucket.allocated_bytes.load(std::memory_order_relaxed);
+        usage.peak_heap_bytes = std::max(usage.peak_heap_bytes, bucket.peak_heap_bytes.load(std::memory_order_relaxed));
+        usage.steps += bucket.steps.load(std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+TenantLedger::QuotaState TenantLedger::quota_state(std::string_view tenant_id, Clock::time_point now) const {
+    if (tenant_id.empty() || (config_.max_cpu_time_ms <= 0 && config_.max_memory_bytes <= 0)) {
+        return QuotaState::within;
+    }
+    auto window = usage(tenant_id, now);
+    if (config_.max_memory_bytes > 0 && window.peak_heap_bytes > config_.max_memory_bytes) {
+        return QuotaState::memory_exceeded;
+    }
+    if (config_.max_cpu_time_ms > 0 && window.cpu_time_ns > config_.max_cpu_time_ms * 1000000) {
+        return QuotaState::cpu_time_exceeded;
+    }
+    return QuotaState::within;
+}
+
+} // namespace worker
+} // namespace beamline
@@ -0,0 +1,562 @@
+#include "beamline/worker/tracer.hpp"
+#include "beamline/worker/json_log_format.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace beamline {
+namespace worker {
+
+namespace {
+
+std::mutex& default_config_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+Tracer::Config& default_config() {
+    static Tracer::Config config;
+    return config;
+}
+
+constexpr size_t MIN_RING_SPANS = 16;
+
+std::atomic<uint64_t> next_tracer_id{1};
+
+thread_local SpanContext current_span_context;
+
+int64_t to_ns(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Non-zero random ids from a per-thread splitmix64 stream
+uint64_t random_id() {
+    thread_local uint64_t state = [] {
+        std::random_device device;
+        return (static_cast<uint64_t>(device()) << 32) ^ device() ^
+               std::hash<std::thread::id>()(std::this_thread::get_id());
+    }();
+    uint64_t value;
+    do {
+        state += 0x9E3779B97F4A7C15ULL;
+        value = state;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        value ^= value >> 31;
+    } while (value == 0);
+    return value;
+}
+
+void append_hex(std::string& out, uint64_t value) {
+    static constexpr char digits[] = "0123456789abcdef";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        out.push_back(digits[(value >> shift) & 0xF]);
+    }
+}
+
+bool parse_hex(std::string_view text, uint64_t& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+uint8_t copy_truncated(char* buffer, std::string_view value) {
+    size_t length = std::min(value.size(), SpanRecord::MAX_VALUE_BYTES);
+    std::memcpy(buffer, value.data(), length);
+    return static_cast<uint8_t>(length);
+}
+
+} // namespace
+
+std::string SpanContext::traceparent() const {
+    std::string header;
+    if (!valid()) {
+        return header;
+    }
+    header.reserve(55);
+    header.append("00-");
+    append_hex(header, trace_high);
+    append_hex(header, trace_low);
+    header.push_back('-');
+    append_hex(header, span_id);
+    header.append(sampled ? "-01" : "-00");
+    return header;
+}
+
+SpanContext SpanContext::from_traceparent(std::string_view header, bool remote) {
+    SpanContext context;
+    uint64_t flags = 0;
+    if (header.size() != 55 || header.substr(0, 3) != "00-" || header[35] != '-' || header[52] != '-' ||
+        !parse_hex(header.substr(3, 16), context.trace_high) ||
+        !parse_hex(header.substr(19, 16), context.trace_low) ||
+        !parse_hex(header.substr(36, 16), context.span_id) ||
+        !parse_hex(header.substr(53, 2), flags)) {
+        return SpanContext();
+    }
+    if (!context.valid()) {
+        return SpanContext();
+    }
+    context.sampled = (flags & 1) != 0;
+    context.remote = remote;
+    return context;
+}
+
+Span::Span(Span&& other) noexcept : tracer_(other.tracer_), record_(other.record_) {
+    other.tracer_ = nullptr;
+}
+
+Span& Span::operator=(Span&& other) noexcept {
+    if (this != &other) {
+        end();
+        tracer_ = other.tracer_;
+        record_ = other.record_;
+        other.tracer_ = nullptr;
+    }
+    return *this;
+}
+
+SpanContext Span::context() const {
+    SpanContext context;
+    if (tracer_) {
+        context.trace_high = record_.trace_high;
+        context.trace_low = record_.trace_low;
+        context.span_id = record_.span_id;
+        context.sampled = (record_.flags & SpanRecord::SAMPLED) != 0;
+    }
+    return context;
+}
+
+Span& Span::set_attribute(const char* key, std::string_view value) {
+    if (tracer_ && record_.attribute_count < SpanRecord::MAX_ATTRIBUTES) {
+        auto& attribute = record_.attributes[record_.attribute_count++];
+        attribute.key = key;
+        attribute.integer = false;
+        attribute.length = copy_truncated(attribute.value, value);
+    }
+    return *this;
+}
+
+Span& Span::set_attribute(const char* key, int64_t value) {
+    if (tracer_ && record_.attribute_count < SpanRecord::MAX_ATTRIBUTES) {
+        auto& attribute = record_.attributes[record_.attribute_count++];
+        attribute.key = key;
+        attribute.integer = true;
+        auto end = std::to_chars(attribute.value, attribute.value + SpanRecord::MAX_VALUE_BYTES, value).ptr;
+        attribute.length = static_cast<uint8_t>(end - attribute.value);
+    }
+    return *this;
+}
+
+void Span::set_error(std::string_view message) {
+    if (tracer_) {
+        record_.flags |= SpanRecord::ERROR;
+        record_.status_length = copy_truncated(record_.status_message, message);
+    }
+}
+
+void Span::end() {
+    if (!tracer_) {
+        return;
+    }
+    record_.end_ns = to_ns(std::chrono::steady_clock::now());
+    tracer_->submit(record_);
+    tracer_ = nullptr;
+}
+
+struct Tracer::Ring {
+    explicit Ring(size_t capacity)
+        : slots(capacity), mask(capacity - 1) {}
+
+    std::vector<SpanRecord> slots;
+    const size_t mask;
+    alignas(64) std::atomic<uint64_t> head{0};      // Written by the owning thread
+    alignas(64) std::atomic<uint64_t> tail{0};      // Written by the exporter
+    alignas(64) std::atomic<uint64_t> recorded{0};  // Owner-only counters, read by stats()
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> closed{false};                // Owning thread has exited
+
+    size_t capacity() const { return slots.size(); }
+};
+
+namespace {
+
+// Rings of the current thread, one per tracer it has recorded into (see AsyncLogger)
+struct LocalRing {
+    uint64_t tracer_id;
+    void* ring;
+    std::shared_ptr<std::atomic<bool>> closed;
+};
+
+struct LocalRings {
+    std::vector<LocalRing> entries;
+
+    ~LocalRings() {
+        for (auto& entry : entries) {
+            entry.closed->store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local LocalRings local_rings;
+
+} // namespace
+
+Tracer::Tracer(Config config)
+    : id_(next_tracer_id.fetch_add(1, std::memory_order_relaxed)),
+      config_(std::move(config)),
+      enabled_(!config_.path.empty()) {
+    size_t capacity = MIN_RING_SPANS;
+    while (capacity < config_.ring_spans) {
+        capacity <<= 1;
+    }
+    config_.ring_spans = capacity;
+    config_.max_batch_spans = std::max<size_t>(config_.max_batch_spans, 1);
+
+    double ratio = std::clamp(config_.sample_ratio, 0.0, 1.0);
+    sample_threshold_ = ratio >= 1.0 ? UINT64_MAX : static_cast<uint64_t>(ratio * 18446744073709551616.0);
+    epoch_offset_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count() -
+                       to_ns(std::chrono::steady_clock::now());
+
+    if (!enabled_) {
+        return;
+    }
+    fd_ = ::open(config_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open trace file " + config_.path + ": " + std::strerror(errno));
+    }
+    exporter_ = std::thread([this]() { exporter_loop(); });
+}
+
+Tracer::~Tracer() {
+    if (!enabled_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    work_cv_.notify_one();
+    exporter_.join();
+    ::close(fd_);
+}
+
+void Tracer::configure(Config config) {
+    std::lock_guard<std::mutex> lock(default_config_mutex());
+    default_config() = std::move(config);
+}
+
+Tracer& Tracer::instance() {
+    static Tracer tracer{[] {
+        std::lock_guard<std::mutex> lock(default_config_mutex());
+        return default_config();
+    }()};
+    return tracer;
+}
+
+Span Tracer::start_span(const char* name, const SpanContext& parent, SpanKind kind) {
+    if (!enabled_) {
+        return Span();
+    }
+    return start_span(name, parent, kind, std::chrono::steady_clock::now());
+}
+
+Span Tracer::start_span(const char* name, const SpanContext& parent, SpanKind kind,
+                        std::chrono::steady_clock::time_point start) {
+    Span span;
+    if (!enabled_) {
+        return span;
+    }
+    span.tracer_ = this;
+    SpanRecord& record = span.record_;
+    record.name = name;
+    record.start_ns = to_ns(start);
+    record.span_id = random_id();
+    bool sampled;
+    if (parent.valid()) {
+        record.trace_high = parent.trace_high;
+        record.trace_low = parent.trace_low;
+        record.parent_span_id = parent.span_id;
+        sampled = parent.sampled;
+    } else {
+        record.trace_high = random_id();
+        record.trace_low = random_id();
+        sampled = sample_threshold_ == UINT64_MAX || record.trace_low < sample_threshold_;
+    }
+    record.flags = static_cast<uint8_t>((sampled ? SpanRecord::SAMPLED : 0) |
+                                        (!parent.valid() || parent.remote ? SpanRecord::LOCAL_ROOT : 0) |
+                                        (kind == SpanKind::client ? SpanRecord::CLIENT : 0));
+    return span;
+}
+
+Span Tracer::start_child(const char* name, SpanKind kind) {
+    if (!enabled_ || !current_span_context.valid()) {
+        return Span();
+    }
+    return start_span(name, current_span_context, kind);
+}
+
+SpanContext Tracer::current() {
+    return current_span_context;
+}
+
+Tracer::Scope::Scope(const SpanContext& context) : previous_(current_span_context) {
+    current_span_context = context;
+}
+
+Tracer::Scope::~Scope() {
+    current_span_context = previous_;
+}
+
+void Tracer::submit(const SpanRecord& record) {
+    Ring& ring = local_ring();
+    ring.recorded.store(ring.recorded.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= ring.capacity()) {
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    ring.slots[static_cast<size_t>(head) & ring.mask] = record;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+Tracer::Ring& Tracer::local_ring() {
+    for (auto& entry : local_rings.entries) {
+        if (entry.tracer_id == id_) {
+            return *static_cast<Ring*>(entry.ring);
+        }
+    }
+
+    auto ring = std::make_shared<Ring>(config_.ring_spans);
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+    local_rings.entries.push_back({id_, ring.get(), std::shared_ptr<std::atomic<bool>>(ring, &ring->closed)});
+    return *ring;
+}
+
+void Tracer::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!enabled_ || !running_) {
+        return;
+    }
+    uint64_t ticket = ++flush_requested_;
+    work_cv_.notify_one();
+    flushed_cv_.wait(lock, [this, ticket]() { return flush_completed_ >= ticket; });
+}
+
+Tracer::Stats Tracer::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        stats.recorded = retired_recorded_;
+        stats.dropped = retired_dropped_;
+        for (const auto& ring : rings_) {
+            stats.recorded += ring->recorded.load(std::memory_order_relaxed);
+            stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+        stats.threads = rings_.size();
+    }
+    stats.dropped += dropped_.load(std::memory_order_relaxed);
+    stats.exported = exported_.load(std::memory_order_relaxed);
+    stats.discarded = discarded_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.pending = pending_spans_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Tracer::exporter_loop() {
+    auto interval = std::chrono::milliseconds(std::max<int64_t>(config_.export_interval_ms, 1));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait_for(lock, interval, [this]() { return !running_ || flush_requested_ > flush_completed_; });
+        bool stopping = !running_;
+        uint64_t target = flush_requested_;
+
+        lock.unlock();
+        export_pass(stopping);
+        lock.lock();
+
+        flush_completed_ = target;
+        flushed_cv_.notify_all();
+        if (stopping) {
+            break;
+        }
+    }
+}
+
+void Tracer::export_pass(bool final) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+    drained_.clear();
+    for (auto& ring : rings) {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail < head; tail++) {
+            drained_.push_back(ring->slots[static_cast<size_t>(tail) & ring->mask]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+
+    // Head-sampled spans go straight out; the rest wait for their trace's tail decision
+    using Decision = PendingTrace::Decision;
+    int64_t now = to_ns(std::chrono::steady_clock::now());
+    int64_t slow_ns = config_.slow_threshold_ms * 1000000;
+    size_t pending_spans = pending_spans_.load(std::memory_order_relaxed);
+    batch_.clear();
+    for (const SpanRecord& record : drained_) {
+        if (record.flags & SpanRecord::SAMPLED) {
+            batch_.push_back(record);
+            continue;
+        }
+        auto [it, inserted] = pending_.try_emplace(TraceKey{record.trace_high, record.trace_low});
+        PendingTrace& trace = it->second;
+        trace.updated_ns = now;
+        if (trace.decision == Decision::keep) {
+            batch_.push_back(record);
+            continue;
+        }
+        if (trace.decision == Decision::drop) {
+            discarded_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        bool root = (record.flags & SpanRecord::LOCAL_ROOT) != 0;
+        bool failed = config_.keep_errors && (record.flags & SpanRecord::ERROR) != 0;
+        if (failed || (root && record.end_ns - record.start_ns >= slow_ns)) {
+            trace.decision = Decision::keep;
+            batch_.insert(batch_.end(), trace.spans.begin(), trace.spans.end());
+            batch_.push_back(record);
+        } else if (root) {
+            trace.decision = Decision::drop;
+            discarded_.fetch_add(trace.spans.size() + 1, std::memory_order_relaxed);
+        } else if (pending_spans >= config_.max_pending_spans) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        } else {
+            trace.spans.push_back(record);
+            pending_spans++;
+            continue;
+        }
+        pending_spans -= trace.spans.size();
+        std::vector<SpanRecord>().swap(trace.spans);
+    }
+
+    // Decisions are remembered for a few intervals so late spans (e.g. from another
+    // thread's ring) follow them; undecided traces expire after the tail timeout
+    int64_t decision_ttl_ns = std::max<int64_t>(config_.export_interval_ms, 1) * 3 * 1000000;
+    int64_t tail_timeout_ns = config_.tail_timeout_ms * 1000000;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        PendingTrace& trace = it->second;
+        int64_t age = now - trace.updated_ns;
+        bool undecided = trace.decision == Decision::undecided;
+        if (final || age >= (undecided ? tail_timeout_ns : decision_ttl_ns)) {
+            discarded_.fetch_add(trace.spans.size(), std::memory_order_relaxed);
+            pending_spans -= trace.spans.size();
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    pending_spans_.store(pending_spans, std::memory_order_relaxed);
+
+    for (size_t offset = 0; offset < batch_.size(); offset += config_.max_batch_spans) {
+        size_t count = std::min(config_.max_batch_spans, batch_.size() - offset);
+        write_batch(std::vector<SpanRecord>(batch_.begin() + static_cast<std::ptrdiff_t>(offset),
+                                            batch_.begin() + static_cast<std::ptrdiff_t>(offset + count)));
+    }
+
+    // Forget rings of exited threads once everything they recorded is drained
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (auto it = rings_.begin(); it != rings_.end();) {
+        Ring& ring = **it;
+        if (ring.closed.load(std::memory_order_acquire) &&
+            ring.tail.load(std::memory_order_relaxed) == ring.head.load(std::memory_order_acquire)) {
+            retired_recorded_ += ring.recorded.load(std::memory_order_relaxed);
+            retired_dropped_ += ring.dropped.load(std::memory_order_relaxed);
+            it = rings_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Tracer::write_batch(const std::vector<SpanRecord>& spans) {
+    // One OTLP/JSON ExportTraceServiceRequest per line
+    std::string& out = output_;
+    out.clear();
+    out.append("{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":{\"stringValue\":");
+    append_json_log_string(out, config_.service_name);
+    out.append("}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"beamline.worker\"},\"spans\":[");
+    char digits[24];
+    auto append_int = [&](int64_t value) {
+        out.push_back('"');
+        out.append(digits, static_cast<size_t>(std::to_chars(digits, digits + sizeof(digits), value).ptr - digits));
+        out.push_back('"');
+    };
+    for (size_t i = 0; i < spans.size(); i++) {
+        const SpanRecord& span = spans[i];
+        out.append(i == 0 ? "{\"traceId\":\"" : ",{\"traceId\":\"");
+        append_hex(out, span.trace_high);
+        append_hex(out, span.trace_low);
+        out.append("\",\"spanId\":\"");
+        append_hex(out, span.span_id);
+        out.push_back('"');
+        if (span.parent_span_id != 0) {
+            out.append(",\"parentSpanId\":\"");
+            append_hex(out, span.parent_span_id);
+            out.push_back('"');
+        }
+        out.append(",\"name\":");
+        append_json_log_string(out, span.name);
+        out.append((span.flags & SpanRecord::CLIENT) ? ",\"kind\":3" : ",\"kind\":1");
+        out.append(",\"startTimeUnixNano\":");
+        append_int(span.start_ns + epoch_offset_ns_);
+        out.append(",\"endTimeUnixNano\":");
+        append_int(span.end_ns + epoch_offset_ns_);
+        out.append(",\"attributes\":[");
+        for (size_t a = 0; a < span.attribute_count; a++) {
+            const auto& attribute = span.attributes[a];
+            out.append(a == 0 ? "{\"key\":" : ",{\"key\":");
+            append_json_log_string(out, attribute.key);
+            out.append(attribute.integer ? ",\"value\":{\"intValue\":" : ",\"value\":{\"stringValue\":");
+            append_json_log_string(out, std::string_view(attribute.value, attribute.length));
+            out.append("}}");
+        }
+        out.push_back(']');
+        if (span.flags & SpanRecord::ERROR) {
+            out.append(",\"status\":{\"code\":2,\"message\":");
+            append_json_log_string(out, std::string_view(span.status_message, span.status_length));
+            out.push_back('}');
+        }
+        out.push_back('}');
+    }
+    out.append("]}]}]}\n");
+
+    size_t written = 0;
+    while (written < out.size()) {
+        ssize_t result = ::write(fd_, out.data() + written, out.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // Nowhere to report it; the batch is lost
+        }
+        written += static_cast<size_t>(result);
+    }
+    exported_.fetch_add(spans.size(), std::memory_order_relaxed);
+    batches_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace worker
+} // namespace beamline
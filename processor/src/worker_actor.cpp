@@ -1,18 +1,23 @@
 #include "beamline/worker/actors.hpp"
 #include "beamline/worker/observability.hpp"
+#ifdef BEAMLINE_WITH_CURL
 #include "beamline/worker/blocks/http_block.hpp"
+#endif
 #include "beamline/worker/blocks/fs_block.hpp"
 #include "beamline/worker/retry_policy.hpp"
 #include "beamline/worker/feature_flags.hpp"
+#include "beamline/worker/result_converter.hpp"
+#include "beamline/worker/tenant_ledger.hpp"
+#include "beamline/worker/tracer.hpp"
 #include <caf/actor_system.hpp>
 #include <caf/scheduled_actor.hpp>
 #include <caf/local_actor.hpp> // Added for send
 #include <caf/typed_event_based_actor.hpp>
 #include <caf/send.hpp>
 #include <unordered_map>
-#include <thread>
+#include <algorithm>
 #include <chrono>
-#include <iostream>
+#include <mutex>
 
 namespace beamline {
 namespace worker {
@@ -86,15 +91,18 @@ worker_actor::behavior_type WorkerActorState::make_behavior() {
 
 void WorkerActorState::initialize_pools() {
     // Create CPU pool
-    PoolConfig cpu_config{ResourceClass::cpu, config_.cpu_pool_size};
+    PoolConfig cpu_config{ResourceClass::cpu, config_.cpu_pool_size, config_.executor_pool_min,
+                          config_.executor_pool_max, config_.executor_idle_timeout_ms, config_.tenant_weights};
     pools_["cpu"] = caf::actor_cast<caf::actor>(system_.spawn<PoolActorImpl>(cpu_config));
     
     // Create GPU pool
-    PoolConfig gpu_config{ResourceClass::gpu, config_.gpu_pool_size};
+    PoolConfig gpu_config{ResourceClass::gpu, config_.gpu_pool_size, config_.executor_pool_min,
+                          config_.executor_pool_max, config_.executor_idle_timeout_ms, config_.tenant_weights};
     pools_["gpu"] = caf::actor_cast<caf::actor>(system_.spawn<PoolActorImpl>(gpu_config));
     
     // Create I/O pool
-    PoolConfig io_config{ResourceClass::io, config_.io_pool_size};
+    PoolConfig io_config{ResourceClass::io, config_.io_pool_size, config_.executor_pool_min,
+                         config_.executor_pool_max, config_.executor_idle_timeout_ms, config_.tenant_weights};
     pools_["io"] = caf::actor_cast<caf::actor>(system_.spawn<PoolActorImpl>(io_config));
     
     observability_->log_info("Actor pools initialized", "", "", "", "", "", {
@@ -125,8 +133,52 @@ caf::actor WorkerActorState::get_pool_for_resource(ResourceClass resource_class)
 }
 
 // Pool Actor Implementation
+// Block types served by pooled executor actors (see create_block_executor)
+static const std::vector<std::string> POOLED_BLOCK_TYPES = {
+    "http.request", "fs.blob_put", "fs.blob_get"
+};
+
+namespace {
+
+std::mutex& block_registry_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_map<std::string, BlockExecutorFactory>& block_registry() {
+    static std::unordered_map<std::string, BlockExecutorFactory> factories;
+    return factories;
+}
+
+} // namespace
+
+void register_block_executor(const std::string& type, BlockExecutorFactory factory) {
+    std::lock_guard<std::mutex> lock(block_registry_mutex());
+    block_registry()[type] = std::move(factory);
+}
+
+// How often throttled tenants are checked against their quotas again
+static constexpr std::chrono::milliseconds THROTTLE_CHECK_INTERVAL{1000};
+
+static const char* resource_pool_name(ResourceClass resource_class) {
+    switch (resource_class) {
+        case ResourceClass::cpu: return "cpu";
+        case ResourceClass::gpu: return "gpu";
+        case ResourceClass::io: return "io";
+    }
+    return "cpu";
+}
+
 PoolActorState::PoolActorState(caf::scheduled_actor* self, PoolConfig config)
-    : system_(self->system()), resource_class_(config.resource_class), max_concurrency_(config.max_concurrency), self_(self) {
+    : system_(self->system()), resource_class_(config.resource_class), max_concurrency_(config.max_concurrency),
+      pending_requests_(parse_tenant_weights(config.tenant_weights)),
+      executor_pooling_(config.executor_pooling),
+      executor_pool_min_(config.executor_pooling ? std::max(0, config.executor_pool_min) : 0),
+      executor_pool_max_(config.executor_pool_max > 0 ? config.executor_pool_max : std::max(1, config.max_concurrency)),
+      executor_idle_timeout_(config.executor_idle_timeout_ms),
+      self_(self) {
+    executor_pool_min_ = std::min(executor_pool_min_, executor_pool_max_);
+
     // CP2: Initialize observability for metrics
     observability_ = std::make_shared<Observability>("pool_" + 
         std::string(resource_class_ == ResourceClass::cpu ? "cpu" : 
@@ -141,18 +193,37 @@ PoolActorState::PoolActorState(caf::scheduled_actor* self, PoolConfig config)
 }
 
 pool_actor::behavior_type PoolActorState::make_behavior() {
+    prewarm_executors();
+    
+    // Periodic idle-executor eviction tick
+    if (executor_pooling_ && executor_idle_timeout_.count() > 0) {
+        caf::delayed_anon_send(caf::actor_cast<caf::actor>(self_),
+                               std::max(executor_idle_timeout_ / 2, std::chrono::milliseconds(100)),
+                               caf::atom("evict"));
+    }
+    
     return {
         [this](caf::atom_value execute_atom, const StepRequest& request) {
             if (execute_atom != caf::atom("execute")) {
                 return;
             }
             
+            auto step_span = start_step_span(request);
+            auto tenant = request.inputs.find("tenant_id");
+            const std::string tenant_id = tenant != request.inputs.end() ? tenant->second : std::string();
+            // A tenant over its quota waits in the pending queue until it is back within it
+            bool throttled = throttle_if_over_quota(tenant_id);
+            
             // CP2: Check queue bounds before queuing
-            if (current_load_ >= max_concurrency_) {
+            if (current_load_ >= max_concurrency_ || throttled) {
                 // Need to queue the request
                 if (FeatureFlags::is_queue_management_enabled()) {
-                    // CP2: Check if queue is full
-                    if (max_queue_size_ > 0 && pending_requests_.size() >= static_cast<size_t>(max_queue_size_)) {
+                    // CP2: Check if queue is full; a tenant below its weighted share of the queue
+                    // takes the least urgent slot of the tenant furthest above its share
+                    if (max_queue_size_ > 0 && pending_requests_.size() >= static_cast<size_t>(max_queue_size_) &&
+                        !pending_requests_.shed_for(tenant_id, [this](const std::string& shed_tenant, auto& entry) {
+                            shed_request(shed_tenant, entry.value);
+                        })) {
                         // Queue is full - reject request
                         observability_->log_warn("Queue full - rejecting request", 
                             request.inputs.count("tenant_id") ? request.inputs.at("tenant_id") : "",
@@ -169,6 +240,7 @@ pool_actor::behavior_type PoolActorState::make_behavior() {
                         
                         // CP2: Update queue metrics
                         update_queue_metrics();
+                        step_span.set_error("Queue full");
                         
                         // Return rejection (would need to send ExecAssignmentAck with rejected status)
                         // For now, log and return
@@ -176,23 +248,40 @@ pool_actor::behavior_type PoolActorState::make_behavior() {
                     }
                 }
                 
-                // Queue the request
-                pending_requests_.push({caf::actor_cast<caf::actor_addr>(self_->current_sender()), request});
+                // Queue the request under its tenant: priority class first, then earliest deadline
+                auto now = std::chrono::steady_clock::now();
+                auto deadline = request.timeout_ms > 0
+                    ? now + std::chrono::milliseconds(request.timeout_ms)
+                    : std::chrono::steady_clock::time_point::max();
+                auto priority = request.inputs.find("priority");
+                auto step_id = request.inputs.find("step_id");
+                pending_requests_.push(tenant_id,
+                                       {caf::actor_cast<caf::actor_addr>(self_->current_sender()), request,
+                                        std::move(step_span)},
+                                       priority != request.inputs.end()
+                                           ? parse_step_priority(priority->second).value_or(StepPriority::normal)
+                                           : StepPriority::normal,
+                                       deadline, now,
+                                       step_id != request.inputs.end() ? step_id->second : std::string());
                 
                 // CP2: Update queue metrics
                 update_queue_metrics();
+                update_tenant_queue_metrics(tenant_id);
                 return;
             }
             
             // Execute immediately
             current_load_++;
             
-            observability_->log_info("Step execution started", "", "", "", request.type, "", {
-                {"resource_class", resource_class_ == ResourceClass::cpu ? "cpu" : 
-                                  resource_class_ == ResourceClass::gpu ? "gpu" : "io"}
-            });
+            if (Observability::is_log_enabled(LogLevel::info)) {
+                observability_->log_info("Step execution started", "", "", "", request.type, "", {
+                    {"resource_class", resource_class_ == ResourceClass::cpu ? "cpu" : 
+                                      resource_class_ == ResourceClass::gpu ? "gpu" : "io"}
+                });
+            }
             
-            execute_step(request, caf::actor_cast<caf::actor_addr>(self_->current_sender()));
+            execute_step(request, caf::actor_cast<caf::actor_addr>(self_->current_sender()), std::move(step_span),
+                         std::chrono::steady_clock::now());
             
             // CP2: Update active tasks metric
             update_queue_metrics();
@@ -203,65 +292,174 @@ pool_actor::behavior_type PoolActorState::make_behavior() {
                 return;
             }
             
-            // Cancel specific step by removing from pending queue and stopping execution
-            // Remove from pending queue
-            std::queue<std::pair<caf::actor_addr, StepRequest>> new_queue;
-            while (!pending_requests_.empty()) {
-                auto [requester, req] = pending_requests_.front();
-                pending_requests_.pop();
-                if (req.inputs.count("step_id") && req.inputs.at("step_id") != step_id) {
-                    new_queue.push({requester, req});
+            // Queued: dropped through the pending queue's step_id index, O(1) per request.
+            // Requests without a step_id input are never matched.
+            size_t dequeued = 0;
+            if (!step_id.empty()) {
+                std::vector<std::string> tenants;
+                dequeued = pending_requests_.erase(step_id, [this, &tenants](const std::string& tenant_id, auto& entry) {
+                    tenants.push_back(tenant_id);
+                    const auto& request = entry.value.request;
+                    auto input = [&request](const char* name) {
+                        auto it = request.inputs.find(name);
+                        return it != request.inputs.end() ? it->second : std::string();
+                    };
+                    observability_->record_step_execution(request.type, "cancelled", input("tenant_id"),
+                                                          input("run_id"), input("flow_id"), input("step_id"));
+                    entry.value.step_span.set_error("Cancelled while queued");
+                });
+                for (const auto& tenant_id : tenants) {
+                    update_tenant_queue_metrics(tenant_id);
+                }
+            }
+            
+            // Dispatched: the executor running it stops retrying and reports the step cancelled
+            bool in_flight = false;
+            auto running_id = running_step_ids_.find(step_id);
+            if (running_id != running_step_ids_.end()) {
+                auto running = running_steps_.find(running_id->second);
+                if (running != running_steps_.end()) {
+                    caf::anon_send(running->second.executor, cancel_atom, step_id);
+                    in_flight = true;
                 }
             }
-            pending_requests_ = std::move(new_queue);
             
-            observability_->log_info("Step cancellation requested", "", "", "", step_id);
+            if (dequeued > 0) {
+                update_queue_metrics();
+            }
+            observability_->log_info("Step cancellation requested", "", "", "", step_id, "", {
+                {"resource_class", resource_pool_name(resource_class_)},
+                {"dequeued", std::to_string(dequeued)},
+                {"in_flight", in_flight ? "true" : "false"}
+            });
         },
         
         [this](caf::atom_value atom) {
             if (atom == caf::atom("metrics")) {
-                // Return pool metrics
-                std::cout << "Pool metrics: load=" << current_load_ 
-                                    << ", pending=" << pending_requests_.size() << std::endl;
-                
-                // CP2: Update metrics if feature flag enabled
+                // Publish pool load: queue depth and active tasks, then pooled executors
                 if (FeatureFlags::is_observability_metrics_enabled()) {
                     update_queue_metrics();
+                    size_t idle_executors = 0;
+                    for (const auto& entry : idle_executors_) {
+                        idle_executors += entry.second.size();
+                    }
+                    int live_executors = 0;
+                    for (const auto& entry : live_executors_) {
+                        live_executors += entry.second;
+                    }
+                    observability_->set_executor_counts(resource_pool_name(resource_class_), live_executors,
+                                                        static_cast<int64_t>(idle_executors));
                 }
-            } else if (atom == caf::atom("done")) {
-                if (current_load_ > 0) {
-                    current_load_--;
+            } else if (atom == caf::atom("throttle")) {
+                // Resume tenants whose usage has aged back within their quota
+                throttle_check_scheduled_ = false;
+                for (const auto& tenant_id : pending_requests_.throttled_tenants()) {
+                    if (!TenantLedger::instance().over_quota(tenant_id)) {
+                        pending_requests_.set_throttled(tenant_id, false);
+                        observability_->set_tenant_throttled(resource_pool_name(resource_class_), tenant_id, false);
+                        observability_->log_info("Tenant back within quota - resuming", tenant_id, "", "", "", "", {
+                            {"resource_class", resource_pool_name(resource_class_)},
+                            {"tenant_queue_depth", std::to_string(pending_requests_.size(tenant_id))}
+                        });
+                    }
+                }
+                if (!pending_requests_.throttled_tenants().empty()) {
+                    schedule_throttle_check();
                 }
-                
-                // CP2: Update active tasks metric
-                update_queue_metrics();
-                
-                // Process next pending request if any
                 process_pending();
+            } else if (atom == caf::atom("evict")) {
+                evict_idle_executors();
+                caf::delayed_anon_send(caf::actor_cast<caf::actor>(self_),
+                                       std::max(executor_idle_timeout_ / 2, std::chrono::milliseconds(100)),
+                                       caf::atom("evict"));
+            } else if (atom == caf::atom("shutdown")) {
+                // Retire the executors with the pool; queued steps are dropped
+                shutdown_executors();
+                self_->quit();
             }
+        },
+        
+        [this](caf::atom_value done_atom, const std::string& block_type, caf::actor executor) {
+            if (done_atom != caf::atom("done")) {
+                return;
+            }
+            
+            if (current_load_ > 0) {
+                current_load_--;
+            }
+            
+            // Queue wait as a share of the step's time in the pool; ends the step's span.
+            // The executor time it took is charged to its tenant's fair share.
+            auto running = running_steps_.find(executor.address());
+            if (running != running_steps_.end()) {
+                auto& step = running->second;
+                auto now = std::chrono::steady_clock::now();
+                double wait = std::chrono::duration<double>(step.dispatched_at - step.enqueued_at).count();
+                double total = std::chrono::duration<double>(now - step.enqueued_at).count();
+                observability_->record_queue_time(resource_pool_name(resource_class_), wait,
+                                                  total > 0 ? wait / total : 0.0);
+                double used_ms = std::chrono::duration<double, std::milli>(now - step.dispatched_at).count();
+                pending_requests_.charge(step.tenant_id, step.estimated_cost_ms, used_ms);
+                observability_->add_tenant_usage(resource_pool_name(resource_class_), step.tenant_id, used_ms);
+                // The executor recorded the step's CPU time and heap use before reporting done
+                throttle_if_over_quota(step.tenant_id);
+                auto running_id = running_step_ids_.find(step.step_id);
+                if (running_id != running_step_ids_.end() && running_id->second == running->first) {
+                    running_step_ids_.erase(running_id);
+                }
+                running_steps_.erase(running);
+            }
+            
+            // Return the executor actor to the warm pool
+            release_executor(block_type, std::move(executor));
+            
+            // CP2: Update active tasks metric
+            update_queue_metrics();
+            
+            // Process next pending request if any
+            process_pending();
         }
     };
 }
 
 void PoolActorState::process_pending() {
-    while (current_load_ < max_concurrency_ && !pending_requests_.empty()) {
-        auto request_pair = pending_requests_.front();
-        pending_requests_.pop();
+    while (current_load_ < max_concurrency_ && pending_requests_.has_ready()) {
+        std::string tenant_id;
+        double estimated_cost_ms = 0;
+        auto entry = pending_requests_.pop(tenant_id, estimated_cost_ms);
+        auto& pending = entry.value;
+        const StepRequest& request = pending.request;
+        auto now = std::chrono::steady_clock::now();
         
-        caf::actor_addr requester = request_pair.first;
-        StepRequest request = request_pair.second;
+        if (pending.step_span) {
+            Tracer::instance().start_span("pool.queue_wait", pending.step_span.context(),
+                                          Tracer::SpanKind::internal, entry.enqueued_at).end();
+        }
+        observability_->record_tenant_queue_wait(resource_pool_name(resource_class_), tenant_id,
+                                                 std::chrono::duration<double>(now - entry.enqueued_at).count());
+        update_tenant_queue_metrics(tenant_id);
+        
+        // Its deadline passed while queued: running it could only time out
+        if (now >= entry.deadline) {
+            pending_requests_.refund(tenant_id, estimated_cost_ms);
+            expire_request(pending, entry.enqueued_at);
+            update_queue_metrics();
+            continue;
+        }
         
         current_load_++;
         
         // Log processing start
-        observability_->log_info("Processing queued request", "", "", "", request.type, "", {
-            {"resource_class", resource_class_ == ResourceClass::cpu ? "cpu" : 
-                              resource_class_ == ResourceClass::gpu ? "gpu" : "io"},
-            {"queue_depth", std::to_string(pending_requests_.size())}
-        });
+        if (Observability::is_log_enabled(LogLevel::info)) {
+            observability_->log_info("Processing queued request", "", "", "", request.type, "", {
+                {"resource_class", resource_class_ == ResourceClass::cpu ? "cpu" : 
+                                  resource_class_ == ResourceClass::gpu ? "gpu" : "io"},
+                {"queue_depth", std::to_string(pending_requests_.size())}
+            });
+        }
         
         // Execute the queued request
-        execute_step(request, requester);
+        execute_step(request, pending.requester, std::move(pending.step_span), entry.enqueued_at, estimated_cost_ms);
         
         // CP2: Update queue metrics after processing
         update_queue_metrics();
@@ -297,40 +495,274 @@ void PoolActorState::update_queue_metrics() {
     observability_->set_active_tasks(resource_pool, static_cast<int64_t>(current_load_));
 }
 
+bool PoolActorState::throttle_if_over_quota(const std::string& tenant_id) {
+    if (tenant_id.empty()) {
+        return false; // Untagged steps are not accounted to any tenant
+    }
+    if (pending_requests_.throttled(tenant_id)) {
+        return true;
+    }
+    auto quota = TenantLedger::instance().quota_state(tenant_id);
+    if (quota == TenantLedger::QuotaState::within) {
+        return false;
+    }
+    
+    pending_requests_.set_throttled(tenant_id, true);
+    observability_->set_tenant_throttled(resource_pool_name(resource_class_), tenant_id, true);
+    observability_->log_warn("Tenant over quota - throttling", tenant_id, "", "", "", "", {
+        {"resource_class", resource_pool_name(resource_class_)},
+        {"reason", quota == TenantLedger::QuotaState::cpu_time_exceeded ? "cpu_time" : "memory"},
+        {"tenant_queue_depth", std::to_string(pending_requests_.size(tenant_id))}
+    });
+    if (!throttle_check_scheduled_) {
+        schedule_throttle_check();
+    }
+    return true;
+}
+
+void PoolActorState::schedule_throttle_check() {
+    throttle_check_scheduled_ = true;
+    caf::delayed_anon_send(caf::actor_cast<caf::actor>(self_), THROTTLE_CHECK_INTERVAL, caf::atom("throttle"));
+}
+
+void PoolActorState::update_tenant_queue_metrics(const std::string& tenant_id) {
+    observability_->set_tenant_queue_depth(resource_pool_name(resource_class_), tenant_id,
+                                           static_cast<int64_t>(pending_requests_.size(tenant_id)));
+}
+
 std::shared_ptr<BlockExecutor> PoolActorState::create_block_executor(const std::string& type) {
+#ifdef BEAMLINE_WITH_CURL
     if (type == "http.request") {
         return std::make_shared<HttpBlockExecutor>();
-    } else if (type == "fs.blob_put") {
+    }
+#endif
+    if (type == "fs.blob_put") {
         return std::make_shared<FsBlockExecutor>();
     } else if (type == "fs.blob_get") {
         return std::make_shared<FsGetBlockExecutor>();
     }
+    {
+        std::lock_guard<std::mutex> lock(block_registry_mutex());
+        auto registered = block_registry().find(type);
+        if (registered != block_registry().end()) {
+            return registered->second();
+        }
+    }
     // Default fallback or error
     // For now returning nullptr which will be checked
     return nullptr;
 }
 
-void PoolActorState::execute_step(const StepRequest& request, caf::actor_addr /*requester*/) {
-    auto executor = create_block_executor(request.type);
+caf::actor PoolActorState::acquire_executor(const std::string& type, const SpanContext& trace_parent) {
+    auto& idle = idle_executors_[type];
+    if (!idle.empty()) {
+        // LIFO: reuse the most recently released executor so cold ones age out
+        auto handle = std::move(idle.back().handle);
+        idle.pop_back();
+        return handle;
+    }
+    
+    auto executor = create_block_executor(type);
     if (!executor) {
+        return caf::actor{};
+    }
+    
+    // Cold start on the step's critical path
+    Span spawn_span;
+    if (trace_parent.valid()) {
+        spawn_span = Tracer::instance().start_span("executor.spawn", trace_parent);
+        spawn_span.set_attribute("block.type", type);
+    }
+    live_executors_[type]++;
+    return caf::actor_cast<caf::actor>(system_.spawn<ExecutorActorImpl>(executor));
+}
+
+void PoolActorState::release_executor(const std::string& type, caf::actor executor) {
+    auto& live = live_executors_[type];
+    if (!executor_pooling_ || live > executor_pool_max_) {
+        // Pool shrank or overshot: retire instead of keeping it warm
+        caf::anon_send(executor, caf::atom("shutdown"));
+        live--;
+        return;
+    }
+    idle_executors_[type].push_back({std::move(executor), std::chrono::steady_clock::now()});
+}
+
+void PoolActorState::prewarm_executors() {
+    std::vector<std::string> types = POOLED_BLOCK_TYPES;
+    {
+        std::lock_guard<std::mutex> lock(block_registry_mutex());
+        for (const auto& entry : block_registry()) {
+            types.push_back(entry.first);
+        }
+    }
+    for (const auto& type : types) {
+        auto& idle = idle_executors_[type];
+        while (live_executors_[type] < executor_pool_min_) {
+            auto executor = create_block_executor(type);
+            if (!executor) {
+                break;
+            }
+            idle.push_back({caf::actor_cast<caf::actor>(system_.spawn<ExecutorActorImpl>(executor)),
+                            std::chrono::steady_clock::now()});
+            live_executors_[type]++;
+        }
+    }
+}
+
+void PoolActorState::evict_idle_executors() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& [type, idle] : idle_executors_) {
+        auto& live = live_executors_[type];
+        // Oldest idle executors sit at the front (LIFO reuse from the back)
+        size_t evicted = 0;
+        while (evicted < idle.size() && live > executor_pool_min_ &&
+               now - idle[evicted].idle_since >= executor_idle_timeout_) {
+            caf::anon_send(idle[evicted].handle, caf::atom("shutdown"));
+            live--;
+            evicted++;
+        }
+        if (evicted > 0) {
+            idle.erase(idle.begin(), idle.begin() + static_cast<std::ptrdiff_t>(evicted));
+        }
+    }
+}
+
+void PoolActorState::shutdown_executors() {
+    for (auto& [type, idle] : idle_executors_) {
+        for (auto& executor : idle) {
+            caf::anon_send(executor.handle, caf::atom("shutdown"));
+        }
+        live_executors_[type] -= static_cast<int>(idle.size());
+    }
+    idle_executors_.clear();
+    // Busy executors finish their step first; its "done" goes nowhere
+    for (auto& [address, step] : running_steps_) {
+        caf::anon_send(step.executor, caf::atom("shutdown"));
+    }
+    running_steps_.clear();
+    running_step_ids_.clear();
+}
+
+Span PoolActorState::start_step_span(const StepRequest& request) {
+    auto& tracer = Tracer::instance();
+    if (!tracer.enabled()) {
+        return Span();
+    }
+    
+    // Continue the caller's trace when the request carries a W3C traceparent
+    SpanContext parent;
+    auto traceparent = request.inputs.find("traceparent");
+    if (traceparent != request.inputs.end()) {
+        parent = SpanContext::from_traceparent(traceparent->second);
+    }
+    auto span = tracer.start_span("step", parent);
+    span.set_attribute("step.type", request.type);
+    auto step_id = request.inputs.find("step_id");
+    if (step_id != request.inputs.end()) {
+        span.set_attribute("step.id", step_id->second);
+    }
+    return span;
+}
+
+void PoolActorState::expire_request(PendingRequest& pending, std::chrono::steady_clock::time_point enqueued_at) {
+    const auto& request = pending.request;
+    auto input = [&request](const char* name) {
+        auto it = request.inputs.find(name);
+        return it != request.inputs.end() ? it->second : std::string();
+    };
+    auto waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - enqueued_at).count();
+    
+    // The requester gets no reply on this path yet (see execute_step), so the timeout
+    // result is reported through metrics, the log and the step's span
+    ResultMetadata metadata;
+    metadata.tenant_id = input("tenant_id");
+    metadata.run_id = input("run_id");
+    metadata.flow_id = input("flow_id");
+    metadata.step_id = input("step_id");
+    auto result = StepResult::timeout_result(metadata, waited_ms);
+    result.error_message = "Deadline expired in pending queue";
+    
+    observability_->log_warn("Dropping expired queued request", metadata.tenant_id, metadata.run_id,
+                             metadata.flow_id, metadata.step_id, "", {
+        {"resource_class", resource_pool_name(resource_class_)},
+        {"block_type", request.type},
+        {"timeout_ms", std::to_string(request.timeout_ms)},
+        {"queued_ms", std::to_string(waited_ms)},
+        {"reason", "deadline_expired"}
+    });
+    observability_->record_step_execution(request.type, "timeout", metadata.tenant_id, metadata.run_id,
+                                          metadata.flow_id, metadata.step_id);
+    observability_->record_step_execution_duration(request.type, "timeout", static_cast<double>(waited_ms) / 1000.0,
+                                                   metadata.tenant_id, metadata.run_id, metadata.flow_id,
+                                                   metadata.step_id);
+    observability_->record_queue_time(resource_pool_name(resource_class_), static_cast<double>(waited_ms) / 1000.0, 1.0);
+    pending.step_span.set_error(result.error_message);
+    pending.step_span.end();
+}
+
+void PoolActorState::shed_request(const std::string& tenant_id, PendingRequest& pending) {
+    const auto& request = pending.request;
+    auto input = [&request](const char* name) {
+        auto it = request.inputs.find(name);
+        return it != request.inputs.end() ? it->second : std::string();
+    };
+    
+    observability_->log_warn("Queue full - shedding request of tenant over its share", tenant_id, input("run_id"),
+                             input("flow_id"), input("step_id"), "", {
+        {"resource_class", resource_pool_name(resource_class_)},
+        {"block_type", request.type},
+        {"tenant_queue_depth", std::to_string(pending_requests_.size(tenant_id))},
+        {"max_queue_size", std::to_string(max_queue_size_)},
+        {"reason", "queue_full"}
+    });
+    pending.step_span.set_error("Shed from full queue");
+    update_tenant_queue_metrics(tenant_id);
+}
+
+void PoolActorState::execute_step(const StepRequest& request, caf::actor_addr /*requester*/, Span step_span,
+                                  std::chrono::steady_clock::time_point enqueued_at, double estimated_cost_ms) {
+    auto executor_actor = acquire_executor(request.type, step_span.context());
+    if (!executor_actor) {
+        step_span.set_error("Unknown block type");
         observability_->log_error("Unknown block type", request.type);
         // In a real system we should notify the requester of the error
         // For now, we just drop it and ensure we don't leak load count
+        auto tenant = request.inputs.find("tenant_id");
+        pending_requests_.refund(tenant != request.inputs.end() ? tenant->second : std::string(), estimated_cost_ms);
         current_load_--;
         process_pending();
         return;
     }
     
-    // Create executor actor
-    // Note: In a production system we might want to pool these actors too
-    // instead of spawning one per request.
-    auto executor_actor = system_.spawn<ExecutorActorImpl>(executor);
-    
     // Send execute request
     // We use anon_send here but include the pool actor (self) as an argument
     // so the executor knows who to reply to.
     // Casting self_ to caf::actor handle ensures compatibility with executor interface.
-    caf::anon_send(executor_actor, caf::atom("execute"), request, caf::actor_cast<caf::actor>(self_));
+    auto& running = running_steps_[executor_actor.address()];
+    running.executor = executor_actor;
+    auto tenant = request.inputs.find("tenant_id");
+    running.tenant_id = tenant != request.inputs.end() ? tenant->second : std::string();
+    running.estimated_cost_ms = estimated_cost_ms;
+    running.enqueued_at = enqueued_at;
+    running.dispatched_at = std::chrono::steady_clock::now();
+    auto step_id = request.inputs.find("step_id");
+    if (step_id != request.inputs.end() && !step_id->second.empty()) {
+        running.step_id = step_id->second;
+        running_step_ids_[running.step_id] = executor_actor.address();
+    }
+    if (!step_span) {
+        caf::anon_send(executor_actor, caf::atom("execute"), request, caf::actor_cast<caf::actor>(self_));
+        return;
+    }
+    
+    // The executor's attempt spans join the trace as children of the step's span,
+    // which stays open until the executor reports "done"
+    StepRequest traced = request;
+    traced.inputs["traceparent"] = step_span.context().traceparent();
+    running.step_span = std::move(step_span);
+    caf::anon_send(executor_actor, caf::atom("execute"), std::move(traced), caf::actor_cast<caf::actor>(self_));
 }
 
 // Executor Actor Implementation
@@ -350,22 +782,32 @@ executor_actor::behavior_type ExecutorActorState::make_behavior() {
                 return;
             }
             
-            auto result = execute_with_retry(request);
-            if (result) {
-                std::cout << "Step completed successfully" << std::endl;
-                
-                // CP2: Record metrics
-                double duration_seconds = static_cast<double>(result->latency_ms) / 1000.0;
-                record_step_metrics(request, *result, duration_seconds);
-            } else {
-                std::cout << "Step failed: " << std::to_string(result.error().code()) << std::endl;
+            start_step(request, std::move(pool));
+        },
+        
+        [this](caf::atom_value retry_atom, uint64_t token) {
+            if (retry_atom != caf::atom("retry")) {
+                return;
             }
             
-            // Notify pool that we are done
-            caf::anon_send(pool, caf::atom("done"));
+            // Backoff elapsed - run the next attempt
+            run_attempt(token);
+        },
+        
+        [this](caf::atom_value attempt_atom, uint64_t token, StepResult result) {
+            if (attempt_atom != caf::atom("attempt")) {
+                return;
+            }
             
-            // Executor is one-shot, so we quit
-            self_->quit();
+            auto it = retries_.find(token);
+            if (it == retries_.end()) {
+                return; // Step already completed (e.g. cancelled while its transfer ran)
+            }
+            result.latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - it->second.attempt_started_at).count();
+            // The block's completion ran on an I/O thread; its metrics are updated here
+            executor_->record_async_result(result);
+            on_attempt_result(token, std::move(result));
         },
         
         
@@ -382,9 +824,37 @@ executor_actor::behavior_type ExecutorActorState::make_behavior() {
                 // caf::aout(caf::self) << "Failed to cancel step: " << result.error() << std::endl;
                 observability_->log_error("Failed to cancel step", std::to_string(result.error().code()), step_id);
             }
+            
+            // Complete the step now: a pending retry or a late async attempt result is ignored
+            std::vector<uint64_t> cancelled;
+            for (const auto& [token, state] : retries_) {
+                auto id = state.request.inputs.find("step_id");
+                if (id != state.request.inputs.end() && id->second == step_id) {
+                    cancelled.push_back(token);
+                }
+            }
+            for (auto token : cancelled) {
+                auto& state = retries_.at(token);
+                if (state.attempt_span) {
+                    state.attempt_span.set_error("Cancelled");
+                }
+                ResultMetadata metadata = state.last_result.metadata;
+                metadata.step_id = step_id;
+                auto cancelled_result = StepResult::cancelled_result(metadata,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - state.started_at).count());
+                cancelled_result.retries_used = state.attempt;
+                cancelled_result.error_message = "Cancelled while running";
+                complete_step(token, cancelled_result);
+            }
         },
         
         [this](caf::atom_value metrics_atom) {
+            if (metrics_atom == caf::atom("shutdown")) {
+                // Evicted from the pool
+                self_->quit();
+                return;
+            }
             if (metrics_atom != caf::atom("metrics")) {
                 return;
             }
@@ -402,94 +872,211 @@ executor_actor::behavior_type ExecutorActorState::make_behavior() {
     };
 }
 
-caf::expected<StepResult> ExecutorActorState::execute_with_retry(const StepRequest& req) {
+void ExecutorActorState::start_step(const StepRequest& req, caf::actor pool) {
     // Initialize retry policy
     RetryPolicy::Config retry_config;
     retry_config.base_delay_ms = 100;
     retry_config.max_delay_ms = 5000;
     retry_config.total_timeout_ms = req.timeout_ms; // Use request timeout as total timeout
     retry_config.max_retries = req.retry_count;
-    RetryPolicy retry_policy(retry_config);
     
-    auto total_start_time = std::chrono::steady_clock::now();
-    StepResult final_result;
-    int http_status_code = 0; // Extract from result if available
+    // Parent for this step's attempt spans, set by the pool when tracing is on
+    SpanContext trace_parent;
+    auto traceparent = req.inputs.find("traceparent");
+    if (traceparent != req.inputs.end()) {
+        trace_parent = SpanContext::from_traceparent(traceparent->second, false);
+    }
     
-    for (int attempt = 0; attempt <= retry_policy.max_retries(); attempt++) {
-        // Check retry budget before attempting
-        auto current_time = std::chrono::steady_clock::now();
-        auto total_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            current_time - total_start_time).count();
-        
-        if (retry_policy.is_budget_exhausted(total_elapsed_ms, attempt)) {
-            // Budget exhausted - return timeout result
-            final_result.retries_used = attempt;
-            final_result.status = StepStatus::timeout;
-            final_result.error_code = ErrorCode::cancelled_by_timeout;
-            final_result.error_message = "Retry budget exhausted: total timeout exceeded";
-            return final_result;
+    auto token = next_retry_token_++;
+    retries_.emplace(token, RetryState{req, std::move(pool), RetryPolicy(retry_config),
+                                       std::chrono::steady_clock::now(), {}, 0, StepResult{},
+                                       trace_parent, Span(), {}});
+    run_attempt(token);
+}
+
+void ExecutorActorState::run_attempt(uint64_t token) {
+    auto it = retries_.find(token);
+    if (it == retries_.end()) {
+        return; // Step already completed
+    }
+    auto& state = it->second;
+    const auto& req = state.request;
+    const auto& retry_policy = state.policy;
+    
+    // Check retry budget before attempting
+    auto total_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - state.started_at).count();
+    
+    if (retry_policy.is_budget_exhausted(total_elapsed_ms, state.attempt)) {
+        // Budget exhausted - return timeout result
+        StepResult timeout_result = state.last_result;
+        timeout_result.retries_used = state.attempt;
+        timeout_result.status = StepStatus::timeout;
+        timeout_result.error_code = ErrorCode::cancelled_by_timeout;
+        timeout_result.error_message = "Retry budget exhausted: total timeout exceeded";
+        complete_step(token, timeout_result);
+        return;
+    }
+    
+    if (state.trace_parent.valid()) {
+        state.attempt_span = Tracer::instance().start_span("step.attempt", state.trace_parent);
+        state.attempt_span.set_attribute("retry.attempt", int64_t{state.attempt});
+    }
+    // Backend spans the block starts (HTTP request, fs I/O, SQL query) are children of the attempt
+    Tracer::Scope trace_scope(state.attempt_span.context());
+    
+    // CPU time and heap use of the attempt on this thread, charged to the step's tenant
+    ResourceMeter meter;
+    if (executor_->supports_async()) {
+        // I/O engine completes the attempt; hop back onto this actor via a message.
+        // Only issuing the request is metered: the I/O engine's threads are shared.
+        state.attempt_started_at = std::chrono::steady_clock::now();
+        auto self_handle = caf::actor_cast<caf::actor>(self_);
+        executor_->execute_async(req, BlockContext{}, [self_handle, token](caf::expected<StepResult> result) {
+            StepResult attempt_result = result ? std::move(*result)
+                : StepResult::error_result(ErrorCode::execution_failed,
+                                           "Execution failed: " + std::to_string(result.error().code()),
+                                           ResultMetadata{});
+            caf::anon_send(self_handle, caf::atom("attempt"), token, std::move(attempt_result));
+        });
+        add_attempt_usage(state, meter.elapsed());
+        return;
+    }
+    
+    auto result = execute_single_attempt(req);
+    add_attempt_usage(state, meter.elapsed());
+    on_attempt_result(token, std::move(result));
+}
+
+void ExecutorActorState::add_attempt_usage(RetryState& state, const ResourceMeter::Usage& usage) {
+    state.usage.cpu_time_ns += usage.cpu_time_ns;
+    state.usage.allocated_bytes += usage.allocated_bytes;
+    state.usage.peak_heap_bytes = std::max(state.usage.peak_heap_bytes, usage.peak_heap_bytes);
+}
+
+void ExecutorActorState::on_attempt_result(uint64_t token, caf::expected<StepResult> result) {
+    auto it = retries_.find(token);
+    if (it == retries_.end()) {
+        return; // Step already completed
+    }
+    auto& state = it->second;
+    const auto& req = state.request;
+    const auto& retry_policy = state.policy;
+    
+    if (state.attempt_span) {
+        if (!result) {
+            state.attempt_span.set_error("Execution failed: " + std::to_string(result.error().code()));
+        } else if (result->status != StepStatus::ok) {
+            state.attempt_span.set_error(result->error_message);
         }
+        state.attempt_span.end();
+    }
+    
+    int http_status_code = 0; // Extract from result if available
+    if (result) {
+        state.last_result = *result;
+        state.last_result.retries_used = state.attempt;
         
-        auto result = execute_single_attempt(req);
-        if (result) {
-            final_result = *result;
-            final_result.retries_used = attempt;
-            
-            // Extract HTTP status code if available (for error classification)
-            if (req.type == "http.request" && result->outputs.count("status_code")) {
-                try {
-                    http_status_code = std::stoi(result->outputs.at("status_code"));
-                } catch (...) {
-                    http_status_code = 0;
-                }
-            }
-            
-            if (final_result.status == StepStatus::ok) {
-                return final_result;
-            }
-            
-            // Check if error is retryable
-            if (!retry_policy.is_retryable(final_result.error_code, http_status_code)) {
-                // Non-retryable error - return immediately
-                return final_result;
-            }
-        } else {
-            // Execution failed - check if retryable
-            // For now, assume network/system errors are retryable
-            if (!retry_policy.is_retryable(ErrorCode::network_error, 0)) {
-                // Non-retryable - return error
-                final_result.status = StepStatus::error;
-                final_result.error_code = ErrorCode::execution_failed;
-                final_result.error_message = "Execution failed and error is non-retryable";
-                final_result.retries_used = attempt;
-                return final_result;
+        // Extract HTTP status code if available (for error classification)
+        if (req.type == "http.request" && result->outputs.count("status_code")) {
+            try {
+                http_status_code = std::stoi(result->outputs.at("status_code"));
+            } catch (...) {
+                http_status_code = 0;
             }
         }
         
-        // If not the last attempt, wait before retry with exponential backoff
-        if (attempt < retry_policy.max_retries()) {
-            int64_t backoff_delay = retry_policy.calculate_backoff_delay(attempt);
-            
-            // Check if backoff would exceed budget
-            auto time_after_backoff = std::chrono::steady_clock::now() + 
-                std::chrono::milliseconds(backoff_delay);
-            auto total_after_backoff_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                time_after_backoff - total_start_time).count();
-            
-            if (total_after_backoff_ms >= retry_config.total_timeout_ms) {
-                // Backoff would exceed budget - return timeout
-                final_result.retries_used = attempt;
-                final_result.status = StepStatus::timeout;
-                final_result.error_code = ErrorCode::cancelled_by_timeout;
-                final_result.error_message = "Retry budget exhausted: backoff delay would exceed total timeout";
-                return final_result;
-            }
-            
-            std::this_thread::sleep_for(std::chrono::milliseconds(backoff_delay));
+        if (state.last_result.status == StepStatus::ok) {
+            complete_step(token, state.last_result);
+            return;
+        }
+        
+        // Check if error is retryable
+        if (!retry_policy.is_retryable(state.last_result.error_code, http_status_code)) {
+            // Non-retryable error - return immediately
+            complete_step(token, state.last_result);
+            return;
         }
+    } else {
+        // Execution failed - check if retryable
+        // For now, assume network/system errors are retryable
+        state.last_result = StepResult::error_result(
+            ErrorCode::execution_failed,
+            "Execution failed: " + std::to_string(result.error().code()),
+            ResultMetadata{});
+        state.last_result.retries_used = state.attempt;
+        if (!retry_policy.is_retryable(ErrorCode::network_error, 0)) {
+            // Non-retryable - return error
+            state.last_result.error_message = "Execution failed and error is non-retryable";
+            complete_step(token, state.last_result);
+            return;
+        }
+    }
+    
+    if (state.attempt >= retry_policy.max_retries()) {
+        // Attempts exhausted - return last result
+        complete_step(token, state.last_result);
+        return;
+    }
+    
+    // Schedule next attempt with exponential backoff
+    int64_t backoff_delay = retry_policy.calculate_backoff_delay(state.attempt);
+    
+    // Check if backoff would exceed budget
+    auto total_after_backoff_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - state.started_at).count() + backoff_delay;
+    
+    if (total_after_backoff_ms >= retry_policy.total_timeout_ms()) {
+        // Backoff would exceed budget - return timeout
+        StepResult timeout_result = state.last_result;
+        timeout_result.status = StepStatus::timeout;
+        timeout_result.error_code = ErrorCode::cancelled_by_timeout;
+        timeout_result.error_message = "Retry budget exhausted: backoff delay would exceed total timeout";
+        complete_step(token, timeout_result);
+        return;
+    }
+    
+    // Non-blocking backoff: the actor keeps serving other messages meanwhile
+    state.attempt++;
+    caf::delayed_anon_send(caf::actor_cast<caf::actor>(self_), std::chrono::milliseconds(backoff_delay),
+                           caf::atom("retry"), token);
+}
+
+void ExecutorActorState::complete_step(uint64_t token, const StepResult& result) {
+    auto it = retries_.find(token);
+    if (it == retries_.end()) {
+        return;
+    }
+    auto state = std::move(it->second);
+    retries_.erase(it);
+    
+    if (Observability::is_log_enabled(LogLevel::debug)) {
+        observability_->log_debug(result.status == StepStatus::ok ? "Step completed" : "Step failed",
+                                  result.metadata.tenant_id, result.metadata.run_id, result.metadata.flow_id,
+                                  result.metadata.step_id, "", {
+            {"block_type", state.request.type},
+            {"error_code", ResultConverter::error_code_to_string(result.error_code)},
+            {"retries_used", std::to_string(result.retries_used)}
+        });
+    }
+    
+    // CP2: Record metrics
+    double duration_seconds = static_cast<double>(result.latency_ms) / 1000.0;
+    record_step_metrics(state.request, result, duration_seconds);
+    
+    // Measured usage counts against the tenant's quotas, whatever the outcome
+    observability_->record_resource_usage(state.request.type, state.usage.cpu_time_ns / 1000000,
+                                          state.usage.peak_heap_bytes);
+    auto tenant = state.request.inputs.find("tenant_id");
+    if (tenant != state.request.inputs.end() && !tenant->second.empty()) {
+        TenantLedger::instance().record(tenant->second, state.usage.cpu_time_ns, state.usage.allocated_bytes,
+                                        state.usage.peak_heap_bytes);
+        observability_->add_tenant_resource_usage(tenant->second, state.usage.cpu_time_ns,
+                                                  state.usage.allocated_bytes);
     }
     
-    return final_result;
+    // Notify pool that we are done; the pool keeps this actor warm for the next step
+    caf::anon_send(state.pool, caf::atom("done"), state.request.type, caf::actor_cast<caf::actor>(self_));
 }
 
 caf::expected<StepResult> ExecutorActorState::execute_single_attempt(const StepRequest& req) {
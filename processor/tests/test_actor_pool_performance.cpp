@@ -0,0 +1,241 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "runtime/actor_pools.hpp"
+
+using namespace worker;
+
+// The previous ActorPool: one mutex and condition variable around a std::queue<std::function>
+class MutexPool {
+public:
+    explicit MutexPool(int concurrency) {
+        for (int i = 0; i < concurrency; ++i) {
+            threads_.emplace_back([this]() { run(); });
+        }
+    }
+    ~MutexPool() {
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            q_.push(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait(lk, [this] { return stop_ || !q_.empty(); });
+                if (stop_ && q_.empty()) return;
+                task = std::move(q_.front());
+                q_.pop();
+            }
+            task();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::queue<std::function<void()>> q_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+struct Tracked {
+    static inline std::atomic<int> live{0};
+    std::atomic<int>* counter;
+    explicit Tracked(std::atomic<int>* c) : counter(c) { live++; }
+    Tracked(const Tracked& other) : counter(other.counter) { live++; }
+    Tracked(Tracked&& other) noexcept : counter(other.counter) { live++; }
+    ~Tracked() { live--; }
+    void operator()() const { counter->fetch_add(1); }
+};
+
+void test_task_storage() {
+    std::cout << "Testing small-buffer task storage..." << std::endl;
+
+    std::atomic<int> calls{0};
+    {
+        Task small(Tracked{&calls});
+        Task moved(std::move(small));
+        assert(!small);
+        assert(moved);
+        moved();
+
+        // Larger than the inline buffer: stored on the heap, still move-only
+        char padding[Task::kInlineSize * 2] = {};
+        Task large([&calls, padding]() { calls.fetch_add(1 + padding[0]); });
+        Task assigned;
+        assigned = std::move(large);
+        assigned();
+        assigned = Task(Tracked{&calls});
+        assigned();
+    }
+    assert(calls.load() == 3);
+    assert(Tracked::live.load() == 0);
+
+    std::cout << "✓ Task storage test passed" << std::endl;
+}
+
+void test_deque_stealing() {
+    std::cout << "Testing work-stealing deque..." << std::endl;
+
+    const int tasks = 100000;
+    const int thieves = 3;
+    WorkStealingDeque deque(4); // Forces growth
+    std::vector<std::atomic<int>> runs(tasks);
+    std::atomic<bool> done{false};
+    std::atomic<int> stolen{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thieves; ++i) {
+        threads.emplace_back([&]() {
+            while (!done.load()) {
+                if (Task* task = deque.steal()) {
+                    (*task)();
+                    delete task;
+                    stolen++;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < tasks; ++i) {
+        deque.push(new Task([&runs, i]() { runs[static_cast<size_t>(i)]++; }));
+        if (i % 3 == 0) {
+            if (Task* task = deque.take()) {
+                (*task)();
+                delete task;
+            }
+        }
+    }
+    while (Task* task = deque.take()) {
+        (*task)();
+        delete task;
+    }
+    done = true;
+    for (auto& t : threads) t.join();
+
+    for (auto& count : runs) {
+        assert(count.load() == 1);
+    }
+    std::cout << "  Stolen: " << stolen.load() << " of " << tasks << std::endl;
+
+    std::cout << "✓ Work-stealing deque test passed" << std::endl;
+}
+
+void test_nested_submit_and_drain() {
+    std::cout << "Testing nested submits and drain on destruction..." << std::endl;
+
+    std::atomic<int> runs{0};
+    {
+        ActorPool pool(4, 64); // Small injection queue exercises the overflow path
+        for (int i = 0; i < 1000; ++i) {
+            pool.submit([&pool, &runs]() {
+                runs++;
+                for (int j = 0; j < 10; ++j) {
+                    pool.submit([&runs]() { runs++; });
+                }
+            });
+        }
+        pool.submit([]() { throw std::runtime_error("task failure"); });
+    }
+    assert(runs.load() == 11000);
+
+    std::cout << "✓ Nested submit test passed" << std::endl;
+}
+
+void test_park_and_wake() {
+    std::cout << "Testing idle workers park and wake..." << std::endl;
+
+    ActorPool pool(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Let the workers park
+    for (int round = 0; round < 100; ++round) {
+        std::atomic<bool> ran{false};
+        pool.submit([&ran]() { ran = true; });
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!ran.load()) {
+            assert(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::yield();
+        }
+    }
+    assert(pool.queue_depth() == 0);
+
+    std::cout << "✓ Park and wake test passed" << std::endl;
+}
+
+template <class Pool>
+static double run_contention(int submitters, int workers, int total_tasks) {
+    std::atomic<int> runs{0};
+    int per_submitter = total_tasks / submitters;
+    auto start = std::chrono::steady_clock::now();
+    {
+        Pool pool(workers);
+        std::vector<std::thread> threads;
+        for (int s = 0; s < submitters; ++s) {
+            threads.emplace_back([&pool, &runs, per_submitter]() {
+                for (int i = 0; i < per_submitter; ++i) {
+                    pool.submit([&runs]() { runs.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(runs.load() == per_submitter * submitters);
+    return static_cast<double>(runs.load()) / elapsed;
+}
+
+void test_contention_scaling() {
+    std::cout << "Testing submit/run throughput from 1 to 64 threads..." << std::endl;
+
+    const int total_tasks = 128000;
+    const int workers = 4;
+    std::cout << "  threads  mutex queue (tasks/s)  lock-free (tasks/s)" << std::endl;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        double mutex_rate = run_contention<MutexPool>(threads, workers, total_tasks);
+        double lock_free_rate = run_contention<ActorPool>(threads, workers, total_tasks);
+        std::cout << "  " << std::setw(7) << threads << "  " << std::setw(21) << std::fixed << std::setprecision(0)
+                  << mutex_rate << "  " << std::setw(19) << lock_free_rate << std::endl;
+    }
+
+    std::cout << "✓ Contention scaling test completed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Actor Pool Performance Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_task_storage();
+        test_deque_stealing();
+        test_nested_submit_and_drain();
+        test_park_and_wake();
+        test_contention_scaling();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
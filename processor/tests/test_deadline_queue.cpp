@@ -0,0 +1,168 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "beamline/worker/deadline_queue.hpp"
+
+using namespace beamline::worker;
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<std::string> drain(DeadlineQueue<std::string>& queue) {
+    std::vector<std::string> order;
+    while (!queue.empty()) {
+        order.push_back(queue.pop().value);
+    }
+    return order;
+}
+
+void test_parse_priority() {
+    std::cout << "Testing priority parsing..." << std::endl;
+
+    assert(parse_step_priority("") == StepPriority::normal);
+    assert(parse_step_priority("normal") == StepPriority::normal);
+    assert(parse_step_priority("high") == StepPriority::high);
+    assert(parse_step_priority("low") == StepPriority::low);
+    assert(!parse_step_priority("urgent"));
+
+    std::cout << "✓ Priority parsing test passed" << std::endl;
+}
+
+void test_earliest_deadline_first() {
+    std::cout << "Testing earliest deadline first..." << std::endl;
+
+    auto now = Clock::now();
+    DeadlineQueue<std::string> queue;
+    queue.push("30s", StepPriority::normal, now + std::chrono::seconds(30), now);
+    queue.push("500ms", StepPriority::normal, now + std::chrono::milliseconds(500), now);
+    queue.push("5s", StepPriority::normal, now + std::chrono::seconds(5), now);
+    queue.push("no deadline", StepPriority::normal, Clock::time_point::max(), now);
+    assert(queue.size() == 4);
+    assert(queue.top().value == "500ms");
+
+    auto order = drain(queue);
+    assert((order == std::vector<std::string>{"500ms", "5s", "30s", "no deadline"}));
+
+    std::cout << "✓ Earliest deadline first test passed" << std::endl;
+}
+
+void test_priority_classes_and_fifo_ties() {
+    std::cout << "Testing priority classes and FIFO ties..." << std::endl;
+
+    auto now = Clock::now();
+    auto deadline = now + std::chrono::seconds(10);
+    DeadlineQueue<std::string> queue;
+    queue.push("low", StepPriority::low, now + std::chrono::milliseconds(1), now);
+    queue.push("normal-a", StepPriority::normal, deadline, now);
+    queue.push("high-late", StepPriority::high, now + std::chrono::hours(1), now);
+    queue.push("normal-b", StepPriority::normal, deadline, now);
+    queue.push("high-soon", StepPriority::high, now + std::chrono::seconds(1), now);
+    queue.push("normal-c", StepPriority::normal, deadline, now);
+
+    auto order = drain(queue);
+    assert((order == std::vector<std::string>{"high-soon", "high-late", "normal-a", "normal-b", "normal-c", "low"}));
+
+    std::cout << "✓ Priority class test passed" << std::endl;
+}
+
+void test_entry_timestamps() {
+    std::cout << "Testing entry timestamps..." << std::endl;
+
+    auto enqueued = Clock::now() - std::chrono::seconds(2);
+    auto deadline = enqueued + std::chrono::seconds(1);
+    DeadlineQueue<std::unique_ptr<int>> queue; // Move-only values
+    queue.push(std::make_unique<int>(7), StepPriority::normal, deadline, enqueued);
+    auto entry = queue.pop();
+    assert(*entry.value == 7);
+    assert(entry.enqueued_at == enqueued);
+    assert(entry.deadline == deadline);
+    assert(Clock::now() >= entry.deadline); // Expired: the pool drops it at dequeue
+
+    std::cout << "✓ Entry timestamp test passed" << std::endl;
+}
+
+void test_erase_by_key() {
+    std::cout << "Testing erase by key..." << std::endl;
+
+    auto now = Clock::now();
+    DeadlineQueue<std::string> queue;
+    for (int i = 0; i < 10; i++) {
+        queue.push("step" + std::to_string(i), StepPriority::normal, now + std::chrono::seconds(10 - i), now,
+                   "step" + std::to_string(i));
+    }
+    queue.push("unkeyed", StepPriority::low, now, now); // Not indexed: never matches a key
+    queue.push("step3-retry", StepPriority::low, now, now, "step3");
+    assert(queue.contains("step3"));
+
+    std::vector<std::string> erased;
+    assert(queue.erase("step3", [&erased](auto& entry) { erased.push_back(entry.value); }) == 2);
+    assert((erased == std::vector<std::string>{"step3", "step3-retry"} ||
+            erased == std::vector<std::string>{"step3-retry", "step3"}));
+    assert(queue.erase("step9") == 1); // The front entry
+    assert(queue.erase("step9") == 0);
+    assert(queue.erase("") == 0);
+    assert(!queue.contains("step3"));
+    assert(queue.size() == 9);
+    assert(queue.top().value == "step8");
+
+    auto order = drain(queue);
+    assert((order == std::vector<std::string>{"step8", "step7", "step6", "step5", "step4", "step2", "step1", "step0",
+                                              "unkeyed"}));
+
+    std::cout << "✓ Erase by key test passed" << std::endl;
+}
+
+void test_cancel_storm() {
+    std::cout << "Testing cancel storm..." << std::endl;
+
+    auto now = Clock::now();
+    const int steps = 100000;
+    DeadlineQueue<int> queue;
+    for (int i = 0; i < steps; i++) {
+        queue.push(i, StepPriority::normal, now + std::chrono::milliseconds(i), now, "step" + std::to_string(i));
+    }
+
+    // Cancel every step but each 100th, as a flow abort would; compaction reclaims the tombstones
+    auto start = Clock::now();
+    for (int i = 0; i < steps; i++) {
+        if (i % 100 != 0) {
+            assert(queue.erase("step" + std::to_string(i)) == 1);
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    assert(queue.size() == steps / 100);
+    std::cout << "  " << steps - steps / 100 << " cancellations in " << elapsed << " ms" << std::endl;
+
+    // Reused nodes keep working after compaction
+    queue.push(-1, StepPriority::high, Clock::time_point::max(), now, "late");
+    assert(queue.pop().value == -1);
+    for (int i = 0; i < steps; i += 100) {
+        assert(queue.pop().value == i);
+    }
+    assert(queue.empty());
+
+    std::cout << "✓ Cancel storm test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Deadline Queue Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_parse_priority();
+        test_earliest_deadline_first();
+        test_priority_classes_and_fifo_ties();
+        test_entry_timestamps();
+        test_erase_by_key();
+        test_cancel_storm();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/send.hpp>
+#include "beamline/worker/core.hpp"
+#include "beamline/worker/actors.hpp"
+#include "beamline/worker/base_block_executor.hpp"
+
+using namespace beamline::worker;
+
+// Completions are observed inside the block: the pool has no reply path to the requester
+struct CompletionLog {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::chrono::steady_clock::time_point> sent_at; // By step index
+    std::vector<double> latencies_us;
+};
+
+// Trivial executor so the benchmark measures pool and actor overhead, not block I/O
+class NoopBlockExecutor : public BaseBlockExecutor {
+public:
+    explicit NoopBlockExecutor(std::shared_ptr<CompletionLog> log)
+        : BaseBlockExecutor("bench.noop", ResourceClass::cpu), log_(std::move(log)) {}
+
+    caf::expected<StepResult> execute_impl(const StepRequest& req, const BlockContext& ctx) override {
+        auto now = std::chrono::steady_clock::now();
+        auto index = static_cast<size_t>(std::stoul(req.inputs.at("step_id")));
+        {
+            std::lock_guard<std::mutex> lock(log_->mutex);
+            log_->latencies_us.push_back(std::chrono::duration<double, std::micro>(now - log_->sent_at[index]).count());
+        }
+        log_->cv.notify_one();
+        record_success(0);
+        return StepResult::success(metadata_from_context(ctx));
+    }
+
+private:
+    std::shared_ptr<CompletionLog> log_;
+};
+
+struct BenchmarkResults {
+    double steps_per_second;
+    double p50_latency_us;
+    double p99_latency_us;
+};
+
+static StepRequest make_request(size_t index) {
+    StepRequest req;
+    req.type = "bench.noop";
+    req.timeout_ms = 60000;
+    req.retry_count = 0;
+    req.inputs["step_id"] = std::to_string(index);
+    return req;
+}
+
+static BenchmarkResults summarize(std::vector<double>& latencies_us, std::chrono::microseconds total) {
+    std::sort(latencies_us.begin(), latencies_us.end());
+    BenchmarkResults results{};
+    results.steps_per_second = (static_cast<double>(latencies_us.size()) * 1000000.0) / static_cast<double>(total.count());
+    results.p50_latency_us = latencies_us[latencies_us.size() / 2];
+    results.p99_latency_us = latencies_us[(latencies_us.size() * 99) / 100];
+    return results;
+}
+
+// Runs `num_steps` steps through a pool actor keeping `window` in flight; latency is from
+// submitting the step to the pool until its block runs. With `pooled` false the pool spawns
+// an executor actor per step and retires it afterwards (pre-pool behaviour).
+static BenchmarkResults run_benchmark(caf::actor_system& system, size_t num_steps, int window, bool pooled) {
+    auto log = std::make_shared<CompletionLog>();
+    log->sent_at.resize(num_steps);
+    log->latencies_us.reserve(num_steps);
+    register_block_executor("bench.noop", [log]() { return std::make_shared<NoopBlockExecutor>(log); });
+
+    PoolConfig config{ResourceClass::cpu, window, pooled ? window : 0, window, 0, "", pooled};
+    auto pool = caf::actor_cast<caf::actor>(system.spawn<PoolActorImpl>(config));
+
+    size_t sent = 0;
+    auto submit_next = [&]() { // Called with log->mutex held
+        log->sent_at[sent] = std::chrono::steady_clock::now();
+        caf::anon_send(pool, caf::atom("execute"), make_request(sent));
+        sent++;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(log->mutex);
+        while (sent < num_steps && sent < static_cast<size_t>(window)) {
+            submit_next();
+        }
+        for (size_t completed = 0; completed < num_steps;) {
+            log->cv.wait(lock, [&]() { return log->latencies_us.size() > completed; });
+            for (; completed < log->latencies_us.size(); completed++) {
+                if (sent < num_steps) {
+                    submit_next();
+                }
+            }
+        }
+    }
+    auto total = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    caf::anon_send(pool, caf::atom("shutdown"));
+    std::lock_guard<std::mutex> lock(log->mutex);
+    return summarize(log->latencies_us, total);
+}
+
+static void print_results(const std::string& label, const BenchmarkResults& results) {
+    std::cout << "  " << label << ":" << std::endl;
+    std::cout << "    Throughput: " << results.steps_per_second << " steps/second" << std::endl;
+    std::cout << "    p50 latency: " << results.p50_latency_us << " microseconds" << std::endl;
+    std::cout << "    p99 latency: " << results.p99_latency_us << " microseconds" << std::endl;
+}
+
+void test_spawn_per_step_vs_pooled() {
+    std::cout << "Testing spawn-per-step vs pooled executor actors through the pool actor..." << std::endl;
+
+    caf::actor_system_config cfg;
+    caf::actor_system system{cfg};
+    Observability::set_log_level(LogLevel::warn); // Keep per-step pool logs out of the measurement
+
+    const size_t num_steps = 5000;
+    const int window = 8;
+
+    // Warm up the scheduler before measuring
+    run_benchmark(system, 1000, window, true);
+
+    auto spawned = run_benchmark(system, num_steps, window, false);
+    auto pooled = run_benchmark(system, num_steps, window, true);
+
+    print_results("Spawn per step", spawned);
+    print_results("Pooled executors", pooled);
+    std::cout << "  Throughput gain: " << (pooled.steps_per_second / spawned.steps_per_second) << "x" << std::endl;
+
+    assert(spawned.steps_per_second > 0);
+    assert(pooled.steps_per_second > 0);
+
+    std::cout << "✓ Executor pool benchmark completed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Worker Executor Pool Performance Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_spawn_per_step_vs_pooled();
+        std::cout << std::endl;
+
+        std::cout << "=== All Performance Tests Completed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Performance test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,258 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/event_based_actor.hpp>
+#include <caf/send.hpp>
+#include "beamline/worker/core.hpp"
+#include "beamline/worker/actors.hpp"
+#include "beamline/worker/base_block_executor.hpp"
+#include "beamline/worker/feature_flags.hpp"
+#include "beamline/worker/observability.hpp"
+
+using namespace beamline::worker;
+
+using Clock = std::chrono::steady_clock;
+
+// What the executor actor did, observed from the block and from a stand-in pool
+struct RetryLog {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<std::string, std::vector<Clock::time_point>> attempts; // By step_id
+    std::vector<std::pair<std::string, Clock::time_point>> done;    // Block type of each "done" message
+};
+
+// Fails the first `fail_times` attempts of each step with a retryable error
+class FlakyBlockExecutor : public BaseBlockExecutor {
+public:
+    FlakyBlockExecutor(std::string block_type, std::shared_ptr<RetryLog> log)
+        : BaseBlockExecutor(std::move(block_type), ResourceClass::cpu), log_(std::move(log)) {}
+
+    caf::expected<StepResult> execute_impl(const StepRequest& req, const BlockContext& ctx) override {
+        size_t attempt = 0;
+        {
+            std::lock_guard<std::mutex> lock(log_->mutex);
+            auto& attempts = log_->attempts[req.inputs.at("step_id")];
+            attempts.push_back(Clock::now());
+            attempt = attempts.size();
+        }
+        log_->cv.notify_all();
+        if (attempt <= std::stoul(req.inputs.at("fail_times"))) {
+            record_error(0);
+            return StepResult::error_result(ErrorCode::network_error, "Injected failure",
+                                            metadata_from_context(ctx), 0);
+        }
+        record_success(0);
+        return StepResult::success(metadata_from_context(ctx));
+    }
+
+private:
+    std::shared_ptr<RetryLog> log_;
+};
+
+static StepRequest make_request(const std::string& type, const std::string& step_id, int fail_times,
+                                int32_t retry_count, int64_t timeout_ms) {
+    StepRequest req;
+    req.type = type;
+    req.timeout_ms = timeout_ms;
+    req.retry_count = retry_count;
+    req.inputs["step_id"] = step_id;
+    req.inputs["fail_times"] = std::to_string(fail_times);
+    return req;
+}
+
+// Records each "done" the executor sends to its pool
+static caf::actor spawn_pool(caf::actor_system& system, std::shared_ptr<RetryLog> log) {
+    return system.spawn([log](caf::event_based_actor*) -> caf::behavior {
+        return {
+            [log](caf::atom_value done_atom, const std::string& block_type, const caf::actor&) {
+                if (done_atom != caf::atom("done")) {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(log->mutex);
+                    log->done.emplace_back(block_type, Clock::now());
+                }
+                log->cv.notify_all();
+            }
+        };
+    });
+}
+
+// Caller holds log.mutex
+static size_t count_done(const RetryLog& log, const std::string& block_type) {
+    return static_cast<size_t>(std::count_if(log.done.begin(), log.done.end(),
+        [&](const auto& done) { return done.first == block_type; }));
+}
+
+static bool wait_for(RetryLog& log, std::chrono::milliseconds timeout, const std::function<bool()>& done) {
+    std::unique_lock<std::mutex> lock(log.mutex);
+    return log.cv.wait_for(lock, timeout, done);
+}
+
+// The "done" message is sent after the step leaves retries_, so once it was seen the count is stable
+static size_t steps_in_flight(const caf::actor& executor) {
+    auto* actor = dynamic_cast<ExecutorActorImpl*>(caf::actor_cast<caf::abstract_actor*>(executor));
+    assert(actor);
+    return actor->state().steps_in_flight();
+}
+
+static bool recorded_status(const std::string& block_type, const std::string& status) {
+    Observability observability("test_worker");
+    return observability.get_metrics_response().find(
+        "worker_step_executions_total{step_type=\"" + block_type + "\",execution_status=\"" + status + "\"} 1") !=
+        std::string::npos;
+}
+
+static int64_t ms_between(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+void test_retries_until_success(caf::actor_system& system) {
+    std::cout << "Testing a step retried on delayed messages until it succeeds..." << std::endl;
+
+    auto log = std::make_shared<RetryLog>();
+    auto pool = spawn_pool(system, log);
+    auto executor = caf::actor_cast<caf::actor>(
+        system.spawn<ExecutorActorImpl>(std::make_shared<FlakyBlockExecutor>("retry.flaky", log)));
+
+    caf::anon_send(executor, caf::atom("execute"), make_request("retry.flaky", "flaky", 2, 3, 10000), pool);
+    assert(wait_for(*log, std::chrono::seconds(5), [&]() { return count_done(*log, "retry.flaky") == 1; }));
+
+    {
+        std::lock_guard<std::mutex> lock(log->mutex);
+        const auto& attempts = log->attempts.at("flaky");
+        assert(attempts.size() == 3);
+        // Exponential backoff between attempts: 100ms, then 200ms
+        assert(ms_between(attempts[0], attempts[1]) >= 100);
+        assert(ms_between(attempts[1], attempts[2]) >= 200);
+    }
+    assert(recorded_status("retry.flaky", "success"));
+    assert(steps_in_flight(executor) == 0);
+
+    caf::anon_send(executor, caf::atom("shutdown"));
+    std::cout << "✓ Retry until success test passed" << std::endl;
+}
+
+void test_budget_exhausted(caf::actor_system& system) {
+    std::cout << "Testing a step that runs out of its retry budget..." << std::endl;
+
+    auto log = std::make_shared<RetryLog>();
+    auto pool = spawn_pool(system, log);
+    auto executor = caf::actor_cast<caf::actor>(
+        system.spawn<ExecutorActorImpl>(std::make_shared<FlakyBlockExecutor>("retry.budget", log)));
+
+    // Retries are left, but the second backoff (200ms) would end past the 250ms total timeout
+    caf::anon_send(executor, caf::atom("execute"), make_request("retry.budget", "budget", 100, 5, 250), pool);
+    assert(wait_for(*log, std::chrono::seconds(5), [&]() { return count_done(*log, "retry.budget") == 1; }));
+
+    {
+        std::lock_guard<std::mutex> lock(log->mutex);
+        assert(log->attempts.at("budget").size() <= 2);
+        assert(ms_between(log->attempts.at("budget").front(), log->done.back().second) < 250);
+    }
+    assert(recorded_status("retry.budget", "timeout"));
+    assert(steps_in_flight(executor) == 0);
+
+    caf::anon_send(executor, caf::atom("shutdown"));
+    std::cout << "✓ Retry budget test passed" << std::endl;
+}
+
+void test_cancel_during_backoff(caf::actor_system& system) {
+    std::cout << "Testing a step cancelled while it waits for its next attempt..." << std::endl;
+
+    auto log = std::make_shared<RetryLog>();
+    auto pool = spawn_pool(system, log);
+    auto executor = caf::actor_cast<caf::actor>(
+        system.spawn<ExecutorActorImpl>(std::make_shared<FlakyBlockExecutor>("retry.cancel", log)));
+
+    caf::anon_send(executor, caf::atom("execute"), make_request("retry.cancel", "cancel", 100, 5, 10000), pool);
+    assert(wait_for(*log, std::chrono::seconds(5), [&]() { return log->attempts["cancel"].size() == 1; }));
+    caf::anon_send(executor, caf::atom("cancel"), std::string("cancel"));
+    assert(wait_for(*log, std::chrono::seconds(5), [&]() { return count_done(*log, "retry.cancel") == 1; }));
+    assert(recorded_status("retry.cancel", "cancelled"));
+    assert(steps_in_flight(executor) == 0);
+
+    // The retry already scheduled finds no step and runs nothing
+    assert(!wait_for(*log, std::chrono::milliseconds(300), [&]() { return log->attempts["cancel"].size() > 1; }));
+
+    caf::anon_send(executor, caf::atom("shutdown"));
+    std::cout << "✓ Cancel during backoff test passed" << std::endl;
+}
+
+void test_other_steps_run_during_backoff(caf::actor_system& system) {
+    std::cout << "Testing other steps complete while one step backs off..." << std::endl;
+
+    auto log = std::make_shared<RetryLog>();
+    auto pool = spawn_pool(system, log);
+    auto executor = caf::actor_cast<caf::actor>(
+        system.spawn<ExecutorActorImpl>(std::make_shared<FlakyBlockExecutor>("retry.fast", log)));
+
+    // One scheduler thread: a backoff that slept would hold up every step behind it
+    caf::anon_send(executor, caf::atom("execute"), make_request("retry.slow", "slow", 1, 3, 10000), pool);
+    assert(wait_for(*log, std::chrono::seconds(5), [&]() { return log->attempts["slow"].size() == 1; }));
+    for (int i = 0; i < 5; i++) {
+        caf::anon_send(executor, caf::atom("execute"),
+                       make_request("retry.fast", "fast" + std::to_string(i), 0, 0, 10000), pool);
+    }
+    assert(wait_for(*log, std::chrono::seconds(5), [&]() { return count_done(*log, "retry.slow") == 1; }));
+
+    {
+        std::lock_guard<std::mutex> lock(log->mutex);
+        // All other steps completed inside the slow step's 100ms backoff, before its second attempt
+        assert(log->done.size() == 6);
+        assert(log->done.back().first == "retry.slow");
+        const auto& slow = log->attempts.at("slow");
+        assert(slow.size() == 2);
+        assert(ms_between(slow[0], slow[1]) >= 100);
+        for (size_t i = 0; i < 5; i++) {
+            assert(log->done[i].second < slow[1]);
+        }
+    }
+    assert(recorded_status("retry.slow", "success"));
+    assert(steps_in_flight(executor) == 0);
+
+    caf::anon_send(executor, caf::atom("shutdown"));
+    std::cout << "✓ Steps during backoff test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Executor Retry Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    // Exponential backoff and the total-timeout budget, with step outcomes exported as metrics
+    setenv("CP2_ADVANCED_RETRY_ENABLED", "true", 1);
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "true", 1);
+    FeatureFlags::reload();
+    Observability::set_log_level(LogLevel::warn);
+
+    try {
+        caf::actor_system_config cfg;
+        cfg.set("scheduler.max-threads", 1);
+        caf::actor_system system{cfg};
+
+        test_retries_until_success(system);
+        test_budget_exhausted(system);
+        test_cancel_during_backoff(system);
+        test_other_steps_run_during_backoff(system);
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
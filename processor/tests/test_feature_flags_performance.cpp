@@ -0,0 +1,139 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "beamline/worker/feature_flags.hpp"
+
+using namespace beamline::worker;
+
+static const std::string FLAGS_FILE = "/tmp/beamline_test_feature_flags.conf";
+
+// Per-call cost of the previous implementation: getenv, copy and lowercase on every check
+static bool legacy_is_complete_timeout_enabled() {
+    return FeatureFlags::parse_bool(std::getenv("CP2_COMPLETE_TIMEOUT_ENABLED"), false);
+}
+
+static bool wait_for(bool (*predicate)(), int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (predicate()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return predicate();
+}
+
+void test_check_cost() {
+    std::cout << "Testing per-check cost (getenv vs snapshot)..." << std::endl;
+
+    setenv("CP2_COMPLETE_TIMEOUT_ENABLED", "TRUE", 1);
+    FeatureFlags::reload();
+
+    const int iterations = 2000000;
+    volatile bool sink = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = legacy_is_complete_timeout_enabled();
+    }
+    auto legacy_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = FeatureFlags::is_complete_timeout_enabled();
+    }
+    auto snapshot_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    (void)sink;
+
+    double legacy_per_check = static_cast<double>(legacy_ns) / iterations;
+    double snapshot_per_check = static_cast<double>(snapshot_ns) / iterations;
+    std::cout << "  getenv per check:   " << legacy_per_check << " ns" << std::endl;
+    std::cout << "  snapshot per check: " << snapshot_per_check << " ns" << std::endl;
+    std::cout << "  Speedup: " << legacy_per_check / snapshot_per_check << "x" << std::endl;
+
+    assert(FeatureFlags::is_complete_timeout_enabled());
+    assert(snapshot_per_check * 5 < legacy_per_check);
+
+    std::cout << "✓ Check cost test passed" << std::endl;
+}
+
+void test_snapshot_is_stable_until_reload() {
+    std::cout << "Testing snapshots only change on reload..." << std::endl;
+
+    setenv("CP2_ADVANCED_RETRY_ENABLED", "yes", 1);
+    FeatureFlags::reload();
+    const auto& before = FeatureFlags::snapshot();
+    assert(before.advanced_retry);
+
+    unsetenv("CP2_ADVANCED_RETRY_ENABLED");
+    assert(FeatureFlags::is_advanced_retry_enabled());
+
+    FeatureFlags::reload();
+    assert(!FeatureFlags::is_advanced_retry_enabled());
+    assert(FeatureFlags::snapshot().version > before.version);
+    assert(before.advanced_retry); // Old snapshot stays valid for readers holding it
+
+    std::cout << "✓ Snapshot stability test passed" << std::endl;
+}
+
+void test_flags_file_and_sighup_reload() {
+    std::cout << "Testing flags file watch and SIGHUP reload..." << std::endl;
+
+    unsetenv("CP2_QUEUE_MANAGEMENT_ENABLED");
+    {
+        std::ofstream file(FLAGS_FILE);
+        file << "# test flags\nCP2_QUEUE_MANAGEMENT_ENABLED = true\n";
+    }
+    FeatureFlags::set_flags_file(FLAGS_FILE);
+    FeatureFlags::reload();
+    assert(FeatureFlags::is_queue_management_enabled());
+
+    FeatureFlags::start_reload_watcher(20);
+
+    // Editing the file is picked up by the watcher
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::ofstream file(FLAGS_FILE, std::ios::trunc);
+        file << "CP2_QUEUE_MANAGEMENT_ENABLED=false\n";
+    }
+    auto file_mtime = std::filesystem::last_write_time(FLAGS_FILE);
+    std::filesystem::last_write_time(FLAGS_FILE, file_mtime + std::chrono::seconds(1));
+    assert(wait_for([]() { return !FeatureFlags::is_queue_management_enabled(); }, 2000));
+
+    // SIGHUP re-reads the environment as well
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "1", 1);
+    assert(!FeatureFlags::is_observability_metrics_enabled());
+    std::raise(SIGHUP);
+    assert(wait_for([]() { return FeatureFlags::is_observability_metrics_enabled(); }, 2000));
+
+    FeatureFlags::stop_reload_watcher();
+    FeatureFlags::set_flags_file("");
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    std::filesystem::remove(FLAGS_FILE);
+
+    std::cout << "✓ Reload test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Feature Flags Performance Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_check_cost();
+        test_snapshot_is_stable_until_reload();
+        test_flags_file_and_sighup_reload();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,269 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "beamline/worker/core.hpp"
+#include "beamline/worker/blob_buffer.hpp"
+#include "beamline/worker/group_commit.hpp"
+#include "beamline/worker/blocks/fs_block.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace beamline::worker;
+
+static const std::string TEST_DIR = "/tmp/beamline/test_fs_block/";
+
+static std::string write_test_file(const std::string& name, const std::string& content) {
+    std::filesystem::create_directories(TEST_DIR);
+    std::string path = TEST_DIR + name;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return path;
+}
+
+static std::string make_pattern(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<char>('a' + (i % 26));
+    }
+    return data;
+}
+
+static StepRequest make_get_request(const std::string& path) {
+    StepRequest req;
+    req.type = "fs.blob_get";
+    req.inputs["path"] = path;
+    return req;
+}
+
+static StepRequest make_put_request(const std::string& path, const std::string& content) {
+    StepRequest req;
+    req.type = "fs.blob_put";
+    req.inputs["path"] = path;
+    req.inputs["content"] = content;
+    return req;
+}
+
+static size_t count_temp_files(const std::string& dir) {
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().filename().string().find(".tmp.") != std::string::npos) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void test_blob_buffer_map_and_slice() {
+    std::cout << "Testing BlobBuffer mapping and slicing..." << std::endl;
+
+    auto data = make_pattern(100000);
+    auto path = write_test_file("map.bin", data);
+
+    auto whole = BlobBuffer::map_file(path);
+    assert(whole.size() == data.size());
+    assert(whole.file_size() == data.size());
+    assert(whole.view() == data);
+
+    // Unaligned offset inside the second page
+    auto range = BlobBuffer::map_file(path, 5000, 1234);
+    assert(range.size() == 1234);
+    assert(range.view() == std::string_view(data).substr(5000, 1234));
+
+    // Length is clipped to end of file
+    auto tail = BlobBuffer::map_file(path, 99990, 1000);
+    assert(tail.size() == 10);
+
+    auto sliced = range.slice(10, 20);
+    assert(sliced.view() == std::string_view(data).substr(5010, 20));
+
+    // Offset past end of file is an error
+    bool threw = false;
+    try {
+        BlobBuffer::map_file(path, data.size() + 1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "✓ BlobBuffer map/slice test passed" << std::endl;
+}
+
+void test_blob_buffer_outlives_file() {
+    std::cout << "Testing BlobBuffer keeps the mapping alive..." << std::endl;
+
+    auto data = make_pattern(8192);
+    auto path = write_test_file("lifetime.bin", data);
+
+    BlobBuffer copy;
+    {
+        auto buffer = BlobBuffer::map_file(path);
+        copy = buffer.slice(0, buffer.size());
+    }
+    std::filesystem::remove(path);
+    assert(copy.view() == data);
+
+    auto empty_path = write_test_file("empty.bin", "");
+    auto empty = BlobBuffer::map_file(empty_path);
+    assert(empty.empty());
+
+    std::cout << "✓ BlobBuffer lifetime test passed" << std::endl;
+}
+
+void test_blob_get_ranged_read() {
+    std::cout << "Testing fs.blob_get ranged reads..." << std::endl;
+
+    auto data = make_pattern(50000);
+    auto path = write_test_file("ranged.bin", data);
+    FsGetBlockExecutor executor;
+
+    auto req = make_get_request(path);
+    req.inputs["offset"] = "1000";
+    req.inputs["length"] = "500";
+    auto result = executor.execute(req, BlockContext{});
+    assert(result);
+    assert(result->is_success());
+    assert(result->outputs.at("content") == data.substr(1000, 500));
+    assert(result->outputs.at("size") == "500");
+    assert(result->outputs.at("file_size") == "50000");
+    assert(result->blobs.at("content").view() == std::string_view(data).substr(1000, 500));
+
+    req.inputs["offset"] = "60000";
+    auto past_end = executor.execute(req, BlockContext{});
+    assert(past_end);
+    assert(past_end->is_error());
+    assert(past_end->error_code == ErrorCode::invalid_input);
+
+    std::cout << "✓ fs.blob_get ranged read test passed" << std::endl;
+}
+
+void test_blob_get_buffer_mode() {
+    std::cout << "Testing fs.blob_get buffer mode skips the copy..." << std::endl;
+
+    auto data = make_pattern(1 << 20);
+    auto path = write_test_file("buffer.bin", data);
+    FsGetBlockExecutor executor;
+
+    auto req = make_get_request(path);
+    req.inputs["content_mode"] = "buffer";
+    auto result = executor.execute(req, BlockContext{});
+    assert(result);
+    assert(result->is_success());
+    assert(result->outputs.count("content") == 0);
+    assert(result->blobs.at("content").size() == data.size());
+    assert(result->blobs.at("content").view() == data);
+
+    auto missing = executor.execute(make_get_request(TEST_DIR + "missing.bin"), BlockContext{});
+    assert(missing);
+    assert(missing->error_code == ErrorCode::resource_unavailable);
+
+    std::cout << "✓ fs.blob_get buffer mode test passed" << std::endl;
+}
+
+void test_blob_put_atomic_replace() {
+    std::cout << "Testing fs.blob_put atomic replace..." << std::endl;
+
+    std::string dir = TEST_DIR + "put/nested/";
+    std::string path = dir + "blob.txt";
+    FsBlockExecutor executor;
+
+    auto first = executor.execute(make_put_request(path, "first"), BlockContext{});
+    assert(first);
+    assert(first->is_success());
+    assert(first->outputs.at("sync") == "none");
+
+    // Without overwrite the existing file is left untouched
+    auto refused = executor.execute(make_put_request(path, "second"), BlockContext{});
+    assert(refused);
+    assert(refused->is_error());
+    assert(BlobBuffer::map_file(path).view() == "first");
+
+    auto req = make_put_request(path, "second");
+    req.inputs["overwrite"] = "true";
+    req.inputs["sync"] = "per_write";
+    auto replaced = executor.execute(req, BlockContext{});
+    assert(replaced);
+    assert(replaced->is_success());
+    assert(replaced->outputs.at("sync") == "per_write");
+    assert(BlobBuffer::map_file(path).view() == "second");
+
+    req.inputs["sync"] = "sometimes";
+    auto invalid = executor.execute(req, BlockContext{});
+    assert(invalid);
+    assert(invalid->error_code == ErrorCode::invalid_input);
+
+    assert(count_temp_files(dir) == 0);
+
+    std::cout << "✓ fs.blob_put atomic replace test passed" << std::endl;
+}
+
+void test_group_commit_batches_syncs() {
+    std::cout << "Testing group commit batches concurrent syncs..." << std::endl;
+
+    std::string dir = TEST_DIR + "group/";
+    std::filesystem::create_directories(dir);
+
+    GroupCommitter::Config config;
+    config.policy = SyncPolicy::group_commit;
+    config.interval_ms = 5;
+    GroupCommitter committer(config);
+
+    const int num_threads = 16;
+    const int writes_per_thread = 20;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < writes_per_thread; i++) {
+                std::string path = dir + std::to_string(t) + "_" + std::to_string(i) + ".bin";
+                write_test_file("group/" + std::to_string(t) + "_" + std::to_string(i) + ".bin", "payload");
+                int fd = open(path.c_str(), O_RDONLY);
+                std::string error;
+                if (fd < 0 || !committer.sync_file(fd, SyncPolicy::group_commit, error)) {
+                    failures++;
+                }
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    assert(failures == 0);
+    int total_writes = num_threads * writes_per_thread;
+    assert(committer.commits() > 0);
+    assert(committer.commits() < total_writes);
+    std::cout << "  " << total_writes << " writes shared " << committer.commits() << " syncfs() calls" << std::endl;
+
+    std::cout << "✓ Group commit test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== FS Block Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_blob_buffer_map_and_slice();
+        test_blob_buffer_outlives_file();
+        test_blob_get_ranged_read();
+        test_blob_get_buffer_mode();
+        test_blob_put_atomic_replace();
+        test_group_commit_batches_syncs();
+
+        std::filesystem::remove_all(TEST_DIR);
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
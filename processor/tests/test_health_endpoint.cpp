@@ -9,7 +9,11 @@
 #include <unistd.h>
 #include <cstring>
 #include "beamline/worker/observability.hpp"
+#include "beamline/worker/admin_server.hpp"
+#include "beamline/worker/feature_flags.hpp"
+#include <cstdlib>
 #include <nlohmann/json.hpp>
+#include <zlib.h>
 using namespace beamline::worker;
 using json = nlohmann::json;
 
@@ -38,6 +42,91 @@ void test_health_endpoint_starts() {
     }
 }
 
+static int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    struct timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static void send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        assert(n > 0);
+        sent += static_cast<size_t>(n);
+    }
+}
+
+struct HttpResponse {
+    int status = 0;
+    std::string headers;
+    std::string body;
+    bool closed = false; // Server closed the connection after the response
+};
+
+// Read one response (Content-Length framed); `buffered` keeps bytes of the next one
+static HttpResponse read_response(int fd, std::string& buffered, bool head = false) {
+    HttpResponse response;
+    char chunk[4096];
+    size_t header_end;
+    while ((header_end = buffered.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            response.closed = true;
+            return response;
+        }
+        buffered.append(chunk, static_cast<size_t>(n));
+    }
+    response.headers = buffered.substr(0, header_end + 4);
+    response.status = std::stoi(response.headers.substr(9, 3));
+    size_t length_pos = response.headers.find("Content-Length: ");
+    size_t length = length_pos == std::string::npos ? 0 : std::stoul(response.headers.substr(length_pos + 16));
+    if (head) {
+        length = 0;
+    }
+    while (buffered.size() < header_end + 4 + length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        assert(n > 0);
+        buffered.append(chunk, static_cast<size_t>(n));
+    }
+    response.body = buffered.substr(header_end + 4, length);
+    buffered.erase(0, header_end + 4 + length);
+    if (response.headers.find("Connection: close") != std::string::npos) {
+        response.closed = recv(fd, chunk, sizeof(chunk), 0) == 0;
+    }
+    return response;
+}
+
+static HttpResponse http_get(uint16_t port, const std::string& path, const std::string& extra_headers = "") {
+    int fd = connect_to(port);
+    send_all(fd, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n" + extra_headers + "\r\n");
+    std::string buffered;
+    HttpResponse response = read_response(fd, buffered);
+    close(fd);
+    return response;
+}
+
+static std::string gunzip(const std::string& data) {
+    z_stream stream{};
+    assert(inflateInit2(&stream, 15 + 16) == Z_OK);
+    std::string output(data.size() * 20 + 1024, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    assert(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+    output.resize(stream.total_out);
+    inflateEnd(&stream);
+    return output;
+}
+
 void test_health_endpoint_returns_200() {
     std::cout << "Testing health endpoint returns 200 OK..." << std::endl;
     
@@ -48,17 +137,170 @@ void test_health_endpoint_returns_200() {
     uint16_t port = 19092; // Use different port
     
     observability->start_health_endpoint(address, port);
+    assert(observability->admin_port() == port);
     
-    // Wait for server to start
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
-    
-    // Note: HTTP request test would require curl library
-    // For now, we test the health response format directly
-    // In production, use external test script (test_worker_observability.sh) for HTTP tests
+    for (const char* path : {"/_health", "/health"}) {
+        HttpResponse response = http_get(port, path);
+        assert(response.status == 200);
+        assert(response.headers.find("Content-Type: application/json") != std::string::npos);
+        assert(json::parse(response.body)["status"] == "healthy");
+        assert(response.closed); // Client asked for Connection: close
+    }
+    assert(http_get(port, "/unknown").status == 404);
     
     observability->stop_health_endpoint();
     
-    std::cout << "✓ Health endpoint HTTP test skipped (use test_worker_observability.sh for HTTP tests)" << std::endl;
+    std::cout << "✓ Health endpoint returns 200 OK" << std::endl;
+}
+
+void test_readiness_and_metrics_routes() {
+    std::cout << "Testing /ready and /metrics on the admin port..." << std::endl;
+    
+    auto observability = std::make_unique<Observability>("test_worker");
+    observability->start_admin_endpoint("127.0.0.1", 0); // Any free port
+    uint16_t port = observability->admin_port();
+    assert(port != 0);
+    
+    HttpResponse not_ready = http_get(port, "/ready");
+    assert(not_ready.status == 503);
+    assert(json::parse(not_ready.body)["status"] == "not_ready");
+    observability->set_ready(true);
+    assert(http_get(port, "/ready").status == 200);
+    
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    FeatureFlags::reload();
+    assert(http_get(port, "/metrics").status == 404);
+    
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "true", 1);
+    FeatureFlags::reload();
+    for (int i = 0; i < 200; i++) {
+        observability->set_queue_depth("pool_" + std::to_string(i), i);
+    }
+    HttpResponse plain = http_get(port, "/metrics");
+    assert(plain.status == 200);
+    assert(plain.headers.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+    assert(plain.body.find("worker_queue_depth{resource_pool=\"pool_7\"} 7\n") != std::string::npos);
+    
+    // Large payloads are gzip-compressed when the client accepts it
+    HttpResponse compressed = http_get(port, "/metrics", "Accept-Encoding: gzip\r\n");
+    assert(compressed.status == 200);
+    assert(compressed.headers.find("Content-Encoding: gzip") != std::string::npos);
+    assert(compressed.body.size() < plain.body.size() / 2);
+    assert(gunzip(compressed.body) == plain.body);
+    HttpResponse refused = http_get(port, "/metrics", "Accept-Encoding: gzip;q=0, identity\r\n");
+    assert(refused.headers.find("Content-Encoding") == std::string::npos);
+    
+    // Content negotiation: Prometheus' scrape Accept header selects OpenMetrics
+    HttpResponse openmetrics = http_get(port, "/metrics",
+        "Accept: application/openmetrics-text;version=1.0.0,text/plain;version=0.0.4;q=0.5,*/*;q=0.1\r\n");
+    assert(openmetrics.headers.find("Content-Type: application/openmetrics-text; version=1.0.0") != std::string::npos);
+    assert(openmetrics.body.compare(openmetrics.body.size() - 6, 6, "# EOF\n") == 0);
+    HttpResponse text = http_get(port, "/metrics", "Accept: application/openmetrics-text;q=0.2, text/plain\r\n");
+    assert(text.headers.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+    
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    FeatureFlags::reload();
+    observability->stop_admin_endpoint();
+    
+    std::cout << "✓ Readiness and metrics routes test passed" << std::endl;
+}
+
+void test_component_metrics_on_admin_endpoint() {
+    std::cout << "Testing pool and executor metrics on the worker's /metrics..." << std::endl;
+    
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "true", 1);
+    FeatureFlags::reload();
+    
+    // As in the worker: main serves /metrics, pools and executors have their own instances
+    auto worker = std::make_unique<Observability>("worker_1");
+    auto pool = std::make_shared<Observability>("pool_io");
+    auto executor = std::make_shared<Observability>("executor");
+    assert(&pool->registry() == &worker->registry());
+    assert(&executor->registry() == &worker->registry());
+    
+    worker->start_admin_endpoint("127.0.0.1", 0);
+    uint16_t port = worker->admin_port();
+    pool->set_active_tasks("io", 4);
+    executor->record_step_execution("fs.blob_put", "success", "tenant_shared");
+    executor.reset(); // Executor actors come and go; what they recorded stays
+    
+    HttpResponse response = http_get(port, "/metrics");
+    assert(response.status == 200);
+    assert(response.body.find("worker_active_tasks{resource_pool=\"io\"} 4\n") != std::string::npos);
+    assert(response.body.find("worker_step_executions_total{step_type=\"fs.blob_put\",execution_status=\"success\","
+                              "tenant_id=\"tenant_shared\"} 1\n") != std::string::npos);
+    
+    // A private set of families is kept apart from the process-wide one
+    Observability isolated("isolated", std::make_shared<Observability::Metrics>("isolated"));
+    assert(&isolated.registry() != &worker->registry());
+    isolated.set_active_tasks("io", 9);
+    assert(http_get(port, "/metrics").body.find("worker_active_tasks{resource_pool=\"io\"} 4\n") != std::string::npos);
+    
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    FeatureFlags::reload();
+    worker->stop_admin_endpoint();
+    
+    std::cout << "✓ Component metrics test passed" << std::endl;
+}
+
+void test_admin_keep_alive_and_slow_clients() {
+    std::cout << "Testing admin server keep-alive, pipelining and slow clients..." << std::endl;
+    
+    AdminServer::Config config;
+    config.address = "127.0.0.1";
+    config.port = 0;
+    config.request_timeout_ms = 300;
+    config.idle_timeout_ms = 500;
+    AdminServer server(config);
+    int calls = 0;
+    server.handle("/ping", [&calls](const AdminServer::Request& request) {
+        calls++;
+        AdminServer::Response response;
+        response.body = "pong " + std::string(request.query);
+        return response;
+    });
+    server.start();
+    uint16_t port = server.port();
+    
+    // A client that sends half a request must not stall others
+    int slow = connect_to(port);
+    send_all(slow, "GET /ping HTTP/1.1\r\nHost: loc");
+    
+    // Keep-alive: several requests (one pipelined pair) on one connection
+    int fd = connect_to(port);
+    std::string buffered;
+    send_all(fd, "GET /ping?a=1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    HttpResponse first = read_response(fd, buffered);
+    assert(first.status == 200 && first.body == "pong a=1" && !first.closed);
+    assert(first.headers.find("Connection: keep-alive") != std::string::npos);
+    send_all(fd, "GET /ping?b=2 HTTP/1.1\r\n\r\nHEAD /ping HTTP/1.1\r\n\r\n");
+    assert(read_response(fd, buffered).body == "pong b=2");
+    HttpResponse head = read_response(fd, buffered, true);
+    assert(head.status == 200 && head.body.empty());
+    assert(head.headers.find("Content-Length: 5") != std::string::npos);
+    send_all(fd, "POST /ping HTTP/1.1\r\n\r\n");
+    assert(read_response(fd, buffered).status == 405);
+    assert(calls == 3);
+    
+    // The slow client times out; the idle keep-alive connection is closed later
+    auto start = std::chrono::steady_clock::now();
+    char byte;
+    assert(recv(slow, &byte, 1, 0) == 0);
+    auto waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    assert(waited_ms < 2000);
+    assert(recv(fd, &byte, 1, 0) == 0);
+    close(slow);
+    close(fd);
+    
+    // Oversized request headers are rejected
+    int big = connect_to(port);
+    send_all(big, "GET /ping HTTP/1.1\r\nX-Fill: " + std::string(10000, 'x') + "\r\n\r\n");
+    buffered.clear();
+    assert(read_response(big, buffered).status == 431);
+    close(big);
+    
+    server.stop();
+    std::cout << "✓ Keep-alive and slow client test passed" << std::endl;
 }
 
 void test_health_endpoint_cp1_format() {
@@ -132,8 +374,10 @@ int main() {
         test_health_endpoint_cp1_format();
         test_health_endpoint_stops();
         
-        // Test HTTP request (may fail if health endpoint is not accessible)
         test_health_endpoint_returns_200();
+        test_readiness_and_metrics_routes();
+        test_component_metrics_on_admin_endpoint();
+        test_admin_keep_alive_and_slow_clients();
         
         std::cout << std::endl;
         std::cout << "=== All Tests Passed ===" << std::endl;
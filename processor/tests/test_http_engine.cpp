@@ -0,0 +1,385 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <filesystem>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "beamline/worker/http_engine.hpp"
+
+using namespace beamline::worker;
+
+// Minimal keep-alive HTTP/1.1 server: answers every request on a connection with "ok"
+class LocalHttpServer {
+public:
+    LocalHttpServer() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        assert(bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        assert(listen(listen_fd_, 256) == 0);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        accept_thread_ = std::thread([this]() { accept_loop(); });
+    }
+
+    ~LocalHttpServer() {
+        running_ = false;
+        shutdown(listen_fd_, SHUT_RDWR);
+        close(listen_fd_);
+        accept_thread_.join();
+        for (auto& t : connection_threads_) {
+            t.join();
+        }
+    }
+
+    uint16_t port() const { return port_; }
+    int connections() const { return connections_.load(); }
+
+private:
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_{true};
+    std::atomic<int> connections_{0};
+    std::thread accept_thread_;
+    std::vector<std::thread> connection_threads_;
+
+    void accept_loop() {
+        while (running_) {
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                break;
+            }
+            connections_++;
+            connection_threads_.emplace_back([fd]() { serve(fd); });
+        }
+    }
+
+    static void serve(int fd) {
+        std::string buffer;
+        char chunk[4096];
+        while (true) {
+            auto n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+            size_t end;
+            while ((end = buffer.find("\r\n\r\n")) != std::string::npos) {
+                // "GET /hang" is never answered, the connection stays open until the client closes it
+                auto hang_pos = buffer.find("/hang");
+                if (hang_pos != std::string::npos && hang_pos < end) {
+                    buffer.erase(0, end + 4);
+                    continue;
+                }
+                // "GET /bytes/N" returns N bytes, everything else returns "ok"
+                std::string body = "ok";
+                auto bytes_pos = buffer.find("/bytes/");
+                if (bytes_pos != std::string::npos && bytes_pos < end) {
+                    body.assign(std::stoul(buffer.substr(bytes_pos + 7)), 'x');
+                }
+                buffer.erase(0, end + 4);
+                const std::string response =
+                    "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) +
+                    "\r\nConnection: keep-alive\r\n\r\n" + body;
+                send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+            }
+        }
+        close(fd);
+    }
+};
+
+void test_single_request() {
+    std::cout << "Testing single request through the engine..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine engine{HttpEngine::Config{}};
+
+    HttpEngine::Request request;
+    request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/";
+    request.timeout_ms = 5000;
+    auto response = engine.perform(request);
+
+    assert(response.ok());
+    assert(response.status_code == 200);
+    assert(response.body == "ok");
+    assert(response.headers.find("Content-Length: 2") != std::string::npos);
+
+    std::cout << "✓ Single request test passed" << std::endl;
+}
+
+void test_connection_error_reported() {
+    std::cout << "Testing connection errors are reported through the callback..." << std::endl;
+
+    HttpEngine engine{HttpEngine::Config{}};
+
+    HttpEngine::Request request;
+    request.url = "http://127.0.0.1:1/"; // Nothing listens on port 1
+    request.timeout_ms = 2000;
+    auto response = engine.perform(request);
+
+    assert(!response.ok());
+    assert(!response.error.empty());
+    assert(response.status_code == 0);
+
+    std::cout << "✓ Connection error test passed" << std::endl;
+}
+
+void test_origin_key() {
+    std::cout << "Testing connection pool origin keys..." << std::endl;
+
+    assert(HttpEngine::origin_key("http://Example.com/path?q=1") == "http://example.com:80");
+    assert(HttpEngine::origin_key("https://api.example.com/v1") == "https://api.example.com:443");
+    assert(HttpEngine::origin_key("http://127.0.0.1:8080/x") == "http://127.0.0.1:8080");
+
+    std::cout << "✓ Origin key test passed" << std::endl;
+}
+
+void test_keep_alive_reuse_stats() {
+    std::cout << "Testing keep-alive reuse and pool statistics..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine engine{HttpEngine::Config{}};
+    const std::string base = "http://127.0.0.1:" + std::to_string(server.port());
+
+    const int num_requests = 20;
+    for (int i = 0; i < num_requests; i++) {
+        HttpEngine::Request request;
+        request.url = base + "/seq/" + std::to_string(i);
+        request.timeout_ms = 5000;
+        auto response = engine.perform(request);
+        assert(response.ok());
+    }
+
+    auto stats = engine.pool_stats();
+    auto& host = stats.hosts.at(HttpEngine::origin_key(base));
+    std::cout << "  Requests: " << host.requests << std::endl;
+    std::cout << "  New connections: " << host.new_connections << std::endl;
+    std::cout << "  Reuse ratio: " << stats.reuse_ratio() << std::endl;
+
+    assert(host.requests == num_requests);
+    assert(host.new_connections == 1);
+    assert(host.reused_connections == num_requests - 1);
+    assert(host.active == 0);
+    assert(server.connections() == 1);
+    assert(stats.occupancy() == 0.0);
+
+    std::cout << "✓ Keep-alive reuse test passed" << std::endl;
+}
+
+void test_large_body_spills_to_file() {
+    std::cout << "Testing large response bodies spill to a file..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine engine{HttpEngine::Config{}};
+    const std::string base = "http://127.0.0.1:" + std::to_string(server.port());
+
+    // Small body stays in memory
+    HttpEngine::Request small;
+    small.url = base + "/bytes/512";
+    small.max_body_in_memory = 1024;
+    small.spill_dir = "/tmp/beamline/test_http_spill";
+    auto small_response = engine.perform(small);
+    assert(small_response.ok());
+    assert(!small_response.spilled());
+    assert(small_response.body.size() == 512);
+    assert(small_response.body_size == 512);
+
+    // Large body streams to disk and is released from memory
+    HttpEngine::Request large = small;
+    large.url = base + "/bytes/1000000";
+    auto large_response = engine.perform(large);
+    assert(large_response.ok());
+    assert(large_response.spilled());
+    assert(large_response.body.empty());
+    assert(large_response.body.capacity() < 1024 * 16);
+    assert(large_response.body_size == 1000000);
+    assert(large_response.body_path.find("/tmp/beamline/test_http_spill/") == 0);
+    assert(std::filesystem::file_size(large_response.body_path) == 1000000);
+    std::filesystem::remove(large_response.body_path);
+
+    std::cout << "  Spilled to: " << large_response.body_path << std::endl;
+    std::cout << "✓ Large body spill test passed" << std::endl;
+}
+
+void test_request_cannot_raise_body_cap() {
+    std::cout << "Testing a request's body cap is bounded by the engine's..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine::Config config;
+    config.max_body_in_memory = 1024;
+    config.spill_dir = "/tmp/beamline/test_http_spill";
+    HttpEngine engine{config};
+
+    HttpEngine::Request request;
+    request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/bytes/65536";
+    request.max_body_in_memory = size_t{1} << 40;
+    auto response = engine.perform(request);
+    assert(response.ok());
+    assert(response.spilled());
+    assert(response.body.empty());
+    assert(std::filesystem::file_size(response.body_path) == 65536);
+    std::filesystem::remove(response.body_path);
+
+    // Lowering the cap still applies
+    request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/bytes/768";
+    request.max_body_in_memory = 512;
+    response = engine.perform(request);
+    assert(response.ok());
+    assert(response.spilled());
+    std::filesystem::remove(response.body_path);
+
+    std::cout << "✓ Body cap bound test passed" << std::endl;
+}
+
+void test_body_cap_without_spill_dir() {
+    std::cout << "Testing body cap without a spill directory..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine::Config config;
+    config.max_body_in_memory = 1024;
+    config.spill_dir = "";
+    HttpEngine engine{config};
+
+    HttpEngine::Request request;
+    request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/bytes/4096";
+    auto response = engine.perform(request);
+    assert(!response.ok());
+    assert(response.error.find("in-memory limit") != std::string::npos);
+    assert(!response.spilled());
+
+    std::cout << "✓ Body cap test passed" << std::endl;
+}
+
+void test_concurrent_requests_reuse_connections() {
+    std::cout << "Testing concurrent requests share connections..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine::Config config;
+    config.max_host_connections = 8;
+    HttpEngine engine{config};
+
+    const int num_requests = 2000;
+    std::mutex mutex;
+    std::condition_variable cv;
+    int completed = 0;
+    std::atomic<int> ok_responses{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_requests; i++) {
+        HttpEngine::Request request;
+        request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/item/" + std::to_string(i);
+        request.timeout_ms = 10000;
+        engine.submit(std::move(request), [&](HttpEngine::Response response) {
+            if (response.ok() && response.status_code == 200) {
+                ok_responses++;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            completed++;
+            cv.notify_one();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return completed == num_requests; });
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::cout << "  Requests: " << num_requests << std::endl;
+    std::cout << "  Duration: " << duration.count() << " ms" << std::endl;
+    std::cout << "  Connections opened: " << server.connections() << std::endl;
+
+    assert(ok_responses.load() == num_requests);
+    assert(engine.in_flight() == 0);
+    assert(server.connections() <= 8);
+    auto stats = engine.pool_stats();
+    std::cout << "  Reuse ratio: " << stats.reuse_ratio() << std::endl;
+    assert(stats.hosts.size() == 1);
+    assert(stats.hosts.begin()->second.peak_active > 0);
+    assert(stats.reuse_ratio() > 0.99);
+
+    std::cout << "✓ Concurrent requests test passed" << std::endl;
+}
+
+void test_cancel_in_flight_transfer() {
+    std::cout << "Testing cancellation of an in-flight transfer..." << std::endl;
+
+    LocalHttpServer server;
+    HttpEngine engine{HttpEngine::Config{}};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<HttpEngine::Response> responses;
+    auto on_complete = [&](HttpEngine::Response response) {
+        std::lock_guard<std::mutex> lock(mutex);
+        responses.push_back(std::move(response));
+        cv.notify_all();
+    };
+
+    HttpEngine::Request request;
+    request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/hang";
+    request.timeout_ms = 30000;
+    auto id = engine.submit(request, on_complete);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Let the request reach the server
+    assert(engine.in_flight() == 1);
+
+    auto started = std::chrono::steady_clock::now();
+    engine.cancel(id);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        assert(cv.wait_for(lock, std::chrono::seconds(5), [&] { return responses.size() == 1; }));
+    }
+    assert(std::chrono::steady_clock::now() - started < std::chrono::seconds(5));
+    assert(!responses[0].ok());
+    assert(responses[0].error == "Transfer cancelled");
+    assert(engine.in_flight() == 0);
+    assert(engine.pool_stats().active == 0);
+
+    // Cancelling a finished transfer is a no-op, and the engine keeps serving requests
+    engine.cancel(id);
+    request.url = "http://127.0.0.1:" + std::to_string(server.port()) + "/";
+    auto response = engine.perform(request);
+    assert(response.ok());
+    assert(response.body == "ok");
+    assert(responses.size() == 1);
+
+    std::cout << "✓ Cancel in-flight transfer test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== HTTP Engine Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_single_request();
+        test_connection_error_reported();
+        test_origin_key();
+        test_keep_alive_reuse_stats();
+        test_large_body_spills_to_file();
+        test_request_cannot_raise_body_cap();
+        test_body_cap_without_spill_dir();
+        test_concurrent_requests_reuse_connections();
+        test_cancel_in_flight_transfer();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,264 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include "beamline/worker/io_executor.hpp"
+#include "beamline/worker/timeout_enforcement.hpp"
+
+using namespace beamline::worker;
+
+static std::chrono::steady_clock::time_point in_ms(int64_t ms) {
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+}
+
+static int64_t elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test_bounded_threads() {
+    std::cout << "Testing operations share a bounded set of threads..." << std::endl;
+
+    IoExecutor::Config config;
+    config.threads = 4;
+    IoExecutor executor(config);
+
+    std::mutex ids_mutex;
+    std::set<std::thread::id> thread_ids;
+    for (int i = 0; i < 200; i++) {
+        int value = 0;
+        auto status = executor.run_until<int>([&, i](const IoTask&) {
+            std::lock_guard<std::mutex> lock(ids_mutex);
+            thread_ids.insert(std::this_thread::get_id());
+            return i;
+        }, in_ms(1000), value);
+        assert(status == IoTaskStatus::completed);
+        assert(value == i);
+    }
+
+    assert(thread_ids.size() <= 4);
+    auto stats = executor.stats();
+    assert(stats.completed == 200);
+    assert(stats.queue_depth == 0);
+
+    std::cout << "✓ Bounded threads test passed" << std::endl;
+}
+
+void test_deadline_does_not_block() {
+    std::cout << "Testing a timed-out caller returns at the deadline..." << std::endl;
+
+    IoExecutor::Config config;
+    config.threads = 1;
+    IoExecutor executor(config);
+
+    std::atomic<bool> observed_cancel{false};
+    auto start = std::chrono::steady_clock::now();
+    int value = 0;
+    auto status = executor.run_until<int>([&](const IoTask& task) {
+        // Slow operation that polls for cancellation
+        for (int i = 0; i < 200 && !task.cancelled(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        observed_cancel = task.cancelled();
+        return 1;
+    }, in_ms(50), value);
+
+    assert(status == IoTaskStatus::timed_out);
+    assert(elapsed_ms(start) < 500);
+    assert(value == 0);
+
+    // The running operation sees the cancellation and frees the thread
+    while (executor.stats().active > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert(observed_cancel);
+
+    std::cout << "✓ Deadline test passed" << std::endl;
+}
+
+void test_expired_and_cancelled_tasks_never_run() {
+    std::cout << "Testing queued tasks past their deadline are dropped..." << std::endl;
+
+    IoExecutor::Config config;
+    config.threads = 1;
+    IoExecutor executor(config);
+
+    // Occupy the only thread
+    std::atomic<bool> release{false};
+    auto blocker = executor.submit([&](const IoTask&) {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }, in_ms(10000));
+    assert(blocker);
+    while (executor.stats().active == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::atomic<int> runs{0};
+    auto expiring = executor.submit([&](const IoTask&) { runs++; }, in_ms(20));
+    auto cancelled = executor.submit([&](const IoTask&) { runs++; }, in_ms(10000));
+    assert(executor.stats().queue_depth == 2);
+
+    assert(cancelled->cancel());
+    assert(executor.stats().queue_depth == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release = true;
+    assert(expiring->wait_until(in_ms(1000)));
+    assert(blocker->wait_until(in_ms(1000)));
+
+    assert(runs == 0);
+    assert(expiring->state() == IoTask::State::cancelled);
+    auto stats = executor.stats();
+    assert(stats.expired == 1);
+    assert(stats.cancelled == 1);
+    assert(stats.queue_depth == 0);
+    assert(stats.max_queue_wait_ms >= 20);
+
+    std::cout << "✓ Expired/cancelled tasks test passed" << std::endl;
+}
+
+void test_queue_limit_rejects() {
+    std::cout << "Testing full queue rejects new work..." << std::endl;
+
+    IoExecutor::Config config;
+    config.threads = 1;
+    config.max_queue_depth = 2;
+    IoExecutor executor(config);
+
+    std::atomic<bool> release{false};
+    auto blocker = executor.submit([&](const IoTask&) {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }, in_ms(10000));
+    while (executor.stats().active == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    assert(executor.submit([](const IoTask&) {}, in_ms(10000)));
+    assert(executor.submit([](const IoTask&) {}, in_ms(10000)));
+    int value = 0;
+    auto status = executor.run_until<int>([](const IoTask&) { return 1; }, in_ms(10000), value);
+    assert(status == IoTaskStatus::rejected);
+    assert(executor.stats().rejected == 1);
+    assert(executor.stats().peak_queue_depth == 2);
+
+    release = true;
+    std::cout << "✓ Queue limit test passed" << std::endl;
+}
+
+void test_abandoned_tasks_are_counted() {
+    std::cout << "Testing running tasks past their timeout are counted as abandoned..." << std::endl;
+
+    IoExecutor::Config config;
+    config.threads = 1;
+    IoExecutor executor(config);
+
+    // An operation that ignores cancellation keeps its thread after the caller gives up
+    std::atomic<bool> release{false};
+    int value = 0;
+    auto status = executor.run_until<int>([&](const IoTask&) {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 1;
+    }, in_ms(50), value);
+    assert(status == IoTaskStatus::timed_out);
+    assert(executor.stats().abandoned == 1);
+    assert(executor.stats().active == 1);
+
+    release = true;
+    while (executor.stats().active > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(executor.stats().abandoned == 0);
+
+    // One that checks its task returns at the timeout and frees the thread
+    auto start = std::chrono::steady_clock::now();
+    status = executor.run_until<int>([](const IoTask& task) {
+        while (!task.cancelled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 2;
+    }, in_ms(50), value);
+    assert(status == IoTaskStatus::timed_out);
+    while (executor.stats().active > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(elapsed_ms(start) < 400);
+    assert(executor.stats().abandoned == 0);
+
+    std::cout << "✓ Abandoned task test passed" << std::endl;
+}
+
+void test_timeout_enforcement_uses_executor() {
+    std::cout << "Testing TimeoutEnforcement returns at the timeout..." << std::endl;
+
+    setenv("CP2_COMPLETE_TIMEOUT_ENABLED", "true", 1);
+    FeatureFlags::reload();
+
+    std::string result;
+    bool completed = TimeoutEnforcement::execute_with_timeout<std::string>(
+        []() { return std::string("done"); }, 1000, result, std::string("timeout"));
+    assert(completed);
+    assert(result == "done");
+
+    auto start = std::chrono::steady_clock::now();
+    completed = TimeoutEnforcement::execute_with_timeout<std::string>(
+        []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            return std::string("late");
+        }, 50, result, std::string("timeout"));
+    assert(!completed);
+    assert(result == "timeout");
+    assert(elapsed_ms(start) < 400);
+
+    // An operation taking the task stops once the timeout cancels it
+    std::atomic<bool> stopped{false};
+    completed = TimeoutEnforcement::execute_with_timeout<std::string>(
+        [&stopped](const IoTask& task) {
+            while (!task.cancelled()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            stopped = true;
+            return std::string("late");
+        }, 50, result, std::string("timeout"));
+    assert(!completed);
+    assert(result == "timeout");
+    start = std::chrono::steady_clock::now();
+    while (!stopped) {
+        assert(elapsed_ms(start) < 1000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    unsetenv("CP2_COMPLETE_TIMEOUT_ENABLED");
+    FeatureFlags::reload();
+    std::cout << "✓ TimeoutEnforcement test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Blocking I/O Executor Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_bounded_threads();
+        test_deadline_does_not_block();
+        test_expired_and_cancelled_tasks_never_run();
+        test_queue_limit_rejects();
+        test_abandoned_tasks_are_counted();
+        test_timeout_enforcement_uses_executor();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,357 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "beamline/worker/metrics_registry.hpp"
+
+using namespace beamline::worker;
+
+using MetricType = MetricsRegistry::MetricType;
+
+template <typename Exception, typename Fn>
+static bool throws(Fn&& fn) {
+    try {
+        fn();
+    } catch (const Exception&) {
+        return true;
+    }
+    return false;
+}
+
+static bool contains(const std::string& text, const std::string& fragment) {
+    return text.find(fragment) != std::string::npos;
+}
+
+void test_counter_and_gauge() {
+    std::cout << "Testing counters and gauges..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& tasks = registry.add_family(MetricType::counter, "tasks_total", "Tasks run", {"block_type", "status"},
+                                      {}, {{"worker_id", "w1"}});
+    auto ok = tasks.counter({"http", "ok"});
+    ok.inc();
+    ok.inc(4);
+    tasks.counter({"http", "ok"}).inc(); // Resolves to the same series
+    tasks.counter({"fs", ""}).inc(2);
+    assert(ok.value() == 6);
+    assert(tasks.series_count() == 2);
+
+    auto& depth = registry.add_family(MetricType::gauge, "queue_depth", "Queue \"depth\"\nper pool", {"pool"});
+    auto cpu = depth.gauge({"cpu"});
+    cpu.set(7);
+    cpu.add(-2.5);
+    assert(cpu.value() == 4.5);
+    depth.gauge({"a\"b\\c"}).set(1);
+
+    std::string text;
+    registry.render(text);
+    assert(contains(text, "# HELP queue_depth Queue \"depth\"\\nper pool\n# TYPE queue_depth gauge\n"));
+    assert(contains(text, "queue_depth{pool=\"cpu\"} 4.5\n"));
+    assert(contains(text, "queue_depth{pool=\"a\\\"b\\\\c\"} 1\n"));
+    assert(contains(text, "# TYPE tasks_total counter\n"));
+    assert(contains(text, "tasks_total{worker_id=\"w1\",block_type=\"http\",status=\"ok\"} 6\n"));
+    assert(contains(text, "tasks_total{worker_id=\"w1\",block_type=\"fs\"} 2\n")); // Empty label omitted
+    assert(text.find("queue_depth") < text.find("tasks_total")); // Families sorted by name
+
+    std::cout << "✓ Counter and gauge test passed" << std::endl;
+}
+
+void test_histogram() {
+    std::cout << "Testing histograms..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& latency = registry.add_family(MetricType::histogram, "latency_seconds", "", {}, {0.1, 0.5, 1.0});
+    auto histogram = latency.histogram({});
+    for (double value : {0.05, 0.1, 0.3, 0.7, 2.0}) {
+        histogram.observe(value);
+    }
+    assert(histogram.count() == 5);
+    assert(histogram.sum() > 3.149 && histogram.sum() < 3.151);
+
+    std::string text;
+    registry.render(text);
+    assert(contains(text, "latency_seconds_bucket{le=\"0.1\"} 2\n"));
+    assert(contains(text, "latency_seconds_bucket{le=\"0.5\"} 3\n"));
+    assert(contains(text, "latency_seconds_bucket{le=\"1\"} 4\n"));
+    assert(contains(text, "latency_seconds_bucket{le=\"+Inf\"} 5\n"));
+    assert(contains(text, "latency_seconds_sum 3.15\n"));
+    assert(contains(text, "latency_seconds_count 5\n"));
+    assert(!contains(text, "# HELP"));
+
+    std::cout << "✓ Histogram test passed" << std::endl;
+}
+
+void test_registration_errors() {
+    std::cout << "Testing registration and usage errors..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& family = registry.add_family(MetricType::counter, "errors_total", "", {"code"});
+
+    assert(throws<std::invalid_argument>([&] { registry.add_family(MetricType::counter, "errors_total", ""); }));
+    assert(throws<std::invalid_argument>([&] { registry.add_family(MetricType::counter, "bad-name", ""); }));
+    assert(throws<std::invalid_argument>([&] { registry.add_family(MetricType::counter, "bad_label", "", {"le"}); }));
+    assert(throws<std::invalid_argument>([&] { registry.add_family(MetricType::histogram, "no_buckets", ""); }));
+    assert(throws<std::invalid_argument>([&] { registry.add_family(MetricType::histogram, "unsorted", "", {}, {1.0, 0.5}); }));
+    assert(throws<std::logic_error>([&] { family.counter({"a", "b"}); }));
+    assert(throws<std::logic_error>([&] { family.gauge({"a"}); }));
+
+    std::cout << "✓ Registration errors test passed" << std::endl;
+}
+
+void test_series_limit() {
+    std::cout << "Testing per-family series limit and overflow..." << std::endl;
+
+    MetricsRegistry::Options options;
+    options.max_series_per_family = 2;
+    MetricsRegistry registry(options);
+    auto& family = registry.add_family(MetricType::counter, "limited_total", "", {"id", "kind"});
+    auto& wide = registry.add_family(MetricType::counter, "wide_total", "", {"id"}, {}, {}, 100);
+    family.counter({"a", "x"}).inc();
+    family.counter({"b", "x"}).inc();
+    auto overflow = family.counter({"c", "x"});
+    assert(overflow);
+    overflow.inc(5);
+    family.counter({"d", "y"}).inc(); // Same overflow series
+    family.counter({"d", "y"}).inc(); // Counted again: dropped samples, not distinct series
+    family.counter({"a", "x"}).inc(); // Existing series still resolve
+    assert(family.counter({"a", "x"}).value() == 2);
+    assert(family.series_count() == 2);
+    for (int i = 0; i < 50; i++) {
+        wide.counter({std::to_string(i)}).inc(); // Per-family limit overrides the default
+    }
+    assert(wide.series_count() == 50);
+
+    std::string text;
+    registry.render(text);
+    assert(contains(text, "limited_total{id=\"__overflow__\",kind=\"__overflow__\"} 7\n"));
+    assert(contains(text, "metrics_dropped_samples_total{family=\"limited_total\"} 3\n"));
+    assert(!contains(text, "metrics_dropped_samples_total{family=\"wide_total\"}"));
+
+    std::cout << "✓ Series limit test passed" << std::endl;
+}
+
+void test_unbounded_labels_rejected() {
+    std::cout << "Testing unbounded label policy..." << std::endl;
+
+    MetricsRegistry registry;
+    for (const char* label : {"run_id", "flow_id", "step_id", "trace_id"}) {
+        assert(throws<std::invalid_argument>([&] {
+            registry.add_family(MetricType::counter, std::string("by_") + label, "", {"tenant_id", label});
+        }));
+    }
+
+    MetricsRegistry::Options options;
+    options.unbounded_labels = {"user_id"};
+    MetricsRegistry custom(options);
+    custom.add_family(MetricType::counter, "by_run", "", {"run_id"});
+    assert(throws<std::invalid_argument>([&] { custom.add_family(MetricType::counter, "by_user", "", {"user_id"}); }));
+
+    std::cout << "✓ Unbounded label policy test passed" << std::endl;
+}
+
+void test_exemplars() {
+    std::cout << "Testing exemplars..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& steps = registry.add_family(MetricType::counter, "steps_total", "", {"step_type"});
+    auto counter = steps.counter({"http"});
+    counter.inc();
+    assert(!counter.exemplar());
+    counter.inc(1, {{"run_id", "run_1"}, {"flow_id", ""}, {"step_id", "step \"1\""}});
+    counter.inc(1, {{"run_id", ""}}); // Nothing to keep; the previous exemplar stays
+    auto exemplar = counter.exemplar();
+    assert(exemplar);
+    assert(exemplar->labels == "run_id=\"run_1\",step_id=\"step \\\"1\\\"\"");
+    assert(exemplar->value == 1);
+    assert(exemplar->timestamp > 1.6e9);
+    assert(counter.value() == 3);
+
+    // Pairs that would exceed 128 characters are left out
+    std::string long_id(110, 'r');
+    counter.inc(2, {{"run_id", long_id}, {"step_id", "s9"}});
+    exemplar = counter.exemplar();
+    assert(exemplar->labels == "run_id=\"" + long_id + "\"");
+    assert(exemplar->value == 2);
+
+    auto& latency = registry.add_family(MetricType::histogram, "latency_seconds", "", {}, {0.1, 1.0});
+    auto histogram = latency.histogram({});
+    histogram.observe(0.05, {{"run_id", "fast"}});
+    histogram.observe(5.0, {{"run_id", "slow"}});
+    assert(histogram.exemplar(0)->labels == "run_id=\"fast\"");
+    assert(!histogram.exemplar(1));
+    assert(histogram.exemplar(2)->labels == "run_id=\"slow\"");
+    assert(histogram.exemplar(2)->value == 5.0);
+    assert(!histogram.exemplar(3));
+
+    std::cout << "✓ Exemplars test passed" << std::endl;
+}
+
+void test_concurrent_updates() {
+    std::cout << "Testing concurrent updates across shards..." << std::endl;
+
+    MetricsRegistry::Options options;
+    options.shards = 8; // Independent of the machine's CPU count
+    MetricsRegistry registry(options);
+    auto& counters = registry.add_family(MetricType::counter, "ops_total", "", {"kind"});
+    auto& histograms = registry.add_family(MetricType::histogram, "op_seconds", "", {"kind"}, {0.5});
+
+    const int threads = 8;
+    const int per_thread = 50000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            // Every thread races to create the same two series
+            auto shared = counters.counter({"shared"});
+            auto own = histograms.histogram({t % 2 == 0 ? "even" : "odd"});
+            for (int i = 0; i < per_thread; i++) {
+                shared.inc();
+                own.observe(i % 2 == 0 ? 0.25 : 1.0);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    assert(counters.series_count() == 1);
+    assert(counters.counter({"shared"}).value() == static_cast<uint64_t>(threads) * per_thread);
+    auto even = histograms.histogram({"even"});
+    assert(even.count() == static_cast<uint64_t>(threads / 2) * per_thread);
+    assert(even.sum() == (threads / 2) * (per_thread / 2) * 1.25);
+    std::cout << "  Shards per series: " << registry.shard_count() << std::endl;
+
+    std::cout << "✓ Concurrent updates test passed" << std::endl;
+}
+
+void test_hot_path_cost() {
+    std::cout << "Testing hot path cost..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& family = registry.add_family(MetricType::counter, "steps_total", "",
+                                       {"step_type", "execution_status", "tenant_id"});
+    const std::string step_type = "http.request";
+    const std::string status = "success";
+    const std::string tenant = "tenant_123";
+    auto handle = family.counter({step_type, status, tenant});
+
+    const int iterations = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        handle.inc();
+    }
+    auto handle_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        family.counter({step_type, status, tenant}).inc();
+    }
+    auto lookup_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    double handle_per_op = static_cast<double>(handle_ns) / iterations;
+    double lookup_per_op = static_cast<double>(lookup_ns) / iterations;
+    std::cout << "  Pre-resolved handle: " << handle_per_op << " ns per increment" << std::endl;
+    std::cout << "  Resolve by labels:   " << lookup_per_op << " ns per increment" << std::endl;
+    assert(handle.value() == 2u * iterations);
+    assert(handle_per_op < 100);
+    assert(lookup_per_op < 500);
+
+    std::cout << "✓ Hot path cost test completed" << std::endl;
+}
+
+void test_openmetrics_render() {
+    std::cout << "Testing OpenMetrics rendering..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& steps = registry.add_family(MetricType::counter, "steps_total", "Steps \"run\"", {"step_type"});
+    auto& retries = registry.add_family(MetricType::counter, "retries", "", {});
+    auto& latency = registry.add_family(MetricType::histogram, "latency_seconds", "", {"step_type"}, {0.1, 1.0});
+    steps.counter({"http"}).inc(3, {{"run_id", "run_1"}});
+    retries.counter({}).inc();
+    latency.histogram({"http"}).observe(0.5, {{"run_id", "run_2"}});
+    latency.histogram({"http"}).observe(0.05);
+
+    std::string text;
+    registry.render(text, MetricsRegistry::Format::openmetrics);
+    assert(contains(text, "# HELP steps Steps \\\"run\\\"\n# TYPE steps counter\n"));
+    assert(contains(text, "steps_total{step_type=\"http\"} 3 # {run_id=\"run_1\"} 3 1"));
+    assert(contains(text, "# TYPE retries counter\nretries_total 1\n"));
+    assert(contains(text, "latency_seconds_bucket{step_type=\"http\",le=\"0.1\"} 1\n"));
+    assert(contains(text, "latency_seconds_bucket{step_type=\"http\",le=\"1\"} 2 # {run_id=\"run_2\"} 0.5 1"));
+    assert(contains(text, "latency_seconds_bucket{step_type=\"http\",le=\"+Inf\"} 2\n"));
+    assert(contains(text, "latency_seconds_count{step_type=\"http\"} 2\n"));
+    assert(text.size() > 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+
+    // The Prometheus format keeps the registered names and leaves exemplars out
+    std::string prometheus;
+    registry.render(prometheus);
+    assert(contains(prometheus, "# HELP steps_total Steps \"run\"\n# TYPE steps_total counter\n"));
+    assert(contains(prometheus, "steps_total{step_type=\"http\"} 3\n"));
+    assert(contains(prometheus, "# TYPE retries counter\nretries 1\n"));
+    assert(!contains(prometheus, " # {") && !contains(prometheus, "# EOF"));
+
+    std::cout << "✓ OpenMetrics render test passed" << std::endl;
+}
+
+void test_render_cost() {
+    std::cout << "Testing render cost with many series..." << std::endl;
+
+    MetricsRegistry registry;
+    auto& counters = registry.add_family(MetricType::counter, "requests_total", "Requests", {"route", "status"});
+    auto& histograms = registry.add_family(MetricType::histogram, "request_seconds", "Latency", {"route"},
+                                           {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10});
+    for (int route = 0; route < 500; route++) {
+        std::string name = "/api/v1/route_" + std::to_string(route);
+        counters.counter({name, "200"}).inc(1, {{"run_id", "run_" + std::to_string(route)}});
+        counters.counter({name, "500"}).inc();
+        histograms.histogram({name}).observe(0.03, {{"run_id", "run_" + std::to_string(route)}});
+    }
+
+    // A reused buffer stops allocating once it has grown to the exposition size
+    std::string buffer;
+    const int renders = 50;
+    for (auto format : {MetricsRegistry::Format::prometheus, MetricsRegistry::Format::openmetrics}) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < renders; i++) {
+            buffer.clear();
+            registry.render(buffer, format);
+        }
+        auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << (format == MetricsRegistry::Format::prometheus ? "Prometheus:  " : "OpenMetrics: ")
+                  << elapsed_us / renders << " us per render (" << buffer.size() << " bytes, 1500 series)" << std::endl;
+        assert(elapsed_us / renders < 200000);
+    }
+    size_t capacity = buffer.capacity();
+    buffer.clear();
+    registry.render(buffer, MetricsRegistry::Format::openmetrics);
+    assert(buffer.capacity() == capacity);
+
+    std::cout << "✓ Render cost test completed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Metrics Registry Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_counter_and_gauge();
+        test_histogram();
+        test_registration_errors();
+        test_series_limit();
+        test_unbounded_labels_rejected();
+        test_exemplars();
+        test_openmetrics_render();
+        test_concurrent_updates();
+        test_hot_path_cost();
+        test_render_cost();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -5,7 +5,15 @@
 #include <unordered_map>
 #include "beamline/worker/core.hpp"
 #include "beamline/worker/observability.hpp"
+#include "beamline/worker/json_log_format.hpp"
+#include "beamline/worker/pii_matcher.hpp"
+#include "beamline/worker/log_sampler.hpp"
+#include "beamline/worker/feature_flags.hpp"
+#include <cstdlib>
+#include <chrono>
+#include <thread>
 #include <nlohmann/json.hpp>
+#include <algorithm>
 
 using namespace beamline::worker;
 using json = nlohmann::json;
@@ -323,6 +331,387 @@ void test_invalid_json_in_context() {
     std::cout << "✓ Invalid JSON handling test passed (no crash)" << std::endl;
 }
 
+static bool test_redacted(std::string_view key) {
+    std::string lower(key);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const char* field : {"password", "api_key", "secret", "token", "email"}) {
+        if (lower.find(field) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The DOM-based format_json_log used before the streaming writer
+static std::string reference_json_log(const JsonLogRecord& record) {
+    json log_entry;
+    log_entry["timestamp"] = record.timestamp;
+    log_entry["level"] = record.level;
+    log_entry["component"] = record.component;
+    log_entry["message"] = record.message;
+    if (!record.tenant_id.empty()) log_entry["tenant_id"] = record.tenant_id;
+    if (!record.run_id.empty()) log_entry["run_id"] = record.run_id;
+    if (!record.flow_id.empty()) log_entry["flow_id"] = record.flow_id;
+    if (!record.step_id.empty()) log_entry["step_id"] = record.step_id;
+    if (!record.trace_id.empty()) log_entry["trace_id"] = record.trace_id;
+    json context_obj;
+    context_obj["worker_id"] = record.worker_id;
+    for (const auto& [key, value] : *record.context) {
+        context_obj[key] = test_redacted(key) ? "[REDACTED]" : value;
+    }
+    log_entry["context"] = context_obj;
+    return log_entry.dump();
+}
+
+void test_streaming_format_matches_dom() {
+    std::cout << "Testing streaming log format is byte-identical to json::dump()..." << std::endl;
+    
+    std::vector<std::string> messages = {
+        "plain",
+        "",
+        "quotes \"q\" and \\backslash\\ and /slash",
+        "controls \b\f\n\r\t \x01\x1f \x7f",
+        std::string("embedded\0null", 13),
+        "unicode: 你好世界 é 😀"
+    };
+    std::vector<std::unordered_map<std::string, std::string>> contexts = {
+        {},
+        {{"block_type", "http.request"}, {"status", "ok"}},
+        {{"API_KEY", "sk-1"}, {"user_email", "a@b"}, {"zeta", "last"}, {"Alpha", "first"}, {"retry\n", "x"}},
+        {{"worker_id", "override"}, {"worker", "before"}, {"worker_idx", "after"}, {"password", "p\"w"}}
+    };
+    
+    for (const auto& message : messages) {
+        for (const auto& context : contexts) {
+            for (bool with_ids : {true, false}) {
+                JsonLogRecord record;
+                record.timestamp = "2024-01-02T03:04:05.123456Z";
+                record.level = "INFO";
+                record.component = "worker";
+                record.message = message;
+                record.worker_id = "worker_1";
+                record.context = &context;
+                if (with_ids) {
+                    record.tenant_id = "tenant_\"1\"";
+                    record.run_id = "run_abc";
+                    record.flow_id = "flow_xyz";
+                    record.step_id = "step_001";
+                    record.trace_id = "trace_def";
+                }
+                
+                std::string streamed;
+                append_json_log(streamed, record, test_redacted);
+                assert(streamed == reference_json_log(record));
+            }
+        }
+    }
+    
+    // dump() throws on invalid UTF-8; the streaming writer substitutes U+FFFD
+    std::string invalid;
+    append_json_log_string(invalid, "a\xff\xc3(\xed\xa0\x80" "b\xc3\xa9");
+    const std::string replacement = "\xef\xbf\xbd";
+    assert(invalid == "\"a" + replacement + replacement + "(" + replacement + replacement + replacement +
+                      "b\xc3\xa9\"");
+    
+    // Appending into a reused buffer keeps its capacity
+    std::string buffer;
+    std::unordered_map<std::string, std::string> context = contexts[2];
+    JsonLogRecord record;
+    record.message = "reuse";
+    record.context = &context;
+    append_json_log(buffer, record, test_redacted);
+    size_t capacity = buffer.capacity();
+    buffer.clear();
+    append_json_log(buffer, record, test_redacted);
+    assert(buffer.capacity() == capacity);
+    assert(buffer.find("\"API_KEY\":\"[REDACTED]\"") != std::string::npos);
+    
+    std::cout << "✓ Streaming log format test passed" << std::endl;
+}
+
+static bool naive_contains_pattern(const std::string& key, const std::vector<std::string>& patterns) {
+    std::string lower = key;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const auto& pattern : patterns) {
+        std::string lower_pattern = pattern;
+        std::transform(lower_pattern.begin(), lower_pattern.end(), lower_pattern.begin(), ::tolower);
+        if (!lower_pattern.empty() && lower.find(lower_pattern) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_pii_matcher() {
+    std::cout << "Testing precompiled PII matcher..." << std::endl;
+    
+    const auto& matcher = PiiMatcher::instance();
+    assert(matcher.matches("password"));
+    assert(matcher.matches("User_Password_Hash"));
+    assert(matcher.matches("X-API_KEY"));
+    assert(matcher.matches("contact.email"));
+    assert(matcher.matches("tokens"));
+    assert(!matcher.matches(""));
+    assert(!matcher.matches("block_type"));
+    assert(!matcher.matches("api-key"));
+    assert(!matcher.matches("passwor"));
+    
+    // Same answers as a lowercase substring scan, including overlapping patterns
+    std::vector<std::string> patterns = {"he", "she", "his", "hers", "A_b", "ssn", "\xc3\xa9"};
+    PiiMatcher custom(patterns);
+    std::vector<std::string> keys = {"ushers", "SHE", "hi", "this", "a_B", "xa_bx", "ssssn", "ss_n",
+                                     "caf\xc3\xa9", "caf\xc3", "", "h", "HeRs"};
+    const std::string alphabet = "aAbBeEhHirsSn_\xc3\xa9";
+    for (size_t i = 0; i < 20000; i++) {
+        std::string key;
+        for (size_t n = i; n > 0; n /= alphabet.size()) {
+            key.push_back(alphabet[n % alphabet.size()]);
+        }
+        keys.push_back(key);
+    }
+    for (const auto& key : keys) {
+        assert(custom.matches(key) == naive_contains_pattern(key, patterns));
+    }
+    
+    auto parsed = PiiMatcher::parse_list(" password, api_key,,ssn ,");
+    assert((parsed == std::vector<std::string>{"password", "api_key", "ssn"}));
+    assert(PiiMatcher::parse_list("").empty());
+    
+    std::cout << "✓ PII matcher test passed" << std::endl;
+}
+
+void test_log_sampling() {
+    std::cout << "Testing per-message log sampling..." << std::endl;
+    
+    auto config = LogSampler::parse_rules("Step execution started=1/10; Burst=5/s ;Both = 1/2, 1000/s");
+    assert(config.rules.size() == 3);
+    assert(config.rules.at("Step execution started").one_in == 10);
+    assert(config.rules.at("Burst").per_second == 5);
+    assert(config.rules.at("Both").one_in == 2 && config.rules.at("Both").per_second == 1000);
+    auto once_per_second = LogSampler::parse_rules("X=1/s").rules.at("X");
+    assert(once_per_second.per_second == 1 && once_per_second.one_in == 1);
+    for (const char* invalid : {"no_spec", "=1/10", "X=1/0", "X=10", "X=fast/s", "X=1/10x"}) {
+        bool threw = false;
+        try {
+            LogSampler::parse_rules(invalid);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    assert(LogSampler::parse_rules("").rules.empty());
+    
+    LogSampler sampler(config);
+    
+    // 1-in-N: every kept line after the first reports the N-1 lines dropped before it
+    int kept = 0;
+    for (int i = 0; i < 100; i++) {
+        auto decision = sampler.admit("Step execution started");
+        if (decision.keep) {
+            assert(decision.suppressed == (kept == 0 ? 0u : 9u));
+            kept++;
+        }
+    }
+    assert(kept == 10);
+    
+    // Unconfigured templates are never sampled
+    for (int i = 0; i < 100; i++) {
+        auto decision = sampler.admit("Other message");
+        assert(decision.keep && decision.suppressed == 0);
+    }
+    
+    // Token bucket: a burst of `per_second` lines, then refills over time
+    kept = 0;
+    for (int i = 0; i < 50; i++) {
+        kept += sampler.admit("Burst").keep;
+    }
+    assert(kept == 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(450));
+    auto refilled = sampler.admit("Burst");
+    assert(refilled.keep);
+    assert(refilled.suppressed == 45);
+    
+    // The count is written as a top-level field of the kept line
+    std::unordered_map<std::string, std::string> context;
+    JsonLogRecord record;
+    record.level = "INFO";
+    record.message = "Burst";
+    record.step_id = "step_1";
+    record.context = &context;
+    record.suppressed = refilled.suppressed;
+    std::string line;
+    append_json_log(line, record, nullptr);
+    assert(line.find(R"("step_id":"step_1","suppressed":45,"timestamp")") != std::string::npos);
+    assert(json::parse(line)["suppressed"] == 45);
+    
+    std::cout << "✓ Log sampling test passed" << std::endl;
+}
+
+void test_log_level_threshold() {
+    std::cout << "Testing log level threshold..." << std::endl;
+    
+    assert(parse_log_level("DEBUG") == LogLevel::debug);
+    assert(parse_log_level("warning") == LogLevel::warn);
+    assert(!parse_log_level("verbose"));
+    
+    assert(!Observability::is_log_enabled(LogLevel::debug)); // Default threshold is info
+    assert(Observability::is_log_enabled(LogLevel::info));
+    Observability::set_log_level(LogLevel::error);
+    assert(!Observability::is_log_enabled(LogLevel::warn));
+    assert(Observability::is_log_enabled(LogLevel::error));
+    Observability::set_log_level(LogLevel::info);
+    
+    std::cout << "✓ Log level threshold test passed" << std::endl;
+}
+
+void test_metrics_response() {
+    std::cout << "Testing metrics response..." << std::endl;
+    
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "true", 1);
+    FeatureFlags::reload();
+    
+    auto observability = std::make_unique<Observability>("test_worker");
+    observability->record_step_execution("http.request", "success", "tenant_1", "run_1", "flow_1", "step_1");
+    observability->record_step_execution("http.request", "success", "tenant_1", "run_2", "flow_1", "step_2");
+    observability->record_step_execution_duration("http.request", "success", 0.02, "tenant_1");
+    observability->record_step_error("fs.blob_get", "NOT_FOUND");
+    observability->set_queue_depth("cpu", 3);
+    observability->set_executor_counts("cpu", 6, 2);
+    observability->set_pool_queue_depth(ResourceClass::io, 5);
+    observability->increment_task_total("http.request", "ok");
+    observability->record_queue_time("cpu", 0.2, 0.8);
+    observability->set_tenant_queue_depth("io", "tenant_1", 7);
+    observability->add_tenant_usage("io", "tenant_1", 41.6);
+    observability->add_tenant_resource_usage("tenant_1", 2500000, 4096);
+    observability->set_tenant_throttled("io", "tenant_1", true);
+    
+    std::string response = observability->get_metrics_response();
+    assert(response.find("# TYPE worker_step_executions_total counter\n") != std::string::npos);
+    assert(response.find("worker_step_executions_total{step_type=\"http.request\",execution_status=\"success\","
+                         "tenant_id=\"tenant_1\"} 2\n") != std::string::npos);
+    assert(response.find("worker_step_execution_duration_seconds_bucket{step_type=\"http.request\","
+                         "execution_status=\"success\",tenant_id=\"tenant_1\",le=\"0.05\"} 1\n") != std::string::npos);
+    assert(response.find("worker_step_errors_total{step_type=\"fs.blob_get\",error_code=\"NOT_FOUND\"} 1\n") != std::string::npos);
+    assert(response.find("worker_queue_depth{resource_pool=\"cpu\"} 3\n") != std::string::npos);
+    assert(response.find("worker_executors{resource_pool=\"cpu\"} 6\n") != std::string::npos);
+    assert(response.find("worker_idle_executors{resource_pool=\"cpu\"} 2\n") != std::string::npos);
+    // The shared set is recorded into by instances with different ids, so it has no worker_id label
+    assert(response.find("worker_pool_queue_depth{resource_class=\"io\"} 5\n") != std::string::npos);
+    assert(response.find("worker_tasks_total{block_type=\"http.request\",status=\"ok\"} 1\n") != std::string::npos);
+    assert(response.find("worker_step_queue_wait_seconds_bucket{resource_pool=\"cpu\",le=\"0.5\"} 1\n") != std::string::npos);
+    assert(response.find("worker_step_queue_time_ratio_bucket{resource_pool=\"cpu\",le=\"0.75\"} 0\n") != std::string::npos);
+    assert(response.find("worker_step_queue_time_ratio_bucket{resource_pool=\"cpu\",le=\"0.9\"} 1\n") != std::string::npos);
+    assert(response.find("worker_tenant_queue_depth{resource_pool=\"io\",tenant_id=\"tenant_1\"} 7\n") != std::string::npos);
+    assert(response.find("worker_tenant_usage_ms_total{resource_pool=\"io\",tenant_id=\"tenant_1\"} 42\n") != std::string::npos);
+    assert(response.find("worker_tenant_cpu_time_us_total{tenant_id=\"tenant_1\"} 2500\n") != std::string::npos);
+    assert(response.find("worker_tenant_allocated_bytes_total{tenant_id=\"tenant_1\"} 4096\n") != std::string::npos);
+    assert(response.find("worker_tenant_throttled{resource_pool=\"io\",tenant_id=\"tenant_1\"} 1\n") != std::string::npos);
+    
+    // A private set keeps its worker_id label
+    Observability isolated("isolated_worker", std::make_shared<Observability::Metrics>("isolated_worker"));
+    isolated.set_pool_queue_depth(ResourceClass::io, 2);
+    assert(isolated.get_metrics_response().find(
+        "worker_pool_queue_depth{worker_id=\"isolated_worker\",resource_class=\"io\"} 2\n") != std::string::npos);
+    
+    // Per-run identifiers are exemplars, not labels
+    assert(response.find("run_") == std::string::npos);
+    assert(response.find("step_id") == std::string::npos);
+    
+    // OpenMetrics carries them as exemplars
+    std::string openmetrics = observability->get_metrics_response(MetricsRegistry::Format::openmetrics);
+    assert(openmetrics.find("# TYPE worker_step_executions counter\n") != std::string::npos);
+    assert(openmetrics.find("tenant_id=\"tenant_1\"} 2 # {run_id=\"run_2\",flow_id=\"flow_1\",step_id=\"step_2\"} 1 ")
+           != std::string::npos);
+    assert(openmetrics.compare(openmetrics.size() - 6, 6, "# EOF\n") == 0);
+    
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    FeatureFlags::reload();
+    assert(observability->get_metrics_response().empty());
+    
+    std::cout << "✓ Metrics response test passed" << std::endl;
+}
+
+void test_metrics_response_cache() {
+    std::cout << "Testing metrics response cache..." << std::endl;
+    
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "true", 1);
+    FeatureFlags::reload();
+    
+    auto observability = std::make_unique<Observability>("test_worker");
+    observability->set_queue_depth("cpu", 1);
+    std::string first = observability->get_metrics_response();
+    observability->set_queue_depth("cpu", 2);
+    
+    // Without a cache window every scrape renders afresh
+    assert(observability->get_metrics_response().find("worker_queue_depth{resource_pool=\"cpu\"} 2\n") != std::string::npos);
+    
+    // Within the window scrapes share the last render, per format
+    observability->set_metrics_cache_ms(200);
+    std::string cached = observability->get_metrics_response();
+    observability->set_queue_depth("cpu", 3);
+    assert(observability->get_metrics_response() == cached);
+    assert(observability->get_metrics_response(MetricsRegistry::Format::openmetrics)
+               .find("worker_queue_depth{resource_pool=\"cpu\"} 3\n") != std::string::npos);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    assert(observability->get_metrics_response().find("worker_queue_depth{resource_pool=\"cpu\"} 3\n") != std::string::npos);
+    
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    FeatureFlags::reload();
+    
+    std::cout << "✓ Metrics response cache test passed" << std::endl;
+}
+
+void test_metrics_collectors() {
+    std::cout << "Testing metrics sampled at scrape time..." << std::endl;
+    
+    setenv("CP2_OBSERVABILITY_METRICS_ENABLED", "true", 1);
+    FeatureFlags::reload();
+    
+    Observability observability("test_worker", std::make_shared<Observability::Metrics>("test_worker"));
+    int64_t requests = 10;
+    observability.add_metrics_collector([&requests](Observability& metrics) {
+        metrics.set_http_pool_stats(requests, requests / 2, 3, 2, 0.75);
+    });
+    observability.add_metrics_collector([&requests](Observability& metrics) {
+        metrics.set_blocking_io_stats(7, 4, static_cast<uint64_t>(requests / 5), 1, 250, 2);
+    });
+    observability.add_metrics_collector([&requests](Observability& metrics) {
+        metrics.set_logger_stats(static_cast<uint64_t>(requests * 100), static_cast<uint64_t>(requests - 10), 12);
+    });
+    
+    std::string first = observability.get_metrics_response();
+    assert(first.find("worker_http_requests_total 10\n") != std::string::npos);
+    assert(first.find("worker_http_reused_connections_total 5\n") != std::string::npos);
+    assert(first.find("worker_http_connection_reuse_ratio 0.5\n") != std::string::npos);
+    assert(first.find("worker_http_active_transfers 3\n") != std::string::npos);
+    assert(first.find("worker_http_idle_handles 2\n") != std::string::npos);
+    assert(first.find("worker_http_pool_occupancy 0.75\n") != std::string::npos);
+    assert(first.find("worker_queue_depth{resource_pool=\"blocking_io\"} 9\n") != std::string::npos);
+    assert(first.find("worker_active_tasks{resource_pool=\"blocking_io\"} 4\n") != std::string::npos);
+    assert(first.find("worker_blocking_io_expired_total 2\n") != std::string::npos);
+    assert(first.find("worker_blocking_io_rejected_total 1\n") != std::string::npos);
+    assert(first.find("worker_blocking_io_max_queue_wait_ms 250\n") != std::string::npos);
+    assert(first.find("worker_blocking_io_abandoned 2\n") != std::string::npos);
+    assert(first.find("worker_log_lines_written_total 1000\n") != std::string::npos);
+    assert(first.find("worker_log_lines_dropped_total 0\n") != std::string::npos);
+    assert(first.find("worker_log_write_calls_total 12\n") != std::string::npos);
+    
+    // Totals kept by the component become counters that advance by what they grew
+    requests = 16;
+    std::string second = observability.get_metrics_response();
+    assert(second.find("worker_http_requests_total 16\n") != std::string::npos);
+    assert(second.find("worker_http_reused_connections_total 8\n") != std::string::npos);
+    assert(second.find("worker_blocking_io_expired_total 3\n") != std::string::npos);
+    assert(second.find("worker_blocking_io_rejected_total 1\n") != std::string::npos);
+    assert(second.find("worker_log_lines_written_total 1600\n") != std::string::npos);
+    assert(second.find("worker_log_lines_dropped_total 6\n") != std::string::npos);
+    
+    unsetenv("CP2_OBSERVABILITY_METRICS_ENABLED");
+    FeatureFlags::reload();
+    
+    std::cout << "✓ Scrape-time metrics test passed" << std::endl;
+}
+
 int main() {
     std::cout << "=== Worker Observability Unit Tests ===" << std::endl;
     std::cout << std::endl;
@@ -333,6 +722,12 @@ int main() {
         test_cp1_fields_at_top_level();
         test_cp1_fields_with_context();
         test_pii_filtering();
+        test_pii_matcher();
+        test_log_sampling();
+        test_log_level_threshold();
+        test_metrics_response();
+        test_metrics_response_cache();
+        test_metrics_collectors();
         test_all_log_levels();
         test_health_endpoint_response();
         test_context_object_structure();
@@ -348,6 +743,7 @@ int main() {
         test_special_characters();
         test_very_large_context();
         test_invalid_json_in_context();
+        test_streaming_format_matches_dom();
         
         std::cout << std::endl;
         std::cout << "=== All Tests Passed ===" << std::endl;
@@ -0,0 +1,361 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include "beamline/worker/core.hpp"
+#include "beamline/worker/sqlite_pool.hpp"
+#include "beamline/worker/sql_result_encoder.hpp"
+#include "beamline/worker/blocks/sql_block.hpp"
+
+using namespace beamline::worker;
+
+static const std::string TEST_DIR = "/tmp/beamline/test_sql_block/";
+
+static StepRequest make_query(const std::string& db, const std::string& query, const std::string& params = "") {
+    StepRequest req;
+    req.type = "sql.query";
+    req.inputs["connection"] = db;
+    req.inputs["query"] = query;
+    if (!params.empty()) {
+        req.inputs["params"] = params;
+    }
+    return req;
+}
+
+void test_pool_reuses_handles_and_statements() {
+    std::cout << "Testing pooled handles and statement cache..." << std::endl;
+
+    std::filesystem::remove_all(TEST_DIR);
+    std::filesystem::create_directories(TEST_DIR);
+    std::string db = TEST_DIR + "pool.db";
+    SqliteConnectionPool::Config config;
+    config.statement_cache_size = 2;
+    SqliteConnectionPool pool(config);
+
+    {
+        auto lease = pool.acquire(db);
+        sqlite3_stmt* stmt = lease->prepare("PRAGMA journal_mode");
+        assert(sqlite3_step(stmt) == SQLITE_ROW);
+        assert(std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))) == "wal");
+        SqliteConnection::release(stmt);
+        assert(lease->prepare("PRAGMA journal_mode") == stmt);
+    }
+    {
+        // Same handle comes back; the LRU evicts the oldest statement beyond capacity
+        auto lease = pool.acquire(db);
+        assert(lease->cached_statements() == 1);
+        lease->prepare("SELECT 1");
+        lease->prepare("SELECT 2");
+        assert(lease->cached_statements() == 2);
+        lease->prepare("PRAGMA journal_mode");
+        assert(lease->cache_misses() == 4);
+    }
+
+    auto stats = pool.stats();
+    assert(stats.opened == 1);
+    assert(stats.reused == 1);
+    assert(stats.statement_hits == 1);
+    assert(stats.statement_misses == 4);
+    assert(stats.idle == 1);
+
+    // In-memory databases are private per handle and never pooled
+    {
+        auto lease = pool.acquire(":memory:");
+    }
+    assert(pool.stats().opened == 2);
+    assert(pool.stats().idle == 1);
+
+    std::cout << "✓ Pool test passed" << std::endl;
+}
+
+void test_params_binding() {
+    std::cout << "Testing params binding..." << std::endl;
+
+    std::string db = TEST_DIR + "params.db";
+    SqlBlockExecutor executor;
+
+    auto created = executor.execute(make_query(db, "CREATE TABLE IF NOT EXISTS items (id INTEGER, name TEXT, price REAL)"),
+                                    BlockContext{});
+    assert(created && created->is_success());
+
+    auto inserted = executor.execute(make_query(db, "INSERT INTO items VALUES (?, ?, ?)", R"([1, "it's \"quoted\"", 2.5])"),
+                                     BlockContext{});
+    assert(inserted && inserted->is_success());
+    assert(inserted->outputs.at("affected_rows") == "1");
+
+    inserted = executor.execute(make_query(db, "INSERT INTO items VALUES (:id, :name, :price)",
+                                           R"({"id": 2, "name": "second", "price": null})"),
+                                BlockContext{});
+    assert(inserted && inserted->is_success());
+
+    auto selected = executor.execute(make_query(db, "SELECT name FROM items WHERE id = ?", "[2]"), BlockContext{});
+    assert(selected && selected->is_success());
+    assert(selected->outputs.at("row_count") == "1");
+    assert(selected->outputs.at("rows").find("second") != std::string::npos);
+
+    // Reusing the cached statement must not keep the previous binding
+    selected = executor.execute(make_query(db, "SELECT name FROM items WHERE id = ?", "[1]"), BlockContext{});
+    assert(selected && selected->is_success());
+    assert(selected->outputs.at("rows").find("second") == std::string::npos);
+
+    auto wrong_count = executor.execute(make_query(db, "SELECT name FROM items WHERE id = ?", "[1, 2]"), BlockContext{});
+    assert(wrong_count && wrong_count->error_code == ErrorCode::invalid_input);
+
+    auto bad_json = executor.execute(make_query(db, "SELECT name FROM items WHERE id = ?", "[1,"), BlockContext{});
+    assert(bad_json && bad_json->error_code == ErrorCode::invalid_input);
+
+    auto unknown = executor.execute(make_query(db, "SELECT name FROM items WHERE id = :id", R"({"other": 1})"),
+                                    BlockContext{});
+    assert(unknown && unknown->error_code == ErrorCode::invalid_input);
+
+    auto syntax = executor.execute(make_query(db, "SELEKT 1"), BlockContext{});
+    assert(syntax && syntax->error_code == ErrorCode::execution_failed);
+
+    std::cout << "✓ Params binding test passed" << std::endl;
+}
+
+static std::string decode_base64(const std::string& text) {
+    static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (char c : text) {
+        if (c == '=') {
+            break;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(alphabet.find(c));
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            out.push_back(static_cast<char>((bits >> bit_count) & 0xFF));
+        }
+    }
+    return out;
+}
+
+static uint64_t read_varint(const std::string& data, size_t& pos) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (true) {
+        auto byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+void test_result_formats() {
+    std::cout << "Testing result encoder formats..." << std::endl;
+
+    std::string db = TEST_DIR + "formats.db";
+    SqlBlockExecutor executor;
+    executor.execute(make_query(db, "CREATE TABLE t (id INTEGER, name TEXT, score REAL, data BLOB)"), BlockContext{});
+    executor.execute(make_query(db, "INSERT INTO t VALUES (-3, 'a\"b\\c' || char(10), 1.5, x'00ff10')"), BlockContext{});
+    executor.execute(make_query(db, "INSERT INTO t VALUES (7, NULL, NULL, NULL)"), BlockContext{});
+
+    std::string select = "SELECT id, name, score, data FROM t ORDER BY rowid";
+    auto rows = executor.execute(make_query(db, select), BlockContext{});
+    assert(rows && rows->is_success());
+    assert(rows->outputs.at("rows").substr(0, 31) == R"([{"id":"-3","name":"a\"b\\c\n",)");
+    assert(rows->outputs.at("rows").find(R"({"id":"7"})") != std::string::npos);
+
+    auto req = make_query(db, select);
+    req.inputs["format"] = "columnar";
+    auto columnar = executor.execute(req, BlockContext{});
+    assert(columnar && columnar->is_success());
+    assert(columnar->outputs.at("rows") ==
+           R"({"columns":["id","name","score","data"],"rows":[[-3,"a\"b\\c\n",1.5,"AP8Q"],[7,null,null,null]]})");
+    assert(columnar->outputs.at("row_count") == "2");
+
+    req.inputs["format"] = "binary";
+    auto binary = executor.execute(req, BlockContext{});
+    assert(binary && binary->is_success());
+    // Returned in the serialized outputs, base64-encoded
+    assert(binary->blobs.empty());
+    std::string data = decode_base64(binary->outputs.at("rows"));
+    assert(data.substr(0, 4) == "BLSQ" && data[4] == 1);
+    size_t pos = 5;
+    assert(read_varint(data, pos) == 4);
+    for (int i = 0; i < 4; i++) {
+        pos += read_varint(data, pos);
+    }
+    assert(data[pos++] == 1);                // row marker
+    assert(data[pos++] == 1);                // integer
+    assert(read_varint(data, pos) == 5);     // zigzag(-3)
+    assert(data[pos++] == 3);                // text
+    assert(read_varint(data, pos) == 6);
+    pos += 6;
+    assert(data[pos++] == 2);                // float
+    pos += 8;
+    assert(data[pos++] == 4);                // blob
+    assert(read_varint(data, pos) == 3);
+    pos += 3;
+    assert(data[pos++] == 1);                // second row
+    assert(data[pos++] == 1 && read_varint(data, pos) == 14);
+    assert(data[pos++] == 0 && data[pos++] == 0 && data[pos++] == 0);
+    assert(data[pos++] == 0);                // end of result
+    assert(pos == data.size());
+    assert(binary->outputs.at("rows_size") == std::to_string(data.size()));
+
+    req.inputs["format"] = "xml";
+    auto invalid = executor.execute(req, BlockContext{});
+    assert(invalid && invalid->error_code == ErrorCode::invalid_input);
+
+    std::cout << "✓ Result format test passed" << std::endl;
+}
+
+void test_max_rows_cursor() {
+    std::cout << "Testing max_rows paging with a cursor..." << std::endl;
+
+    std::string db = TEST_DIR + "paging.db";
+    SqlBlockExecutor executor;
+    executor.execute(make_query(db, "CREATE TABLE n (v INTEGER)"), BlockContext{});
+    executor.execute(make_query(db, "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 25) "
+                                    "INSERT INTO n SELECT x FROM c"), BlockContext{});
+
+    auto req = make_query(db, "SELECT v FROM n ORDER BY v");
+    req.inputs["format"] = "columnar";
+    req.inputs["max_rows"] = "10";
+
+    std::string seen;
+    int pages = 0;
+    while (true) {
+        auto page = executor.execute(req, BlockContext{});
+        assert(page && page->is_success());
+        pages++;
+        seen += page->outputs.at("rows");
+        if (page->outputs.at("has_more") == "false") {
+            assert(page->outputs.at("row_count") == "5");
+            assert(page->outputs.count("cursor") == 0);
+            break;
+        }
+        assert(page->outputs.at("row_count") == "10");
+        req.inputs["cursor"] = page->outputs.at("cursor");
+    }
+    assert(pages == 3);
+    assert(seen.find("[[1],[2]") != std::string::npos);
+    assert(seen.find("[25]]") != std::string::npos);
+
+    std::cout << "✓ Paging test passed" << std::endl;
+}
+
+void test_cursor_requires_read_only_query() {
+    std::cout << "Testing cursor restrictions..." << std::endl;
+
+    std::string db = TEST_DIR + "paging.db";
+    SqlBlockExecutor executor;
+
+    // A write is never paged, so it cannot run again per page
+    auto insert = make_query(db, "INSERT INTO n VALUES (100)");
+    insert.inputs["max_rows"] = "1";
+    auto rejected = executor.execute(insert, BlockContext{});
+    assert(rejected && rejected->error_code == ErrorCode::invalid_input);
+    auto count = executor.execute(make_query(db, "SELECT COUNT(*) AS c FROM n WHERE v = 100"), BlockContext{});
+    assert(count && count->outputs.at("rows") == "[{\"c\":\"0\"}]");
+
+    // A cursor continues only the query it was issued for
+    auto req = make_query(db, "SELECT v FROM n ORDER BY v");
+    req.inputs["max_rows"] = "10";
+    auto first = executor.execute(req, BlockContext{});
+    assert(first && first->is_success() && first->outputs.at("has_more") == "true");
+    auto other = make_query(db, "SELECT v FROM n ORDER BY v DESC");
+    other.inputs["cursor"] = first->outputs.at("cursor");
+    auto mismatched = executor.execute(other, BlockContext{});
+    assert(mismatched && mismatched->error_code == ErrorCode::invalid_input);
+
+    // ...and each token only once
+    req.inputs["cursor"] = first->outputs.at("cursor");
+    auto second = executor.execute(req, BlockContext{});
+    assert(second && second->is_success() && second->outputs.at("row_count") == "10");
+    auto replayed = executor.execute(req, BlockContext{});
+    assert(replayed && replayed->error_code == ErrorCode::invalid_input);
+
+    std::cout << "✓ Cursor restriction test passed" << std::endl;
+}
+
+void test_cursor_table_bounds() {
+    std::cout << "Testing cursor table expiry and capacity..." << std::endl;
+
+    SqlCursorTable::Config config;
+    config.max_cursors = 2;
+    config.idle_timeout_ms = 1000;
+    SqlCursorTable table(config);
+    auto now = SqlCursorTable::Clock::now();
+
+    auto make_cursor = [](const std::string& key) {
+        auto cursor = std::make_unique<SqlCursorTable::Cursor>();
+        cursor->key = key;
+        return cursor;
+    };
+
+    // Beyond capacity the cursor closest to expiry is closed
+    std::string a = table.park(make_cursor("a"), now);
+    std::string b = table.park(make_cursor("b"), now + std::chrono::milliseconds(10));
+    std::string c = table.park(make_cursor("c"), now + std::chrono::milliseconds(20));
+    assert(table.size() == 2);
+    assert(!table.take(a, "a", now + std::chrono::milliseconds(30)));
+    assert(!table.take(b, "c", now + std::chrono::milliseconds(30)));
+    assert(table.take(b, "b", now + std::chrono::milliseconds(30)));
+
+    // An idle cursor is closed once its timeout passes
+    assert(!table.take(c, "c", now + std::chrono::milliseconds(1020)));
+    assert(table.size() == 0);
+
+    std::cout << "✓ Cursor table test passed" << std::endl;
+}
+
+void test_encoder_reuses_buffer() {
+    std::cout << "Testing encoder buffer reuse..." << std::endl;
+
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    SqliteConnection connection(db, 4);
+    SqlResultEncoder encoder;
+
+    auto run = [&](const std::string& sql) {
+        sqlite3_stmt* stmt = connection.prepare(sql);
+        encoder.begin(SqlResultEncoder::Format::columnar, stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            encoder.add_row(stmt);
+        }
+        encoder.finish();
+        SqliteConnection::release(stmt);
+    };
+
+    run("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000) SELECT x, 'row' FROM c");
+    size_t capacity = encoder.capacity();
+    assert(encoder.row_count() == 1000);
+    run("SELECT 1");
+    assert(encoder.capacity() == capacity);
+    assert(encoder.buffer() == R"({"columns":["1"],"rows":[[1]]})");
+
+    std::cout << "✓ Buffer reuse test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== SQL Block Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_pool_reuses_handles_and_statements();
+        test_params_binding();
+        test_result_formats();
+        test_max_rows_cursor();
+        test_cursor_requires_read_only_query();
+        test_cursor_table_bounds();
+        test_encoder_reuses_buffer();
+
+        std::filesystem::remove_all(TEST_DIR);
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,287 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "beamline/worker/tenant_fair_queue.hpp"
+
+using namespace beamline::worker;
+
+using Clock = std::chrono::steady_clock;
+
+// Pops `count` steps, settling each at its tenant's cost; returns steps served per tenant
+static std::map<std::string, int> serve(TenantFairQueue<int>& queue, int count,
+                                        const std::map<std::string, double>& cost_ms) {
+    std::map<std::string, int> served;
+    for (int i = 0; i < count && queue.has_ready(); i++) {
+        std::string tenant;
+        double estimate = 0;
+        queue.pop(tenant, estimate);
+        queue.charge(tenant, estimate, cost_ms.at(tenant));
+        served[tenant]++;
+    }
+    return served;
+}
+
+void test_parse_weights() {
+    std::cout << "Testing tenant weight parsing..." << std::endl;
+
+    auto weights = parse_tenant_weights(" gold=4, silver=2.5 ,*=0.5,");
+    assert(weights.size() == 3);
+    assert(weights.at("gold") == 4.0);
+    assert(weights.at("silver") == 2.5);
+    assert(weights.at("*") == 0.5);
+    assert(parse_tenant_weights("").empty());
+
+    for (const char* invalid : {"gold", "=2", "gold=0", "gold=-1", "gold=x", "gold=2x"}) {
+        bool threw = false;
+        try {
+            parse_tenant_weights(invalid);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    TenantFairQueue<int> queue(weights);
+    assert(queue.weight("gold") == 4.0);
+    assert(queue.weight("bronze") == 0.5);
+
+    std::cout << "✓ Tenant weight parsing test passed" << std::endl;
+}
+
+void test_noisy_tenant_does_not_starve_others() {
+    std::cout << "Testing a noisy tenant does not starve others..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue;
+    for (int i = 0; i < 1000; i++) {
+        queue.push("noisy", i, StepPriority::normal, Clock::time_point::max(), now);
+    }
+    for (int i = 0; i < 10; i++) {
+        queue.push("quiet", i, StepPriority::normal, Clock::time_point::max(), now);
+    }
+    assert(queue.size() == 1010);
+    assert(queue.size("quiet") == 10);
+
+    // The quiet tenant's steps are served alongside, not after, the noisy backlog
+    auto served = serve(queue, 20, {{"noisy", 10.0}, {"quiet", 10.0}});
+    assert(served["quiet"] == 10);
+    assert(served["noisy"] == 10);
+
+    std::cout << "✓ Noisy tenant test passed" << std::endl;
+}
+
+void test_weighted_shares() {
+    std::cout << "Testing weighted shares..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue({{"gold", 3.0}, {"bronze", 1.0}});
+    for (int i = 0; i < 2000; i++) {
+        queue.push("gold", i, StepPriority::normal, Clock::time_point::max(), now);
+        queue.push("bronze", i, StepPriority::normal, Clock::time_point::max(), now);
+    }
+
+    auto served = serve(queue, 1000, {{"gold", 10.0}, {"bronze", 10.0}});
+    std::cout << "  gold=" << served["gold"] << " bronze=" << served["bronze"] << std::endl;
+    assert(std::abs(served["gold"] - 750) <= 20);
+    assert(std::abs(served["bronze"] - 250) <= 20);
+
+    std::cout << "✓ Weighted share test passed" << std::endl;
+}
+
+void test_usage_based_fairness() {
+    std::cout << "Testing shares follow measured cost..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue;
+    for (int i = 0; i < 2000; i++) {
+        queue.push("heavy", i, StepPriority::normal, Clock::time_point::max(), now);
+        queue.push("light", i, StepPriority::normal, Clock::time_point::max(), now);
+    }
+
+    // Equal weights: both get about the same executor time, so 4x more light steps
+    auto served = serve(queue, 1000, {{"heavy", 40.0}, {"light", 10.0}});
+    double heavy_usage = queue.usage_ms("heavy");
+    double light_usage = queue.usage_ms("light");
+    std::cout << "  heavy=" << served["heavy"] << " (" << heavy_usage << " ms) light=" << served["light"]
+              << " (" << light_usage << " ms)" << std::endl;
+    assert(served["light"] > 3 * served["heavy"]);
+    assert(std::abs(heavy_usage - light_usage) / (heavy_usage + light_usage) < 0.1);
+
+    std::cout << "✓ Usage-based fairness test passed" << std::endl;
+}
+
+void test_order_within_tenant() {
+    std::cout << "Testing priority and deadline order within a tenant..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue;
+    queue.push("t", 1, StepPriority::low, now, now);
+    queue.push("t", 2, StepPriority::normal, now + std::chrono::seconds(5), now);
+    queue.push("t", 3, StepPriority::normal, now + std::chrono::seconds(1), now);
+    queue.push("t", 4, StepPriority::high, Clock::time_point::max(), now);
+
+    std::vector<int> order;
+    while (!queue.empty()) {
+        std::string tenant;
+        double estimate = 0;
+        order.push_back(queue.pop(tenant, estimate).value);
+        assert(tenant == "t");
+    }
+    assert((order == std::vector<int>{4, 3, 2, 1}));
+
+    std::cout << "✓ Order within tenant test passed" << std::endl;
+}
+
+void test_shed_for_arriving_tenant() {
+    std::cout << "Testing load shedding when the queue is full..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue;
+    for (int i = 0; i < 10; i++) {
+        queue.push("noisy", i, StepPriority::normal, now + std::chrono::seconds(i), now, "noisy" + std::to_string(i));
+    }
+
+    // A tenant alone is never shed for itself
+    assert(!queue.shed_for("noisy", [](const std::string&, auto&) { assert(false); }));
+
+    // A newcomer takes the noisy tenant's least urgent slot
+    std::string shed_tenant;
+    int shed_value = -1;
+    assert(queue.shed_for("quiet", [&](const std::string& tenant, auto& entry) {
+        shed_tenant = tenant;
+        shed_value = entry.value;
+    }));
+    assert(shed_tenant == "noisy");
+    assert(shed_value == 9);
+    assert(queue.size("noisy") == 9);
+    assert(queue.erase("noisy9") == 0); // Its key went with it
+
+    // Until the newcomer holds as many steps as the noisy tenant
+    for (int i = 0; i < 4; i++) {
+        queue.push("quiet", i, StepPriority::normal, now, now);
+        assert(queue.shed_for("quiet", [](const std::string&, auto&) {}));
+    }
+    assert(queue.size("noisy") == 5);
+    queue.push("quiet", 4, StepPriority::normal, now, now);
+    assert(!queue.shed_for("quiet", [](const std::string&, auto&) {}));
+
+    std::cout << "✓ Load shedding test passed" << std::endl;
+}
+
+void test_erase_across_tenants() {
+    std::cout << "Testing erase by key across tenants..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue;
+    queue.push("a", 1, StepPriority::normal, now, now, "step1");
+    queue.push("b", 2, StepPriority::normal, now, now, "step1");
+    queue.push("b", 3, StepPriority::normal, now, now, "step2");
+    queue.push("c", 4, StepPriority::normal, now, now);
+
+    std::vector<std::string> tenants;
+    assert(queue.erase("step1", [&tenants](const std::string& tenant, auto&) { tenants.push_back(tenant); }) == 2);
+    assert(tenants.size() == 2);
+    assert(queue.size() == 2);
+    assert(queue.size("a") == 0);
+    assert(queue.erase("step1") == 0);
+
+    // Tenant "a" left the round; the others are still served
+    auto served = serve(queue, 10, {{"b", 1.0}, {"c", 1.0}});
+    assert(served["b"] == 1 && served["c"] == 1);
+    assert(queue.empty());
+
+    std::cout << "✓ Erase across tenants test passed" << std::endl;
+}
+
+void test_throttled_tenant_is_skipped() {
+    std::cout << "Testing throttled tenants keep their backlog..." << std::endl;
+
+    auto now = Clock::now();
+    TenantFairQueue<int> queue;
+    for (int i = 0; i < 3; i++) {
+        queue.push("over", i, StepPriority::normal, now, now);
+    }
+    queue.set_throttled("over", true);
+    assert(queue.throttled("over"));
+    assert((queue.throttled_tenants() == std::vector<std::string>{"over"}));
+    assert(!queue.has_ready());
+    assert(queue.size() == 3);
+
+    // Other tenants are served; the throttled backlog waits
+    queue.push("other", 7, StepPriority::normal, now, now);
+    assert(queue.has_ready());
+    auto served = serve(queue, 10, {{"over", 10.0}, {"other", 10.0}});
+    assert(served["other"] == 1 && served.count("over") == 0);
+    assert(!queue.has_ready() && queue.size() == 3);
+
+    // Pushing while throttled does not rejoin the round
+    queue.push("over", 3, StepPriority::normal, now, now);
+    assert(!queue.has_ready());
+
+    queue.set_throttled("over", false);
+    assert(queue.throttled_tenants().empty());
+    served = serve(queue, 10, {{"over", 10.0}, {"other", 10.0}});
+    assert(served["over"] == 4);
+    assert(queue.empty());
+
+    std::cout << "✓ Throttled tenant test passed" << std::endl;
+}
+
+void test_quantum_decays_after_burst() {
+    std::cout << "Testing the quantum decays after a slow burst..." << std::endl;
+
+    TenantFairQueue<int> queue;
+    assert(queue.quantum_ms() == TenantFairQueue<int>::kInitialCostMs);
+
+    // A run of slow steps raises the quantum to cover them
+    for (int i = 0; i < 20; i++) {
+        queue.charge("slow", 1, 2000);
+    }
+    double raised = queue.quantum_ms();
+    assert(raised > 1000);
+
+    // Once the tenant's steps are cheap again, the quantum falls back to the floor
+    for (int i = 0; i < 1000; i++) {
+        queue.charge("slow", 1, 5);
+    }
+    assert(queue.quantum_ms() < raised / 10);
+    assert(queue.quantum_ms() >= TenantFairQueue<int>::kInitialCostMs);
+
+    // A tenant that stays expensive keeps it up
+    for (int i = 0; i < 1000; i++) {
+        queue.charge("steady", 1, 200);
+        queue.charge("slow", 1, 5);
+    }
+    assert(queue.quantum_ms() >= 190);
+
+    std::cout << "✓ Quantum decay test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Tenant Fair Queue Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_parse_weights();
+        test_noisy_tenant_does_not_starve_others();
+        test_weighted_shares();
+        test_usage_based_fairness();
+        test_order_within_tenant();
+        test_shed_for_arriving_tenant();
+        test_erase_across_tenants();
+        test_throttled_tenant_is_skipped();
+        test_quantum_decays_after_burst();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
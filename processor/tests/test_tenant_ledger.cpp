@@ -0,0 +1,235 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "beamline/worker/tenant_ledger.hpp"
+#include "beamline/worker/resource_meter.hpp"
+
+using namespace beamline::worker;
+
+using Clock = std::chrono::steady_clock;
+
+static TenantLedger::Config window_config(int64_t window_ms, size_t buckets) {
+    TenantLedger::Config config;
+    config.window_ms = window_ms;
+    config.buckets = buckets;
+    return config;
+}
+
+void test_meter_cpu_time() {
+    std::cout << "Testing thread CPU time measurement..." << std::endl;
+
+    ResourceMeter meter;
+    // Sleeping costs no CPU time; spinning does
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto slept = meter.elapsed();
+    volatile uint64_t sink = 0;
+    auto until = Clock::now() + std::chrono::milliseconds(30);
+    while (Clock::now() < until) {
+        sink = sink + 1;
+    }
+    auto spun = meter.elapsed();
+    std::cout << "  after sleep: " << slept.cpu_time_ns / 1000 << " us, after spin: "
+              << spun.cpu_time_ns / 1000 << " us" << std::endl;
+    assert(slept.cpu_time_ns < 20'000'000);
+    assert(spun.cpu_time_ns - slept.cpu_time_ns >= 10'000'000);
+
+    std::cout << "✓ CPU time test passed" << std::endl;
+}
+
+void test_meter_heap_use() {
+    std::cout << "Testing heap accounting..." << std::endl;
+
+    ResourceMeter meter;
+    {
+        std::vector<char> buffer(1 << 20);
+        buffer[0] = 1;
+        auto held = meter.elapsed();
+        assert(held.allocated_bytes >= (1 << 20));
+        assert(held.peak_heap_bytes >= (1 << 20));
+    }
+
+    // Nested meters: the inner one sees only its own peak, the outer keeps the larger one
+    {
+        ResourceMeter inner;
+        auto small = std::make_unique<char[]>(4096);
+        small[0] = 1;
+        auto usage = inner.elapsed();
+        assert(usage.peak_heap_bytes >= 4096 && usage.peak_heap_bytes < (1 << 20));
+    }
+    auto total = meter.elapsed();
+    assert(total.allocated_bytes >= (1 << 20) + 4096);
+    assert(total.peak_heap_bytes >= (1 << 20));
+
+    // Other threads' allocations are not counted here
+    ResourceMeter idle;
+    std::thread([]() { std::vector<char> elsewhere(1 << 20); elsewhere[0] = 1; }).join();
+    assert(idle.elapsed().allocated_bytes < (1 << 16));
+
+    std::cout << "✓ Heap accounting test passed" << std::endl;
+}
+
+void test_sliding_window() {
+    std::cout << "Testing sliding window totals..." << std::endl;
+
+    TenantLedger ledger(window_config(10000, 10)); // 10 s window of 1 s buckets
+    auto start = Clock::now();
+    for (int second = 0; second < 10; second++) {
+        ledger.record("tenant_a", 1'000'000, 100, 50 + second, start + std::chrono::seconds(second));
+    }
+    ledger.record("tenant_b", 5'000'000, 0, 0, start);
+
+    auto usage = ledger.usage("tenant_a", start + std::chrono::seconds(9));
+    assert(usage.cpu_time_ns == 10'000'000);
+    assert(usage.allocated_bytes == 1000);
+    assert(usage.peak_heap_bytes == 59);
+    assert(usage.steps == 10);
+    assert(ledger.usage("tenant_b", start).cpu_time_ns == 5'000'000);
+    assert(ledger.usage("unknown", start).steps == 0);
+
+    // Five seconds later the first five buckets have aged out
+    usage = ledger.usage("tenant_a", start + std::chrono::seconds(14));
+    assert(usage.steps == 5);
+    assert(usage.cpu_time_ns == 5'000'000);
+
+    // A bucket slot coming round again starts from zero
+    ledger.record("tenant_a", 7, 0, 0, start + std::chrono::seconds(20));
+    usage = ledger.usage("tenant_a", start + std::chrono::seconds(20));
+    assert(usage.steps == 1 && usage.cpu_time_ns == 7);
+
+    std::cout << "✓ Sliding window test passed" << std::endl;
+}
+
+void test_quota_state() {
+    std::cout << "Testing quota enforcement..." << std::endl;
+
+    auto config = window_config(60000, 60);
+    config.max_cpu_time_ms = 100;
+    config.max_memory_bytes = 1 << 20;
+    TenantLedger ledger(config);
+    auto now = Clock::now();
+
+    assert(ledger.quota_state("tenant_a", now) == TenantLedger::QuotaState::within);
+    ledger.record("tenant_a", 60'000'000, 0, 1024, now);
+    assert(!ledger.over_quota("tenant_a", now));
+    ledger.record("tenant_a", 60'000'000, 0, 1024, now);
+    assert(ledger.quota_state("tenant_a", now) == TenantLedger::QuotaState::cpu_time_exceeded);
+
+    // Recovers once the usage leaves the window
+    assert(!ledger.over_quota("tenant_a", now + std::chrono::seconds(61)));
+
+    ledger.record("tenant_b", 0, 0, 2 << 20, now);
+    assert(ledger.quota_state("tenant_b", now) == TenantLedger::QuotaState::memory_exceeded);
+
+    // No limits configured: never over quota
+    TenantLedger unlimited(window_config(60000, 60));
+    unlimited.record("tenant_a", int64_t{1} << 50, 0, int64_t{1} << 40, now);
+    assert(!unlimited.over_quota("tenant_a", now));
+
+    std::cout << "✓ Quota enforcement test passed" << std::endl;
+}
+
+void test_tenant_limit_overflow() {
+    std::cout << "Testing tenant limit..." << std::endl;
+
+    auto config = window_config(60000, 60);
+    config.max_tenants = 4;
+    TenantLedger ledger(config);
+    auto now = Clock::now();
+    for (int i = 0; i < 10; i++) {
+        ledger.record("tenant_" + std::to_string(i), 1, 0, 0, now);
+    }
+    assert(ledger.usage("tenant_0", now).steps == 1);
+    assert(ledger.usage("tenant_3", now).steps == 1);
+    // Later tenants share one account
+    assert(ledger.usage(TenantLedger::OVERFLOW_TENANT, now).steps == 6);
+    assert(ledger.usage("tenant_9", now).steps == 6);
+
+    std::cout << "✓ Tenant limit test passed" << std::endl;
+}
+
+void test_concurrent_recording() {
+    std::cout << "Testing concurrent recording..." << std::endl;
+
+    TenantLedger ledger(window_config(3600000, 60));
+    const int threads = 8;
+    const int steps = 20000;
+    auto now = Clock::now();
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&ledger, t, now]() {
+            for (int i = 0; i < steps; i++) {
+                ledger.record("tenant_" + std::to_string((t + i) % 4), 1000, 10, i, now);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    uint64_t total_steps = 0;
+    int64_t total_cpu = 0;
+    for (int i = 0; i < 4; i++) {
+        auto usage = ledger.usage("tenant_" + std::to_string(i), now);
+        total_steps += usage.steps;
+        total_cpu += usage.cpu_time_ns;
+        assert(usage.peak_heap_bytes == steps - 1);
+    }
+    assert(total_steps == static_cast<uint64_t>(threads) * steps);
+    assert(total_cpu == int64_t{threads} * steps * 1000);
+    std::cout << "  " << elapsed / (threads * steps) << " ns per record" << std::endl;
+
+    std::cout << "✓ Concurrent recording test passed" << std::endl;
+}
+
+void test_untagged_steps_never_throttled() {
+    std::cout << "Testing steps without a tenant id are not accounted..." << std::endl;
+
+    auto config = window_config(60000, 60);
+    config.max_cpu_time_ms = 1;
+    config.max_memory_bytes = 1;
+    config.max_tenants = 1;
+    TenantLedger ledger(config);
+    auto now = Clock::now();
+
+    ledger.record("", int64_t{1} << 50, int64_t{1} << 40, int64_t{1} << 40, now);
+    assert(ledger.usage("", now).steps == 0);
+    assert(ledger.quota_state("", now) == TenantLedger::QuotaState::within);
+
+    // Untagged steps neither take a tenant slot nor land in (or read) the overflow account
+    ledger.record("tenant_a", 0, 0, 0, now);
+    ledger.record("tenant_b", int64_t{1} << 50, 0, 0, now);
+    assert(ledger.over_quota("tenant_b", now));
+    assert(ledger.usage(TenantLedger::OVERFLOW_TENANT, now).steps == 1);
+    assert(!ledger.over_quota("", now));
+
+    std::cout << "✓ Untagged steps test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Tenant Ledger Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_meter_cpu_time();
+        test_meter_heap_use();
+        test_sliding_window();
+        test_quota_state();
+        test_tenant_limit_overflow();
+        test_concurrent_recording();
+        test_untagged_steps_never_throttled();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
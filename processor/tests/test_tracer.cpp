@@ -0,0 +1,352 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "beamline/worker/tracer.hpp"
+
+using namespace beamline::worker;
+using json = nlohmann::json;
+
+static std::string temp_trace_path(const std::string& name) {
+    std::string path = "/tmp/beamline_test_" + name + "_" + std::to_string(::getpid()) + ".jsonl";
+    std::remove(path.c_str());
+    return path;
+}
+
+static Tracer::Config trace_config(const std::string& path) {
+    Tracer::Config config;
+    config.path = path;
+    config.export_interval_ms = 50;
+    return config;
+}
+
+// All exported spans keyed by span id, after checking every line is a valid request
+static std::map<std::string, json> read_spans(const std::string& path) {
+    std::map<std::string, json> spans;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        json request = json::parse(line);
+        auto& resource = request["resourceSpans"][0];
+        assert(resource["resource"]["attributes"][0]["key"] == "service.name");
+        for (auto& span : resource["scopeSpans"][0]["spans"]) {
+            spans[span["spanId"].get<std::string>()] = span;
+        }
+    }
+    return spans;
+}
+
+static std::string hex(uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+void test_traceparent() {
+    std::cout << "Testing traceparent round trip..." << std::endl;
+
+    SpanContext context;
+    context.trace_high = 0x0af7651916cd43ddULL;
+    context.trace_low = 0x8448eb211c80319cULL;
+    context.span_id = 0xb7ad6b7169203331ULL;
+    context.sampled = true;
+    std::string header = context.traceparent();
+    assert(header == "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01");
+
+    SpanContext parsed = SpanContext::from_traceparent(header);
+    assert(parsed.valid());
+    assert(parsed.trace_high == context.trace_high && parsed.trace_low == context.trace_low);
+    assert(parsed.span_id == context.span_id);
+    assert(parsed.sampled && parsed.remote);
+    assert(!SpanContext::from_traceparent(header, false).remote);
+
+    assert(!SpanContext::from_traceparent("").valid());
+    assert(!SpanContext::from_traceparent("01-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01").valid());
+    assert(!SpanContext::from_traceparent("00-00000000000000000000000000000000-b7ad6b7169203331-01").valid());
+    assert(!SpanContext::from_traceparent("00-0af7651916cd43dd8448eb211c80319c-b7ad6b716920333z-01").valid());
+    assert(SpanContext().traceparent().empty());
+
+    std::cout << "✓ Traceparent test passed" << std::endl;
+}
+
+void test_disabled_tracer() {
+    std::cout << "Testing disabled tracer..." << std::endl;
+
+    Tracer tracer(Tracer::Config{});
+    assert(!tracer.enabled());
+    Span span = tracer.start_span("noop");
+    assert(!span);
+    assert(!span.context().valid());
+    span.set_attribute("key", "value");
+    span.set_error("ignored");
+    span.end();
+    tracer.flush();
+    assert(tracer.stats().recorded == 0);
+
+    std::cout << "✓ Disabled tracer test passed" << std::endl;
+}
+
+void test_head_sampling_and_export() {
+    std::cout << "Testing head sampling and OTLP/JSON export..." << std::endl;
+
+    std::string path = temp_trace_path("trace_head");
+    auto config = trace_config(path);
+    config.sample_ratio = 1.0;
+    uint64_t root_id = 0;
+    uint64_t child_id = 0;
+    uint64_t client_id = 0;
+    {
+        Tracer tracer(config);
+        Span root = tracer.start_span("step");
+        assert(root && root.context().sampled);
+        root.set_attribute("step.type", "http.request").set_attribute("retry.attempt", int64_t{2});
+        {
+            Tracer::Scope scope(root.context());
+            assert(Tracer::current().span_id == root.context().span_id);
+            Span child = tracer.start_span("step.attempt", Tracer::current());
+            child.set_error("boom \"quoted\"");
+            child_id = child.context().span_id;
+
+            Span client = tracer.start_span("http.request", child.context(), Tracer::SpanKind::client);
+            client_id = client.context().span_id;
+        }
+        assert(!Tracer::current().valid());
+        root_id = root.context().span_id;
+        root.end();
+        tracer.flush();
+
+        auto stats = tracer.stats();
+        assert(stats.recorded == 3);
+        assert(stats.exported == 3);
+        assert(stats.dropped == 0 && stats.discarded == 0);
+    }
+
+    auto spans = read_spans(path);
+    assert(spans.size() == 3);
+    const json& root = spans.at(hex(root_id));
+    const json& child = spans.at(hex(child_id));
+    const json& client = spans.at(hex(client_id));
+    assert(root["name"] == "step");
+    assert(!root.contains("parentSpanId"));
+    assert(root["kind"] == 1);
+    assert(root["traceId"].get<std::string>().size() == 32);
+    assert(child["traceId"] == root["traceId"] && client["traceId"] == root["traceId"]);
+    assert(child["parentSpanId"] == hex(root_id));
+    assert(client["parentSpanId"] == hex(child_id));
+    assert(client["kind"] == 3);
+    assert(root["attributes"][0]["key"] == "step.type");
+    assert(root["attributes"][0]["value"]["stringValue"] == "http.request");
+    assert(root["attributes"][1]["value"]["intValue"] == "2");
+    assert(child["status"]["code"] == 2);
+    assert(child["status"]["message"] == "boom \"quoted\"");
+    assert(!root.contains("status"));
+
+    int64_t start = std::stoll(root["startTimeUnixNano"].get<std::string>());
+    int64_t end = std::stoll(root["endTimeUnixNano"].get<std::string>());
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch()).count();
+    assert(start <= end && end <= now && now - start < 60LL * 1000000000);
+
+    std::remove(path.c_str());
+    std::cout << "✓ Head sampling test passed" << std::endl;
+}
+
+void test_tail_sampling() {
+    std::cout << "Testing tail sampling..." << std::endl;
+
+    std::string path = temp_trace_path("trace_tail");
+    auto config = trace_config(path);
+    config.sample_ratio = 0.0;
+    config.slow_threshold_ms = 20;
+    uint64_t failed_trace = 0;
+    uint64_t slow_trace = 0;
+    {
+        Tracer tracer(config);
+
+        // Fast, successful trace: discarded once its root ends
+        {
+            Span root = tracer.start_span("step");
+            assert(root && !root.context().sampled);
+            Span child = tracer.start_span("step.attempt", root.context());
+        }
+        // Failed child: the whole trace is kept, including spans that ended before it
+        {
+            Span root = tracer.start_span("step");
+            failed_trace = root.context().trace_low;
+            { Span ok = tracer.start_span("fs.read", root.context()); }
+            tracer.flush();
+            Span failed = tracer.start_span("step.attempt", root.context());
+            failed.set_error("timeout");
+        }
+        // Slow root
+        {
+            Span root = tracer.start_span("step", SpanContext(), Tracer::SpanKind::internal,
+                                          std::chrono::steady_clock::now() - std::chrono::milliseconds(50));
+            slow_trace = root.context().trace_low;
+            Span child = tracer.start_span("pool.queue_wait", root.context());
+        }
+        // Remote unsampled parent: the first local span is the local root
+        {
+            SpanContext remote = SpanContext::from_traceparent(
+                "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-00");
+            Span root = tracer.start_span("step", remote);
+            Span child = tracer.start_span("step.attempt", root.context());
+            child.set_error();
+        }
+        tracer.flush();
+
+        auto stats = tracer.stats();
+        assert(stats.recorded == 9);
+        assert(stats.exported == 7);
+        assert(stats.discarded == 2);
+        assert(stats.pending == 0);
+    }
+
+    auto spans = read_spans(path);
+    assert(spans.size() == 7);
+    std::map<std::string, int> per_trace;
+    for (auto& [id, span] : spans) {
+        per_trace[span["traceId"].get<std::string>().substr(16)]++;
+    }
+    assert(per_trace.size() == 3);
+    assert(per_trace[hex(failed_trace)] == 3);
+    assert(per_trace[hex(slow_trace)] == 2);
+    assert(per_trace["8448eb211c80319c"] == 2);
+
+    std::remove(path.c_str());
+    std::cout << "✓ Tail sampling test passed" << std::endl;
+}
+
+void test_undecided_traces_expire() {
+    std::cout << "Testing undecided trace expiry and pending limit..." << std::endl;
+
+    std::string path = temp_trace_path("trace_expire");
+    auto config = trace_config(path);
+    config.sample_ratio = 0.0;
+    config.tail_timeout_ms = 100;
+    config.max_pending_spans = 4;
+    {
+        Tracer tracer(config);
+        Span root = tracer.start_span("step");
+        for (int i = 0; i < 6; i++) {
+            Span child = tracer.start_span("step.attempt", root.context());
+        }
+        tracer.flush();
+        auto stats = tracer.stats();
+        assert(stats.pending == 4);
+        assert(stats.dropped == 2);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        tracer.flush();
+        stats = tracer.stats();
+        assert(stats.pending == 0);
+        assert(stats.discarded == 4);
+        assert(stats.exported == 0);
+    }
+    std::remove(path.c_str());
+
+    std::cout << "✓ Expiry test passed" << std::endl;
+}
+
+void test_multithreaded_recording() {
+    std::cout << "Testing recording from many threads..." << std::endl;
+
+    std::string path = temp_trace_path("trace_threads");
+    auto config = trace_config(path);
+    config.sample_ratio = 1.0;
+    config.ring_spans = 4096;
+    config.max_batch_spans = 100;
+    const int threads = 4;
+    const int spans_per_thread = 1000;
+    {
+        Tracer tracer(config);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&tracer]() {
+                for (int i = 0; i < spans_per_thread; i++) {
+                    Span span = tracer.start_span("step");
+                    span.set_attribute("index", int64_t{i});
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        tracer.flush();
+
+        auto stats = tracer.stats();
+        assert(stats.recorded == threads * spans_per_thread);
+        assert(stats.exported + stats.dropped == stats.recorded);
+        assert(stats.batches >= stats.exported / 100);
+        std::cout << "  Exported " << stats.exported << " spans in " << stats.batches << " lines, dropped "
+                  << stats.dropped << std::endl;
+    }
+    auto spans = read_spans(path);
+    assert(!spans.empty());
+    std::remove(path.c_str());
+
+    std::cout << "✓ Multithreaded recording test passed" << std::endl;
+}
+
+void test_span_overhead() {
+    std::cout << "Testing per-span overhead..." << std::endl;
+
+    const int iterations = 200000;
+    auto measure = [&](Tracer& tracer) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            Span span = tracer.start_span("step");
+            span.set_attribute("retry.attempt", int64_t{i});
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return static_cast<double>(elapsed.count()) / iterations;
+    };
+
+    Tracer disabled(Tracer::Config{});
+    double disabled_ns = measure(disabled);
+
+    std::string path = temp_trace_path("trace_overhead");
+    auto config = trace_config(path);
+    config.sample_ratio = 0.0;
+    config.ring_spans = 8192;
+    Tracer enabled(config);
+    double enabled_ns = measure(enabled);
+
+    std::cout << "  Disabled: " << disabled_ns << " ns per span" << std::endl;
+    std::cout << "  Enabled:  " << enabled_ns << " ns per span" << std::endl;
+    // Steps take milliseconds; a handful of spans per step stays well under 1%
+    assert(disabled_ns < 100);
+    assert(enabled_ns < 2000);
+    std::remove(path.c_str());
+
+    std::cout << "✓ Span overhead test completed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Tracer Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        test_traceparent();
+        test_disabled_tracer();
+        test_head_sampling_and_export();
+        test_tail_sampling();
+        test_undecided_traces_expire();
+        test_multithreaded_recording();
+        test_span_overhead();
+
+        std::cout << std::endl;
+        std::cout << "=== All Tests Passed ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}